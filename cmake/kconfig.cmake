@@ -331,6 +331,11 @@ if(EXISTS ${BOARD_DEFCONFIG})
 		add_definitions(-DPX4_CRYPTO)
 	endif()
 
+	if(CONFIG_MODULES_UORB_SHM_BRIDGE)
+		# uORB forwards publications to the communicator channel (uORBCommunicator::IChannel)
+		add_definitions(-DORB_COMMUNICATOR)
+	endif()
+
 	if(LINKER_PREFIX)
 		set(PX4_BOARD_LINKER_PREFIX ${LINKER_PREFIX} CACHE STRING "PX4 board linker prefix" FORCE)
 	else()
@@ -60,6 +60,68 @@ def add_fields(msg_fields, name_prefix='', offset=0):
 
 fields, struct_size = add_fields(spec.parsed_fields())
 
+# get the offsets of the (flattened) fields in the uORB struct, which is sorted by field size (see templates/uorb/msg.h.em)
+def add_struct_offsets(msg_fields, offsets, name_prefix='', offset=0):
+	sorted_fields = sorted(msg_fields, key=sizeof_field_type, reverse=True)
+	add_padding_bytes(sorted_fields, search_path)
+	for field in sorted_fields:
+		if not field.is_header:
+			array_size = field.array_len if field.is_array else 1
+			if field.is_builtin:
+				offsets[name_prefix+field.name] = offset
+			else:
+				children_fields = get_children_fields(field.base_type, search_path)
+				for i in range(array_size):
+					sub_name_prefix = name_prefix+field.name
+					if array_size > 1:
+						sub_name_prefix += '['+str(i)+']'
+					add_struct_offsets(children_fields, offsets, sub_name_prefix+'.', offset + i * field.sizeof_field_type)
+			offset += field.sizeof_field_type * array_size
+
+struct_offsets = {}
+add_struct_offsets(spec.parsed_fields(), struct_offsets)
+
+# group consecutive fields without padding in the CDR stream, which are also consecutive in the struct, into runs
+# that are copied with a single memcpy (the layout is checked at build time)
+runs = []
+for field_type, field_name, field_size, padding in fields:
+	if runs and padding == 0 and field_name in struct_offsets and runs[-1][-1][1] in struct_offsets \
+			and struct_offsets[field_name] == struct_offsets[runs[-1][-1][1]] + runs[-1][-1][2]:
+		runs[-1].append((field_type, field_name, field_size, padding))
+	else:
+		runs.append([(field_type, field_name, field_size, padding)])
+
+def print_copy(run, serialize):
+	field_type, first_name, first_size, padding = run[0]
+	if padding > 0:
+		print('\tbuf.iterator += {:}; // padding'.format(padding))
+		print('\tbuf.offset += {:}; // padding'.format(padding))
+
+	if len(run) == 1:
+		print('\tstatic_assert(sizeof(topic.{0}) == {1}, "size mismatch");'.format(first_name, first_size))
+		if serialize:
+			print('\tmemcpy(buf.iterator, &topic.{0}, sizeof(topic.{0}));'.format(first_name))
+		else:
+			print('\tmemcpy(&topic.{0}, buf.iterator, sizeof(topic.{0}));'.format(first_name))
+		print('\tbuf.iterator += sizeof(topic.{:});'.format(first_name))
+		print('\tbuf.offset += sizeof(topic.{:});'.format(first_name))
+		return
+
+	run_size = 0
+	for field_type, field_name, field_size, padding in run:
+		print('\tstatic_assert(sizeof(topic.{0}) == {1}, "size mismatch");'.format(field_name, field_size))
+		if run_size > 0:
+			print('\tstatic_assert(offsetof({0}, {1}) - offsetof({0}, {2}) == {3}, "layout mismatch");'.format(uorb_struct, field_name, first_name, run_size))
+		run_size += field_size
+
+	print('\t// {:} fields with the same layout'.format(len(run)))
+	if serialize:
+		print('\tmemcpy(buf.iterator, (const uint8_t *)&topic + offsetof({0}, {1}), {2});'.format(uorb_struct, first_name, run_size))
+	else:
+		print('\tmemcpy((uint8_t *)&topic + offsetof({0}, {1}), buf.iterator, {2});'.format(uorb_struct, first_name, run_size))
+	print('\tbuf.iterator += {:};'.format(run_size))
+	print('\tbuf.offset += {:};'.format(run_size))
+
 }@
 
 // auto-generated file
@@ -67,6 +129,7 @@ fields, struct_size = add_fields(spec.parsed_fields())
 #pragma once
 
 #include <ucdr/microcdr.h>
+#include <stddef.h>
 #include <string.h>
 #include <uORB/topics/@(topic).h>
 
@@ -87,21 +150,24 @@ static inline constexpr int ucdr_topic_size_@(topic)()
 	return @(struct_size);
 }
 
+static inline constexpr int ucdr_num_fields_@(topic)()
+{
+	return @(len(fields));
+}
+
+static inline constexpr int ucdr_num_copies_@(topic)()
+{
+	return @(len(runs));
+}
+
 bool ucdr_serialize_@(topic)(const @(uorb_struct)& topic, ucdrBuffer& buf)
 {
 	if (ucdr_buffer_remaining(&buf) < @(struct_size)) {
 		return false;
 	}
 @{
-for field_type, field_name, field_size, padding in fields:
-	if padding > 0:
-		print('\tbuf.iterator += {:}; // padding'.format(padding))
-		print('\tbuf.offset += {:}; // padding'.format(padding))
-
-	print('\tstatic_assert(sizeof(topic.{0}) == {1}, "size mismatch");'.format(field_name, field_size))
-	print('\tmemcpy(buf.iterator, &topic.{0}, sizeof(topic.{0}));'.format(field_name))
-	print('\tbuf.iterator += sizeof(topic.{:});'.format(field_name))
-	print('\tbuf.offset += sizeof(topic.{:});'.format(field_name))
+for run in runs:
+	print_copy(run, True)
 
 }@
 	return true;
@@ -113,16 +179,25 @@ bool ucdr_deserialize_@(topic)(ucdrBuffer& buf, @(uorb_struct)& topic)
 		return false;
 	}
 @{
-for field_type, field_name, field_size, padding in fields:
-	if padding > 0:
-		print('\tbuf.iterator += {:}; // padding'.format(padding))
-		print('\tbuf.offset += {:}; // padding'.format(padding))
+for run in runs:
+	print_copy(run, False)
 
-	print('\tstatic_assert(sizeof(topic.{0}) == {1}, "size mismatch");'.format(field_name, field_size))
-	print('\tmemcpy(&topic.{0}, buf.iterator, sizeof(topic.{0}));'.format(field_name))
-	print('\tbuf.iterator += sizeof(topic.{:});'.format(field_name))
-	print('\tbuf.offset += sizeof(topic.{:});'.format(field_name))
+}@
+	return true;
+}
+
+#if defined(UCDR_FIELDWISE_REFERENCE)
+// field by field serialization, as reference for tests and benchmarks
+bool ucdr_serialize_fieldwise_@(topic)(const @(uorb_struct)& topic, ucdrBuffer& buf)
+{
+	if (ucdr_buffer_remaining(&buf) < @(struct_size)) {
+		return false;
+	}
+@{
+for field in fields:
+	print_copy([field], True)
 
 }@
 	return true;
 }
+#endif // UCDR_FIELDWISE_REFERENCE
@@ -15,6 +15,7 @@
 @#  - search_path (dict) search paths for genmsg
 @#  - topics (List of String) multi-topic names
 @#  - constrained_flash set to true if flash is constrained
+@#  - field_descriptors set to true to generate the precompiled field descriptors
 @###############################################
 /****************************************************************************
  *
@@ -62,9 +63,11 @@ topic_name = spec.short_name
 sorted_fields = sorted(spec.parsed_fields(), key=sizeof_field_type, reverse=True)
 struct_size, padding_end_size = add_padding_bytes(sorted_fields, search_path)
 topic_fields = ["%s %s" % (convert_type(field.type, True), field.name) for field in sorted_fields]
+field_descriptors = get_field_descriptors(sorted_fields)
 }@
 
 #include <inttypes.h>
+#include <stddef.h>
 #include <px4_platform_common/log.h>
 #include <px4_platform_common/defines.h>
 #include <uORB/topics/@(topic_name).h>
@@ -78,9 +81,23 @@ topic_fields = ["%s %s" % (convert_type(field.type, True), field.name) for field
 @# This is used for the logger
 constexpr char __orb_@(topic_name)_fields[] = "@( ";".join(topic_fields) );";
 
+@[if not field_descriptors]@
+@# the fields are parsed at runtime from o_fields instead
 @[for multi_topic in topics]@
-ORB_DEFINE(@multi_topic, struct @uorb_struct, @(struct_size-padding_end_size), __orb_@(topic_name)_fields, static_cast<uint8_t>(ORB_ID::@multi_topic));
+ORB_DEFINE(@multi_topic, struct @uorb_struct, @(struct_size-padding_end_size), __orb_@(topic_name)_fields, nullptr, 0, static_cast<uint8_t>(ORB_ID::@multi_topic));
 @[end for]
+@[else]@
+@# precompiled fields: {offset, count, name index in o_fields, name length, type, hint, nested ORB_ID}
+constexpr orb_field_descriptor __orb_@(topic_name)_field_descriptors[] = {
+@[for (name, count, name_idx, name_length, field_type, hint, nested) in field_descriptors]@
+	{offsetof(@uorb_struct, @name), @count, @name_idx, @name_length, @field_type, @hint, static_cast<uint8_t>(ORB_ID::@(nested if nested else 'INVALID'))},
+@[end for]
+};
+
+@[for multi_topic in topics]@
+ORB_DEFINE(@multi_topic, struct @uorb_struct, @(struct_size-padding_end_size), __orb_@(topic_name)_fields, __orb_@(topic_name)_field_descriptors, @(len(field_descriptors)), static_cast<uint8_t>(ORB_ID::@multi_topic));
+@[end for]
+@[end if]
 
 void print_message(const orb_metadata *meta, const @uorb_struct& message)
 {
@@ -25,10 +25,16 @@ receive_base_types = [s.short_name for idx, s in enumerate(spec) if scope[idx] =
 }@
 
 
+#include <string.h>
+
 #include <uxr/client/client.h>
 #include <ucdr/microcdr.h>
 
-#include <uORB/Subscription.hpp>
+#include <drivers/drv_hrt.h>
+#include <mathlib/mathlib.h>
+#include <px4_platform_common/sem.h>
+#include <px4_platform_common/time.h>
+#include <uORB/SubscriptionCallback.hpp>
 #include <uORB/Publication.hpp>
 @[for idx, topic in enumerate(send_topics)]@
 #include <uORB/ucdr/@(send_base_types[idx]).h>
@@ -37,21 +43,151 @@ receive_base_types = [s.short_name for idx, s in enumerate(spec) if scope[idx] =
 #include <uORB/ucdr/@(receive_base_types[idx]).h>
 @[end for]@
 
+// Subscription which wakes up the sending task on new publications (respecting the interval)
+class SendSubscription : public uORB::SubscriptionCallback
+{
+public:
+	SendSubscription(const orb_metadata *meta, px4_sem_t *wakeup) :
+		uORB::SubscriptionCallback(meta),
+		_wakeup(wakeup)
+	{
+	}
+
+	void call() override
+	{
+		if ((_interval_us == 0) || (hrt_elapsed_time(&_last_update) >= _interval_us)) {
+			// coalesce the wakeups of all topics
+			int value = 0;
+
+			if ((px4_sem_getvalue(_wakeup, &value) == 0) && (value <= 0)) {
+				px4_sem_post(_wakeup);
+			}
+		}
+	}
+
+private:
+	px4_sem_t *_wakeup;
+};
+
 // Subscribers for messages to send
 struct SendTopicsSubs {
+	static constexpr int NUM_TOPICS = @(len(send_topics));
+
+	// maximum number of queued samples of a topic sent per update
+	static constexpr int MAX_SAMPLES_PER_UPDATE = 8;
+
+	struct TopicStats {
+		uint32_t num_sent;
+		uint32_t bytes_sent;
+		uint32_t last_num_sent;
+		uint32_t last_bytes_sent;
+		float message_rate; ///< in Hz
+		float byte_rate; ///< in B/s
+		uint64_t serialize_time_total; ///< in us, copying and serializing all samples of an update
+		uint32_t serialize_time_max; ///< in us, of an update (up to MAX_SAMPLES_PER_UPDATE samples)
+	};
+
+	SendTopicsSubs();
+	~SendTopicsSubs();
+
+	px4_sem_t wakeup;
+
 @[    for idx, topic in enumerate(send_topics)]@
-	uORB::Subscription @(topic)_sub{ORB_ID(@(topic))};
+	SendSubscription @(topic)_sub{ORB_ID(@(topic)), &wakeup};
 	uxrObjectId @(topic)_data_writer;
 @[    end for]@
 
+	TopicStats stats[NUM_TOPICS] {};
+
 	uxrSession* session;
 
 	uint32_t num_payload_sent{};
+	uint32_t num_batches_sent{};
 
 	bool init(uxrSession* session_, uxrStreamId stream_id, uxrObjectId participant_id);
 	void update(uxrStreamId stream_id);
+
+	/**
+	 * Wait for new publications of any topic.
+	 * @return true if woken up by a publication, false on timeout
+	 */
+	bool wait(uint32_t timeout_us);
+
+	static const char *topic_name(int index);
+	static int topic_index(const char *name);
+
+	/** limit the rate of a topic, 0 for every publication */
+	void set_interval_us(int index, uint32_t interval_us);
+	uint32_t get_interval_us(int index);
+
+	void update_rates(float dt);
+	void print_status();
+
+private:
+	/** reserve space for a sample in the output stream, sends the batch if it is full */
+	bool prepare(uxrStreamId stream_id, uxrObjectId data_writer, ucdrBuffer &ub, uint32_t size);
+
+	bool _batch_pending{false};
+	uint64_t _flush_time{0}; ///< in us, time spent sending full batches, excluded from the serialization time
 };
 
+SendTopicsSubs::SendTopicsSubs()
+{
+	px4_sem_init(&wakeup, 0, 0);
+	px4_sem_setprotocol(&wakeup, SEM_PRIO_NONE);
+}
+
+SendTopicsSubs::~SendTopicsSubs()
+{
+@[    for idx, topic in enumerate(send_topics)]@
+	@(topic)_sub.unregisterCallback();
+@[    end for]@
+
+	px4_sem_destroy(&wakeup);
+}
+
+const char *SendTopicsSubs::topic_name(int index)
+{
+	switch (index) {
+@[    for idx, topic in enumerate(send_topics)]@
+	case @(idx): return "@(topic)";
+@[    end for]@
+	}
+
+	return nullptr;
+}
+
+int SendTopicsSubs::topic_index(const char *name)
+{
+	for (int i = 0; i < NUM_TOPICS; i++) {
+		if (strcmp(topic_name(i), name) == 0) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+void SendTopicsSubs::set_interval_us(int index, uint32_t interval_us)
+{
+	switch (index) {
+@[    for idx, topic in enumerate(send_topics)]@
+	case @(idx): @(topic)_sub.set_interval_us(interval_us); break;
+@[    end for]@
+	}
+}
+
+uint32_t SendTopicsSubs::get_interval_us(int index)
+{
+	switch (index) {
+@[    for idx, topic in enumerate(send_topics)]@
+	case @(idx): return @(topic)_sub.get_interval_us();
+@[    end for]@
+	}
+
+	return 0;
+}
+
 bool SendTopicsSubs::init(uxrSession* session_, uxrStreamId stream_id, uxrObjectId participant_id)
 {
 	session = session_;
@@ -100,6 +236,8 @@ topic_pascal = topic.replace("_", " ").title().replace(" ", "")
 			PX4_ERR("create entities failed: %s, topic: %i publisher: %i datawriter: %i", "@(topic_pascal)", status[0], status[1], status[2]);
 			return false;
 		}
+
+		@(topic)_sub.registerCallback();
 	}
 
 @[    end for]@
@@ -107,24 +245,113 @@ topic_pascal = topic.replace("_", " ").title().replace(" ", "")
 	return true;
 }
 
+bool SendTopicsSubs::wait(uint32_t timeout_us)
+{
+	struct timespec ts;
+	px4_clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	// Calculate an absolute time in the future
+	const unsigned billion = (1000 * 1000 * 1000);
+	uint64_t nsecs = ts.tv_nsec + ((uint64_t)timeout_us * 1000);
+	ts.tv_sec += nsecs / billion;
+	nsecs -= (nsecs / billion) * billion;
+	ts.tv_nsec = nsecs;
+
+	return px4_sem_timedwait(&wakeup, &ts) == 0;
+}
+
+bool SendTopicsSubs::prepare(uxrStreamId stream_id, uxrObjectId data_writer, ucdrBuffer &ub, uint32_t size)
+{
+	if (uxr_prepare_output_stream(session, stream_id, data_writer, &ub, size) != UXR_INVALID_REQUEST_ID) {
+		_batch_pending = true;
+		return true;
+	}
+
+	if (!_batch_pending) {
+		// does not fit into an empty stream buffer
+		return false;
+	}
+
+	// the batch is full, send it and start a new one
+	const hrt_abstime flush_start = hrt_absolute_time();
+	uxr_flash_output_streams(session);
+	_flush_time += hrt_elapsed_time(&flush_start);
+	num_batches_sent++;
+	_batch_pending = false;
+
+	if (uxr_prepare_output_stream(session, stream_id, data_writer, &ub, size) != UXR_INVALID_REQUEST_ID) {
+		_batch_pending = true;
+		return true;
+	}
+
+	return false;
+}
+
 void SendTopicsSubs::update(uxrStreamId stream_id)
 {
+	// all samples are batched into the output stream buffer, which is sent once it is full and at the end
+	// the serialization time is measured over all samples of a topic, a single sample takes less than the
+	// resolution of the timer
 @[    for idx, topic in enumerate(send_topics)]@
 	{
 		@(send_base_types[idx])_s data;
+		TopicStats &s = stats[@(idx)];
+		const hrt_abstime update_start = hrt_absolute_time();
+		const uint64_t flush_time_start = _flush_time;
+		int num_serialized = 0;
 
-		if (@(topic)_sub.update(&data)) {
+		for (int i = 0; (i < MAX_SAMPLES_PER_UPDATE) && @(topic)_sub.update(&data); i++) {
 			ucdrBuffer ub{};
 			uint32_t topic_size = ucdr_topic_size_@(send_base_types[idx])();
-			uxr_prepare_output_stream(session, stream_id, @(topic)_data_writer, &ub, topic_size);
-			ucdr_serialize_@(send_base_types[idx])(data, ub);
-			// TODO: fill up the MTU and then flush, which reduces the packet overhead
-			uxr_flash_output_streams(session);
-			num_payload_sent += topic_size;
+
+			if (prepare(stream_id, @(topic)_data_writer, ub, topic_size)) {
+				ucdr_serialize_@(send_base_types[idx])(data, ub);
+				s.num_sent++;
+				s.bytes_sent += topic_size;
+				num_payload_sent += topic_size;
+				num_serialized++;
+			}
+		}
+
+		if (num_serialized > 0) {
+			const uint32_t serialize_time = hrt_elapsed_time(&update_start) - (_flush_time - flush_time_start);
+			s.serialize_time_total += serialize_time;
+			s.serialize_time_max = math::max(s.serialize_time_max, serialize_time);
 		}
 	}
 @[    end for]@
 
+	if (_batch_pending) {
+		uxr_flash_output_streams(session);
+		num_batches_sent++;
+		_batch_pending = false;
+	}
+}
+
+void SendTopicsSubs::update_rates(float dt)
+{
+	for (int i = 0; i < NUM_TOPICS; i++) {
+		TopicStats &s = stats[i];
+		s.message_rate = (s.num_sent - s.last_num_sent) / dt;
+		s.byte_rate = (s.bytes_sent - s.last_bytes_sent) / dt;
+		s.last_num_sent = s.num_sent;
+		s.last_bytes_sent = s.bytes_sent;
+	}
+}
+
+void SendTopicsSubs::print_status()
+{
+	PX4_INFO_RAW("%-32s %10s %10s %10s %14s %14s\n", "topic", "limit Hz", "rate Hz", "B/s", "serialize us", "max us/update");
+
+	for (int i = 0; i < NUM_TOPICS; i++) {
+		const TopicStats &s = stats[i];
+		const uint32_t interval_us = get_interval_us(i);
+		const float limit = (interval_us > 0) ? 1e6f / interval_us : 0.f;
+		const double serialize_time_mean = (s.num_sent > 0) ? (double)s.serialize_time_total / s.num_sent : 0.;
+
+		PX4_INFO_RAW("%-32s %10.1f %10.1f %10.0f %14.2f %14" PRIu32 "\n", topic_name(i), (double)limit,
+			     (double)s.message_rate, (double)s.byte_rate, serialize_time_mean, s.serialize_time_max);
+	}
 }
 
 static void on_topic_update(uxrSession* session, uxrObjectId object_id,
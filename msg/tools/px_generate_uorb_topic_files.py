@@ -90,6 +90,7 @@ TOPICS_TOKEN = '# TOPICS '
 IDL_TEMPLATE_FILE = 'msg.idl.em'
 
 CONSTRAINED_FLASH = False
+FIELD_DESCRIPTORS = False
 
 
 class MsgScope:
@@ -170,7 +171,8 @@ def generate_output_from_file(format_idx, filename, outputdir, package, template
         "msg_context": msg_context,
         "spec": spec,
         "topics": topics,
-        "constrained_flash": CONSTRAINED_FLASH
+        "constrained_flash": CONSTRAINED_FLASH,
+        "field_descriptors": FIELD_DESCRIPTORS
     }
 
     # Make sure output directory exists:
@@ -525,12 +527,15 @@ if __name__ == "__main__":
                         ' name when converting directories')
     parser.add_argument('--constrained-flash', dest='constrained_flash', default=False, action='store_true',
                         help='set to save flash space')
+    parser.add_argument('--field-descriptors', dest='field_descriptors', default=False, action='store_true',
+                        help='generate the precompiled field descriptors')
     args = parser.parse_args()
 
     if args.include_paths:
         append_to_include_path(args.include_paths, INCL_DEFAULT, args.package)
 
     CONSTRAINED_FLASH = args.constrained_flash
+    FIELD_DESCRIPTORS = args.field_descriptors
 
     if args.headers:
         generate_idx = 0
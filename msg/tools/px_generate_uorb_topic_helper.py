@@ -241,6 +241,54 @@ def convert_type(spec_type, use_short_type=False):
     return c_type
 
 
+def get_field_descriptors(fields):
+    """
+    Get the field descriptors (struct orb_field_descriptor) matching the o_fields
+    string of a list of sorted and padded fields.
+    returns a list of tuples (field name, count, name index, name length, type,
+    hint, nested type name or None)
+    """
+    descriptors = []
+    format_idx = 0
+    for field in fields:
+        field_format = convert_type(field.type, True)
+        # the short types are escaped, e.g. '\\x8a[3]', count the resulting characters
+        type_length = len(field_format.encode('ascii').decode('unicode_escape'))
+        name_idx = format_idx + type_length + 1
+        format_idx = name_idx + len(field.name) + 1
+
+        count = field.array_len if field.is_array else 1
+        bare_type = bare_name(field.type)
+        nested = None
+        hint = 'ORB_FIELD_HINT_NONE'
+
+        if bare_type in type_map_short:
+            c_type = type_map[bare_type]
+            field_type = 'ORB_FIELD_TYPE_' + c_type.replace('_t', '').upper()
+            if field.name.startswith('_padding'):
+                hint = 'ORB_FIELD_HINT_PADDING'
+            elif count == 1:
+                if c_type == 'uint64_t' and field.name == 'timestamp':
+                    hint = 'ORB_FIELD_HINT_TIMESTAMP'
+                elif c_type == 'uint64_t' and field.name == 'timestamp_sample':
+                    hint = 'ORB_FIELD_HINT_TIMESTAMP_SAMPLE'
+                elif 'flags' in field.name:
+                    if c_type in ['uint8_t', 'uint16_t', 'uint32_t']:
+                        hint = 'ORB_FIELD_HINT_BITFIELD'
+                elif c_type == 'uint32_t' and 'device_id' in field.name:
+                    hint = 'ORB_FIELD_HINT_DEVICE_ID'
+            elif count == 4 and c_type == 'float' and (field.name == 'q' or field.name.startswith('q_')):
+                hint = 'ORB_FIELD_HINT_QUATERNION'
+        else:
+            field_type = 'ORB_FIELD_TYPE_NESTED'
+            nested = bare_type
+
+        assert len(field.name) <= 255, "%r field name too long" % field.name
+        descriptors.append((field.name, count, name_idx, len(field.name), field_type, hint, nested))
+    assert format_idx <= 65535, "o_fields too long"
+    return descriptors
+
+
 def print_field_def(field):
     """
     Print the C type from a field
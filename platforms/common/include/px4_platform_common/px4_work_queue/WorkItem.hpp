@@ -134,6 +134,11 @@ private:
 
 	WorkQueue	*_wq{nullptr};
 
+#if defined(ENABLE_LOCKSTEP_SCHEDULER)
+	friend class WorkQueue;
+	uint32_t	_lockstep_step{0}; ///< parallel lockstep: step the item was queued in, 0 if not queued
+#endif // ENABLE_LOCKSTEP_SCHEDULER
+
 };
 
 } // namespace px4
@@ -71,6 +71,15 @@ public:
 
 	void request_stop() { _should_exit.store(true); }
 
+	/**
+	 * Pin the work queue thread to a CPU (Linux only). The affinity is applied
+	 * by the work queue thread itself on its next wakeup.
+	 *
+	 * @param cpu CPU index, or -1 to allow all CPUs
+	 * @return false if CPU affinity isn't supported on this platform
+	 */
+	bool SetCpuAffinity(int cpu);
+
 	void print_status(bool last = false);
 
 	// WorkQueues sorted numerically by relative priority (-1 to -255)
@@ -82,6 +91,13 @@ private:
 
 	inline void SignalWorkerThread();
 
+	void UpdateCpuAffinity();
+
+#if defined(ENABLE_LOCKSTEP_SCHEDULER)
+	void RunLockstepStep();
+	WorkItem *NextLockstepItem(uint32_t step);
+#endif // ENABLE_LOCKSTEP_SCHEDULER
+
 #ifdef __PX4_NUTTX
 	// In NuttX work can be enqueued from an ISR
 	void work_lock() { _flags = enter_critical_section(); }
@@ -101,8 +117,12 @@ private:
 	BlockingList<WorkItem *>	_work_items;
 	px4::atomic_bool		_should_exit{false};
 
+	px4::atomic_int			_cpu_affinity{-1};
+	px4::atomic_bool		_cpu_affinity_changed{false};
+
 #if defined(ENABLE_LOCKSTEP_SCHEDULER)
 	int _lockstep_component {-1};
+	int _lockstep_member {-1}; ///< parallel lockstep step member
 #endif // ENABLE_LOCKSTEP_SCHEDULER
 
 };
@@ -71,6 +71,8 @@ static constexpr wq_config_t INS0{"wq:INS0", 6000, -14};
 static constexpr wq_config_t INS1{"wq:INS1", 6000, -15};
 static constexpr wq_config_t INS2{"wq:INS2", 6000, -16};
 static constexpr wq_config_t INS3{"wq:INS3", 6000, -17};
+static constexpr wq_config_t INS4{"wq:INS4", 6000, -17}; // multi-EKF on POSIX only
+static constexpr wq_config_t INS5{"wq:INS5", 6000, -17}; // multi-EKF on POSIX only
 
 static constexpr wq_config_t hp_default{"wq:hp_default", 1900, -18};
 
@@ -0,0 +1,116 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file WorkQueueTrace.hpp
+ *
+ * Lightweight execution tracer for work queues and uORB publications (POSIX only).
+ *
+ * Events are recorded into a fixed size ring buffer while tracing is enabled
+ * and can be written out as Chrome trace JSON (chrome://tracing, Perfetto).
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <px4_platform_common/atomic.h>
+
+namespace px4
+{
+namespace wq_trace
+{
+
+enum class EventType : uint8_t {
+	Begin,   ///< work item Run() started
+	End,     ///< work item Run() finished
+	Publish, ///< uORB topic published
+};
+
+#if defined(__PX4_POSIX)
+
+extern px4::atomic_bool enabled;
+
+/**
+ * Record a trace event for the calling thread. Only call if enabled().
+ *
+ * @param type		event type
+ * @param name		work item or topic name (copied)
+ * @param instance	topic instance (publish events only)
+ */
+void record(EventType type, const char *name, uint8_t instance = 0);
+
+/**
+ * Name the calling thread's trace track (eg the work queue name).
+ * Threads that don't set a name are named from pthread_getname_np on their first event.
+ */
+void set_thread_name(const char *name);
+
+static inline bool is_enabled() { return enabled.load(); }
+
+#else
+
+static inline void record(EventType type, const char *name, uint8_t instance = 0) {}
+static inline void set_thread_name(const char *name) {}
+static inline bool is_enabled() { return false; }
+
+#endif // __PX4_POSIX
+
+} // namespace wq_trace
+
+/**
+ * Allocate the trace buffer and start recording.
+ *
+ * @param num_events	ring buffer capacity (rounded up to a power of 2)
+ */
+int WorkQueueTraceStart(unsigned num_events);
+
+/**
+ * Stop recording (the buffer is kept for dumping).
+ */
+int WorkQueueTraceStop();
+
+/**
+ * Write the recorded events as Chrome trace JSON.
+ *
+ * @param path		output file
+ */
+int WorkQueueTraceDump(const char *path);
+
+/**
+ * Print trace buffer status.
+ */
+int WorkQueueTraceStatus();
+
+} // namespace px4
@@ -33,9 +33,15 @@
 
 #include <px4_platform_common/px4_work_queue/WorkQueue.hpp>
 #include <px4_platform_common/px4_work_queue/WorkItem.hpp>
+#include <px4_platform_common/px4_work_queue/WorkQueueTrace.hpp>
 
 #include <string.h>
 
+#if defined(__PX4_LINUX)
+#include <sched.h>
+#include <unistd.h>
+#endif
+
 #include <px4_platform_common/tasks.h>
 #include <px4_platform_common/time.h>
 #include <drivers/drv_hrt.h>
@@ -62,6 +68,10 @@ WorkQueue::WorkQueue(const wq_config_t &config) :
 
 	px4_sem_init(&_exit_lock, 0, 1);
 	px4_sem_setprotocol(&_exit_lock, SEM_PRIO_NONE);
+
+#if defined(ENABLE_LOCKSTEP_SCHEDULER)
+	_lockstep_member = px4_lockstep_register_work_queue();
+#endif // ENABLE_LOCKSTEP_SCHEDULER
 }
 
 WorkQueue::~WorkQueue()
@@ -114,6 +124,12 @@ void WorkQueue::Detach(WorkItem *item)
 		exiting = true;
 		request_stop();
 		SignalWorkerThread();
+
+#if defined(ENABLE_LOCKSTEP_SCHEDULER)
+		// also wakes up the worker thread if it's waiting for the next step
+		px4_lockstep_unregister_work_queue(_lockstep_member);
+		_lockstep_member = -1;
+#endif // ENABLE_LOCKSTEP_SCHEDULER
 	}
 
 	work_unlock();
@@ -131,7 +147,15 @@ void WorkQueue::Add(WorkItem *item)
 
 #if defined(ENABLE_LOCKSTEP_SCHEDULER)
 
-	if (_lockstep_component == -1) {
+	if (_lockstep_member >= 0) {
+		// work queued during a step is only due in the next one
+		const uint32_t step = px4_lockstep_work_queue_add(_lockstep_member);
+
+		if (item->_lockstep_step == 0) {
+			item->_lockstep_step = step;
+		}
+
+	} else if (_lockstep_component == -1) {
 		_lockstep_component = px4_lockstep_register_component();
 	}
 
@@ -156,6 +180,9 @@ void WorkQueue::Remove(WorkItem *item)
 {
 	work_lock();
 	_q.remove(item);
+#if defined(ENABLE_LOCKSTEP_SCHEDULER)
+	item->_lockstep_step = 0;
+#endif // ENABLE_LOCKSTEP_SCHEDULER
 	work_unlock();
 }
 
@@ -164,7 +191,11 @@ void WorkQueue::Clear()
 	work_lock();
 
 	while (!_q.empty()) {
+#if defined(ENABLE_LOCKSTEP_SCHEDULER)
+		_q.pop()->_lockstep_step = 0;
+#else
 		_q.pop();
+#endif // ENABLE_LOCKSTEP_SCHEDULER
 	}
 
 	work_unlock();
@@ -172,10 +203,25 @@ void WorkQueue::Clear()
 
 void WorkQueue::Run()
 {
+	wq_trace::set_thread_name(_config.name);
+
 	while (!should_exit()) {
 		// loop as the wait may be interrupted by a signal
 		do {} while (px4_sem_wait(&_process_lock) != 0);
 
+		if (_cpu_affinity_changed.load()) {
+			UpdateCpuAffinity();
+		}
+
+#if defined(ENABLE_LOCKSTEP_SCHEDULER)
+
+		if (_lockstep_member >= 0) {
+			RunLockstepStep();
+			continue;
+		}
+
+#endif // ENABLE_LOCKSTEP_SCHEDULER
+
 		work_lock();
 
 		// process queued work
@@ -184,7 +230,16 @@ void WorkQueue::Run()
 
 			work_unlock(); // unlock work queue to run (item may requeue itself)
 			work->RunPreamble();
-			work->Run();
+
+			if (wq_trace::is_enabled()) {
+				wq_trace::record(wq_trace::EventType::Begin, work->ItemName());
+				work->Run();
+				wq_trace::record(wq_trace::EventType::End, nullptr); // work might be deleted
+
+			} else {
+				work->Run();
+			}
+
 			// Note: after Run() we cannot access work anymore, as it might have been deleted
 			work_lock(); // re-lock
 		}
@@ -204,10 +259,103 @@ void WorkQueue::Run()
 	PX4_DEBUG("%s: exiting", _config.name);
 }
 
+#if defined(ENABLE_LOCKSTEP_SCHEDULER)
+void WorkQueue::RunLockstepStep()
+{
+	const int member = _lockstep_member;
+	const uint32_t step = px4_lockstep_work_queue_begin(member);
+
+	work_lock();
+
+	// run the due work in the (name sorted) order of the work items, independent of the order it was queued in
+	for (WorkItem *work = NextLockstepItem(step); work != nullptr; work = NextLockstepItem(step)) {
+		_q.remove(work);
+		work->_lockstep_step = 0;
+
+		work_unlock(); // unlock work queue to run (item may requeue itself)
+		work->RunPreamble();
+
+		if (wq_trace::is_enabled()) {
+			wq_trace::record(wq_trace::EventType::Begin, work->ItemName());
+			work->Run();
+			wq_trace::record(wq_trace::EventType::End, nullptr); // work might be deleted
+
+		} else {
+			work->Run();
+		}
+
+		// Note: after Run() we cannot access work anymore, as it might have been deleted
+		work_lock(); // re-lock
+	}
+
+	work_unlock();
+
+	px4_lockstep_work_queue_end(member);
+}
+
+WorkItem *WorkQueue::NextLockstepItem(uint32_t step)
+{
+	for (WorkItem *item : _work_items) {
+		if ((item->_lockstep_step != 0) && (item->_lockstep_step < step)) {
+			return item;
+		}
+	}
+
+	return nullptr;
+}
+#endif // ENABLE_LOCKSTEP_SCHEDULER
+
+bool WorkQueue::SetCpuAffinity(int cpu)
+{
+#if defined(__PX4_LINUX)
+	_cpu_affinity.store(cpu);
+	_cpu_affinity_changed.store(true);
+	SignalWorkerThread();
+	return true;
+#else
+	(void)cpu;
+	return false;
+#endif
+}
+
+void WorkQueue::UpdateCpuAffinity()
+{
+	_cpu_affinity_changed.store(false);
+
+#if defined(__PX4_LINUX)
+	const int cpu = _cpu_affinity.load();
+	const int num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+	cpu_set_t cpuset;
+	CPU_ZERO(&cpuset);
+
+	for (int i = 0; i < num_cpus; i++) {
+		if ((cpu < 0) || (cpu == i)) {
+			CPU_SET(i, &cpuset);
+		}
+	}
+
+	int ret = pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+
+	if (ret != 0) {
+		PX4_ERR("%s: setting CPU affinity %d failed (%i)", _config.name, cpu, ret);
+	}
+
+#endif // __PX4_LINUX
+}
+
 void WorkQueue::print_status(bool last)
 {
 	const size_t num_items = _work_items.size();
-	PX4_INFO_RAW("%-16s\n", get_name());
+	const int cpu = _cpu_affinity.load();
+
+	if (cpu >= 0) {
+		PX4_INFO_RAW("%-16s (CPU %d)\n", get_name(), cpu);
+
+	} else {
+		PX4_INFO_RAW("%-16s\n", get_name());
+	}
+
 	unsigned i = 0;
 
 	for (WorkItem *item : _work_items) {
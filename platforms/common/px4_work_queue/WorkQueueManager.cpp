@@ -217,6 +217,10 @@ const wq_config_t &ins_instance_to_wq(uint8_t instance)
 	case 2: return wq_configurations::INS2;
 
 	case 3: return wq_configurations::INS3;
+
+	case 4: return wq_configurations::INS4;
+
+	case 5: return wq_configurations::INS5;
 	}
 
 	PX4_WARN("no INS%d wq configuration, using INS0", instance);
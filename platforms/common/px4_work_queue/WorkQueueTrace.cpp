@@ -0,0 +1,280 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+#include <px4_platform_common/px4_work_queue/WorkQueueTrace.hpp>
+
+#include <px4_platform_common/log.h>
+#include <px4_platform_common/posix.h>
+#include <px4_platform_common/time.h>
+#include <drivers/drv_hrt.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__PX4_POSIX)
+#include <pthread.h>
+#endif // __PX4_POSIX
+
+namespace px4
+{
+
+#if defined(__PX4_POSIX)
+
+namespace wq_trace
+{
+
+static constexpr int MAX_TRACKS = 64;
+static constexpr size_t NAME_LEN = 24;
+
+struct Event {
+	hrt_abstime timestamp;
+	char name[NAME_LEN];
+	EventType type;
+	uint8_t track;
+	uint8_t instance;
+};
+
+px4::atomic_bool enabled{false};
+
+static Event *_events{nullptr};
+static uint32_t _capacity{0};
+static px4::atomic<uint32_t> _head{0};
+static px4::atomic_int _writers{0}; // events being written
+
+static char _track_names[MAX_TRACKS][NAME_LEN] {};
+static px4::atomic_int _num_tracks{0};
+
+static thread_local const char *_thread_name{nullptr};
+static thread_local int _track{-1};
+
+void set_thread_name(const char *name)
+{
+	_thread_name = name;
+}
+
+static int register_track()
+{
+	const int track = _num_tracks.fetch_add(1);
+
+	if (track >= MAX_TRACKS) {
+		return MAX_TRACKS - 1; // share the last track
+	}
+
+	if (_thread_name) {
+		strncpy(_track_names[track], _thread_name, NAME_LEN - 1);
+
+	} else {
+		pthread_getname_np(pthread_self(), _track_names[track], NAME_LEN);
+	}
+
+	return track;
+}
+
+void record(EventType type, const char *name, uint8_t instance)
+{
+	if (_events == nullptr) {
+		return;
+	}
+
+	// the caller checked enabled, check again once counted as writer (dump waits for the writers)
+	_writers.fetch_add(1);
+
+	if (!enabled.load()) {
+		_writers.fetch_sub(1);
+		return;
+	}
+
+	if (_track < 0) {
+		_track = register_track();
+	}
+
+	// claim a slot, older events are overwritten once the buffer is full
+	const uint32_t index = _head.fetch_add(1) & (_capacity - 1);
+	Event &event = _events[index];
+
+	event.timestamp = hrt_absolute_time();
+	strncpy(event.name, name ? name : "", NAME_LEN - 1);
+	event.name[NAME_LEN - 1] = '\0';
+	event.type = type;
+	event.track = _track;
+	event.instance = instance;
+
+	_writers.fetch_sub(1);
+}
+
+} // namespace wq_trace
+
+int WorkQueueTraceStart(unsigned num_events)
+{
+	using namespace wq_trace;
+
+	if (_events == nullptr) {
+		uint32_t capacity = 1;
+
+		while (capacity < num_events) {
+			capacity <<= 1;
+		}
+
+		_events = new Event[capacity] {};
+
+		if (_events == nullptr) {
+			PX4_ERR("trace buffer alloc failed");
+			return PX4_ERROR;
+		}
+
+		_capacity = capacity;
+
+	} else if (num_events > _capacity) {
+		// the buffer is never freed or resized, writers may still hold a reference
+		PX4_WARN("trace buffer already allocated (%u events)", (unsigned)_capacity);
+	}
+
+	_head.store(0);
+	enabled.store(true);
+
+	return PX4_OK;
+}
+
+int WorkQueueTraceStop()
+{
+	wq_trace::enabled.store(false);
+	return PX4_OK;
+}
+
+int WorkQueueTraceDump(const char *path)
+{
+	using namespace wq_trace;
+
+	if (_events == nullptr) {
+		PX4_ERR("trace not started");
+		return PX4_ERROR;
+	}
+
+	FILE *fp = fopen(path, "w");
+
+	if (fp == nullptr) {
+		PX4_ERR("failed to open %s", path);
+		return PX4_ERROR;
+	}
+
+	// pause recording and wait for in-flight writers to finish
+	const bool was_enabled = enabled.load();
+	enabled.store(false);
+
+	while (_writers.load() > 0) {
+		px4_usleep(100);
+	}
+
+	const uint32_t head = _head.load();
+	const uint32_t count = (head < _capacity) ? head : _capacity;
+	const int num_tracks = (_num_tracks.load() < MAX_TRACKS) ? _num_tracks.load() : MAX_TRACKS;
+
+	fprintf(fp, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+
+	for (int i = 0; i < num_tracks; i++) {
+		fprintf(fp, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}},\n",
+			i, _track_names[i]);
+	}
+
+	// an End without its Begin (overwritten) would confuse the viewer
+	bool open[MAX_TRACKS] {};
+
+	for (uint32_t i = head - count; i != head; i++) {
+		const Event &event = _events[i & (_capacity - 1)];
+
+		switch (event.type) {
+		case EventType::Begin:
+			open[event.track] = true;
+			fprintf(fp, "{\"name\":\"%s\",\"cat\":\"wq\",\"ph\":\"B\",\"ts\":%" PRIu64 ",\"pid\":1,\"tid\":%d},\n",
+				event.name, event.timestamp, event.track);
+			break;
+
+		case EventType::End:
+			if (open[event.track]) {
+				open[event.track] = false;
+				fprintf(fp, "{\"ph\":\"E\",\"ts\":%" PRIu64 ",\"pid\":1,\"tid\":%d},\n",
+					event.timestamp, event.track);
+			}
+
+			break;
+
+		case EventType::Publish:
+			fprintf(fp, "{\"name\":\"%s\",\"cat\":\"uorb\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%" PRIu64
+				",\"pid\":1,\"tid\":%d,\"args\":{\"instance\":%d}},\n",
+				event.name, event.timestamp, event.track, event.instance);
+			break;
+		}
+	}
+
+	// trailing metadata entry avoids a dangling comma
+	fprintf(fp, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"px4\"}}\n]}\n");
+	fclose(fp);
+
+	PX4_INFO("wrote %" PRIu32 " events (%d threads) to %s", count, num_tracks, path);
+
+	if (head > _capacity) {
+		PX4_INFO("%" PRIu32 " older events overwritten", head - _capacity);
+	}
+
+	enabled.store(was_enabled);
+
+	return PX4_OK;
+}
+
+int WorkQueueTraceStatus()
+{
+	using namespace wq_trace;
+
+	PX4_INFO("trace %s, buffer: %" PRIu32 " events, recorded: %" PRIu32 ", threads: %d",
+		 enabled.load() ? "running" : "stopped", _capacity, _head.load(), _num_tracks.load());
+
+	return PX4_OK;
+}
+
+#else
+
+int WorkQueueTraceStart(unsigned num_events)
+{
+	PX4_ERR("tracing not supported");
+	return PX4_ERROR;
+}
+
+int WorkQueueTraceStop() { return PX4_ERROR; }
+int WorkQueueTraceDump(const char *path) { return PX4_ERROR; }
+int WorkQueueTraceStatus() { return PX4_ERROR; }
+
+#endif // __PX4_POSIX
+
+} // namespace px4
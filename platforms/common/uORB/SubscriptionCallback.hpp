@@ -40,8 +40,13 @@
 
 #include <uORB/SubscriptionInterval.hpp>
 #include <containers/List.hpp>
+#include <px4_platform_common/atomic.h>
+#include <px4_platform_common/log.h>
 #include <px4_platform_common/px4_work_queue/WorkItem.hpp>
 
+#include <float.h>
+#include <math.h>
+
 namespace uORB
 {
 
@@ -135,10 +140,83 @@ public:
 
 	bool registered() const { return _registered; }
 
+	/**
+	 * Only dispatch every n-th publication to call(). Skipped publications don't call call() at all.
+	 *
+	 * @param decimation Number of publications per callback (1: every publication).
+	 * @param average Pass every publication to accumulate(), e.g. to average the skipped samples.
+	 */
+	void set_callback_decimation(uint16_t decimation, bool average = false)
+	{
+		_callback_decimation = math::max(decimation, (uint16_t)1);
+		_callback_average = average;
+	}
+
+	/**
+	 * Limit the callbacks to at most one every interval_us. Publications in between don't call call() at all.
+	 *
+	 * @param interval_us The minimum interval between callbacks in microseconds (0: no limit).
+	 */
+	void set_callback_interval_us(uint32_t interval_us) { _callback_interval_us = interval_us; }
+
+	uint16_t get_callback_decimation() const { return _callback_decimation; }
+	uint32_t get_callback_interval_us() const { return _callback_interval_us; }
+
+	/**
+	 * Called by the DeviceNode for every publication, with the node locked.
+	 *
+	 * @param data The published message.
+	 * @return true if call() needs to be called
+	 */
+	bool dispatch(const void *data)
+	{
+		if (_callback_samples < UINT16_MAX) {
+			_callback_samples++;
+		}
+
+		bool dispatch = (_callback_samples >= _callback_decimation);
+
+		if (dispatch && (_callback_interval_us > 0)) {
+			const hrt_abstime now = hrt_absolute_time();
+
+			if (now - _last_callback >= _callback_interval_us) {
+				// shift last callback time forward, but don't let it get further behind than the interval
+				_last_callback = math::constrain(_last_callback + _callback_interval_us, now - _callback_interval_us, now);
+
+			} else {
+				dispatch = false;
+			}
+		}
+
+		if (_callback_average) {
+			accumulate(data, dispatch);
+		}
+
+		if (dispatch) {
+			_callback_samples = 0;
+		}
+
+		return dispatch;
+	}
+
 protected:
 
+	/**
+	 * Called for every publication if averaging is enabled (with the node locked, possibly from interrupt context).
+	 *
+	 * @param data The published message.
+	 * @param dispatch true if call() is called for this publication
+	 */
+	virtual void accumulate(const void *data, bool dispatch) {}
+
 	bool _registered{false};
 
+	bool _callback_average{false};
+	uint16_t _callback_decimation{1};
+	uint16_t _callback_samples{0};		///< publications since the last callback
+	uint32_t _callback_interval_us{0};
+	hrt_abstime _last_callback{0};
+
 };
 
 // Subscription with callback that schedules a WorkItem
@@ -188,4 +266,185 @@ private:
 	uint8_t _required_updates{0};
 };
 
+// Subscription with callback that schedules a WorkItem with the average of the decimated publications
+template<typename T>
+class SubscriptionCallbackWorkItemAverage : public SubscriptionCallbackWorkItem
+{
+public:
+	/**
+	 * Constructor
+	 *
+	 * @param work_item The WorkItem that will be scheduled for every decimation-th publication.
+	 * @param meta The uORB metadata (usually from the ORB_ID() macro) for the topic.
+	 * @param decimation Number of publications to average.
+	 * @param instance The instance for multi sub.
+	 */
+	SubscriptionCallbackWorkItemAverage(px4::WorkItem *work_item, const orb_metadata *meta, uint16_t decimation,
+					    uint8_t instance = 0) :
+		SubscriptionCallbackWorkItem(work_item, meta, instance)
+	{
+		// the float fields are looked up once, the accumulation runs with the node locked
+		if (!add_float_fields(meta, 0)) {
+			PX4_ERR("%s: averaging not supported, using the latest publication", meta->o_name);
+			_num_float_fields = 0;
+		}
+
+		set_callback_decimation(decimation, true);
+	}
+
+	virtual ~SubscriptionCallbackWorkItemAverage() = default;
+
+	/**
+	 * Copy the average of the publications up to the last callback, if there is a new one.
+	 * Float fields are averaged (and quaternions normalized), all other fields are from the latest publication.
+	 * Without averaging support (see averaging()) this is the latest publication.
+	 *
+	 * @param dst The destination the average is copied to.
+	 * @return true only if there was a new average.
+	 */
+	bool update_average(T &dst)
+	{
+		unsigned sequence;
+
+		do {
+			sequence = _sequence.load();
+
+			if (sequence == _read_sequence) {
+				return false;
+			}
+
+			dst = _average;
+
+			// the copy needs to complete before the sequence is checked again
+			__atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+			// retry if the average was written meanwhile (odd sequence while writing)
+		} while ((sequence & 1) || (sequence != _sequence.load()));
+
+		_read_sequence = sequence;
+		return true;
+	}
+
+	/**
+	 * @return false if the float fields of the topic are unknown (without CONFIG_BOARD_UORB_FIELD_DESCRIPTORS)
+	 */
+	bool averaging() const { return _num_float_fields > 0; }
+
+protected:
+	void accumulate(const void *data, bool dispatch) override
+	{
+		const T &sample = *static_cast<const T *>(data);
+		const float *values = reinterpret_cast<const float *>(&sample);
+
+		for (unsigned i = 0; i < _num_float_fields; i++) {
+			const FloatField &field = _float_fields[i];
+
+			for (unsigned k = field.index; k < field.index + field.count; k++) {
+				_sum[k] += values[k];
+			}
+		}
+
+		_num_samples++;
+
+		if (!dispatch) {
+			return;
+		}
+
+		_sequence.fetch_add(1);
+		_average = sample;
+
+		float *average = reinterpret_cast<float *>(&_average);
+
+		for (unsigned i = 0; i < _num_float_fields; i++) {
+			const FloatField &field = _float_fields[i];
+			float norm_sq = 0.f;
+
+			for (unsigned k = field.index; k < field.index + field.count; k++) {
+				average[k] = _sum[k] / _num_samples;
+				norm_sq += average[k] * average[k];
+				_sum[k] = 0.f;
+			}
+
+			if (field.quaternion && (norm_sq > FLT_EPSILON)) {
+				const float norm = sqrtf(norm_sq);
+
+				for (unsigned k = field.index; k < field.index + field.count; k++) {
+					average[k] /= norm;
+				}
+			}
+		}
+
+		_sequence.fetch_add(1);
+
+		_num_samples = 0;
+	}
+
+private:
+	static constexpr unsigned MAX_FLOAT_FIELDS = 32;
+
+	struct FloatField {
+		uint16_t index;		///< index of the first float in the message
+		uint8_t count;
+		bool quaternion;
+	};
+
+	/**
+	 * Add the float fields of a (nested) message at offset to the list of averaged fields.
+	 * @return false if the fields are unknown or there are too many
+	 */
+	bool add_float_fields(const orb_metadata *meta, unsigned offset)
+	{
+		if ((meta == nullptr) || (meta->o_field_descriptors == nullptr)) {
+			return false;
+		}
+
+		for (unsigned f = 0; f < meta->o_num_fields; f++) {
+			const orb_field_descriptor &field = meta->o_field_descriptors[f];
+
+			if (field.type == ORB_FIELD_TYPE_NESTED) {
+				const orb_metadata *nested = get_orb_meta(static_cast<ORB_ID>(field.nested_id));
+
+				for (unsigned i = 0; i < field.count; i++) {
+					if (!nested || !add_float_fields(nested, offset + field.offset + i * nested->o_size)) {
+						return false;
+					}
+				}
+
+			} else if (field.type == ORB_FIELD_TYPE_FLOAT) {
+				const unsigned index = (offset + field.offset) / sizeof(float);
+				const bool quaternion = (field.hint == ORB_FIELD_HINT_QUATERNION);
+
+				// extend the previous field if it's adjacent
+				if ((_num_float_fields > 0) && !quaternion) {
+					FloatField &last = _float_fields[_num_float_fields - 1];
+
+					if (!last.quaternion && (last.index + last.count == index) && (last.count + field.count <= UINT8_MAX)) {
+						last.count += field.count;
+						continue;
+					}
+				}
+
+				if ((_num_float_fields >= MAX_FLOAT_FIELDS) || (field.count > UINT8_MAX)
+				    || (offset + field.offset + field.count * sizeof(float) > sizeof(T))) {
+					return false;
+				}
+
+				_float_fields[_num_float_fields++] = FloatField{(uint16_t)index, (uint8_t)field.count, quaternion};
+			}
+		}
+
+		return true;
+	}
+
+	T _average{};
+	float _sum[sizeof(T) / sizeof(float)] {};
+	uint16_t _num_samples{0};
+
+	FloatField _float_fields[MAX_FLOAT_FIELDS] {};
+	unsigned _num_float_fields{0};
+
+	px4::atomic<unsigned> _sequence{0};
+	unsigned _read_sequence{0};
+};
+
 } // namespace uORB
@@ -198,297 +198,406 @@ const char *orb_get_c_type(unsigned char short_type)
 {
 	// this matches with the uorb o_fields generator
 	switch (short_type) {
-	case 0x82: return "int8_t";
+	case ORB_FIELD_TYPE_INT8: return "int8_t";
 
-	case 0x83: return "int16_t";
+	case ORB_FIELD_TYPE_INT16: return "int16_t";
 
-	case 0x84: return "int32_t";
+	case ORB_FIELD_TYPE_INT32: return "int32_t";
 
-	case 0x85: return "int64_t";
+	case ORB_FIELD_TYPE_INT64: return "int64_t";
 
-	case 0x86: return "uint8_t";
+	case ORB_FIELD_TYPE_UINT8: return "uint8_t";
 
-	case 0x87: return "uint16_t";
+	case ORB_FIELD_TYPE_UINT16: return "uint16_t";
 
-	case 0x88: return "uint32_t";
+	case ORB_FIELD_TYPE_UINT32: return "uint32_t";
 
-	case 0x89: return "uint64_t";
+	case ORB_FIELD_TYPE_UINT64: return "uint64_t";
 
-	case 0x8a: return "float";
+	case ORB_FIELD_TYPE_FLOAT: return "float";
 
-	case 0x8b: return "double";
+	case ORB_FIELD_TYPE_DOUBLE: return "double";
 
-	case 0x8c: return "bool";
+	case ORB_FIELD_TYPE_BOOL: return "bool";
 
-	case 0x8d: return "char";
+	case ORB_FIELD_TYPE_CHAR: return "char";
 	}
 
 	return nullptr;
 }
 
-
-void orb_print_message_internal(const orb_metadata *meta, const void *data, bool print_topic_name)
+static unsigned orb_get_type_size(unsigned char short_type)
 {
-	if (print_topic_name) {
-		PX4_INFO_RAW(" %s\n", meta->o_name);
+	switch (short_type) {
+	case ORB_FIELD_TYPE_INT8:
+	case ORB_FIELD_TYPE_UINT8:
+	case ORB_FIELD_TYPE_BOOL:
+	case ORB_FIELD_TYPE_CHAR:
+		return 1;
+
+	case ORB_FIELD_TYPE_INT16:
+	case ORB_FIELD_TYPE_UINT16:
+		return 2;
+
+	case ORB_FIELD_TYPE_INT32:
+	case ORB_FIELD_TYPE_UINT32:
+	case ORB_FIELD_TYPE_FLOAT:
+		return 4;
+
+	case ORB_FIELD_TYPE_INT64:
+	case ORB_FIELD_TYPE_UINT64:
+	case ORB_FIELD_TYPE_DOUBLE:
+		return 8;
 	}
 
-	const hrt_abstime now = hrt_absolute_time();
-	hrt_abstime topic_timestamp = 0;
+	return 0;
+}
 
-	const uint8_t *data_ptr = (const uint8_t *)data;
-	int data_offset = 0;
+// this matches with the hints of the uorb field descriptor generator
+static uint8_t orb_get_field_hint(const char *name, int name_length, uint8_t type, int count)
+{
+	if (name_length >= 8 && strncmp(name, "_padding", 8) == 0) {
+		return ORB_FIELD_HINT_PADDING;
+	}
 
-	for (int format_idx = 0; meta->o_fields[format_idx] != 0;) {
-		const char *end_field = strchr(meta->o_fields + format_idx, ';');
+	char field_name[80];
 
-		if (!end_field) {
-			PX4_ERR("Format error in %s", meta->o_fields);
-			return;
-		}
+	if (name_length >= (int)sizeof(field_name)) {
+		return ORB_FIELD_HINT_NONE;
+	}
 
-		const char *c_type = orb_get_c_type(meta->o_fields[format_idx]);
-		const int end_field_idx = end_field - meta->o_fields;
+	memcpy(field_name, name, name_length);
+	field_name[name_length] = '\0';
 
-		int array_idx = -1;
-		int field_name_idx = -1;
+	if (count == 1) {
+		if (type == ORB_FIELD_TYPE_UINT64 && strcmp(field_name, "timestamp") == 0) {
+			return ORB_FIELD_HINT_TIMESTAMP;
 
-		for (int field_idx = format_idx; field_idx != end_field_idx; ++field_idx) {
-			if (meta->o_fields[field_idx] == '[') {
-				array_idx = field_idx + 1;
+		} else if (type == ORB_FIELD_TYPE_UINT64 && strcmp(field_name, "timestamp_sample") == 0) {
+			return ORB_FIELD_HINT_TIMESTAMP_SAMPLE;
 
-			} else if (meta->o_fields[field_idx] == ' ') {
-				field_name_idx = field_idx + 1;
-				break;
+		} else if (strstr(field_name, "flags") != nullptr) {
+			if (type == ORB_FIELD_TYPE_UINT8 || type == ORB_FIELD_TYPE_UINT16 || type == ORB_FIELD_TYPE_UINT32) {
+				return ORB_FIELD_HINT_BITFIELD;
 			}
+
+		} else if (type == ORB_FIELD_TYPE_UINT32 && strstr(field_name, "device_id") != nullptr) {
+			return ORB_FIELD_HINT_DEVICE_ID;
 		}
 
-		int array_size = 1;
+	} else if (count == 4 && type == ORB_FIELD_TYPE_FLOAT
+		   && (strcmp(field_name, "q") == 0 || strncmp(field_name, "q_", 2) == 0)) {
+		return ORB_FIELD_HINT_QUATERNION;
+	}
 
-		if (array_idx >= 0) {
-			array_size = strtol(meta->o_fields + array_idx, nullptr, 10);
-		}
+	return ORB_FIELD_HINT_NONE;
+}
 
-		char field_name[80];
-		size_t field_name_len = end_field_idx - field_name_idx;
+void orb_field_iterator_init(orb_field_iterator *it, const orb_metadata *meta)
+{
+	it->meta = meta;
+	it->index = 0;
+	it->format_idx = 0;
+	it->offset = 0;
+}
+
+bool orb_next_field(orb_field_iterator *it, orb_field_descriptor *field)
+{
+	const orb_metadata *meta = it->meta;
 
-		if (field_name_len >= sizeof(field_name)) {
-			PX4_ERR("field name too long %s (max: %u)", meta->o_fields, (unsigned)sizeof(field_name));
-			return;
+	if (meta->o_field_descriptors) {
+		if (it->index >= meta->o_num_fields) {
+			return false;
 		}
 
-		memcpy(field_name, meta->o_fields + field_name_idx, field_name_len);
-		field_name[field_name_len] = '\0';
+		*field = meta->o_field_descriptors[it->index++];
+		return true;
+	}
 
-		if (c_type) { // built-in type
-			bool dont_print = false;
+	// no precompiled descriptors: parse o_fields, which looks like this: "<chr> timestamp;<chr>[5] array;"
+	const int format_idx = it->format_idx;
 
-			// handle special cases
-			if (strncmp(field_name, "_padding", 8) == 0) {
-				dont_print = true;
+	if (meta->o_fields[format_idx] == 0) {
+		return false;
+	}
 
-			} else if (strcmp(c_type, "char") == 0 && array_size > 1) { // string
-				PX4_INFO_RAW("    %s: \"%.*s\"\n", field_name, array_size, (char *)(data_ptr + data_offset));
-				dont_print = true;
-			}
+	const char *end_field = strchr(meta->o_fields + format_idx, ';');
 
-			if (!dont_print) {
-				PX4_INFO_RAW("    %s: ", field_name);
-			}
+	if (!end_field) {
+		PX4_ERR("Format error in %s", meta->o_fields);
+		return false;
+	}
 
-			if (!dont_print && array_size > 1) {
-				PX4_INFO_RAW("[");
-			}
+	const int end_field_idx = end_field - meta->o_fields;
 
-			const int previous_data_offset = data_offset;
+	int array_idx = -1;
+	int field_name_idx = -1;
 
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wcast-align" // the caller ensures data is aligned
+	for (int field_idx = format_idx; field_idx != end_field_idx; ++field_idx) {
+		if (meta->o_fields[field_idx] == '[') {
+			array_idx = field_idx + 1;
 
-			for (int i = 0; i < array_size; ++i) {
-				if (strcmp(c_type, "int8_t") == 0) {
-					if (!dont_print) { PX4_INFO_RAW("%" PRIi8, *(int8_t *)(data_ptr + data_offset)); }
+		} else if (meta->o_fields[field_idx] == ' ') {
+			field_name_idx = field_idx + 1;
+			break;
+		}
+	}
+
+	if (field_name_idx < 0 || end_field_idx - field_name_idx > UINT8_MAX) {
+		PX4_ERR("Format error in %s", meta->o_fields);
+		return false;
+	}
+
+	field->offset = it->offset;
+	field->count = (array_idx >= 0) ? strtol(meta->o_fields + array_idx, nullptr, 10) : 1;
+	field->name = field_name_idx;
+	field->name_length = end_field_idx - field_name_idx;
+
+	unsigned size = orb_get_type_size(meta->o_fields[format_idx]);
+
+	if (size > 0) {
+		field->type = meta->o_fields[format_idx];
+		field->nested_id = static_cast<uint8_t>(ORB_ID::INVALID);
+
+	} else {
+		// nested type: find the metadata by name
+		const int type_length = (array_idx >= 0 ? array_idx : field_name_idx) - 1 - format_idx;
+		const orb_metadata *const *topics = orb_get_topics();
+		const orb_metadata *found_topic = nullptr;
+
+		for (size_t i = 0; i < orb_topics_count(); i++) {
+			if (strncmp(topics[i]->o_name, meta->o_fields + format_idx, type_length) == 0
+			    && topics[i]->o_name[type_length] == '\0') {
+				found_topic = topics[i];
+				break;
+			}
+		}
 
-					data_offset += sizeof(int8_t);
+		field->type = ORB_FIELD_TYPE_NESTED;
 
-				} else if (strcmp(c_type, "int16_t") == 0) {
-					if (!dont_print) { PX4_INFO_RAW("%" PRIi16, *(int16_t *)(data_ptr + data_offset)); }
+		if (found_topic) {
+			field->nested_id = found_topic->o_id;
+			size = found_topic->o_size;
 
-					data_offset += sizeof(int16_t);
+		} else {
+			// returned anyway so that users can skip only this field, the following offsets are invalid
+			PX4_ERR("Topic %.*s did not match any known topics", type_length, meta->o_fields + format_idx);
+			field->nested_id = static_cast<uint8_t>(ORB_ID::INVALID);
+		}
+	}
 
-				} else if (strcmp(c_type, "int32_t") == 0) {
-					if (!dont_print) { PX4_INFO_RAW("%" PRIi32, *(int32_t *)(data_ptr + data_offset)); }
+	field->hint = orb_get_field_hint(meta->o_fields + field->name, field->name_length, field->type, field->count);
 
-					data_offset += sizeof(int32_t);
+	it->index++;
+	it->format_idx = end_field_idx + 1;
+	it->offset += size * field->count;
 
-				} else if (strcmp(c_type, "int64_t") == 0) {
-					if (!dont_print) { PX4_INFO_RAW("%" PRIi64, *(int64_t *)(data_ptr + data_offset)); }
+	return true;
+}
 
-					data_offset += sizeof(int64_t);
+int orb_get_field_format(const orb_metadata *meta, const orb_field_descriptor *field, char *buf, size_t buf_len)
+{
+	const char *type_name;
+
+	if (field->type == ORB_FIELD_TYPE_NESTED) {
+		const orb_metadata *nested = get_orb_meta(static_cast<ORB_ID>(field->nested_id));
 
-				} else if (strcmp(c_type, "uint8_t") == 0) {
-					if (!dont_print) { PX4_INFO_RAW("%" PRIu8, *(uint8_t *)(data_ptr + data_offset)); }
+		if (!nested) {
+			// unknown nested topic: the field as it is in o_fields
+			int field_start = field->name - 1;
 
-					data_offset += sizeof(uint8_t);
+			while (field_start > 0 && meta->o_fields[field_start - 1] != ';') {
+				--field_start;
+			}
 
-				} else if (strcmp(c_type, "uint16_t") == 0) {
-					if (!dont_print) { PX4_INFO_RAW("%" PRIu16, *(uint16_t *)(data_ptr + data_offset)); }
+			return snprintf(buf, buf_len, "%.*s;", (int)(field->name + field->name_length - field_start),
+					meta->o_fields + field_start);
+		}
 
-					data_offset += sizeof(uint16_t);
+		type_name = nested->o_name;
 
-				} else if (strcmp(c_type, "uint32_t") == 0) {
-					if (!dont_print) { PX4_INFO_RAW("%" PRIu32, *(uint32_t *)(data_ptr + data_offset)); }
+	} else {
+		type_name = orb_get_c_type(field->type);
 
-					data_offset += sizeof(uint32_t);
+		if (!type_name) {
+			return -1;
+		}
+	}
 
-				} else if (strcmp(c_type, "uint64_t") == 0) {
-					if (!dont_print) { PX4_INFO_RAW("%" PRIu64, *(uint64_t *)(data_ptr + data_offset)); }
+	// arrays can also have a single element, so check o_fields: "<type>[<count>] <name>;"
+	if (field->name >= 2 && meta->o_fields[field->name - 2] == ']') {
+		return snprintf(buf, buf_len, "%s[%u] %.*s;", type_name, (unsigned)field->count, (int)field->name_length,
+				meta->o_fields + field->name);
+	}
 
-					data_offset += sizeof(uint64_t);
+	return snprintf(buf, buf_len, "%s %.*s;", type_name, (int)field->name_length, meta->o_fields + field->name);
+}
 
-				} else if (strcmp(c_type, "float") == 0) {
-					if (!dont_print) { PX4_INFO_RAW("%.4f", (double) * (float *)(data_ptr + data_offset)); }
+void orb_print_message_internal(const orb_metadata *meta, const void *data, bool print_topic_name)
+{
+	if (print_topic_name) {
+		PX4_INFO_RAW(" %s\n", meta->o_name);
+	}
 
-					data_offset += sizeof(float);
+	const hrt_abstime now = hrt_absolute_time();
+	hrt_abstime topic_timestamp = 0;
 
-				} else if (strcmp(c_type, "double") == 0) {
-					if (!dont_print) { PX4_INFO_RAW("%.4f", *(double *)(data_ptr + data_offset)); }
+	const uint8_t *data_ptr = (const uint8_t *)data;
 
-					data_offset += sizeof(double);
+	orb_field_iterator it;
+	orb_field_iterator_init(&it, meta);
+	orb_field_descriptor field;
 
-				} else if (strcmp(c_type, "bool") == 0) {
-					if (!dont_print) { PX4_INFO_RAW("%s", *(bool *)(data_ptr + data_offset) ? "True" : "False"); }
+	while (orb_next_field(&it, &field)) {
+		const char *field_name = meta->o_fields + field.name;
+		const int field_name_len = field.name_length;
+		const uint8_t *field_ptr = data_ptr + field.offset;
+		const int array_size = field.count;
 
-					data_offset += sizeof(bool);
+		if (field.type == ORB_FIELD_TYPE_NESTED) {
+			const orb_metadata *nested = get_orb_meta(static_cast<ORB_ID>(field.nested_id));
 
-				} else if (strcmp(c_type, "char") == 0) {
-					if (!dont_print) { PX4_INFO_RAW("%i", (int) * (char *)(data_ptr + data_offset)); }
+			if (!nested) {
+				PX4_ERR("invalid nested topic in %s", meta->o_name);
+				return;
+			}
 
-					data_offset += sizeof(char);
+			// print recursively
+			for (int i = 0; i < array_size; ++i) {
+				PX4_INFO_RAW("  %.*s", field_name_len, field_name);
 
-				} else {
-					PX4_ERR("unknown type: %s", c_type);
-					return;
+				if (array_size > 1) {
+					PX4_INFO_RAW("[%i]", i);
 				}
 
-				if (!dont_print && i < array_size - 1) {
-					PX4_INFO_RAW(", ");
-				}
+				PX4_INFO_RAW(" (%s):\n", nested->o_name);
+				orb_print_message_internal(nested, field_ptr + i * nested->o_size, false);
 			}
 
-			if (!dont_print && array_size > 1) {
-				PX4_INFO_RAW("]");
-			}
+			continue;
+		}
 
-			// handle special cases
-			if (array_size == 1) {
-				if (strcmp(c_type, "uint64_t") == 0 && strcmp(field_name, "timestamp") == 0) {
-					topic_timestamp = *(uint64_t *)(data_ptr + previous_data_offset);
+		if (field.hint == ORB_FIELD_HINT_PADDING) {
+			continue;
+		}
 
-					if (topic_timestamp != 0) {
-						PX4_INFO_RAW(" (%.6f seconds ago)", (double)((now - topic_timestamp) / 1e6f));
-					}
+		if (field.type == ORB_FIELD_TYPE_CHAR && array_size > 1) { // string
+			PX4_INFO_RAW("    %.*s: \"%.*s\"\n", field_name_len, field_name, array_size, (const char *)field_ptr);
+			continue;
+		}
 
-				} else if (strcmp(c_type, "uint64_t") == 0 && strcmp(field_name, "timestamp_sample") == 0) {
-					hrt_abstime timestamp = *(uint64_t *)(data_ptr + previous_data_offset);
+		PX4_INFO_RAW("    %.*s: ", field_name_len, field_name);
 
-					if (topic_timestamp != 0 && timestamp != 0) {
-						PX4_INFO_RAW(" (%i us before timestamp)", (int)(topic_timestamp - timestamp));
-					}
+		if (array_size > 1) {
+			PX4_INFO_RAW("[");
+		}
 
-				} else if (strstr(field_name, "flags") != nullptr) {
-					// bitfield
-					unsigned field_size = 0;
-					unsigned long value = 0;
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wcast-align" // the caller ensures data is aligned
 
-					if (strcmp(c_type, "uint8_t") == 0) {
-						field_size = sizeof(uint8_t);
-						value = *(uint8_t *)(data_ptr + previous_data_offset);
+		for (int i = 0; i < array_size; ++i) {
+			switch (field.type) {
+			case ORB_FIELD_TYPE_INT8: PX4_INFO_RAW("%" PRIi8, ((const int8_t *)field_ptr)[i]); break;
 
-					} else if (strcmp(c_type, "uint16_t") == 0) {
-						field_size = sizeof(uint16_t);
-						value = *(uint16_t *)(data_ptr + previous_data_offset);
+			case ORB_FIELD_TYPE_INT16: PX4_INFO_RAW("%" PRIi16, ((const int16_t *)field_ptr)[i]); break;
 
-					} else if (strcmp(c_type, "uint32_t") == 0) {
-						field_size = sizeof(uint32_t);
-						value = *(uint32_t *)(data_ptr + previous_data_offset);
-					}
+			case ORB_FIELD_TYPE_INT32: PX4_INFO_RAW("%" PRIi32, ((const int32_t *)field_ptr)[i]); break;
 
-					if (field_size > 0) {
-						PX4_INFO_RAW(" (0b");
+			case ORB_FIELD_TYPE_INT64: PX4_INFO_RAW("%" PRIi64, ((const int64_t *)field_ptr)[i]); break;
 
-						for (int i = (field_size * 8) - 1; i >= 0; i--) {
-							PX4_INFO_RAW("%lu%s", (value >> i) & 1, ((unsigned)i < (field_size * 8) - 1 && i % 4 == 0 && i > 0) ? "'" : "");
-						}
+			case ORB_FIELD_TYPE_UINT8: PX4_INFO_RAW("%" PRIu8, ((const uint8_t *)field_ptr)[i]); break;
 
-						PX4_INFO_RAW(")");
-					}
+			case ORB_FIELD_TYPE_UINT16: PX4_INFO_RAW("%" PRIu16, ((const uint16_t *)field_ptr)[i]); break;
 
-				} else if (strcmp(c_type, "uint32_t") == 0 && strstr(field_name, "device_id") != nullptr) {
-					// Device ID
-					uint32_t device_id = *(uint32_t *)(data_ptr + previous_data_offset);
-					char device_id_buffer[80];
-					device::Device::device_id_print_buffer(device_id_buffer, sizeof(device_id_buffer), device_id);
-					PX4_INFO_RAW(" (%s)", device_id_buffer);
-				}
+			case ORB_FIELD_TYPE_UINT32: PX4_INFO_RAW("%" PRIu32, ((const uint32_t *)field_ptr)[i]); break;
 
-			} else if (array_size == 4 && strcmp(c_type, "float") == 0 && (strcmp(field_name, "q") == 0
-					|| strncmp(field_name, "q_", 2) == 0)) {
-				// attitude
-				float *attitude = (float *)(data_ptr + previous_data_offset);
-				matrix::Eulerf euler{matrix::Quatf{attitude}};
-				PX4_INFO_RAW(" (Roll: %.1f deg, Pitch: %.1f deg, Yaw: %.1f deg)",
-					     (double)math::degrees(euler(0)), (double)math::degrees(euler(1)), (double)math::degrees(euler(2)));
-			}
+			case ORB_FIELD_TYPE_UINT64: PX4_INFO_RAW("%" PRIu64, ((const uint64_t *)field_ptr)[i]); break;
 
-#pragma GCC diagnostic pop
+			case ORB_FIELD_TYPE_FLOAT: PX4_INFO_RAW("%.4f", (double)((const float *)field_ptr)[i]); break;
 
-			PX4_INFO_RAW("\n");
+			case ORB_FIELD_TYPE_DOUBLE: PX4_INFO_RAW("%.4f", ((const double *)field_ptr)[i]); break;
 
-		} else {
+			case ORB_FIELD_TYPE_BOOL: PX4_INFO_RAW("%s", ((const bool *)field_ptr)[i] ? "True" : "False"); break;
 
-			// extract the topic name
-			char topic_name[80];
-			const size_t topic_name_len = array_size > 1 ? array_idx - format_idx - 1 : field_name_idx - format_idx - 1;
+			case ORB_FIELD_TYPE_CHAR: PX4_INFO_RAW("%i", (int)((const char *)field_ptr)[i]); break;
 
-			if (topic_name_len >= sizeof(topic_name)) {
-				PX4_ERR("topic name too long in %s (max: %u)", meta->o_name, (unsigned)sizeof(topic_name));
+			default:
+				PX4_ERR("unknown type: %i", field.type);
 				return;
 			}
 
-			memcpy(topic_name, meta->o_fields + format_idx, topic_name_len);
-			topic_name[topic_name_len] = '\0';
+			if (i < array_size - 1) {
+				PX4_INFO_RAW(", ");
+			}
+		}
 
-			// find the metadata
-			const orb_metadata *const *topics = orb_get_topics();
-			const orb_metadata *found_topic = nullptr;
+		if (array_size > 1) {
+			PX4_INFO_RAW("]");
+		}
 
-			for (size_t i = 0; i < orb_topics_count(); i++) {
-				if (strcmp(topics[i]->o_name, topic_name) == 0) {
-					found_topic = topics[i];
-					break;
-				}
+		// handle special cases
+		switch (field.hint) {
+		case ORB_FIELD_HINT_TIMESTAMP:
+			topic_timestamp = *(const uint64_t *)field_ptr;
+
+			if (topic_timestamp != 0) {
+				PX4_INFO_RAW(" (%.6f seconds ago)", (double)((now - topic_timestamp) / 1e6f));
 			}
 
-			if (!found_topic) {
-				PX4_ERR("Topic %s did not match any known topics", topic_name);
-				return;
+			break;
+
+		case ORB_FIELD_HINT_TIMESTAMP_SAMPLE: {
+				const hrt_abstime timestamp = *(const uint64_t *)field_ptr;
+
+				if (topic_timestamp != 0 && timestamp != 0) {
+					PX4_INFO_RAW(" (%i us before timestamp)", (int)(topic_timestamp - timestamp));
+				}
 			}
+			break;
 
-			// print recursively
-			for (int i = 0; i < array_size; ++i) {
-				PX4_INFO_RAW("  %s", field_name);
+		case ORB_FIELD_HINT_BITFIELD: {
+				const unsigned field_size = orb_get_type_size(field.type);
+				unsigned long value = 0;
 
-				if (array_size > 1) {
-					PX4_INFO_RAW("[%i]", i);
+				if (field.type == ORB_FIELD_TYPE_UINT8) {
+					value = *(const uint8_t *)field_ptr;
+
+				} else if (field.type == ORB_FIELD_TYPE_UINT16) {
+					value = *(const uint16_t *)field_ptr;
+
+				} else {
+					value = *(const uint32_t *)field_ptr;
 				}
 
-				PX4_INFO_RAW(" (%s):\n", topic_name);
-				orb_print_message_internal(found_topic, data_ptr + data_offset, false);
-				data_offset += found_topic->o_size;
+				PX4_INFO_RAW(" (0b");
+
+				for (int i = (field_size * 8) - 1; i >= 0; i--) {
+					PX4_INFO_RAW("%lu%s", (value >> i) & 1, ((unsigned)i < (field_size * 8) - 1 && i % 4 == 0 && i > 0) ? "'" : "");
+				}
+
+				PX4_INFO_RAW(")");
+			}
+			break;
+
+		case ORB_FIELD_HINT_DEVICE_ID: {
+				const uint32_t device_id = *(const uint32_t *)field_ptr;
+				char device_id_buffer[80];
+				device::Device::device_id_print_buffer(device_id_buffer, sizeof(device_id_buffer), device_id);
+				PX4_INFO_RAW(" (%s)", device_id_buffer);
 			}
+			break;
+
+		case ORB_FIELD_HINT_QUATERNION: {
+				// attitude
+				const matrix::Eulerf euler{matrix::Quatf{(const float *)field_ptr}};
+				PX4_INFO_RAW(" (Roll: %.1f deg, Pitch: %.1f deg, Yaw: %.1f deg)",
+					     (double)math::degrees(euler(0)), (double)math::degrees(euler(1)), (double)math::degrees(euler(2)));
+			}
+			break;
 		}
 
-		format_idx = end_field_idx + 1;
+#pragma GCC diagnostic pop
+
+		PX4_INFO_RAW("\n");
 	}
 }
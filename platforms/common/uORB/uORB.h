@@ -43,6 +43,48 @@
 #include <stdbool.h>
 
 
+/**
+ * Field types: the short types used in o_fields, or a nested topic.
+ * This needs to match with the uorb o_fields generator.
+ */
+#define ORB_FIELD_TYPE_NESTED	0x00
+#define ORB_FIELD_TYPE_INT8	0x82
+#define ORB_FIELD_TYPE_INT16	0x83
+#define ORB_FIELD_TYPE_INT32	0x84
+#define ORB_FIELD_TYPE_INT64	0x85
+#define ORB_FIELD_TYPE_UINT8	0x86
+#define ORB_FIELD_TYPE_UINT16	0x87
+#define ORB_FIELD_TYPE_UINT32	0x88
+#define ORB_FIELD_TYPE_UINT64	0x89
+#define ORB_FIELD_TYPE_FLOAT	0x8a
+#define ORB_FIELD_TYPE_DOUBLE	0x8b
+#define ORB_FIELD_TYPE_BOOL	0x8c
+#define ORB_FIELD_TYPE_CHAR	0x8d
+
+/**
+ * Field hints, determined from the field name and type (used for printing).
+ */
+#define ORB_FIELD_HINT_NONE		0
+#define ORB_FIELD_HINT_PADDING		1	/**< _padding* fields */
+#define ORB_FIELD_HINT_TIMESTAMP	2	/**< uint64_t timestamp */
+#define ORB_FIELD_HINT_TIMESTAMP_SAMPLE	3	/**< uint64_t timestamp_sample */
+#define ORB_FIELD_HINT_BITFIELD		4	/**< unsigned integer *flags* */
+#define ORB_FIELD_HINT_DEVICE_ID	5	/**< uint32_t *device_id* */
+#define ORB_FIELD_HINT_QUATERNION	6	/**< float[4] q or q_* */
+
+/**
+ * Precompiled description of a field in o_fields.
+ */
+struct orb_field_descriptor {
+	uint16_t offset;	/**< offset of the field within the struct */
+	uint16_t count;		/**< number of array elements, 1 if not an array */
+	uint16_t name;		/**< index of the field name in o_fields */
+	uint8_t name_length;	/**< length of the field name */
+	uint8_t type;		/**< ORB_FIELD_TYPE_* */
+	uint8_t hint;		/**< ORB_FIELD_HINT_* */
+	uint8_t nested_id;	/**< ORB_ID enum of the nested topic (if type is ORB_FIELD_TYPE_NESTED), INVALID if unknown */
+};
+
 /**
  * Object metadata.
  */
@@ -51,6 +93,8 @@ struct orb_metadata {
 	const uint16_t o_size;		/**< object size */
 	const uint16_t o_size_no_padding;	/**< object size w/o padding at the end (for logger) */
 	const char *o_fields;		/**< semicolon separated list of fields (with type) */
+	const struct orb_field_descriptor *o_field_descriptors;	/**< fields of o_fields, nullptr if not generated */
+	uint16_t o_num_fields;		/**< number of o_field_descriptors */
 	uint8_t o_id;			/**< ORB_ID enum */
 };
 
@@ -100,14 +144,18 @@ typedef const struct orb_metadata *orb_id_t;
  * @param _struct	The structure the topic provides.
  * @param _size_no_padding	Struct size w/o padding at the end
  * @param _fields	All fields in a semicolon separated list e.g: "float[3] position;bool armed"
+ * @param _field_descriptors	Array of orb_field_descriptor for _fields (or nullptr)
+ * @param _num_fields	Number of elements in _field_descriptors
  * @param _orb_id_enum	ORB ID enum e.g.: ORB_ID::vehicle_status
  */
-#define ORB_DEFINE(_name, _struct, _size_no_padding, _fields, _orb_id_enum)		\
+#define ORB_DEFINE(_name, _struct, _size_no_padding, _fields, _field_descriptors, _num_fields, _orb_id_enum)	\
 	const struct orb_metadata __orb_##_name = {	\
 		#_name,					\
 		sizeof(_struct),		\
 		_size_no_padding,			\
 		_fields,				\
+		_field_descriptors,			\
+		_num_fields,				\
 		_orb_id_enum				\
 	}; struct hack
 
@@ -240,6 +288,38 @@ extern int	orb_get_interval(int handle, unsigned *interval) __EXPORT;
  */
 const char *orb_get_c_type(unsigned char short_type);
 
+/**
+ * Iteration state for orb_next_field()
+ */
+struct orb_field_iterator {
+	const struct orb_metadata *meta;
+	uint16_t index;		/**< index of the next field */
+	uint16_t format_idx;	/**< position of the next field in o_fields (only if there are no field descriptors) */
+	uint16_t offset;	/**< offset of the next field (only if there are no field descriptors) */
+};
+
+/**
+ * Initialize an iterator over the fields of a topic.
+ */
+void orb_field_iterator_init(struct orb_field_iterator *it, const struct orb_metadata *meta);
+
+/**
+ * Get the next field of a topic. This uses the precompiled field descriptors, or parses o_fields
+ * if there are none. A nested topic which is not known is returned with an invalid nested_id, the offsets
+ * of the following fields are then invalid.
+ * @param it iterator, initialized with orb_field_iterator_init()
+ * @param field set to the next field
+ * @return true if a field was returned, false at the end or on a format error (which is printed)
+ */
+bool orb_next_field(struct orb_field_iterator *it, struct orb_field_descriptor *field);
+
+/**
+ * Write the format of a field as used in o_fields, but with the C type, e.g. "float[3] position;".
+ * @return number of characters (excluding the null termination) that would have been written, < 0 on error
+ */
+int orb_get_field_format(const struct orb_metadata *meta, const struct orb_field_descriptor *field, char *buf,
+			 size_t buf_len);
+
 /**
  * Print a topic to console. Do not call this directly, use print_message() instead.
  * @param meta orb topic metadata
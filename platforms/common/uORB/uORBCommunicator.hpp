@@ -144,6 +144,21 @@ public:
 
 	virtual int16_t send_message(const char *messageName, int32_t length, uint8_t *data) = 0;
 
+	/**
+	 * @brief Sends the data message of a topic instance over the communication link.
+	 * Channels which do not distinguish topic instances don't need to implement this.
+	 * @param instance
+	 * 	The topic instance the data was published to.
+	 * @return
+	 *  0 = success; otherwise = failure.
+	 */
+
+	virtual int16_t send_message(const char *messageName, int32_t length, uint8_t *data, uint8_t instance)
+	{
+		(void)instance;
+		return send_message(messageName, length, data);
+	}
+
 };
 
 /**
@@ -99,16 +99,25 @@ int uORB::DeviceMaster::advertise(const struct orb_metadata *meta, bool is_adver
 			*instance = group_tries;
 		}
 
-		/* construct the new node, passing the ownership of path to it */
-		uORB::DeviceNode *node = new uORB::DeviceNode(meta, group_tries, nodepath);
+		/* only construct a new node if this instance does not exist yet (checked in the node table,
+		 * which is much cheaper than failing to register the device with the same name) */
+		uORB::DeviceNode *node = nullptr;
 
-		/* if we didn't get a device, that's bad */
-		if (node == nullptr) {
-			return -ENOMEM;
-		}
+		if (getDeviceNodeLocked(meta, group_tries) != nullptr) {
+			ret = -EEXIST;
+
+		} else {
+			/* construct the new node, passing the ownership of path to it */
+			node = new uORB::DeviceNode(meta, group_tries, nodepath);
 
-		/* initialise the node - this may fail if e.g. a node with this name already exists */
-		ret = node->init();
+			/* if we didn't get a device, that's bad */
+			if (node == nullptr) {
+				return -ENOMEM;
+			}
+
+			/* initialise the node - this may fail if e.g. a node with this name already exists */
+			ret = node->init();
+		}
 
 		/* if init failed, discard the node and its name */
 		if (ret != PX4_OK) {
@@ -152,9 +161,7 @@ int uORB::DeviceMaster::advertise(const struct orb_metadata *meta, bool is_adver
 				node->mark_as_advertised();
 			}
 
-			// add to the node map.
-			_node_list.add(node);
-			_node_exists[node->get_instance()].set((uint8_t)node->id(), true);
+			addDeviceNodeLocked(node);
 		}
 
 		group_tries++;
@@ -453,11 +460,18 @@ uORB::DeviceNode *uORB::DeviceMaster::getDeviceNode(const char *nodepath)
 
 uORB::DeviceNode *uORB::DeviceMaster::getDeviceNodeLocked(const struct orb_metadata *meta, const uint8_t instance)
 {
-	for (uORB::DeviceNode *node : _node_list) {
-		if ((strcmp(node->get_name(), meta->o_name) == 0) && (node->get_instance() == instance)) {
-			return node;
-		}
+	if ((meta == nullptr) || (meta->o_id >= ORB_TOPICS_COUNT) || (instance >= ORB_MULTI_MAX_INSTANCES)) {
+		return nullptr;
 	}
 
-	return nullptr;
+	return _node_table[meta->o_id][instance];
+}
+
+void uORB::DeviceMaster::addDeviceNodeLocked(uORB::DeviceNode *node)
+{
+	_node_list.add(node);
+
+	// the table entry must be valid before the node is marked as existing
+	_node_table[(uint8_t)node->id()][node->get_instance()] = node;
+	_node_exists[node->get_instance()].set((uint8_t)node->id(), true);
 }
@@ -68,10 +68,15 @@ public:
 	int advertise(const struct orb_metadata *meta, bool is_advertiser, int *instance);
 
 	/**
-	 * Public interface for getDeviceNodeLocked(). Takes care of synchronization.
+	 * Find a node given its path. Takes care of synchronization.
 	 * @return node if exists, nullptr otherwise
 	 */
 	uORB::DeviceNode *getDeviceNode(const char *node_name);
+
+	/**
+	 * Find a node given its topic and instance in the node table, this does not need to take the lock.
+	 * @return node if exists, nullptr otherwise
+	 */
 	uORB::DeviceNode *getDeviceNode(const struct orb_metadata *meta, const uint8_t instance)
 	{
 		if (meta == nullptr) {
@@ -82,14 +87,9 @@ public:
 			return nullptr;
 		}
 
-		lock();
-		uORB::DeviceNode *node = getDeviceNodeLocked(meta, instance);
-		unlock();
-
 		//We can safely return the node that can be used by any thread, because
 		//a DeviceNode never gets deleted.
-		return node;
-
+		return _node_table[meta->o_id][instance];
 	}
 
 	bool deviceNodeExists(ORB_ID id, const uint8_t instance)
@@ -133,13 +133,25 @@ private:
 	friend class uORB::Manager;
 
 	/**
-	 * Find a node give its name.
+	 * Find a node give its topic and instance.
 	 * _lock must already be held when calling this.
 	 * @return node if exists, nullptr otherwise
 	 */
 	uORB::DeviceNode *getDeviceNodeLocked(const struct orb_metadata *meta, const uint8_t instance);
 
-	IntrusiveSortedList<uORB::DeviceNode *> _node_list;
+	/**
+	 * Add a new node to the list and the node table.
+	 * _lock must already be held when calling this.
+	 */
+	void addDeviceNodeLocked(uORB::DeviceNode *node);
+
+	IntrusiveSortedList<uORB::DeviceNode *> _node_list; ///< sorted by name, used to iterate over all nodes
+
+	/**
+	 * Nodes indexed by ORB_ID and instance. An entry is only written once (with _lock held) before the
+	 * corresponding _node_exists bit is set, so readers checking _node_exists first don't need the lock.
+	 */
+	uORB::DeviceNode *_node_table[ORB_TOPICS_COUNT][ORB_MULTI_MAX_INSTANCES] {};
 	AtomicBitset<ORB_TOPICS_COUNT> _node_exists[ORB_MULTI_MAX_INSTANCES];
 
 	px4_sem_t	_lock; /**< lock to protect access to all class members (also for derived classes) */
@@ -38,6 +38,8 @@
 
 #include "SubscriptionCallback.hpp"
 
+#include <px4_platform_common/px4_work_queue/WorkQueueTrace.hpp>
+
 #ifdef ORB_COMMUNICATOR
 #include "uORBCommunicator.hpp"
 #endif /* ORB_COMMUNICATOR */
@@ -216,9 +218,11 @@ uORB::DeviceNode::write(cdev::file_t *filp, const char *buffer, size_t buflen)
 
 	memcpy(_data + (_meta->o_size * (generation % _queue_size)), buffer, _meta->o_size);
 
-	// callbacks
+	// callbacks (decimated or rate limited subscriptions are only called for the publications they want)
 	for (auto item : _callbacks) {
-		item->call();
+		if (item->dispatch(buffer)) {
+			item->call();
+		}
 	}
 
 	/* Mark at least one data has been published */
@@ -226,6 +230,10 @@ uORB::DeviceNode::write(cdev::file_t *filp, const char *buffer, size_t buflen)
 
 	ATOMIC_LEAVE;
 
+	if (px4::wq_trace::is_enabled()) {
+		px4::wq_trace::record(px4::wq_trace::EventType::Publish, _meta->o_name, _instance);
+	}
+
 	/* notify any poll waiters */
 	poll_notify(POLLIN);
 
@@ -311,7 +319,7 @@ uORB::DeviceNode::publish(const orb_metadata *meta, orb_advert_t handle, const v
 	uORBCommunicator::IChannel *ch = uORB::Manager::get_instance()->get_uorb_communicator();
 
 	if (ch != nullptr) {
-		if (ch->send_message(meta->o_name, meta->o_size, (uint8_t *)data) != 0) {
+		if (ch->send_message(meta->o_name, meta->o_size, (uint8_t *)data, devnode->get_instance()) != 0) {
 			PX4_ERR("Error Sending [%s] topic data over comm_channel", meta->o_name);
 			return PX4_ERROR;
 		}
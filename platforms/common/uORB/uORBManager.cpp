@@ -251,6 +251,11 @@ int uORB::Manager::orb_exists(const struct orb_metadata *meta, int instance)
 
 #ifdef ORB_COMMUNICATOR
 
+	// only topics of a remote entity can exist in addition to the local nodes
+	if (uORB::Manager::get_instance()->get_uorb_communicator() == nullptr) {
+		return ret;
+	}
+
 	/*
 	 * Generate the path to the node and try to open it.
 	 */
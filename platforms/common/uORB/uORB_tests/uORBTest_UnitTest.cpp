@@ -40,7 +40,52 @@
 #include <math.h>
 #include <lib/cdev/CDev.hpp>
 #include <uORB/PublicationMulti.hpp>
+#include <uORB/SubscriptionCallback.hpp>
 #include <uORB/SubscriptionMultiArray.hpp>
+#include <uORB/topics/vehicle_angular_velocity.h>
+
+namespace
+{
+
+// work item copying the subscription when it runs, like a module would
+class CountingWorkItem : public px4::WorkItem
+{
+public:
+	CountingWorkItem() : px4::WorkItem("uorb_test_callback", px4::wq_configurations::test1) {}
+
+	void Run() override
+	{
+		if (_sub) {
+			vehicle_angular_velocity_s data;
+			_sub->update(&data);
+		}
+
+		_runs.fetch_add(1);
+	}
+
+	uORB::SubscriptionInterval *_sub{nullptr};
+	px4::atomic<unsigned> _runs{0};
+};
+
+class CountingCallback : public uORB::SubscriptionCallbackWorkItem
+{
+public:
+	CountingCallback(CountingWorkItem *work_item, const orb_metadata *meta, uint8_t instance) :
+		SubscriptionCallbackWorkItem(work_item, meta, instance)
+	{
+		work_item->_sub = this;
+	}
+
+	void call() override
+	{
+		_calls++;
+		SubscriptionCallbackWorkItem::call();
+	}
+
+	unsigned _calls{0};
+};
+
+} // namespace
 
 uORBTest::UnitTest &uORBTest::UnitTest::instance()
 {
@@ -206,7 +251,19 @@ int uORBTest::UnitTest::test()
 		return ret;
 	}
 
-	return test_queue_poll_notify();
+	ret = test_queue_poll_notify();
+
+	if (ret != OK) {
+		return ret;
+	}
+
+	ret = test_fields();
+
+	if (ret != OK) {
+		return ret;
+	}
+
+	return test_callback_decimation();
 }
 
 int uORBTest::UnitTest::test_unadvertise()
@@ -1085,6 +1142,407 @@ int uORBTest::UnitTest::latency_test(bool print)
 	return pubsubtest_res;
 }
 
+int uORBTest::UnitTest::startup_benchmark()
+{
+	test_note("---------------- STARTUP BENCHMARK ------------------");
+
+	uORB::DeviceMaster *device_master = uORB::Manager::get_instance()->get_device_master();
+
+	if (device_master == nullptr) {
+		return test_fail("no DeviceMaster");
+	}
+
+	static constexpr int ROUNDS = 10;
+	static constexpr int LOOKUPS = ROUNDS * ORB_TOPICS_COUNT * ORB_MULTI_MAX_INSTANCES;
+
+	// modules checking for every topic instance at startup and while waiting for publishers
+	int num_existing = 0;
+	hrt_abstime start = hrt_absolute_time();
+
+	for (int round = 0; round < ROUNDS; round++) {
+		for (size_t i = 0; i < ORB_TOPICS_COUNT; i++) {
+			for (int instance = 0; instance < ORB_MULTI_MAX_INSTANCES; instance++) {
+				if (orb_exists(get_orb_meta((ORB_ID)i), instance) == PX4_OK) {
+					num_existing++;
+				}
+			}
+		}
+	}
+
+	const hrt_abstime exists_time = hrt_elapsed_time(&start);
+
+	start = hrt_absolute_time();
+
+	for (int round = 0; round < ROUNDS; round++) {
+		for (size_t i = 0; i < ORB_TOPICS_COUNT; i++) {
+			for (int instance = 0; instance < ORB_MULTI_MAX_INSTANCES; instance++) {
+				uORB::Subscription sub{get_orb_meta((ORB_ID)i), (uint8_t)instance};
+				sub.subscribe();
+			}
+		}
+	}
+
+	const hrt_abstime subscribe_time = hrt_elapsed_time(&start);
+
+	// node lookup by path (walks the node list) compared to the node table
+	hrt_abstime path_lookup_time = 0;
+	hrt_abstime table_lookup_time = 0;
+	int num_nodes = 0;
+
+	for (size_t i = 0; i < ORB_TOPICS_COUNT; i++) {
+		const orb_metadata *meta = get_orb_meta((ORB_ID)i);
+
+		for (int instance = 0; instance < ORB_MULTI_MAX_INSTANCES; instance++) {
+			uORB::DeviceNode *node = device_master->getDeviceNode(meta, instance);
+
+			if (node == nullptr) {
+				continue;
+			}
+
+			num_nodes++;
+
+			start = hrt_absolute_time();
+
+			for (int round = 0; round < ROUNDS; round++) {
+				if (device_master->getDeviceNode(node->get_devname()) != node) {
+					return test_fail("path lookup of %s failed", node->get_devname());
+				}
+			}
+
+			path_lookup_time += hrt_elapsed_time(&start);
+
+			start = hrt_absolute_time();
+
+			for (int round = 0; round < ROUNDS; round++) {
+				if (device_master->getDeviceNode(meta, instance) != node) {
+					return test_fail("table lookup of %s failed", node->get_devname());
+				}
+			}
+
+			table_lookup_time += hrt_elapsed_time(&start);
+		}
+	}
+
+	// advertising all instances of a multi-instance topic, every advertiser checks the lower instances first
+	orb_advert_t handles[ORB_MULTI_MAX_INSTANCES] {};
+	orb_test_s t{};
+	start = hrt_absolute_time();
+
+	for (int round = 0; round < ROUNDS; round++) {
+		for (int i = 0; i < ORB_MULTI_MAX_INSTANCES; i++) {
+			int instance;
+			handles[i] = orb_advertise_multi(ORB_ID(orb_multitest), &t, &instance);
+
+			if ((handles[i] == nullptr) || (instance != i)) {
+				return test_fail("advertise failed (instance %i, expected %i)", instance, i);
+			}
+		}
+
+		for (int i = 0; i < ORB_MULTI_MAX_INSTANCES; i++) {
+			orb_unadvertise(handles[i]);
+		}
+	}
+
+	const hrt_abstime advertise_time = hrt_elapsed_time(&start);
+
+	test_note("%i topics, %i instances each, %i nodes (%i advertised)", (int)ORB_TOPICS_COUNT, ORB_MULTI_MAX_INSTANCES,
+		  num_nodes, num_existing / ROUNDS);
+	test_note("orb_exists: %.3f us", (double)exists_time / LOOKUPS);
+	test_note("Subscription::subscribe: %.3f us", (double)subscribe_time / LOOKUPS);
+
+	if (num_nodes > 0) {
+		test_note("node lookup by path: %.3f us, by table: %.3f us", (double)path_lookup_time / (num_nodes * ROUNDS),
+			  (double)table_lookup_time / (num_nodes * ROUNDS));
+	}
+
+	test_note("orb_advertise_multi: %.3f us", (double)advertise_time / (ROUNDS * ORB_MULTI_MAX_INSTANCES));
+
+	return PX4_OK;
+}
+
+int uORBTest::UnitTest::test_fields()
+{
+	test_note("Testing field descriptors");
+
+	for (size_t i = 0; i < ORB_TOPICS_COUNT; i++) {
+		const orb_metadata *meta = get_orb_meta((ORB_ID)i);
+
+		// the same metadata without the precompiled descriptors, so that o_fields is parsed
+		const orb_metadata parsed_meta{meta->o_name, meta->o_size, meta->o_size_no_padding, meta->o_fields, nullptr, 0, meta->o_id};
+
+		orb_field_iterator it;
+		orb_field_iterator_init(&it, meta);
+		orb_field_iterator parsed_it;
+		orb_field_iterator_init(&parsed_it, &parsed_meta);
+
+		orb_field_descriptor field;
+		orb_field_descriptor parsed_field;
+		unsigned num_fields = 0;
+		unsigned end = 0;
+
+		while (orb_next_field(&parsed_it, &parsed_field)) {
+			if (meta->o_field_descriptors) {
+				if (!orb_next_field(&it, &field)) {
+					return test_fail("%s: missing field %u", meta->o_name, num_fields);
+				}
+
+				if (field.offset != parsed_field.offset || field.count != parsed_field.count || field.name != parsed_field.name
+				    || field.name_length != parsed_field.name_length || field.type != parsed_field.type
+				    || field.hint != parsed_field.hint || field.nested_id != parsed_field.nested_id) {
+					return test_fail("%s: field %u does not match o_fields", meta->o_name, num_fields);
+				}
+			}
+
+			if (parsed_field.offset != end) {
+				return test_fail("%s: unexpected offset of field %u", meta->o_name, num_fields);
+			}
+
+			switch (parsed_field.type) {
+			case ORB_FIELD_TYPE_NESTED: end += get_orb_meta((ORB_ID)parsed_field.nested_id)->o_size * parsed_field.count; break;
+
+			case ORB_FIELD_TYPE_INT16:
+			case ORB_FIELD_TYPE_UINT16: end += 2 * parsed_field.count; break;
+
+			case ORB_FIELD_TYPE_INT32:
+			case ORB_FIELD_TYPE_UINT32:
+			case ORB_FIELD_TYPE_FLOAT: end += 4 * parsed_field.count; break;
+
+			case ORB_FIELD_TYPE_INT64:
+			case ORB_FIELD_TYPE_UINT64:
+			case ORB_FIELD_TYPE_DOUBLE: end += 8 * parsed_field.count; break;
+
+			default: end += parsed_field.count; break;
+			}
+
+			num_fields++;
+		}
+
+		if (meta->o_field_descriptors && (num_fields != meta->o_num_fields || orb_next_field(&it, &field))) {
+			return test_fail("%s: %u field descriptors, o_fields has %u", meta->o_name, meta->o_num_fields, num_fields);
+		}
+
+		if (end != meta->o_size) {
+			return test_fail("%s: fields end at %u, size is %u", meta->o_name, end, meta->o_size);
+		}
+	}
+
+	return test_note("PASS field descriptors");
+}
+
+int uORBTest::UnitTest::format_benchmark()
+{
+	test_note("---------------- FORMAT BENCHMARK ------------------");
+
+	static constexpr int ROUNDS = 100;
+
+	// building the format strings of all topics, as done by the logger and replay
+	char format[1500];
+	unsigned num_fields = 0;
+	hrt_abstime descriptor_time = 0;
+	hrt_abstime parse_time = 0;
+
+	for (size_t i = 0; i < ORB_TOPICS_COUNT; i++) {
+		const orb_metadata *meta = get_orb_meta((ORB_ID)i);
+		const orb_metadata parsed_meta{meta->o_name, meta->o_size, meta->o_size_no_padding, meta->o_fields, nullptr, 0, meta->o_id};
+
+		for (int pass = 0; pass < 2; pass++) {
+			const orb_metadata *m = (pass == 0) ? meta : &parsed_meta;
+			const hrt_abstime start = hrt_absolute_time();
+
+			for (int round = 0; round < ROUNDS; round++) {
+				orb_field_iterator it;
+				orb_field_iterator_init(&it, m);
+				orb_field_descriptor field;
+				int format_len = 0;
+
+				while (orb_next_field(&it, &field)) {
+					const int len = orb_get_field_format(m, &field, format + format_len, sizeof(format) - format_len);
+
+					if (len < 0 || len >= (int)sizeof(format) - format_len) {
+						return test_fail("format of %s too long", m->o_name);
+					}
+
+					format_len += len;
+
+					if (round == 0 && pass == 0) {
+						num_fields++;
+					}
+				}
+			}
+
+			if (pass == 0) {
+				descriptor_time += hrt_elapsed_time(&start);
+
+			} else {
+				parse_time += hrt_elapsed_time(&start);
+			}
+		}
+	}
+
+	if (get_orb_meta((ORB_ID)0)->o_field_descriptors == nullptr) {
+		test_note("no precompiled field descriptors (CONFIG_BOARD_UORB_FIELD_DESCRIPTORS disabled)");
+	}
+
+	test_note("%i topics, %u fields", (int)ORB_TOPICS_COUNT, num_fields);
+	test_note("format of all topics from descriptors: %.3f us, parsed: %.3f us", (double)descriptor_time / ROUNDS,
+		  (double)parse_time / ROUNDS);
+
+	return PX4_OK;
+}
+
+int uORBTest::UnitTest::test_callback_decimation()
+{
+	test_note("Testing callback decimation");
+
+	// use a separate instance, so that nothing else is published on it
+	const orb_metadata *meta = ORB_ID(vehicle_angular_velocity_groundtruth);
+	vehicle_angular_velocity_s avel{};
+	int instance = 0;
+	orb_advert_t pub = orb_advertise_multi(meta, &avel, &instance);
+
+	if (pub == nullptr) {
+		return test_fail("advertise failed: %d", errno);
+	}
+
+	CountingWorkItem work_items[3];
+	CountingCallback all{&work_items[0], meta, (uint8_t)instance};
+	CountingCallback decimated{&work_items[1], meta, (uint8_t)instance};
+	CountingCallback limited{&work_items[2], meta, (uint8_t)instance};
+	decimated.set_callback_decimation(4);
+	limited.set_callback_interval_us(10 * 1000 * 1000);
+
+	CountingWorkItem average_work_item;
+	uORB::SubscriptionCallbackWorkItemAverage<vehicle_angular_velocity_s> average{&average_work_item, meta, 4, (uint8_t)instance};
+
+	if (!all.registerCallback() || !decimated.registerCallback() || !limited.registerCallback()
+	    || !average.registerCallback()) {
+		orb_unadvertise(pub);
+		return test_fail("registerCallback failed");
+	}
+
+	static constexpr int NUM_PUBLICATIONS = 16;
+
+	for (int i = 1; i <= NUM_PUBLICATIONS; i++) {
+		avel.timestamp = hrt_absolute_time();
+		avel.xyz[0] = i;
+		avel.xyz[1] = -i;
+		avel.xyz[2] = 0.f;
+		orb_publish(meta, pub, &avel);
+	}
+
+	all.unregisterCallback();
+	decimated.unregisterCallback();
+	limited.unregisterCallback();
+	average.unregisterCallback();
+	orb_unadvertise(pub);
+
+	if (all._calls != NUM_PUBLICATIONS) {
+		return test_fail("%u callbacks, expected %i", all._calls, NUM_PUBLICATIONS);
+	}
+
+	if (decimated._calls != NUM_PUBLICATIONS / 4) {
+		return test_fail("%u decimated callbacks, expected %i", decimated._calls, NUM_PUBLICATIONS / 4);
+	}
+
+	if (limited._calls > 1) {
+		return test_fail("%u rate limited callbacks, expected at most 1", limited._calls);
+	}
+
+	// average of the last 4 publications (the latest one without field descriptors)
+	vehicle_angular_velocity_s avel_average{};
+
+	if (!average.update_average(avel_average)) {
+		return test_fail("no average");
+	}
+
+	const float expected = average.averaging() ? 14.5f : NUM_PUBLICATIONS;
+
+	if ((fabsf(avel_average.xyz[0] - expected) > FLT_EPSILON) || (fabsf(avel_average.xyz[1] + expected) > FLT_EPSILON)
+	    || (avel_average.timestamp != avel.timestamp)) {
+		return test_fail("wrong average (%.3f, %.3f)", (double)avel_average.xyz[0], (double)avel_average.xyz[1]);
+	}
+
+	if (average.update_average(avel_average)) {
+		return test_fail("average updated twice");
+	}
+
+	return test_note("PASS callback decimation");
+}
+
+int uORBTest::UnitTest::callback_benchmark()
+{
+	test_note("---------------- CALLBACK BENCHMARK ------------------");
+
+	// high rate topic (like vehicle_angular_velocity) with subscribers wanting a lower rate
+	const orb_metadata *meta = ORB_ID(vehicle_angular_velocity_groundtruth);
+	vehicle_angular_velocity_s avel{};
+	int instance = 0;
+	orb_advert_t pub = orb_advertise_multi(meta, &avel, &instance);
+
+	if (pub == nullptr) {
+		return test_fail("advertise failed: %d", errno);
+	}
+
+	static constexpr int PUBLISH_INTERVAL_US = 250; // 4 kHz
+	static constexpr int NUM_PUBLICATIONS = 4000;
+	static constexpr int NUM_CONFIGS = 4;
+	static constexpr const char *config_names[NUM_CONFIGS] {
+		"every publication",
+		"subscription interval 2.5 ms",
+		"callback interval 2.5 ms",
+		"callback decimation 10",
+	};
+
+	CountingWorkItem work_items[NUM_CONFIGS];
+	CountingCallback *subs[NUM_CONFIGS] {};
+
+	for (int i = 0; i < NUM_CONFIGS; i++) {
+		subs[i] = new CountingCallback(&work_items[i], meta, (uint8_t)instance);
+	}
+
+	subs[1]->set_interval_us(2500);
+	subs[2]->set_callback_interval_us(2500);
+	subs[3]->set_callback_decimation(10);
+
+	hrt_abstime publish_time[NUM_CONFIGS] {};
+
+	for (int config = 0; config < NUM_CONFIGS; config++) {
+		if (!subs[config]->registerCallback()) {
+			test_fail("registerCallback failed");
+			break;
+		}
+
+		for (int i = 0; i < NUM_PUBLICATIONS; i++) {
+			avel.timestamp = hrt_absolute_time();
+			orb_publish(meta, pub, &avel);
+			publish_time[config] += hrt_elapsed_time(&avel.timestamp);
+			px4_usleep(PUBLISH_INTERVAL_US);
+		}
+
+		subs[config]->unregisterCallback();
+	}
+
+	orb_unadvertise(pub);
+
+	// the work queue runs items in order, once this one ran all callbacks are processed
+	CountingWorkItem last_work_item;
+	last_work_item.ScheduleNow();
+
+	while (last_work_item._runs.load() == 0) {
+		px4_usleep(1000);
+	}
+
+	test_note("%i publications at %i Hz", NUM_PUBLICATIONS, 1000000 / PUBLISH_INTERVAL_US);
+
+	for (int i = 0; i < NUM_CONFIGS; i++) {
+		test_note("%-30s callbacks: %5u, work item runs: %5u, publish: %.3f us", config_names[i], subs[i]->_calls,
+			  work_items[i]._runs.load(), (double)publish_time[i] / NUM_PUBLICATIONS);
+		delete subs[i];
+	}
+
+	return PX4_OK;
+}
+
 int uORBTest::UnitTest::test_fail(const char *fmt, ...)
 {
 	va_list ap;
@@ -67,6 +67,9 @@ public:
 
 	int test();
 	int latency_test(bool print);
+	int startup_benchmark();
+	int format_benchmark();
+	int callback_benchmark();
 	int info();
 
 	// Disallow copy
@@ -108,6 +111,10 @@ private:
 
 	int test_SubscriptionMulti();
 
+	int test_fields();
+
+	int test_callback_decimation();
+
 	/* queuing tests */
 	int test_queue();
 	static int pub_test_queue_entry(int argc, char *argv[]);
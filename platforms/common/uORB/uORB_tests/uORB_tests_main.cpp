@@ -39,7 +39,7 @@ extern "C" { __EXPORT int uorb_tests_main(int argc, char *argv[]); }
 
 static void usage()
 {
-	PX4_INFO("Usage: uorb_tests [latency_test]");
+	PX4_INFO("Usage: uorb_tests [latency_test|startup_benchmark|format_benchmark|callback_benchmark]");
 }
 
 int
@@ -70,6 +70,30 @@ uorb_tests_main(int argc, char *argv[])
 		return t.latency_test(true);
 	}
 
+	/*
+	 * Benchmark the node lookups done during startup.
+	 */
+	if (argc > 1 && !strcmp(argv[1], "startup_benchmark")) {
+		uORBTest::UnitTest &t = uORBTest::UnitTest::instance();
+		return t.startup_benchmark();
+	}
+
+	/*
+	 * Benchmark building the topic formats from the field descriptors compared to parsing o_fields.
+	 */
+	if (argc > 1 && !strcmp(argv[1], "format_benchmark")) {
+		uORBTest::UnitTest &t = uORBTest::UnitTest::instance();
+		return t.format_benchmark();
+	}
+
+	/*
+	 * Benchmark the callbacks of rate limited and decimated subscriptions.
+	 */
+	if (argc > 1 && !strcmp(argv[1], "callback_benchmark")) {
+		uORBTest::UnitTest &t = uORBTest::UnitTest::instance();
+		return t.callback_benchmark();
+	}
+
 	usage();
 	return -EINVAL;
 }
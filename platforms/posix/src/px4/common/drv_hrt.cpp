@@ -44,7 +44,9 @@
 #include <px4_platform_common/tasks.h>
 #include <drivers/drv_hrt.h>
 
+#include <assert.h>
 #include <semaphore.h>
+#include <stdlib.h>
 #include <time.h>
 #include <string.h>
 #include <errno.h>
@@ -234,6 +236,16 @@ void	hrt_init()
 	}
 
 	memset(&_hrt_work, 0, sizeof(_hrt_work));
+
+#if defined(ENABLE_LOCKSTEP_SCHEDULER)
+	const char *parallel = getenv("PX4_LOCKSTEP_PARALLEL");
+
+	if (parallel && atoi(parallel) > 0) {
+		PX4_INFO("parallel lockstep enabled");
+		lockstep_scheduler->components().set_parallel(true);
+	}
+
+#endif // defined(ENABLE_LOCKSTEP_SCHEDULER)
 }
 
 static void
@@ -328,6 +340,15 @@ hrt_call_reschedule()
 	/* set the new compare value and remember it for latency tracking */
 	latency_baseline = now + delay;
 
+#if defined(ENABLE_LOCKSTEP_SCHEDULER)
+
+	// in parallel lockstep mode the callouts are invoked by px4_clock_settime()
+	if (lockstep_scheduler->components().parallel()) {
+		return;
+	}
+
+#endif // defined(ENABLE_LOCKSTEP_SCHEDULER)
+
 	// There is no timer ISR, so simulate one by putting an event on the
 	// high priority work queue
 
@@ -508,11 +529,27 @@ int px4_clock_settime(clockid_t clk_id, const struct timespec *ts)
 		}
 
 		lockstep_scheduler->set_absolute_time(time_us);
+
+		if (lockstep_scheduler->components().parallel()) {
+			// invoke the due callouts right away, so that the work they schedule is tagged
+			// with the current step independent of the thread timing
+			hrt_call_invoke();
+		}
+
 		return 0;
 	}
 }
 
 
+// a work queue in a lockstep step blocks run_steps(), which needs to return for the simulated time to advance
+static void assert_not_in_step()
+{
+	if (lockstep_scheduler->components().in_step()) {
+		PX4_ERR("%s: sleeping in a work item deadlocks in parallel lockstep mode", px4_get_taskname());
+		assert(false);
+	}
+}
+
 int px4_usleep(useconds_t usec)
 {
 	if (px4_timestart_monotonic == 0) {
@@ -521,6 +558,8 @@ int px4_usleep(useconds_t usec)
 		return system_usleep(usec);
 	}
 
+	assert_not_in_step();
+
 	const uint64_t time_finished = lockstep_scheduler->get_absolute_time() + usec;
 
 	return lockstep_scheduler->usleep_until(time_finished);
@@ -534,6 +573,8 @@ unsigned int px4_sleep(unsigned int seconds)
 		return system_sleep(seconds);
 	}
 
+	assert_not_in_step();
+
 	const uint64_t time_finished = lockstep_scheduler->get_absolute_time() +
 				       ((uint64_t)seconds * 1000000);
 
@@ -568,4 +609,34 @@ void px4_lockstep_wait_for_components()
 {
 	lockstep_scheduler->components().wait_for_components();
 }
+
+void px4_lockstep_run_steps()
+{
+	lockstep_scheduler->components().run_steps();
+}
+
+int px4_lockstep_register_work_queue()
+{
+	return lockstep_scheduler->components().register_member();
+}
+
+void px4_lockstep_unregister_work_queue(int member)
+{
+	lockstep_scheduler->components().unregister_member(member);
+}
+
+uint32_t px4_lockstep_work_queue_add(int member)
+{
+	return lockstep_scheduler->components().member_add(member);
+}
+
+uint32_t px4_lockstep_work_queue_begin(int member)
+{
+	return lockstep_scheduler->components().member_begin(member);
+}
+
+void px4_lockstep_work_queue_end(int member)
+{
+	lockstep_scheduler->components().member_end(member);
+}
 #endif
@@ -35,6 +35,8 @@
 
 #include <cstdint>
 #include <atomic>
+#include <condition_variable>
+#include <mutex>
 
 #include <px4_platform_common/sem.h>
 
@@ -42,6 +44,12 @@
  * @class LockstepComponents
  * Allows to register components (threads) that need to be updated or waited for in every lockstep cycle (barrier).
  * Registered components need to ensure they poll on topics that is updated in every lockstep cycle.
+ *
+ * In parallel mode work queues additionally register as step members. Instead of running freely, they are
+ * released in steps: all members with pending work run concurrently, and work queued during a step (e.g. by
+ * a publication of another member) is only due in the next step. Together with a fixed execution order
+ * within a work queue this makes the order of publications independent of the thread timing, as long as
+ * work queues running in the same step do not share data.
  */
 class LockstepComponents
 {
@@ -68,11 +76,71 @@ public:
 	 */
 	void wait_for_components();
 
+	/**
+	 * Enable parallel mode. Needs to be set before any member registers.
+	 */
+	void set_parallel(bool parallel) { _parallel = parallel; }
+	bool parallel() const { return _parallel; }
+
+	/**
+	 * Register a step member (work queue)
+	 * @return a valid member ID >= 0 or -1 on error (or parallel mode disabled)
+	 */
+	int register_member();
+	void unregister_member(int member);
+
+	/**
+	 * Mark a member as having pending work.
+	 * @return the current step, to tag the work with
+	 */
+	uint32_t member_add(int member);
+
+	/**
+	 * Wait until the member is released.
+	 * Note: member_end() needs to be called afterwards.
+	 * @return the released step, work tagged with an earlier step is due
+	 */
+	uint32_t member_begin(int member);
+	void member_end(int member);
+
+	/**
+	 * @return true if the calling thread is a member between member_begin() and member_end()
+	 */
+	bool in_step() const { return _in_step; }
+
+	/**
+	 * Run steps until no member has pending work (or the step limit per cycle is reached).
+	 * This is a no-op if parallel mode is disabled.
+	 * Note: the caller advances the simulated time only after this returns, so a member blocking on the
+	 * simulated time (e.g. px4_usleep() in a work item) deadlocks. px4_usleep() asserts against this.
+	 */
+	void run_steps();
+
+	uint64_t steps() const { return _steps_total; }
+
 private:
 
+	static constexpr int MAX_MEMBERS = 32;
+	static constexpr int MAX_STEPS_PER_CYCLE = 64; ///< limit for members rescheduling themselves in every step
+
 	px4_sem_t _components_sem;
 
 	std::atomic_int _components_used_bitset{0};
 	std::atomic_int _components_progress_bitset{0};
+
+	bool _parallel{false};
+
+	std::mutex _steps_mutex; ///< serializes run_steps() callers
+	std::mutex _members_mutex;
+	std::condition_variable _members_cv;
+
+	uint32_t _members_used{0};
+	uint32_t _members_pending{0};
+	uint32_t _members_running{0};
+	uint32_t _step{1};
+	bool _gated{false}; ///< members run freely until the first step
+	std::atomic<uint64_t> _steps_total{0};
+
+	static thread_local bool _in_step;
 };
 
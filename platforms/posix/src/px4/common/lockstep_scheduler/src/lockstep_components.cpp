@@ -42,6 +42,8 @@
 #include <px4_platform_common/tasks.h>
 #include <limits.h>
 
+thread_local bool LockstepComponents::_in_step{false};
+
 LockstepComponents::LockstepComponents()
 {
 	px4_sem_init(&_components_sem, 0, 0);
@@ -119,9 +121,129 @@ void LockstepComponents::lockstep_progress(int component)
 
 void LockstepComponents::wait_for_components()
 {
+	run_steps();
+
 	if (_components_used_bitset == 0) {
 		return;
 	}
 
 	while (px4_sem_wait(&_components_sem) != 0) {}
 }
+
+int LockstepComponents::register_member()
+{
+	if (!_parallel) {
+		return -1;
+	}
+
+	std::lock_guard<std::mutex> lock(_members_mutex);
+
+	for (int member = 0; member < MAX_MEMBERS; ++member) {
+		if (!(_members_used & (1u << member))) {
+			_members_used |= 1u << member;
+			PX4_DEBUG("%s: got lockstep member %i", px4_get_taskname(), member);
+			return member;
+		}
+	}
+
+	PX4_ERR("No more members left");
+	return -1;
+}
+
+void LockstepComponents::unregister_member(int member)
+{
+	if (member < 0) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(_members_mutex);
+
+	const uint32_t bit = 1u << member;
+	_members_used &= ~bit;
+	_members_pending &= ~bit;
+	_members_running &= ~bit;
+
+	// wakes up the member itself as well as run_steps()
+	_members_cv.notify_all();
+}
+
+uint32_t LockstepComponents::member_add(int member)
+{
+	std::lock_guard<std::mutex> lock(_members_mutex);
+
+	if (member >= 0) {
+		_members_pending |= 1u << member;
+	}
+
+	return _step;
+}
+
+uint32_t LockstepComponents::member_begin(int member)
+{
+	if (member < 0) {
+		return UINT32_MAX;
+	}
+
+	const uint32_t bit = 1u << member;
+
+	std::unique_lock<std::mutex> lock(_members_mutex);
+
+	_in_step = true;
+
+	if (!_gated) {
+		// startup: everything queued is due, the first step waits until we're done
+		_members_running |= bit;
+		return UINT32_MAX;
+	}
+
+	_members_cv.wait(lock, [this, bit] { return (_members_running & bit) || !(_members_used & bit); });
+
+	return _step;
+}
+
+void LockstepComponents::member_end(int member)
+{
+	if (member < 0) {
+		return;
+	}
+
+	_in_step = false;
+
+	std::lock_guard<std::mutex> lock(_members_mutex);
+	_members_running &= ~(1u << member);
+
+	if ((_members_running & _members_used) == 0) {
+		_members_cv.notify_all();
+	}
+}
+
+void LockstepComponents::run_steps()
+{
+	if (!_parallel) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> steps_lock(_steps_mutex);
+	std::unique_lock<std::mutex> lock(_members_mutex);
+
+	_gated = true;
+
+	for (int i = 0; i < MAX_STEPS_PER_CYCLE; ++i) {
+		// barrier: wait for the previous step (or the work started before gating)
+		_members_cv.wait(lock, [this] { return (_members_running & _members_used) == 0; });
+
+		const uint32_t released = _members_pending & _members_used;
+
+		if (released == 0) {
+			return;
+		}
+
+		_members_pending = 0;
+		_members_running = released;
+		++_step;
+		++_steps_total;
+		_members_cv.notify_all();
+	}
+
+	_members_cv.wait(lock, [this] { return (_members_running & _members_used) == 0; });
+}
@@ -6,6 +6,11 @@
 #include <iostream>
 #include <functional>
 #include <chrono>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <cstdio>
 
 class TestThread
 {
@@ -318,3 +323,176 @@ TEST(LockstepScheduler, All)
 		test_multiple_semaphores_waiting();
 	}
 }
+
+class StepMember
+{
+public:
+	StepMember(LockstepComponents &components, const std::function<void(uint32_t)> &work)
+		: _components(components), _work(work), _member(components.register_member())
+	{
+		_thread = std::thread(std::bind(&StepMember::execute, this));
+	}
+
+	~StepMember()
+	{
+		_stop = true;
+		_components.unregister_member(_member);
+		_thread.join();
+	}
+
+	int member() const { return _member; }
+
+private:
+	void execute()
+	{
+		// this is what a work queue does in parallel mode
+		while (true) {
+			const uint32_t step = _components.member_begin(_member);
+
+			if (_stop) {
+				_components.member_end(_member);
+				break;
+			}
+
+			_work(step);
+			_components.member_end(_member);
+		}
+	}
+
+	LockstepComponents &_components;
+	std::function<void(uint32_t)> _work;
+	const int _member;
+	std::atomic<bool> _stop{false};
+	std::thread _thread;
+};
+
+void test_parallel_steps()
+{
+	LockstepComponents components;
+	components.set_parallel(true);
+	components.run_steps(); // gate the members from the start
+
+	std::mutex runs_mutex;
+	std::vector<std::pair<uint32_t, int>> runs; // (step, member index)
+
+	constexpr int num_members = 3;
+	std::unique_ptr<StepMember> members[num_members];
+
+	for (int i = 0; i < num_members; ++i) {
+		members[i].reset(new StepMember(components, [&, i](uint32_t step) {
+			{
+				std::lock_guard<std::mutex> lock(runs_mutex);
+				runs.push_back({step, i});
+			}
+
+			EXPECT_TRUE(components.in_step());
+
+			if (i < num_members - 1) {
+				// work queued during a step is tagged with it, so it is only due in the next step
+				EXPECT_EQ(components.member_add(members[i + 1]->member()), step);
+			}
+		}));
+		EXPECT_EQ(members[i]->member(), i);
+	}
+
+	// a chain: every member only runs after the previous one
+	const uint32_t tag = components.member_add(members[0]->member());
+	components.run_steps();
+	EXPECT_FALSE(components.in_step());
+
+	ASSERT_EQ(runs.size(), 3u);
+
+	for (int i = 0; i < num_members; ++i) {
+		EXPECT_EQ(runs[i].first, tag + 1 + i);
+		EXPECT_EQ(runs[i].second, i);
+	}
+
+	// members with pending work run in the same step
+	runs.clear();
+	components.member_add(members[1]->member());
+	components.member_add(members[2]->member());
+	components.run_steps();
+
+	ASSERT_EQ(runs.size(), 3u);
+	std::sort(runs.begin(), runs.end());
+	EXPECT_EQ(runs[0].first, tag + 4);
+	EXPECT_EQ(runs[0].second, 1);
+	EXPECT_EQ(runs[1].first, tag + 4);
+	EXPECT_EQ(runs[1].second, 2);
+	EXPECT_EQ(runs[2].first, tag + 5);
+	EXPECT_EQ(runs[2].second, 2);
+
+	EXPECT_EQ(components.steps(), 5u);
+}
+
+TEST(LockstepComponents, ParallelSteps)
+{
+	for (unsigned iteration = 1; iteration <= 100; ++iteration) {
+		test_parallel_steps();
+	}
+}
+
+// not part of the unit tests, run with --gtest_also_run_disabled_tests
+TEST(LockstepComponents, DISABLED_ParallelBenchmark)
+{
+	// a step of 1ms simulated time, where 4 work queues are blocked for 150us each
+	constexpr int num_members = 4;
+	constexpr int num_steps = 500;
+	constexpr uint64_t step_us = 1000;
+	const std::chrono::microseconds work_duration{150};
+
+	const double simulated_s = num_steps * step_us * 1e-6;
+
+	// sequential: one work queue after the other
+	double sequential_s;
+	{
+		LockstepScheduler ls;
+		const auto start = std::chrono::steady_clock::now();
+
+		for (int step = 1; step <= num_steps; ++step) {
+			ls.set_absolute_time(some_time_us + step * step_us);
+
+			for (int i = 0; i < num_members; ++i) {
+				std::this_thread::sleep_for(work_duration);
+			}
+
+			ls.components().wait_for_components();
+		}
+
+		sequential_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	// parallel: all work queues in the same step
+	double parallel_s;
+	{
+		LockstepScheduler ls;
+		LockstepComponents &components = ls.components();
+		components.set_parallel(true);
+		components.run_steps();
+
+		std::unique_ptr<StepMember> members[num_members];
+
+		for (int i = 0; i < num_members; ++i) {
+			members[i].reset(new StepMember(components, [&](uint32_t) { std::this_thread::sleep_for(work_duration); }));
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+
+		for (int step = 1; step <= num_steps; ++step) {
+			ls.set_absolute_time(some_time_us + step * step_us);
+
+			for (int i = 0; i < num_members; ++i) {
+				components.member_add(members[i]->member());
+			}
+
+			components.wait_for_components();
+		}
+
+		parallel_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		EXPECT_EQ(components.steps(), (uint64_t)num_steps);
+	}
+
+	printf("simulated seconds per wall second (%i work queues, %u CPUs): sequential %.2f, parallel %.2f\n",
+	       num_members, std::thread::hardware_concurrency(), simulated_s / sequential_s, simulated_s / parallel_s);
+}
@@ -247,11 +247,25 @@ __EXPORT extern void px4_lockstep_unregister_component(int component);
 __EXPORT extern void px4_lockstep_progress(int component);
 __EXPORT extern void px4_lockstep_wait_for_components(void);
 
+/*
+ * Parallel lockstep mode (PX4_LOCKSTEP_PARALLEL=1): work queues run in barrier-synchronized steps.
+ * px4_lockstep_run_steps() returns once the work queues are idle, and only then the simulated time advances.
+ * A work item must therefore not block on the simulated time (px4_usleep(), px4_sleep()), this would deadlock
+ * and is asserted against.
+ */
+__EXPORT extern void px4_lockstep_run_steps(void);
+__EXPORT extern int px4_lockstep_register_work_queue(void);
+__EXPORT extern void px4_lockstep_unregister_work_queue(int member);
+__EXPORT extern uint32_t px4_lockstep_work_queue_add(int member);
+__EXPORT extern uint32_t px4_lockstep_work_queue_begin(int member);
+__EXPORT extern void px4_lockstep_work_queue_end(int member);
+
 #else
 static inline int px4_lockstep_register_component(void) { return 0; }
 static inline void px4_lockstep_unregister_component(int component) { }
 static inline void px4_lockstep_progress(int component) { }
 static inline void px4_lockstep_wait_for_components(void) { }
+static inline void px4_lockstep_run_steps(void) { }
 #endif /* defined(ENABLE_LOCKSTEP_SCHEDULER) */
 
 
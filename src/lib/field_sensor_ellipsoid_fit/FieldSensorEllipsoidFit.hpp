@@ -0,0 +1,389 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file FieldSensorEllipsoidFit.hpp
+ *
+ * Online sphere/ellipsoid fit for the magnetometer calibration parameters.
+ *
+ * The fit is linear in the coefficients of the quadric surface the samples lie on and is solved with
+ * recursive least squares, every sample is an O(1) update and the calibration can be extracted at any time.
+ * With a forgetting factor < 1 it tracks slowly changing calibrations, e.g. in flight.
+ *
+ * Sphere:    |x|^2 = 2 x^T c + (r^2 - |c|^2)
+ * Ellipsoid: x^T Q x + 2 b^T x + d = 0 with the trace of Q fixed to -3, which (unlike the common
+ *            x^T Q x + 2 b^T x = 1 form) stays well conditioned if the offset is close to the field strength:
+ *            |x|^2 = u0 (x^2 + y^2 - 2 z^2) + u1 (x^2 - 2 y^2 + z^2) + 2 u2 xy + 2 u3 xz + 2 u4 yz + 2 [u5 u6 u7] x + u8
+ *            The offset is c = -Q^-1 b and (x - c)^T Q (x - c) = c^T Q c - d.
+ *
+ * Reference: Yury Petrov, Ellipsoid Fit, MATLAB Central File Exchange
+ */
+
+#pragma once
+
+#include <matrix/matrix/math.hpp>
+#include <px4_platform_common/defines.h>
+
+class FieldSensorEllipsoidFit
+{
+public:
+	static constexpr unsigned COVERAGE_BINS = 24;
+
+	FieldSensorEllipsoidFit() { reset(); }
+	~FieldSensorEllipsoidFit() = default;
+
+	/**
+	 * Also fit the scale factors (diagonal and off-diagonal), otherwise only offsets and radius.
+	 * Resets the estimator.
+	 */
+	void setFullEllipsoid(bool full_ellipsoid) { _full_ellipsoid = full_ellipsoid; reset(); }
+
+	/**
+	 * Approximate field strength, the samples are normalized with it to keep the problem well conditioned.
+	 * Resets the estimator.
+	 */
+	void setFieldNorm(float field_norm) { _field_norm = (field_norm > FLT_EPSILON) ? field_norm : 1.f; reset(); }
+
+	/**
+	 * Weight of the previous samples for every new sample, 1 to weigh all samples equally
+	 */
+	void setForgettingFactor(float forgetting_factor) { _forgetting_factor = fminf(fmaxf(forgetting_factor, 0.9f), 1.f); }
+
+	void reset()
+	{
+		_sphere.reset();
+		_ellipsoid.reset();
+		_sample_count = 0;
+		_coverage_mask = 0;
+	}
+
+	/**
+	 * Update the fit with a new sample
+	 * @param field field sensor data, in the same frame and units as the calibration is applied to
+	 */
+	void update(const matrix::Vector3f &field)
+	{
+		const matrix::Vector3f x = field / _field_norm;
+
+		if (_full_ellipsoid) {
+			const float xx = x(0) * x(0);
+			const float yy = x(1) * x(1);
+			const float zz = x(2) * x(2);
+			const float phi[9] {xx + yy - 2.f * zz, xx - 2.f * yy + zz,
+					    2.f * x(0) *x(1), 2.f * x(0) *x(2), 2.f * x(1) *x(2),
+					    2.f * x(0), 2.f * x(1), 2.f * x(2), 1.f};
+			_ellipsoid.update(phi, xx + yy + zz, _forgetting_factor);
+
+		} else {
+			const float phi[4] {2.f * x(0), 2.f * x(1), 2.f * x(2), 1.f};
+			_sphere.update(phi, x.norm_squared(), _forgetting_factor);
+		}
+
+		if (_sample_count < UINT16_MAX) {
+			_sample_count++;
+		}
+
+		// direction of the sample seen from the current offset estimate, the raw direction until the fit is usable
+		matrix::Vector3f offset{};
+
+		if (_sample_count > minSamples()) {
+			offset = normalizedOffset();
+		}
+
+		_coverage_mask |= 1u << coverageBin(x - offset);
+	}
+
+	/**
+	 * Extract the calibration parameters, corrected = diag/offdiag * (field - offset) has the norm radius
+	 * With the full ellipsoid the determinant of the scale matrix is 1.
+	 * @return true if enough samples were collected and the parameters are valid
+	 */
+	bool getCalibration(matrix::Vector3f &offset, matrix::Vector3f &diag, matrix::Vector3f &offdiag, float &radius) const
+	{
+		if (_sample_count <= minSamples()) {
+			return false;
+		}
+
+		if (!_full_ellipsoid) {
+			const matrix::Vector3f c{_sphere.theta[0], _sphere.theta[1], _sphere.theta[2]};
+			const float r_squared = _sphere.theta[3] + c.norm_squared();
+
+			if (!(r_squared > FLT_EPSILON)) {
+				return false;
+			}
+
+			offset = c * _field_norm;
+			diag = matrix::Vector3f{1.f, 1.f, 1.f};
+			offdiag.zero();
+			radius = sqrtf(r_squared) * _field_norm;
+			return isFinite(offset);
+		}
+
+		matrix::SquareMatrix3f Q;
+		matrix::Vector3f b;
+		float d;
+
+		if (!quadric(Q, b, d)) {
+			return false;
+		}
+
+		matrix::SquareMatrix3f Q_inv;
+
+		if (!matrix::inv(Q, Q_inv)) {
+			return false;
+		}
+
+		const matrix::Vector3f c = -(Q_inv * b);
+		const float k = c.dot(Q * c) - d;
+
+		if (!(fabsf(k) > FLT_EPSILON)) {
+			return false;
+		}
+
+		// (x - c)^T M (x - c) = 1, M has to be positive definite
+		const matrix::SquareMatrix3f M = Q / k;
+		const float minor_2 = M(0, 0) * M(1, 1) - M(0, 1) * M(1, 0);
+		const float det = determinant(M);
+
+		if (!(M(0, 0) > 0.f) || !(minor_2 > 0.f) || !(det > 0.f)) {
+			return false;
+		}
+
+		// the scale matrix W is the symmetric square root of M, scaled to a determinant of 1
+		const float r = powf(det, -1.f / 6.f);
+		matrix::SquareMatrix3f W;
+
+		if (!sqrtSymmetric(M, W)) {
+			return false;
+		}
+
+		W *= r;
+
+		offset = c * _field_norm;
+		diag = W.diag();
+		offdiag = matrix::Vector3f{W(0, 1), W(0, 2), W(1, 2)};
+		radius = r * _field_norm;
+
+		return isFinite(offset) && isFinite(diag) && isFinite(offdiag);
+	}
+
+	unsigned sampleCount() const { return _sample_count; }
+
+	/** bitmask of the field directions (COVERAGE_BINS cube face quadrants) seen so far */
+	uint32_t coverageMask() const { return _coverage_mask; }
+
+	/** fraction of the field directions seen so far, approximate until the offset estimate is usable */
+	float coverage() const
+	{
+		unsigned bins = 0;
+
+		for (uint32_t mask = _coverage_mask; mask != 0; mask &= mask - 1) {
+			bins++;
+		}
+
+		return (float)bins / COVERAGE_BINS;
+	}
+
+private:
+	template<size_t N>
+	struct RecursiveLeastSquares {
+		float theta[N];
+		float P[N][N];
+
+		void reset()
+		{
+			for (size_t i = 0; i < N; i++) {
+				theta[i] = 0.f;
+
+				for (size_t j = 0; j < N; j++) {
+					P[i][j] = (i == j) ? P_INITIAL : 0.f;
+				}
+			}
+		}
+
+		void update(const float (&phi)[N], float y, float forgetting_factor)
+		{
+			float P_phi[N];
+			float denominator = forgetting_factor;
+			float residual = y;
+
+			for (size_t i = 0; i < N; i++) {
+				P_phi[i] = 0.f;
+
+				for (size_t j = 0; j < N; j++) {
+					P_phi[i] += P[i][j] * phi[j];
+				}
+
+				denominator += phi[i] * P_phi[i];
+				residual -= phi[i] * theta[i];
+			}
+
+			if (!(denominator > FLT_EPSILON)) {
+				return;
+			}
+
+			// don't let the covariance grow without bound if the samples don't excite all parameters
+			float trace = 0.f;
+
+			for (size_t i = 0; i < N; i++) {
+				trace += P[i][i];
+			}
+
+			const float inv_lambda = (trace < N * P_FORGETTING_MAX) ? 1.f / forgetting_factor : 1.f;
+
+			for (size_t i = 0; i < N; i++) {
+				const float gain = P_phi[i] / denominator;
+				theta[i] += gain * residual;
+
+				// keep the covariance symmetric, otherwise rounding errors accumulate with forgetting
+				for (size_t j = i; j < N; j++) {
+					P[i][j] = (P[i][j] - gain * P_phi[j]) * inv_lambda;
+					P[j][i] = P[i][j];
+				}
+			}
+		}
+	};
+
+	static constexpr float P_INITIAL = 1e3f;
+	static constexpr float P_FORGETTING_MAX = 1.f; ///< mean covariance above which old samples are not forgotten
+
+	unsigned minSamples() const { return _full_ellipsoid ? 18 : 8; }
+
+	bool quadric(matrix::SquareMatrix3f &Q, matrix::Vector3f &b, float &d) const
+	{
+		const float *u = _ellipsoid.theta;
+		const float q[9] {u[0] + u[1] - 1.f, u[2], u[3],
+				  u[2], u[0] - 2.f * u[1] - 1.f, u[4],
+				  u[3], u[4], u[1] - 2.f * u[0] - 1.f};
+		Q = matrix::SquareMatrix3f{q};
+		b = matrix::Vector3f{u[5], u[6], u[7]};
+		d = u[8];
+		return isFinite(Q) && isFinite(b) && PX4_ISFINITE(d);
+	}
+
+	static float determinant(const matrix::SquareMatrix3f &A)
+	{
+		return A(0, 0) * (A(1, 1) * A(2, 2) - A(2, 1) * A(1, 2))
+		       - A(0, 1) * (A(1, 0) * A(2, 2) - A(1, 2) * A(2, 0))
+		       + A(0, 2) * (A(1, 0) * A(2, 1) - A(1, 1) * A(2, 0));
+	}
+
+	template<size_t M, size_t N>
+	static bool isFinite(const matrix::Matrix<float, M, N> &m)
+	{
+		for (size_t i = 0; i < M; i++) {
+			for (size_t j = 0; j < N; j++) {
+				if (!PX4_ISFINITE(m(i, j))) {
+					return false;
+				}
+			}
+		}
+
+		return true;
+	}
+
+	/** offset estimate in normalized units */
+	matrix::Vector3f normalizedOffset() const
+	{
+		if (!_full_ellipsoid) {
+			return matrix::Vector3f{_sphere.theta[0], _sphere.theta[1], _sphere.theta[2]};
+		}
+
+		matrix::SquareMatrix3f Q;
+		matrix::Vector3f b;
+		float d;
+		matrix::SquareMatrix3f Q_inv;
+
+		if (quadric(Q, b, d) && matrix::inv(Q, Q_inv)) {
+			const matrix::Vector3f c = -(Q_inv * b);
+
+			if (isFinite(c)) {
+				return c;
+			}
+		}
+
+		return matrix::Vector3f{};
+	}
+
+	/** Denman-Beavers iteration, converges quickly as the scale matrix is close to the identity */
+	static bool sqrtSymmetric(const matrix::SquareMatrix3f &M, matrix::SquareMatrix3f &sqrt_M)
+	{
+		matrix::SquareMatrix3f Y = M;
+		matrix::SquareMatrix3f Z;
+		Z.setIdentity();
+
+		for (int i = 0; i < 20; i++) {
+			matrix::SquareMatrix3f Y_inv;
+			matrix::SquareMatrix3f Z_inv;
+
+			if (!matrix::inv(Y, Y_inv) || !matrix::inv(Z, Z_inv)) {
+				return false;
+			}
+
+			const matrix::SquareMatrix3f Y_next = (Y + Z_inv) * 0.5f;
+			Z = (Z + Y_inv) * 0.5f;
+
+			const float change = (Y_next - Y).abs().max();
+			Y = Y_next;
+
+			if (change < 1e-7f) {
+				break;
+			}
+		}
+
+		// symmetrize, the iteration only keeps the symmetry up to rounding errors
+		sqrt_M = (Y + Y.transpose()) * 0.5f;
+		return isFinite(sqrt_M);
+	}
+
+	/** cube face (dominant axis and sign) and quadrant (signs of the other two axes) of a direction */
+	static unsigned coverageBin(const matrix::Vector3f &v)
+	{
+		const matrix::Vector3f a = v.abs();
+		const unsigned axis = (a(0) >= a(1)) ? ((a(0) >= a(2)) ? 0 : 2) : ((a(1) >= a(2)) ? 1 : 2);
+		const unsigned face = 2 * axis + ((v(axis) < 0.f) ? 1 : 0);
+		const unsigned quadrant = ((v((axis + 1) % 3) < 0.f) ? 1 : 0) + ((v((axis + 2) % 3) < 0.f) ? 2 : 0);
+		return 4 * face + quadrant;
+	}
+
+	RecursiveLeastSquares<4> _sphere;
+	RecursiveLeastSquares<9> _ellipsoid;
+
+	float _field_norm{1.f};
+	float _forgetting_factor{1.f};
+	bool _full_ellipsoid{false};
+
+	uint16_t _sample_count{0};
+	uint32_t _coverage_mask{0};
+};
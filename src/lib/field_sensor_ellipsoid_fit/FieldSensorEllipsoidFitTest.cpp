@@ -0,0 +1,174 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * Test code for the online Field Sensor Ellipsoid Fit
+ * Run this test only using make tests TESTFILTER=FieldSensorEllipsoidFit
+ */
+
+#include <gtest/gtest.h>
+#include <FieldSensorEllipsoidFit.hpp>
+
+using namespace matrix;
+
+class FieldSensorEllipsoidFitTest : public ::testing::Test
+{
+public:
+	// field of the given strength rotated through all directions and distorted by offset and scale matrix
+	Vector3f sample(int i, int n, float field, const Vector3f &offset, const SquareMatrix3f &distortion)
+	{
+		// spiral on the sphere, equidistributed directions
+		const float z = 1.f - (2.f * i + 1.f) / n;
+		const float r = sqrtf(1.f - z * z);
+		const float phi = i * 2.39996323f;
+		const Vector3f direction{r * cosf(phi), r * sinf(phi), z};
+		return distortion * (direction * field) + offset;
+	}
+};
+
+TEST_F(FieldSensorEllipsoidFitTest, sphere)
+{
+	// GIVEN: samples on a sphere with a large offset
+	const float field = 0.4f;
+	const Vector3f offset_true{0.5f, -0.3f, 0.2f};
+	SquareMatrix3f identity;
+	identity.setIdentity();
+
+	FieldSensorEllipsoidFit fit;
+	fit.setFieldNorm(0.5f);
+
+	Vector3f offset, diag, offdiag;
+	float radius = 0.f;
+
+	// WHEN: not enough samples have been collected
+	for (int i = 0; i < 5; i++) {
+		fit.update(sample(i, 100, field, offset_true, identity));
+	}
+
+	// THEN: no calibration is available
+	EXPECT_FALSE(fit.getCalibration(offset, diag, offdiag, radius));
+
+	// WHEN: the whole sphere has been covered
+	for (int i = 5; i < 100; i++) {
+		fit.update(sample(i, 100, field, offset_true, identity));
+	}
+
+	// THEN: offset and radius are found and all directions have been seen
+	ASSERT_TRUE(fit.getCalibration(offset, diag, offdiag, radius));
+	EXPECT_NEAR(radius, field, 1e-3f);
+	EXPECT_NEAR(offset(0), offset_true(0), 1e-3f);
+	EXPECT_NEAR(offset(1), offset_true(1), 1e-3f);
+	EXPECT_NEAR(offset(2), offset_true(2), 1e-3f);
+	EXPECT_EQ(diag, Vector3f(1.f, 1.f, 1.f));
+	EXPECT_EQ(offdiag, Vector3f());
+	EXPECT_FLOAT_EQ(fit.coverage(), 1.f);
+	EXPECT_EQ(fit.sampleCount(), 100u);
+}
+
+TEST_F(FieldSensorEllipsoidFitTest, ellipsoid)
+{
+	// GIVEN: samples on an ellipsoid with soft-iron distortion and an offset larger than the field
+	const float field = 0.4f;
+	const Vector3f offset_true{-0.18f, 0.05f, -0.58f};
+	const float d[9] {1.05f, 0.03f, -0.02f,
+			  0.03f, 0.97f, 0.04f,
+			  -0.02f, 0.04f, 0.99f
+			 };
+	const SquareMatrix3f distortion{d};
+
+	FieldSensorEllipsoidFit fit;
+	fit.setFullEllipsoid(true);
+	fit.setFieldNorm(0.5f);
+
+	for (int i = 0; i < 200; i++) {
+		fit.update(sample(i, 200, field, offset_true, distortion));
+	}
+
+	// WHEN: extracting the calibration
+	Vector3f offset, diag, offdiag;
+	float radius = 0.f;
+	ASSERT_TRUE(fit.getCalibration(offset, diag, offdiag, radius));
+
+	// THEN: the calibration maps all samples back onto a sphere and the offset is found
+	EXPECT_NEAR(offset(0), offset_true(0), 1e-3f);
+	EXPECT_NEAR(offset(1), offset_true(1), 1e-3f);
+	EXPECT_NEAR(offset(2), offset_true(2), 1e-3f);
+
+	const float w[9] {diag(0), offdiag(0), offdiag(1),
+			  offdiag(0), diag(1), offdiag(2),
+			  offdiag(1), offdiag(2), diag(2)
+			 };
+	const SquareMatrix3f scale{w};
+	const float det = scale(0, 0) * (scale(1, 1) * scale(2, 2) - scale(2, 1) * scale(1, 2))
+			  - scale(0, 1) * (scale(1, 0) * scale(2, 2) - scale(1, 2) * scale(2, 0))
+			  + scale(0, 2) * (scale(1, 0) * scale(2, 1) - scale(1, 1) * scale(2, 0));
+	EXPECT_NEAR(det, 1.f, 1e-4f);
+
+	for (int i = 0; i < 200; i += 7) {
+		const Vector3f corrected = scale * (sample(i, 200, field, offset_true, distortion) - offset);
+		EXPECT_NEAR(corrected.norm(), radius, 2e-3f);
+	}
+}
+
+TEST_F(FieldSensorEllipsoidFitTest, forgettingFactor)
+{
+	// GIVEN: a converged fit with a forgetting factor
+	const float field = 0.4f;
+	SquareMatrix3f identity;
+	identity.setIdentity();
+
+	FieldSensorEllipsoidFit fit;
+	fit.setFieldNorm(0.5f);
+	fit.setForgettingFactor(0.98f);
+
+	for (int i = 0; i < 200; i++) {
+		fit.update(sample(i % 100, 100, field, Vector3f(0.1f, 0.f, 0.f), identity));
+	}
+
+	// WHEN: the offset changes
+	const Vector3f offset_new{-0.1f, 0.2f, 0.f};
+
+	for (int i = 0; i < 400; i++) {
+		fit.update(sample(i % 100, 100, field, offset_new, identity));
+	}
+
+	// THEN: the fit follows the new offset
+	Vector3f offset, diag, offdiag;
+	float radius = 0.f;
+	ASSERT_TRUE(fit.getCalibration(offset, diag, offdiag, radius));
+	EXPECT_NEAR(offset(0), offset_new(0), 1e-3f);
+	EXPECT_NEAR(offset(1), offset_new(1), 1e-3f);
+	EXPECT_NEAR(offset(2), offset_new(2), 1e-3f);
+	EXPECT_NEAR(radius, field, 1e-3f);
+}
@@ -65,6 +65,8 @@ void MapProjection::initReference(double lat_0, double lon_0, uint64_t timestamp
 	_ref_lon = math::radians(lon_0);
 	_ref_sin_lat = sin(_ref_lat);
 	_ref_cos_lat = cos(_ref_lat);
+	_ref_half_sin_cos_lat = static_cast<float>(0.5 * _ref_sin_lat * _ref_cos_lat);
+	_ref_tan_lat = static_cast<float>(tan(_ref_lat));
 	_ref_init_done = true;
 }
 
@@ -84,7 +86,8 @@ void MapProjection::project(double lat, double lon, float &x, float &y) const
 	double k = 1.0;
 
 	if (fabs(c) > 0) {
-		k = (c / sin(c));
+		// sin(acos(arg)), factorized to stay accurate for small angles
+		k = c / sqrt((1.0 - arg) * (1.0 + arg));
 	}
 
 	x = static_cast<float>(k * (_ref_cos_lat * sin_lat - _ref_sin_lat * cos_lat * cos_d_lon) * CONSTANTS_RADIUS_OF_EARTH);
@@ -113,6 +116,23 @@ void MapProjection::reproject(float x, float y, double &lat, double &lon) const
 	}
 }
 
+void MapProjection::projectLocal(const double lat[], const double lon[], float x[], float y[], unsigned count) const
+{
+	// no calls or branches per point, the compiler can vectorize this loop
+	const float half_sin_cos_lat = _ref_half_sin_cos_lat;
+	const float sin_lat = static_cast<float>(_ref_sin_lat);
+	const float cos_lat = static_cast<float>(_ref_cos_lat);
+
+	for (unsigned i = 0; i < count; i++) {
+		float d_lat;
+		float d_lon;
+		localDelta(lat[i], lon[i], d_lat, d_lon);
+
+		x[i] = (d_lat + half_sin_cos_lat * d_lon * d_lon) * CONSTANTS_RADIUS_OF_EARTH_F;
+		y[i] = d_lon * (cos_lat - sin_lat * d_lat) * CONSTANTS_RADIUS_OF_EARTH_F;
+	}
+}
+
 float get_distance_to_next_waypoint(double lat_now, double lon_now, double lat_next, double lon_next)
 {
 	const double lat_now_rad = math::radians(lat_now);
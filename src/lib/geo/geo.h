@@ -167,6 +167,8 @@ private:
 	double _ref_lon{0.0};
 	double _ref_sin_lat{0.0};
 	double _ref_cos_lat{0.0};
+	float _ref_half_sin_cos_lat{0.f};	///< local approximation terms
+	float _ref_tan_lat{0.f};
 	bool _ref_init_done{false};
 
 public:
@@ -270,4 +272,64 @@ public:
 	 * @param lon in degrees (8.1234567°, not 81234567°)
 	 */
 	void reproject(float x, float y, double &lat, double &lon) const;
+
+	/**
+	 * Fast approximation of project() for points close to the reference
+	 *
+	 * Second order expansion of the projection around the reference, without any trigonometric function per point.
+	 * The error grows with the cube of the distance to the reference, it is below 1 mm up to 2 km and below
+	 * 1 cm up to 5 km at mid latitudes (it grows with the tangent of the reference latitude, don't use it close to the poles).
+	 * @param lat in degrees (47.1234567°, not 471234567°)
+	 * @param lon in degrees (8.1234567°, not 81234567°)
+	 * @param x north
+	 * @param y east
+	 */
+	void projectLocal(double lat, double lon, float &x, float &y) const
+	{
+		float d_lat;
+		float d_lon;
+		localDelta(lat, lon, d_lat, d_lon);
+
+		x = (d_lat + _ref_half_sin_cos_lat * d_lon * d_lon) * CONSTANTS_RADIUS_OF_EARTH_F;
+		y = d_lon * (static_cast<float>(_ref_cos_lat) - static_cast<float>(_ref_sin_lat) * d_lat) * CONSTANTS_RADIUS_OF_EARTH_F;
+	}
+
+	/**
+	 * Fast approximation of project() for many points close to the reference, see projectLocal()
+	 * @param count number of points
+	 */
+	void projectLocal(const double lat[], const double lon[], float x[], float y[], unsigned count) const;
+
+	/**
+	 * Fast approximation of reproject() for points close to the reference, see projectLocal()
+	 *
+	 * @param x north
+	 * @param y east
+	 * @param lat in degrees (47.1234567°, not 471234567°)
+	 * @param lon in degrees (8.1234567°, not 81234567°)
+	 */
+	void reprojectLocal(float x, float y, double &lat, double &lon) const
+	{
+		const float x_rad = x / CONSTANTS_RADIUS_OF_EARTH_F;
+		const float y_rad = y / CONSTANTS_RADIUS_OF_EARTH_F;
+
+		const float d_lat = x_rad - 0.5f * _ref_tan_lat * y_rad * y_rad;
+		const float d_lon = y_rad / (static_cast<float>(_ref_cos_lat) - static_cast<float>(_ref_sin_lat) * d_lat);
+
+		lat = math::degrees(_ref_lat + static_cast<double>(d_lat));
+		lon = math::degrees(matrix::wrap_pi(_ref_lon + static_cast<double>(d_lon)));
+	}
+
+private:
+	/**
+	 * latitude and longitude difference to the reference in radians, the longitude difference is wrapped to [-pi, pi)
+	 */
+	void localDelta(double lat, double lon, float &d_lat, float &d_lon) const
+	{
+		double d_lon_rad = math::radians(lon) - _ref_lon;
+		d_lon_rad = (d_lon_rad >= M_PI) ? d_lon_rad - 2.0 * M_PI : ((d_lon_rad < -M_PI) ? d_lon_rad + 2.0 * M_PI : d_lon_rad);
+
+		d_lat = static_cast<float>(math::radians(lat) - _ref_lat);
+		d_lon = static_cast<float>(d_lon_rad);
+	}
 };
@@ -32,6 +32,7 @@
  ****************************************************************************/
 
 #include <gtest/gtest.h>
+#include <chrono>
 #include <math.h>
 #include <mathlib/mathlib.h>
 #include <memory>
@@ -214,3 +215,118 @@ TEST_F(GeoTest, waypoint_from_line_and_negative_distance)
 	EXPECT_FLOAT_EQ(lat_start - lat_offset, lat_target);
 	EXPECT_DOUBLE_EQ(lon_start, lon_target);
 }
+
+TEST_F(GeoTest, projectLocalAccuracy)
+{
+	// GIVEN: references at different latitudes, including one next to the date line
+	const double ref_lat[] {0.0, 47.3566094, -60.0, 30.0};
+	const double ref_lon[] {0.0, 8.5190237, 120.0, 179.999};
+
+	for (unsigned r = 0; r < sizeof(ref_lat) / sizeof(ref_lat[0]); r++) {
+		const MapProjection ref(ref_lat[r], ref_lon[r], 0);
+
+		// WHEN: projecting points in all directions with the exact and the local projection
+		for (float distance : {10.f, 100.f, 1000.f, 2000.f, 5000.f}) {
+			float max_error = 0.f;
+
+			for (int k = 0; k < 16; k++) {
+				const float bearing = k * M_PI_F / 8.f;
+				double lat;
+				double lon;
+				ref.reproject(distance * cosf(bearing), distance * sinf(bearing), lat, lon);
+
+				float x;
+				float y;
+				float x_local;
+				float y_local;
+				ref.project(lat, lon, x, y);
+				ref.projectLocal(lat, lon, x_local, y_local);
+				max_error = fmaxf(max_error, matrix::Vector2f(x - x_local, y - y_local).norm());
+
+				// the inverse matches as well
+				double lat_local;
+				double lon_local;
+				ref.reprojectLocal(x, y, lat_local, lon_local);
+				const float reproject_error = get_distance_to_next_waypoint(lat, lon, lat_local, lon_local);
+				max_error = fmaxf(max_error, reproject_error);
+			}
+
+			// THEN: the error stays within the documented bounds
+			const float bound = (distance <= 2000.f) ? 1e-3f : 1e-2f;
+			EXPECT_LT(max_error, bound) << "reference lat: " << ref_lat[r] << " distance: " << distance;
+		}
+	}
+}
+
+TEST_F(GeoTest, projectLocalBatch)
+{
+	// GIVEN: points around the reference
+	static constexpr unsigned N = 100;
+	double lat[N];
+	double lon[N];
+
+	for (unsigned i = 0; i < N; i++) {
+		lat[i] = 47.3566094 + 0.001 * (double)(i % 10) - 0.005;
+		lon[i] = 8.5190237 + 0.002 * (double)(i / 10) - 0.01;
+	}
+
+	const MapProjection ref(47.3566094, 8.5190237, 0);
+
+	// WHEN: projecting all of them at once
+	float x[N];
+	float y[N];
+	ref.projectLocal(lat, lon, x, y, N);
+
+	// THEN: the result is identical to the single point projection
+	for (unsigned i = 0; i < N; i++) {
+		float x_single;
+		float y_single;
+		ref.projectLocal(lat[i], lon[i], x_single, y_single);
+		EXPECT_EQ(x[i], x_single);
+		EXPECT_EQ(y[i], y_single);
+	}
+}
+
+// not part of the unit tests, run with --gtest_also_run_disabled_tests
+TEST_F(GeoTest, DISABLED_Benchmark)
+{
+	// GIVEN: a mission sized set of points within 1 km of the reference
+	static constexpr unsigned N = 1000;
+	static constexpr int N_RUNS = 200;
+	double lat[N];
+	double lon[N];
+
+	for (unsigned i = 0; i < N; i++) {
+		lat[i] = 47.3566094 + 0.009 * sin(0.1 * i);
+		lon[i] = 8.5190237 + 0.013 * cos(0.07 * i);
+	}
+
+	const MapProjection ref(47.3566094, 8.5190237, 0);
+	float x[N];
+	float y[N];
+	volatile float sink = 0.f;
+
+	const auto single_start = std::chrono::steady_clock::now();
+
+	for (int run = 0; run < N_RUNS; run++) {
+		for (unsigned i = 0; i < N; i++) {
+			ref.project(lat[i], lon[i], x[i], y[i]);
+		}
+
+		sink = sink + x[run % N];
+	}
+
+	const auto local_start = std::chrono::steady_clock::now();
+
+	for (int run = 0; run < N_RUNS; run++) {
+		ref.projectLocal(lat, lon, x, y, N);
+		sink = sink + x[run % N];
+	}
+
+	const auto local_end = std::chrono::steady_clock::now();
+
+	const double single_ns = std::chrono::duration<double, std::nano>(local_start - single_start).count() / (N * N_RUNS);
+	const double local_ns = std::chrono::duration<double, std::nano>(local_end - local_start).count() / (N * N_RUNS);
+
+	printf("per point: project %.1f ns, local batch %.1f ns\n", single_ns, local_ns);
+}
@@ -41,6 +41,10 @@ SAMPLING_MAX_LAT = 60
 SAMPLING_MIN_LON = -180
 SAMPLING_MAX_LON = 180
 
+# rows between the table grid points, used to compare the interpolation methods of get_mag_field()
+REFERENCE_LATITUDES = [-25, 35]
+reference_field = {}
+
 header = """/****************************************************************************
  *
  *   Copyright (c) 2020-2021 PX4 Development Team. All rights reserved.
@@ -75,12 +79,164 @@ header = """/*******************************************************************
  ****************************************************************************/
 
 #include <gtest/gtest.h>
+#include <chrono>
 #include <math.h>
 #include <mathlib/mathlib.h>
 
 #include "geo_mag_declination.h"
 """
 
+mag_field_tests = r"""
+TEST(GeoLookupTest, magFieldBilinear)
+{
+	// the combined lookup gives exactly the same result as the individual functions
+	for (float lat = -95.f; lat <= 95.f; lat += 1.3f) {
+		for (float lon = -185.f; lon <= 185.f; lon += 1.7f) {
+			const MagField field = get_mag_field(lat, lon);
+
+			EXPECT_EQ(field.declination, get_mag_declination_radians(lat, lon));
+			EXPECT_EQ(field.inclination, get_mag_inclination_radians(lat, lon));
+			EXPECT_EQ(field.strength, get_mag_strength_gauss(lat, lon));
+		}
+	}
+}
+
+TEST(GeoLookupTest, magFieldCache)
+{
+	// the cached cell must be updated when crossing cell boundaries, also at the poles and at +-180 degrees
+	for (MagFieldInterpolation interpolation : {MagFieldInterpolation::Bilinear, MagFieldInterpolation::Bicubic}) {
+		MagFieldCache cache;
+
+		for (float lat = -95.f; lat <= 95.f; lat += 2.3f) {
+			for (float lon = -185.f; lon <= 185.f; lon += 0.9f) {
+				const MagField field = get_mag_field(lat, lon, interpolation);
+				const MagField cached = get_mag_field(lat, lon, interpolation, &cache);
+
+				EXPECT_EQ(field.declination, cached.declination);
+				EXPECT_EQ(field.inclination, cached.inclination);
+				EXPECT_EQ(field.strength, cached.strength);
+			}
+		}
+	}
+}
+
+TEST(GeoLookupTest, magFieldBicubic)
+{
+	// the bicubic interpolation goes through the grid points
+	for (float lat = -80.f; lat <= 80.f; lat += 10.f) {
+		for (float lon = -180.f; lon <= 170.f; lon += 10.f) {
+			const MagField bilinear = get_mag_field(lat, lon);
+			const MagField bicubic = get_mag_field(lat, lon, MagFieldInterpolation::Bicubic);
+
+			EXPECT_NEAR(bicubic.declination, bilinear.declination, 1e-6f);
+			EXPECT_NEAR(bicubic.inclination, bilinear.inclination, 1e-6f);
+			EXPECT_NEAR(bicubic.strength, bilinear.strength, 1e-6f);
+		}
+	}
+
+	// and is continuous in the declination across +-180 degrees
+	const MagField west = get_mag_field(-60.f, 179.99f, MagFieldInterpolation::Bicubic);
+	const MagField east = get_mag_field(-60.f, -179.99f, MagFieldInterpolation::Bicubic);
+	EXPECT_NEAR(west.declination, east.declination, 1e-3f);
+}
+
+TEST(GeoLookupTest, magFieldAccuracy)
+{
+	// compare both interpolation methods to the model between the grid points
+	float error_bilinear[3] {};
+	float error_bicubic[3] {};
+
+	for (const auto &reference : reference_field) {
+		const MagField bilinear = get_mag_field(reference[0], reference[1]);
+		const MagField bicubic = get_mag_field(reference[0], reference[1], MagFieldInterpolation::Bicubic);
+
+		const float bilinear_data[3] {math::degrees(bilinear.declination), math::degrees(bilinear.inclination), bilinear.strength * 1e5f};
+		const float bicubic_data[3] {math::degrees(bicubic.declination), math::degrees(bicubic.inclination), bicubic.strength * 1e5f};
+
+		for (int i = 0; i < 3; i++) {
+			error_bilinear[i] += (bilinear_data[i] - reference[i + 2]) * (bilinear_data[i] - reference[i + 2]);
+			error_bicubic[i] += (bicubic_data[i] - reference[i + 2]) * (bicubic_data[i] - reference[i + 2]);
+		}
+
+		EXPECT_NEAR(bicubic_data[0], reference[2], 1.f);
+		EXPECT_NEAR(bicubic_data[1], reference[3], 1.f);
+		EXPECT_NEAR(bicubic_data[2], reference[4], 500.f);
+	}
+
+	const float n = sizeof(reference_field) / sizeof(reference_field[0]);
+	const char *name[3] {"declination (deg)", "inclination (deg)", "strength (nT)"};
+
+	for (int i = 0; i < 3; i++) {
+		const float rms_bilinear = sqrtf(error_bilinear[i] / n);
+		const float rms_bicubic = sqrtf(error_bicubic[i] / n);
+		printf("%s RMS error bilinear: %.4f, bicubic: %.4f\n", name[i], (double)rms_bilinear, (double)rms_bicubic);
+
+		EXPECT_LT(rms_bicubic, rms_bilinear);
+	}
+}
+
+// not part of the unit tests, run with --gtest_also_run_disabled_tests
+TEST(GeoLookupTest, DISABLED_Benchmark)
+{
+	static constexpr int N = 100000;
+	volatile float sink = 0.f;
+
+	// slowly moving position, as seen by the estimator
+	const auto position = [](int i, float & lat, float & lon) {
+		lat = 47.3f + 1e-4f * (i % 1000);
+		lon = 8.5f + 1e-4f * (i % 1000);
+	};
+
+	auto start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < N; i++) {
+		float lat, lon;
+		position(i, lat, lon);
+		sink = sink + get_mag_declination_radians(lat, lon) + get_mag_inclination_radians(lat, lon)
+		       + get_mag_strength_gauss(lat, lon);
+	}
+
+	const double separate = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / N;
+
+	start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < N; i++) {
+		float lat, lon;
+		position(i, lat, lon);
+		const MagField field = get_mag_field(lat, lon);
+		sink = sink + field.declination + field.inclination + field.strength;
+	}
+
+	const double combined = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / N;
+
+	MagFieldCache cache;
+	start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < N; i++) {
+		float lat, lon;
+		position(i, lat, lon);
+		const MagField field = get_mag_field(lat, lon, MagFieldInterpolation::Bilinear, &cache);
+		sink = sink + field.declination + field.inclination + field.strength;
+	}
+
+	const double cached = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / N;
+
+	start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < N; i++) {
+		float lat, lon;
+		position(i, lat, lon);
+		const MagField field = get_mag_field(lat, lon, MagFieldInterpolation::Bicubic, &cache);
+		sink = sink + field.declination + field.inclination + field.strength;
+	}
+
+	const double bicubic = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / N;
+
+	printf("separate: %.1f ns, get_mag_field: %.1f ns, cached: %.1f ns, cached bicubic: %.1f ns\n",
+	       separate, combined, cached, bicubic);
+}
+"""
+
 print(header)
 
 print('')
@@ -105,6 +261,9 @@ for latitude in range(SAMPLING_MIN_LAT, SAMPLING_MAX_LAT+1, SAMPLING_RES):
             error = 2
 
         print('\tEXPECT_NEAR(get_mag_declination_degrees({}, {}), {}, {} + {});'.format(p['latitude'], p['longitude'], p['declination'], p['declination_uncertainty'], error))
+
+        if latitude in REFERENCE_LATITUDES:
+            reference_field.setdefault((p['latitude'], p['longitude']), {})['d'] = p['declination']
 print('}')
 
 print('')
@@ -123,6 +282,9 @@ for latitude in range(SAMPLING_MIN_LAT, SAMPLING_MAX_LAT+1, SAMPLING_RES):
             error = 2
 
         print('\tEXPECT_NEAR(get_mag_inclination_degrees({}, {}), {}, {} + {});'.format(p['latitude'], p['longitude'], p['inclination'], p['inclination_uncertainty'], error))
+
+        if latitude in REFERENCE_LATITUDES:
+            reference_field.setdefault((p['latitude'], p['longitude']), {})['i'] = p['inclination']
 print('}')
 
 print('')
@@ -137,4 +299,17 @@ for latitude in range(SAMPLING_MIN_LAT, SAMPLING_MAX_LAT+1, SAMPLING_RES):
         error = 500
 
         print('\tEXPECT_NEAR(get_mag_strength_tesla({}, {}) * 1e9, {}, {} + {});'.format(p['latitude'], p['longitude'], p['totalintensity'], p['totalintensity_uncertainty'], error))
+
+        if latitude in REFERENCE_LATITUDES:
+            reference_field.setdefault((p['latitude'], p['longitude']), {})['f'] = p['totalintensity']
 print('}')
+
+print('')
+
+print('// latitude, longitude, declination (degrees), inclination (degrees), strength (nT)')
+print('static constexpr float reference_field[][5] {')
+for (latitude, longitude), field in sorted(reference_field.items()):
+    print('\t{{{}, {}, {}, {}, {}}},'.format(latitude, longitude, field['d'], field['i'], field['f']))
+print('};')
+
+print(mag_field_tests)
@@ -66,7 +66,14 @@ static constexpr unsigned get_lookup_table_index(float *val, float min, float ma
 	return static_cast<unsigned>((-(min) + *val) / SAMPLING_RES);
 }
 
-static constexpr float get_table_data(float lat, float lon, const int16_t table[LAT_DIM][LON_DIM])
+struct GridCell {
+	unsigned lat_index; // index of the south west grid point
+	unsigned lon_index;
+	float lat_scale;    // position within the cell [0, 1]
+	float lon_scale;
+};
+
+static constexpr GridCell get_grid_cell(float lat, float lon)
 {
 	lat = math::constrain(lat, SAMPLING_MIN_LAT, SAMPLING_MAX_LAT);
 
@@ -83,22 +90,159 @@ static constexpr float get_table_data(float lat, float lon, const int16_t table[
 	float min_lon = floorf(lon / SAMPLING_RES) * SAMPLING_RES;
 
 	/* find index of nearest low sampling point */
-	unsigned min_lat_index = get_lookup_table_index(&min_lat, SAMPLING_MIN_LAT, SAMPLING_MAX_LAT);
-	unsigned min_lon_index = get_lookup_table_index(&min_lon, SAMPLING_MIN_LON, SAMPLING_MAX_LON);
+	const unsigned min_lat_index = get_lookup_table_index(&min_lat, SAMPLING_MIN_LAT, SAMPLING_MAX_LAT);
+	const unsigned min_lon_index = get_lookup_table_index(&min_lon, SAMPLING_MIN_LON, SAMPLING_MAX_LON);
 
-	const float data_sw = table[min_lat_index][min_lon_index];
-	const float data_se = table[min_lat_index][min_lon_index + 1];
-	const float data_ne = table[min_lat_index + 1][min_lon_index + 1];
-	const float data_nw = table[min_lat_index + 1][min_lon_index];
-
-	/* perform bilinear interpolation on the four grid corners */
 	const float lat_scale = constrain((lat - min_lat) / SAMPLING_RES, 0.f, 1.f);
 	const float lon_scale = constrain((lon - min_lon) / SAMPLING_RES, 0.f, 1.f);
 
-	const float data_min = lon_scale * (data_se - data_sw) + data_sw;
-	const float data_max = lon_scale * (data_ne - data_nw) + data_nw;
+	return GridCell{min_lat_index, min_lon_index, lat_scale, lon_scale};
+}
+
+static constexpr float interpolate_bilinear(const GridCell &cell, float data_sw, float data_se, float data_nw,
+		float data_ne)
+{
+	/* perform bilinear interpolation on the four grid corners */
+	const float data_min = cell.lon_scale * (data_se - data_sw) + data_sw;
+	const float data_max = cell.lon_scale * (data_ne - data_nw) + data_nw;
+
+	return cell.lat_scale * (data_max - data_min) + data_min;
+}
+
+static constexpr float get_cell_data(const GridCell &cell, const int16_t table[LAT_DIM][LON_DIM])
+{
+	return interpolate_bilinear(cell,
+				    table[cell.lat_index][cell.lon_index], table[cell.lat_index][cell.lon_index + 1],
+				    table[cell.lat_index + 1][cell.lon_index], table[cell.lat_index + 1][cell.lon_index + 1]);
+}
+
+static constexpr float get_table_data(float lat, float lon, const int16_t table[LAT_DIM][LON_DIM])
+{
+	return get_cell_data(get_grid_cell(lat, lon), table);
+}
+
+static void catmull_rom_weights(float t, float w[4])
+{
+	w[0] = 0.5f * ((-t + 2.f) * t - 1.f) * t;
+	w[1] = 0.5f * ((3.f * t - 5.f) * t * t + 2.f);
+	w[2] = 0.5f * ((-3.f * t + 4.f) * t + 1.f) * t;
+	w[3] = 0.5f * (t - 1.f) * t * t;
+}
+
+static float interpolate_bicubic(const GridCell &cell, const float data[4][4])
+{
+	float w_lat[4];
+	float w_lon[4];
+	catmull_rom_weights(cell.lat_scale, w_lat);
+	catmull_rom_weights(cell.lon_scale, w_lon);
+
+	float result = 0.f;
+
+	for (int i = 0; i < 4; i++) {
+		result += w_lat[i] * (w_lon[0] * data[i][0] + w_lon[1] * data[i][1] + w_lon[2] * data[i][2] + w_lon[3] * data[i][3]);
+	}
+
+	return result;
+}
+
+static void load_grid_cell(const GridCell &cell, MagFieldCache &cache)
+{
+	for (int i = 0; i < 4; i++) {
+		// repeat the last row beyond the poles
+		const int row = constrain(static_cast<int>(cell.lat_index) + i - 1, 0, LAT_DIM - 1);
+
+		for (int j = 0; j < 4; j++) {
+			// the first and last column are both at +-180 degrees
+			int col = static_cast<int>(cell.lon_index) + j - 1;
+
+			if (col < 0) {
+				col += LON_DIM - 1;
+
+			} else if (col > LON_DIM - 1) {
+				col -= LON_DIM - 1;
+			}
+
+			cache.data[0][i][j] = declination_table[row][col];
+			cache.data[1][i][j] = inclination_table[row][col];
+			cache.data[2][i][j] = strength_table[row][col];
+		}
+	}
+
+	cache.lat_index = cell.lat_index;
+	cache.lon_index = cell.lon_index;
+}
+
+static MagField interpolate_grid_cell(const GridCell &cell, MagFieldInterpolation interpolation,
+				      const MagFieldCache &cache)
+{
+	float result[3];
+
+	if (interpolation == MagFieldInterpolation::Bicubic) {
+		// declination wraps at +-pi close to the magnetic poles, interpolate continuously around the cell
+		static constexpr float PI_E4 = static_cast<float>(M_PI) * 1e4f;
+		const float reference = cache.data[0][1][1];
+
+		for (int k = 0; k < 3; k++) {
+			float data[4][4];
+
+			for (int i = 0; i < 4; i++) {
+				for (int j = 0; j < 4; j++) {
+					data[i][j] = cache.data[k][i][j];
+
+					if (k == 0) {
+						if (data[i][j] - reference > PI_E4) {
+							data[i][j] -= 2.f * PI_E4;
+
+						} else if (data[i][j] - reference < -PI_E4) {
+							data[i][j] += 2.f * PI_E4;
+						}
+					}
+				}
+			}
+
+			result[k] = interpolate_bicubic(cell, data);
+		}
+
+		if (result[0] > PI_E4) {
+			result[0] -= 2.f * PI_E4;
+
+		} else if (result[0] < -PI_E4) {
+			result[0] += 2.f * PI_E4;
+		}
+
+	} else {
+		for (int k = 0; k < 3; k++) {
+			const int16_t (&data)[4][4] = cache.data[k];
+			result[k] = interpolate_bilinear(cell, data[1][1], data[1][2], data[2][1], data[2][2]);
+		}
+	}
+
+	// all tables are stored as 10^-4 radians or 10^-4 Gauss
+	return MagField{result[0] * 1e-4f, result[1] * 1e-4f, result[2] * 1e-4f};
+}
+
+MagField get_mag_field(float lat, float lon, MagFieldInterpolation interpolation, MagFieldCache *cache)
+{
+	const GridCell cell = get_grid_cell(lat, lon);
+
+	if (cache == nullptr) {
+		if (interpolation == MagFieldInterpolation::Bilinear) {
+			// only the four corners of the cell are needed
+			return MagField{get_cell_data(cell, declination_table) * 1e-4f,
+					get_cell_data(cell, inclination_table) * 1e-4f,
+					get_cell_data(cell, strength_table) * 1e-4f};
+		}
+
+		MagFieldCache local_cache;
+		load_grid_cell(cell, local_cache);
+		return interpolate_grid_cell(cell, interpolation, local_cache);
+	}
+
+	if ((cache->lat_index != static_cast<int>(cell.lat_index)) || (cache->lon_index != static_cast<int>(cell.lon_index))) {
+		load_grid_cell(cell, *cache);
+	}
 
-	return lat_scale * (data_max - data_min) + data_min;
+	return interpolate_grid_cell(cell, interpolation, *cache);
 }
 
 float get_mag_declination_radians(float lat, float lon)
@@ -41,6 +41,8 @@
 
 #pragma once
 
+#include <stdint.h>
+
 // Return magnetic declination in degrees or radians
 float get_mag_declination_degrees(float lat, float lon);
 float get_mag_declination_radians(float lat, float lon);
@@ -52,3 +54,27 @@ float get_mag_inclination_radians(float lat, float lon);
 // return magnetic field strength in Gauss or Tesla
 float get_mag_strength_gauss(float lat, float lon);
 float get_mag_strength_tesla(float lat, float lon);
+
+struct MagField {
+	float declination; // radians
+	float inclination; // radians
+	float strength;    // Gauss
+};
+
+enum class MagFieldInterpolation : uint8_t {
+	Bilinear, // same result as the individual functions above
+	Bicubic,  // Catmull-Rom, continuous first derivatives across grid cells
+};
+
+// Table data around the grid cell of the previous get_mag_field() call.
+// Owned by the caller, so that concurrent users don't share any state.
+struct MagFieldCache {
+	int lat_index{-1};
+	int lon_index{-1};
+	int16_t data[3][4][4] {}; // declination, inclination, strength at the 4x4 grid points around the cell
+};
+
+// Return magnetic declination, inclination and strength with a single lookup
+// If a cache is given the table access is skipped as long as the position stays within the same grid cell.
+MagField get_mag_field(float lat, float lon, MagFieldInterpolation interpolation = MagFieldInterpolation::Bilinear,
+		       MagFieldCache *cache = nullptr);
@@ -32,6 +32,7 @@
  ****************************************************************************/
 
 #include <gtest/gtest.h>
+#include <chrono>
 #include <math.h>
 #include <mathlib/mathlib.h>
 
@@ -5086,3 +5087,302 @@ TEST(GeoLookupTest, strength)
 	EXPECT_NEAR(get_mag_strength_tesla(60, 175) * 1e9, 54135.9, 145 + 500);
 	EXPECT_NEAR(get_mag_strength_tesla(60, 180) * 1e9, 53921, 145 + 500);
 }
+
+// latitude, longitude, declination (degrees), inclination (degrees), strength (nT)
+static constexpr float reference_field[][5] {
+	{-25, -180, 15.02726, -49.11776, 46027.5},
+	{-25, -175, 15.27347, -47.949, 44876.5},
+	{-25, -170, 15.42587, -46.80348, 43731.5},
+	{-25, -165, 15.52823, -45.66991, 42594.1},
+	{-25, -160, 15.5958, -44.52831, 41463.4},
+	{-25, -155, 15.62044, -43.36329, 40341},
+	{-25, -150, 15.58541, -42.17183, 39232.4},
+	{-25, -145, 15.47882, -40.96367, 38145},
+	{-25, -140, 15.29994, -39.75763, 37084.4},
+	{-25, -135, 15.06045, -38.57687, 36052.8},
+	{-25, -130, 14.78488, -37.44236, 35048.4},
+	{-25, -125, 14.50973, -36.36157, 34065.6},
+	{-25, -120, 14.27421, -35.31349, 33094},
+	{-25, -115, 14.0972, -34.23849, 32117},
+	{-25, -110, 13.94482, -33.04583, 31112.2},
+	{-25, -105, 13.7055, -31.64533, 30056.8},
+	{-25, -100, 13.19208, -29.99586, 28936.9},
+	{-25, -95, 12.17795, -28.15125, 27757.4},
+	{-25, -90, 10.45473, -26.28356, 26549.1},
+	{-25, -85, 7.89121, -24.67225, 25367.3},
+	{-25, -80, 4.47894, -23.65742, 24284.3},
+	{-25, -75, 0.35663, -23.56203, 23375.4},
+	{-25, -70, -4.19765, -24.59922, 22703.6},
+	{-25, -65, -8.8172, -26.79798, 22304.5},
+	{-25, -60, -13.13209, -29.98766, 22176.3},
+	{-25, -55, -16.85436, -33.85576, 22280.5},
+	{-25, -50, -19.82712, -38.04705, 22554.6},
+	{-25, -45, -22.0277, -42.25266, 22932.1},
+	{-25, -40, -23.53628, -46.25877, 23361.3},
+	{-25, -35, -24.48378, -49.95452, 23815.1},
+	{-25, -30, -24.9902, -53.31105, 24286.9},
+	{-25, -25, -25.11098, -56.34364, 24777.4},
+	{-25, -20, -24.8167, -59.06992, 25278.6},
+	{-25, -15, -24.02393, -61.47802, 25764.8},
+	{-25, -10, -22.6716, -63.51472, 26195.8},
+	{-25, -5, -20.81453, -65.09584, 26532.8},
+	{-25, 0, -18.68876, -66.13221, 26757.2},
+	{-25, 5, -16.69591, -66.55993, 26884.9},
+	{-25, 10, -15.28363, -66.36237, 26971.1},
+	{-25, 15, -14.776, -65.57963, 27103.6},
+	{-25, 20, -15.25917, -64.31233, 27390.2},
+	{-25, 25, -16.5812, -62.72568, 27940.4},
+	{-25, 30, -18.43578, -61.04416, 28846.2},
+	{-25, 35, -20.46377, -59.51878, 30162},
+	{-25, 40, -22.32978, -58.36672, 31889.8},
+	{-25, 45, -23.76649, -57.71167, 33975.6},
+	{-25, 50, -24.59574, -57.55918, 36320.9},
+	{-25, 55, -24.73424, -57.81734, 38804.2},
+	{-25, 60, -24.18541, -58.34509, 41304.5},
+	{-25, 65, -23.01531, -59.00062, 43721.1},
+	{-25, 70, -21.31605, -59.67002, 45980.3},
+	{-25, 75, -19.17216, -60.27032, 48032.3},
+	{-25, 80, -16.65277, -60.73582, 49840.2},
+	{-25, 85, -13.83969, -61.00533, 51372},
+	{-25, 90, -10.87041, -61.02581, 52601},
+	{-25, 95, -7.95154, -60.77383, 53515.6},
+	{-25, 100, -5.31199, -60.27935, 54130.3},
+	{-25, 105, -3.11626, -59.62975, 54488.3},
+	{-25, 110, -1.39704, -58.94455, 54651.2},
+	{-25, 115, -0.05072, -58.33164, 54680},
+	{-25, 120, 1.10757, -57.84797, 54615.3},
+	{-25, 125, 2.26379, -57.48454, 54470.2},
+	{-25, 130, 3.53791, -57.18091, 54234.7},
+	{-25, 135, 4.95678, -56.85875, 53890.7},
+	{-25, 140, 6.4726, -56.45409, 53424.8},
+	{-25, 145, 8.00768, -55.93199, 52834.5},
+	{-25, 150, 9.49257, -55.28163, 52125.5},
+	{-25, 155, 10.877, -54.50305, 51306.5},
+	{-25, 160, 12.11963, -53.59958, 50387},
+	{-25, 165, 13.17868, -52.58068, 49379},
+	{-25, 170, 14.01836, -51.46897, 48300.5},
+	{-25, 175, 14.62664, -50.30105, 47175.2},
+	{-25, 180, 15.02726, -49.11776, 46027.5},
+	{35, -180, 5.33569, 48.43759, 39527.8},
+	{35, -175, 6.80184, 49.26461, 39462.9},
+	{35, -170, 8.09484, 50.1122, 39557.7},
+	{35, -165, 9.23888, 50.94303, 39800.5},
+	{35, -160, 10.26699, 51.74971, 40182.9},
+	{35, -155, 11.1984, 52.55062, 40698.7},
+	{35, -150, 12.0234, 53.37641, 41340.1},
+	{35, -145, 12.70302, 54.25379, 42093.7},
+	{35, -140, 13.18195, 55.19418, 42938.1},
+	{35, -135, 13.40589, 56.19116, 43845.1},
+	{35, -130, 13.33316, 57.22592, 44783.5},
+	{35, -125, 12.93442, 58.27538, 45722.3},
+	{35, -120, 12.18215, 59.31714, 46632.6},
+	{35, -115, 11.03811, 60.32795, 47485.5},
+	{35, -110, 9.45031, 61.27692, 48249.3},
+	{35, -105, 7.36739, 62.11825, 48886.9},
+	{35, -100, 4.77038, 62.78928, 49357.2},
+	{35, -95, 1.71062, 63.21702, 49620},
+	{35, -90, -1.6654, 63.33247, 49644.1},
+	{35, -85, -5.12352, 63.08747, 49414.6},
+	{35, -80, -8.38566, 62.46723, 48938.8},
+	{35, -75, -11.1913, 61.49399, 48247.8},
+	{35, -70, -13.34837, 60.22224, 47394.3},
+	{35, -65, -14.75713, 58.72917, 46447},
+	{35, -60, -15.40916, 57.10388, 45481.1},
+	{35, -55, -15.37072, 55.43668, 44567.6},
+	{35, -50, -14.75746, 53.80906, 43761.7},
+	{35, -45, -13.70439, 52.28619, 43095.9},
+	{35, -40, -12.33702, 50.91502, 42579.8},
+	{35, -35, -10.75244, 49.72892, 42206.8},
+	{35, -30, -9.0177, 48.75615, 41965.1},
+	{35, -25, -7.18498, 48.0254, 41847},
+	{35, -20, -5.31282, 47.56252, 41851.3},
+	{35, -15, -3.47856, 47.37864, 41978.6},
+	{35, -10, -1.7718, 47.45711, 42222.8},
+	{35, -5, -0.27039, 47.7498, 42565.4},
+	{35, 0, 0.98712, 48.18849, 42976.6},
+	{35, 5, 2.0145, 48.70724, 43424.1},
+	{35, 10, 2.86518, 49.26365, 43883.4},
+	{35, 15, 3.59867, 49.84636, 44345.6},
+	{35, 20, 4.24502, 50.46429, 44816.5},
+	{35, 25, 4.78846, 51.12436, 45309.4},
+	{35, 30, 5.18011, 51.81156, 45835},
+	{35, 35, 5.37201, 52.48368, 46395.8},
+	{35, 40, 5.35217, 53.08428, 46986.3},
+	{35, 45, 5.15859, 53.56614, 47599.5},
+	{35, 50, 4.86268, 53.91135, 48232.9},
+	{35, 55, 4.53216, 54.1364, 48889.8},
+	{35, 60, 4.19793, 54.28041, 49574.9},
+	{35, 65, 3.84526, 54.38455, 50286},
+	{35, 70, 3.4308, 54.47541, 51008.8},
+	{35, 75, 2.91023, 54.5602, 51715.3},
+	{35, 80, 2.25725, 54.63301, 52368.9},
+	{35, 85, 1.46466, 54.68435, 52930.2},
+	{35, 90, 0.53225, 54.70515, 53361.7},
+	{35, 95, -0.54367, 54.68235, 53629.2},
+	{35, 100, -1.76638, 54.59059, 53700.6},
+	{35, 105, -3.11868, 54.38845, 53546.1},
+	{35, 110, -4.53884, 54.02589, 53141.6},
+	{35, 115, -5.91115, 53.46222, 52475.8},
+	{35, 120, -7.08309, 52.68652, 51557.4},
+	{35, 125, -7.90432, 51.72954, 50419.8},
+	{35, 130, -8.2673, 50.66091, 49119.2},
+	{35, 135, -8.12984, 49.57335, 47725.9},
+	{35, 140, -7.51297, 48.56196, 46313.8},
+	{35, 145, -6.48164, 47.70738, 44948.8},
+	{35, 150, -5.12095, 47.06769, 43683.1},
+	{35, 155, -3.51837, 46.67848, 42553.5},
+	{35, 160, -1.75666, 46.55638, 41584.8},
+	{35, 165, 0.08507, 46.70084, 40792.4},
+	{35, 170, 1.92866, 47.09253, 40185.1},
+	{35, 175, 3.69939, 47.6911, 39765.1},
+	{35, 180, 5.33569, 48.43759, 39527.8},
+};
+
+TEST(GeoLookupTest, magFieldBilinear)
+{
+	// the combined lookup gives exactly the same result as the individual functions
+	for (float lat = -95.f; lat <= 95.f; lat += 1.3f) {
+		for (float lon = -185.f; lon <= 185.f; lon += 1.7f) {
+			const MagField field = get_mag_field(lat, lon);
+
+			EXPECT_EQ(field.declination, get_mag_declination_radians(lat, lon));
+			EXPECT_EQ(field.inclination, get_mag_inclination_radians(lat, lon));
+			EXPECT_EQ(field.strength, get_mag_strength_gauss(lat, lon));
+		}
+	}
+}
+
+TEST(GeoLookupTest, magFieldCache)
+{
+	// the cached cell must be updated when crossing cell boundaries, also at the poles and at +-180 degrees
+	for (MagFieldInterpolation interpolation : {MagFieldInterpolation::Bilinear, MagFieldInterpolation::Bicubic}) {
+		MagFieldCache cache;
+
+		for (float lat = -95.f; lat <= 95.f; lat += 2.3f) {
+			for (float lon = -185.f; lon <= 185.f; lon += 0.9f) {
+				const MagField field = get_mag_field(lat, lon, interpolation);
+				const MagField cached = get_mag_field(lat, lon, interpolation, &cache);
+
+				EXPECT_EQ(field.declination, cached.declination);
+				EXPECT_EQ(field.inclination, cached.inclination);
+				EXPECT_EQ(field.strength, cached.strength);
+			}
+		}
+	}
+}
+
+TEST(GeoLookupTest, magFieldBicubic)
+{
+	// the bicubic interpolation goes through the grid points
+	for (float lat = -80.f; lat <= 80.f; lat += 10.f) {
+		for (float lon = -180.f; lon <= 170.f; lon += 10.f) {
+			const MagField bilinear = get_mag_field(lat, lon);
+			const MagField bicubic = get_mag_field(lat, lon, MagFieldInterpolation::Bicubic);
+
+			EXPECT_NEAR(bicubic.declination, bilinear.declination, 1e-6f);
+			EXPECT_NEAR(bicubic.inclination, bilinear.inclination, 1e-6f);
+			EXPECT_NEAR(bicubic.strength, bilinear.strength, 1e-6f);
+		}
+	}
+
+	// and is continuous in the declination across +-180 degrees
+	const MagField west = get_mag_field(-60.f, 179.99f, MagFieldInterpolation::Bicubic);
+	const MagField east = get_mag_field(-60.f, -179.99f, MagFieldInterpolation::Bicubic);
+	EXPECT_NEAR(west.declination, east.declination, 1e-3f);
+}
+
+TEST(GeoLookupTest, magFieldAccuracy)
+{
+	// compare both interpolation methods to the model between the grid points
+	float error_bilinear[3] {};
+	float error_bicubic[3] {};
+
+	for (const auto &reference : reference_field) {
+		const MagField bilinear = get_mag_field(reference[0], reference[1]);
+		const MagField bicubic = get_mag_field(reference[0], reference[1], MagFieldInterpolation::Bicubic);
+
+		const float bilinear_data[3] {math::degrees(bilinear.declination), math::degrees(bilinear.inclination), bilinear.strength * 1e5f};
+		const float bicubic_data[3] {math::degrees(bicubic.declination), math::degrees(bicubic.inclination), bicubic.strength * 1e5f};
+
+		for (int i = 0; i < 3; i++) {
+			error_bilinear[i] += (bilinear_data[i] - reference[i + 2]) * (bilinear_data[i] - reference[i + 2]);
+			error_bicubic[i] += (bicubic_data[i] - reference[i + 2]) * (bicubic_data[i] - reference[i + 2]);
+		}
+
+		EXPECT_NEAR(bicubic_data[0], reference[2], 1.f);
+		EXPECT_NEAR(bicubic_data[1], reference[3], 1.f);
+		EXPECT_NEAR(bicubic_data[2], reference[4], 500.f);
+	}
+
+	const float n = sizeof(reference_field) / sizeof(reference_field[0]);
+	const char *name[3] {"declination (deg)", "inclination (deg)", "strength (nT)"};
+
+	for (int i = 0; i < 3; i++) {
+		const float rms_bilinear = sqrtf(error_bilinear[i] / n);
+		const float rms_bicubic = sqrtf(error_bicubic[i] / n);
+		printf("%s RMS error bilinear: %.4f, bicubic: %.4f\n", name[i], (double)rms_bilinear, (double)rms_bicubic);
+
+		EXPECT_LT(rms_bicubic, rms_bilinear);
+	}
+}
+
+// not part of the unit tests, run with --gtest_also_run_disabled_tests
+TEST(GeoLookupTest, DISABLED_Benchmark)
+{
+	static constexpr int N = 100000;
+	volatile float sink = 0.f;
+
+	// slowly moving position, as seen by the estimator
+	const auto position = [](int i, float & lat, float & lon) {
+		lat = 47.3f + 1e-4f * (i % 1000);
+		lon = 8.5f + 1e-4f * (i % 1000);
+	};
+
+	auto start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < N; i++) {
+		float lat, lon;
+		position(i, lat, lon);
+		sink = sink + get_mag_declination_radians(lat, lon) + get_mag_inclination_radians(lat, lon)
+		       + get_mag_strength_gauss(lat, lon);
+	}
+
+	const double separate = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / N;
+
+	start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < N; i++) {
+		float lat, lon;
+		position(i, lat, lon);
+		const MagField field = get_mag_field(lat, lon);
+		sink = sink + field.declination + field.inclination + field.strength;
+	}
+
+	const double combined = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / N;
+
+	MagFieldCache cache;
+	start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < N; i++) {
+		float lat, lon;
+		position(i, lat, lon);
+		const MagField field = get_mag_field(lat, lon, MagFieldInterpolation::Bilinear, &cache);
+		sink = sink + field.declination + field.inclination + field.strength;
+	}
+
+	const double cached = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / N;
+
+	start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < N; i++) {
+		float lat, lon;
+		position(i, lat, lon);
+		const MagField field = get_mag_field(lat, lon, MagFieldInterpolation::Bicubic, &cache);
+		sink = sink + field.declination + field.inclination + field.strength;
+	}
+
+	const double bicubic = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / N;
+
+	printf("separate: %.1f ns, get_mag_field: %.1f ns, cached: %.1f ns, cached bicubic: %.1f ns\n",
+	       separate, combined, cached, bicubic);
+}
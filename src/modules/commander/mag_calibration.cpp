@@ -53,6 +53,7 @@
 #include <lib/sensor_calibration/Magnetometer.hpp>
 #include <lib/sensor_calibration/Utilities.hpp>
 #include <lib/conversion/rotation.h>
+#include <lib/field_sensor_ellipsoid_fit/FieldSensorEllipsoidFit.hpp>
 #include <lib/world_magnetic_model/geo_mag_declination.h>
 #include <lib/systemlib/mavlink_log.h>
 #include <lib/parameters/param.h>
@@ -74,6 +75,7 @@ static constexpr int MAX_MAGS = 4;
 static constexpr float MAG_SPHERE_RADIUS_DEFAULT = 0.2f;
 static constexpr unsigned int calibration_total_points = 240;	///< The total points per magnetometer
 static constexpr unsigned int calibraton_duration_s = 42; 	///< The total duration the routine is allowed to take
+static constexpr unsigned int sample_grid_buckets = 256;	///< Buckets of the spatial hash used to find close samples
 
 calibrate_return mag_calibrate_all(orb_advert_t *mavlink_log_pub, int32_t cal_mask);
 
@@ -94,6 +96,10 @@ struct mag_worker_data_t {
 	float		*y[MAX_MAGS];
 	float		*z[MAX_MAGS];
 
+	float		min_sample_dist;					///< Minimum distance between two samples
+	uint16_t	*sample_grid[MAX_MAGS];					///< Spatial hash of the samples: bucket heads followed by the chain links (index + 1, 0: none)
+	FieldSensorEllipsoidFit	*online_fit[MAX_MAGS];				///< Fit updated with every sample, for coverage feedback and as initial guess
+
 	calibration::Magnetometer calibration[MAX_MAGS] {};
 };
 
@@ -139,28 +145,75 @@ int do_mag_calibration(orb_advert_t *mavlink_log_pub)
 	return result;
 }
 
-static bool reject_sample(float sx, float sy, float sz, float x[], float y[], float z[], unsigned count,
-			  unsigned max_count, float mag_sphere_radius)
+static unsigned sample_grid_bucket(int cx, int cy, int cz)
 {
-	float min_sample_dist = fabsf(5.4f * mag_sphere_radius / sqrtf(max_count)) / 3.0f;
-
-	for (size_t i = 0; i < count; i++) {
-		float dx = sx - x[i];
-		float dy = sy - y[i];
-		float dz = sz - z[i];
-		float dist = sqrtf(dx * dx + dy * dy + dz * dz);
+	return (((unsigned)cx * 73856093u) ^ ((unsigned)cy * 19349663u) ^ ((unsigned)cz * 83492791u)) & (sample_grid_buckets - 1);
+}
 
-		if (dist < min_sample_dist) {
-			PX4_DEBUG("rejected X: %.3f Y: %.3f Z: %.3f (%.3f < %.3f) (%u/%u) ", (double)sx, (double)sy, (double)sz, (double)dist,
-				  (double)min_sample_dist, count, max_count);
+static int sample_grid_cell(float v, float cell_size)
+{
+	return (int)floorf(v / cell_size);
+}
 
-			return true;
+static bool reject_sample(const mag_worker_data_t *worker_data, uint8_t cur_mag, float sx, float sy, float sz)
+{
+	// the grid cells are as large as the minimum distance, only samples in the neighbouring cells can be too close
+	const float min_sample_dist = worker_data->min_sample_dist;
+	const uint16_t *heads = worker_data->sample_grid[cur_mag];
+	const uint16_t *next = heads + sample_grid_buckets;
+	const float *x = worker_data->x[cur_mag];
+	const float *y = worker_data->y[cur_mag];
+	const float *z = worker_data->z[cur_mag];
+
+	const int cx = sample_grid_cell(sx, min_sample_dist);
+	const int cy = sample_grid_cell(sy, min_sample_dist);
+	const int cz = sample_grid_cell(sz, min_sample_dist);
+
+	for (int dx = -1; dx <= 1; dx++) {
+		for (int dy = -1; dy <= 1; dy++) {
+			for (int dz = -1; dz <= 1; dz++) {
+				for (uint16_t i = heads[sample_grid_bucket(cx + dx, cy + dy, cz + dz)]; i != 0; i = next[i - 1]) {
+					const float ex = sx - x[i - 1];
+					const float ey = sy - y[i - 1];
+					const float ez = sz - z[i - 1];
+					const float dist = sqrtf(ex * ex + ey * ey + ez * ez);
+
+					if (dist < min_sample_dist) {
+						PX4_DEBUG("rejected X: %.3f Y: %.3f Z: %.3f (%.3f < %.3f) (%u)", (double)sx, (double)sy, (double)sz, (double)dist,
+							  (double)min_sample_dist, worker_data->calibration_counter_total[cur_mag]);
+
+						return true;
+					}
+				}
+			}
 		}
 	}
 
 	return false;
 }
 
+static void add_sample(mag_worker_data_t *worker_data, uint8_t cur_mag, const Vector3f &sample)
+{
+	const unsigned index = worker_data->calibration_counter_total[cur_mag];
+
+	worker_data->x[cur_mag][index] = sample(0);
+	worker_data->y[cur_mag][index] = sample(1);
+	worker_data->z[cur_mag][index] = sample(2);
+
+	uint16_t *heads = worker_data->sample_grid[cur_mag];
+	uint16_t *next = heads + sample_grid_buckets;
+	const float min_sample_dist = worker_data->min_sample_dist;
+	const unsigned bucket = sample_grid_bucket(sample_grid_cell(sample(0), min_sample_dist),
+				sample_grid_cell(sample(1), min_sample_dist),
+				sample_grid_cell(sample(2), min_sample_dist));
+	next[index] = heads[bucket];
+	heads[bucket] = index + 1;
+
+	worker_data->online_fit[cur_mag]->update(sample);
+
+	worker_data->calibration_counter_total[cur_mag]++;
+}
+
 static unsigned progress_percentage(mag_worker_data_t *worker_data)
 {
 	return 100 * ((float)worker_data->done_count) / worker_data->calibration_sides;
@@ -256,8 +309,6 @@ static calibrate_return mag_calibration_worker(detect_orientation_return orienta
 
 	mag_worker_data_t *worker_data = (mag_worker_data_t *)(data);
 
-	float mag_sphere_radius = get_sphere_radius();
-
 	// notify user to start rotating
 	set_tune(tune_control_s::TUNE_ID_SINGLE_BEEP);
 
@@ -360,11 +411,7 @@ static calibrate_return mag_calibration_worker(detect_orientation_return orienta
 						}
 
 						// Check if this measurement is good to go in
-						bool reject = reject_sample(mag.x, mag.y, mag.z,
-									    worker_data->x[cur_mag], worker_data->y[cur_mag], worker_data->z[cur_mag],
-									    worker_data->calibration_counter_total[cur_mag],
-									    worker_data->calibration_sides * worker_data->calibration_points_perside,
-									    mag_sphere_radius);
+						bool reject = reject_sample(worker_data, cur_mag, mag.x, mag.y, mag.z);
 
 						if (!reject) {
 							new_samples[cur_mag] = Vector3f{mag.x, mag.y, mag.z};
@@ -384,11 +431,7 @@ static calibrate_return mag_calibration_worker(detect_orientation_return orienta
 			if (!rejected) {
 				for (uint8_t cur_mag = 0; cur_mag < MAX_MAGS; cur_mag++) {
 					if (worker_data->calibration[cur_mag].device_id() != 0) {
-						worker_data->x[cur_mag][worker_data->calibration_counter_total[cur_mag]] = new_samples[cur_mag](0);
-						worker_data->y[cur_mag][worker_data->calibration_counter_total[cur_mag]] = new_samples[cur_mag](1);
-						worker_data->z[cur_mag][worker_data->calibration_counter_total[cur_mag]] = new_samples[cur_mag](2);
-
-						worker_data->calibration_counter_total[cur_mag]++;
+						add_sample(worker_data, cur_mag, new_samples[cur_mag]);
 					}
 				}
 
@@ -409,11 +452,13 @@ static calibrate_return mag_calibration_worker(detect_orientation_return orienta
 						status.x[cur_mag] = worker_data->x[cur_mag][sample];
 						status.y[cur_mag] = worker_data->y[cur_mag][sample];
 						status.z[cur_mag] = worker_data->z[cur_mag][sample];
+						status.coverage[cur_mag] = worker_data->online_fit[cur_mag]->coverage();
 
 					} else {
 						status.x[cur_mag] = 0.f;
 						status.y[cur_mag] = 0.f;
 						status.z[cur_mag] = 0.f;
+						status.coverage[cur_mag] = 0.f;
 					}
 				}
 
@@ -518,11 +563,16 @@ calibrate_return mag_calibrate_all(orb_advert_t *mavlink_log_pub, int32_t cal_ma
 		worker_data.x[cur_mag] = nullptr;
 		worker_data.y[cur_mag] = nullptr;
 		worker_data.z[cur_mag] = nullptr;
+		worker_data.sample_grid[cur_mag] = nullptr;
+		worker_data.online_fit[cur_mag] = nullptr;
 		worker_data.calibration_counter_total[cur_mag] = 0;
 	}
 
 	const unsigned int calibration_points_maxcount = worker_data.calibration_sides * worker_data.calibration_points_perside;
 
+	const float mag_sphere_radius = get_sphere_radius();
+	worker_data.min_sample_dist = fabsf(5.4f * mag_sphere_radius / sqrtf(calibration_points_maxcount)) / 3.0f;
+
 	for (uint8_t cur_mag = 0; cur_mag < MAX_MAGS; cur_mag++) {
 
 		uORB::SubscriptionData<sensor_mag_s> mag_sub{ORB_ID(sensor_mag), cur_mag};
@@ -538,13 +588,21 @@ calibrate_return mag_calibrate_all(orb_advert_t *mavlink_log_pub, int32_t cal_ma
 			worker_data.x[cur_mag] = static_cast<float *>(malloc(sizeof(float) * calibration_points_maxcount));
 			worker_data.y[cur_mag] = static_cast<float *>(malloc(sizeof(float) * calibration_points_maxcount));
 			worker_data.z[cur_mag] = static_cast<float *>(malloc(sizeof(float) * calibration_points_maxcount));
+			worker_data.sample_grid[cur_mag] = static_cast<uint16_t *>(calloc(sample_grid_buckets + calibration_points_maxcount,
+							   sizeof(uint16_t)));
+			worker_data.online_fit[cur_mag] = new FieldSensorEllipsoidFit();
 
-			if (worker_data.x[cur_mag] == nullptr || worker_data.y[cur_mag] == nullptr || worker_data.z[cur_mag] == nullptr) {
+			if (worker_data.x[cur_mag] == nullptr || worker_data.y[cur_mag] == nullptr || worker_data.z[cur_mag] == nullptr
+			    || worker_data.sample_grid[cur_mag] == nullptr || worker_data.online_fit[cur_mag] == nullptr) {
 				calibration_log_critical(mavlink_log_pub, "ERROR: out of memory");
 				result = calibrate_return_error;
 				break;
 			}
 
+			// scales can only be estimated with more than two sides
+			worker_data.online_fit[cur_mag]->setFullEllipsoid(worker_data.calibration_sides > 2);
+			worker_data.online_fit[cur_mag]->setFieldNorm(mag_sphere_radius);
+
 		} else {
 			break;
 		}
@@ -564,8 +622,6 @@ calibrate_return mag_calibrate_all(orb_advert_t *mavlink_log_pub, int32_t cal_ma
 	Vector3f offdiag[MAX_MAGS];
 	float sphere_radius[MAX_MAGS];
 
-	const float mag_sphere_radius = get_sphere_radius();
-
 	for (size_t cur_mag = 0; cur_mag < MAX_MAGS; cur_mag++) {
 		sphere_radius[cur_mag] = mag_sphere_radius;
 		sphere[cur_mag].zero();
@@ -590,6 +646,19 @@ calibrate_return mag_calibrate_all(orb_advert_t *mavlink_log_pub, int32_t cal_ma
 				sphere_data.diag = matrix::Vector3f(diag[cur_mag](0), diag[cur_mag](1), diag[cur_mag](2));
 				sphere_data.offdiag = matrix::Vector3f(offdiag[cur_mag](0), offdiag[cur_mag](1), offdiag[cur_mag](2));
 
+				// start from the online fit, which is already close to the solution
+				Vector3f online_offset;
+				Vector3f online_diag;
+				Vector3f online_offdiag;
+				float online_radius;
+
+				if (worker_data.online_fit[cur_mag]->getCalibration(online_offset, online_diag, online_offdiag, online_radius)) {
+					PX4_INFO("Mag: %" PRIu8 " online fit radius: %.4f, coverage: %.0f%%", cur_mag, (double)online_radius,
+						 (double)(worker_data.online_fit[cur_mag]->coverage() * 100.f));
+					sphere_data.radius = online_radius;
+					sphere_data.offset = online_offset;
+				}
+
 				bool sphere_fit_success = false;
 				bool ellipsoid_fit_success = false;
 				int ret = lm_mag_fit(worker_data.x[cur_mag], worker_data.y[cur_mag], worker_data.z[cur_mag],
@@ -884,6 +953,8 @@ calibrate_return mag_calibrate_all(orb_advert_t *mavlink_log_pub, int32_t cal_ma
 		free(worker_data.x[cur_mag]);
 		free(worker_data.y[cur_mag]);
 		free(worker_data.z[cur_mag]);
+		free(worker_data.sample_grid[cur_mag]);
+		delete worker_data.online_fit[cur_mag];
 	}
 
 	FactoryCalibrationStorage factory_storage;
@@ -974,12 +1045,10 @@ int do_mag_calibration_quick(orb_advert_t *mavlink_log_pub, float heading_radian
 	} else {
 
 		// magnetic field data returned by the geo library using the current GPS position
-		const float mag_declination_gps = get_mag_declination_radians(latitude, longitude);
-		const float mag_inclination_gps = get_mag_inclination_radians(latitude, longitude);
-		const float mag_strength_gps = get_mag_strength_gauss(latitude, longitude);
+		const MagField mag_field = get_mag_field(latitude, longitude);
 
-		const Vector3f mag_earth_pred = Dcmf(Eulerf(0, -mag_inclination_gps, mag_declination_gps)) * Vector3f(mag_strength_gps,
-						0, 0);
+		const Vector3f mag_earth_pred = Dcmf(Eulerf(0, -mag_field.inclination, mag_field.declination))
+						* Vector3f(mag_field.strength, 0, 0);
 
 		uORB::Subscription vehicle_attitude_sub{ORB_ID(vehicle_attitude)};
 		vehicle_attitude_s attitude{};
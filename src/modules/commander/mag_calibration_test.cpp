@@ -39,6 +39,8 @@
  */
 
 #include <gtest/gtest.h>
+#include <chrono>
+#include <lib/field_sensor_ellipsoid_fit/FieldSensorEllipsoidFit.hpp>
 #include <matrix/matrix/math.hpp>
 #include <px4_platform_common/defines.h>
 
@@ -236,3 +238,102 @@ TEST_F(MagCalTest, replayTestData)
 	EXPECT_NEAR(ellipsoid.diag(1), scale_true(1), 0.01f) << "scale Y: " << ellipsoid.diag(1);
 	EXPECT_NEAR(ellipsoid.diag(2), scale_true(2), 0.01f) << "scale Z: " << ellipsoid.diag(2);
 }
+
+TEST_F(MagCalTest, onlineFitTestData)
+{
+	// GIVEN: the real test dataset and the batch fit results
+	constexpr unsigned int N_SAMPLES = 231;
+
+	sphere_params batch;
+	batch.radius = 0.2;
+	lm_mag_fit(mag_data1_x, mag_data1_y, mag_data1_z, N_SAMPLES, batch, false);
+	const float sphere_radius = batch.radius;
+	lm_mag_fit(mag_data1_x, mag_data1_y, mag_data1_z, N_SAMPLES, batch, true);
+
+	// WHEN: streaming the samples through the online sphere and ellipsoid fits
+	FieldSensorEllipsoidFit sphere_fit;
+	FieldSensorEllipsoidFit ellipsoid_fit;
+	sphere_fit.setFieldNorm(0.2f);
+	ellipsoid_fit.setFieldNorm(0.2f);
+	ellipsoid_fit.setFullEllipsoid(true);
+
+	for (unsigned int i = 0; i < N_SAMPLES; i++) {
+		const Vector3f sample{mag_data1_x[i], mag_data1_y[i], mag_data1_z[i]};
+		sphere_fit.update(sample);
+		ellipsoid_fit.update(sample);
+	}
+
+	// THEN: both agree with the batch fit
+	Vector3f offset, diag, offdiag;
+	float radius = 0.f;
+	ASSERT_TRUE(sphere_fit.getCalibration(offset, diag, offdiag, radius));
+	EXPECT_NEAR(radius, sphere_radius, 0.01f) << "radius: " << radius;
+	EXPECT_NEAR(offset(0), batch.offset(0), 0.01f) << "offset X: " << offset(0);
+	EXPECT_NEAR(offset(1), batch.offset(1), 0.01f) << "offset Y: " << offset(1);
+	EXPECT_NEAR(offset(2), batch.offset(2), 0.01f) << "offset Z: " << offset(2);
+
+	ASSERT_TRUE(ellipsoid_fit.getCalibration(offset, diag, offdiag, radius));
+	EXPECT_NEAR(radius, batch.radius, 0.02f) << "radius: " << radius;
+	EXPECT_NEAR(offset(0), batch.offset(0), 0.01f) << "offset X: " << offset(0);
+	EXPECT_NEAR(offset(1), batch.offset(1), 0.01f) << "offset Y: " << offset(1);
+	EXPECT_NEAR(offset(2), batch.offset(2), 0.01f) << "offset Z: " << offset(2);
+	EXPECT_NEAR(diag(0), batch.diag(0), 0.02f) << "scale X: " << diag(0);
+	EXPECT_NEAR(diag(1), batch.diag(1), 0.02f) << "scale Y: " << diag(1);
+	EXPECT_NEAR(diag(2), batch.diag(2), 0.02f) << "scale Z: " << diag(2);
+	EXPECT_NEAR(offdiag(0), batch.offdiag(0), 0.02f) << "offdiag XY: " << offdiag(0);
+	EXPECT_NEAR(offdiag(1), batch.offdiag(1), 0.02f) << "offdiag XZ: " << offdiag(1);
+	EXPECT_NEAR(offdiag(2), batch.offdiag(2), 0.02f) << "offdiag YZ: " << offdiag(2);
+
+	// the dataset covers most of the sphere
+	EXPECT_GT(ellipsoid_fit.coverage(), 0.5f);
+}
+
+// not part of the unit tests, run with --gtest_also_run_disabled_tests
+TEST_F(MagCalTest, DISABLED_onlineFitBenchmark)
+{
+	constexpr unsigned int N_SAMPLES = 231;
+	constexpr int N_RUNS = 100;
+
+	// batch: sphere and ellipsoid fit once all samples are collected
+	float batch_radius = 0.f;
+	const auto batch_start = std::chrono::steady_clock::now();
+
+	for (int run = 0; run < N_RUNS; run++) {
+		sphere_params params;
+		params.radius = 0.2;
+		lm_mag_fit(mag_data1_x, mag_data1_y, mag_data1_z, N_SAMPLES, params, false);
+		lm_mag_fit(mag_data1_x, mag_data1_y, mag_data1_z, N_SAMPLES, params, true);
+		batch_radius += params.radius;
+	}
+
+	const auto batch_end = std::chrono::steady_clock::now();
+
+	// online: update with every sample, the calibration is extracted once at the end
+	float online_radius = 0.f;
+	const auto online_start = std::chrono::steady_clock::now();
+
+	for (int run = 0; run < N_RUNS; run++) {
+		FieldSensorEllipsoidFit fit;
+		fit.setFieldNorm(0.2f);
+		fit.setFullEllipsoid(true);
+
+		for (unsigned int i = 0; i < N_SAMPLES; i++) {
+			fit.update(Vector3f{mag_data1_x[i], mag_data1_y[i], mag_data1_z[i]});
+		}
+
+		Vector3f offset, diag, offdiag;
+		float radius = 0.f;
+		fit.getCalibration(offset, diag, offdiag, radius);
+		online_radius += radius;
+	}
+
+	const auto online_end = std::chrono::steady_clock::now();
+
+	const float batch_us = std::chrono::duration<float, std::micro>(batch_end - batch_start).count() / N_RUNS;
+	const float online_us = std::chrono::duration<float, std::micro>(online_end - online_start).count() / N_RUNS;
+
+	printf("batch LM fit: %.1f us, online fit: %.1f us for %u samples (%.3f us per update)\n",
+	       (double)batch_us, (double)online_us, N_SAMPLES, (double)(online_us / N_SAMPLES));
+
+	EXPECT_NEAR(online_radius / N_RUNS, batch_radius / N_RUNS, 0.02f);
+}
@@ -50,6 +50,7 @@ enum class AllocationMethod {
 	PSEUDO_INVERSE = 0,
 	SEQUENTIAL_DESATURATION = 1,
 	AUTO = 2,
+	ACTIVE_SET = 3,
 };
 
 enum class ActuatorType {
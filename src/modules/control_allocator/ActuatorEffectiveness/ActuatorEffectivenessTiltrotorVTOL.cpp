@@ -116,13 +116,17 @@ void ActuatorEffectivenessTiltrotorVTOL::updateSetpoint(const matrix::Vector<flo
 			control_tilt = control_tilt < -0.99f ? -1.f : control_tilt;
 			control_tilt = control_tilt > 0.99f ? 1.f : control_tilt;
 
+			// snap the tilt used for the effectiveness matrix to a fixed grid, so that identical matrices
+			// (and their cached pseudo-inverses in the allocator) are reused when the tilt moves back and forth
+			const float control_tilt_bucket = roundf(control_tilt / TILT_BUCKET_SIZE) * TILT_BUCKET_SIZE;
+
 			// initialize _last_tilt_control
 			if (!PX4_ISFINITE(_last_tilt_control)) {
-				_last_tilt_control = control_tilt;
+				_last_tilt_control = control_tilt_bucket;
 
-			} else if (fabsf(control_tilt - _last_tilt_control) > 0.01f) {
+			} else if (fabsf(control_tilt - _last_tilt_control) > TILT_BUCKET_SIZE) {
 				_combined_tilt_updated = true;
-				_last_tilt_control = control_tilt;
+				_last_tilt_control = control_tilt_bucket;
 			}
 
 			for (int i = 0; i < _tilts.count(); ++i) {
@@ -92,6 +92,8 @@ protected:
 	int _first_control_surface_idx{0}; ///< applies to matrix 1
 	int _first_tilt_idx{0}; ///< applies to matrix 0
 
+	static constexpr float TILT_BUCKET_SIZE = 0.01f; ///< tilt control resolution used for the effectiveness matrix
+
 	float _last_tilt_control{NAN};
 
 	uORB::Subscription _actuator_controls_1_sub{ORB_ID(actuator_controls_1)};
@@ -0,0 +1,268 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file ControlAllocationActiveSet.cpp
+ *
+ * Weighted least squares control allocation with actuator limits (active set method).
+ */
+
+#include "ControlAllocationActiveSet.hpp"
+
+#include <mathlib/math/Limits.hpp>
+
+// Axis priorities (Wv): roll/pitch, then thrust, then yaw
+static constexpr float AXIS_WEIGHTS[ControlAllocation::NUM_AXES] {1.f, 1.f, 0.1f, 0.3f, 0.3f, 0.3f};
+
+void
+ControlAllocationActiveSet::updateHessian()
+{
+	// Bs = diag(scale) * B maps actuators to the normalized control setpoint units
+	for (int i = 0; i < NUM_ACTUATORS; i++) {
+		for (int axis = 0; axis < NUM_AXES; axis++) {
+			const float weight = AXIS_WEIGHTS[axis] * AXIS_WEIGHTS[axis];
+			_control_weight(i, axis) = GAMMA * weight * _control_allocation_scale(axis) * _effectiveness(axis, i);
+		}
+	}
+
+	for (int i = 0; i < _num_actuators; i++) {
+		for (int j = 0; j <= i; j++) {
+			float sum = (i == j) ? 1.f : 0.f;
+
+			for (int axis = 0; axis < NUM_AXES; axis++) {
+				sum += _control_weight(i, axis) * _control_allocation_scale(axis) * _effectiveness(axis, j);
+			}
+
+			_hessian(i, j) = sum;
+			_hessian(j, i) = sum;
+		}
+	}
+}
+
+bool
+ControlAllocationActiveSet::solveFree(const ActuatorVector &r, ActuatorVector &p)
+{
+	p.setZero();
+
+	// Cholesky factorization of the free sub-matrix
+	for (int a = 0; a < _num_free; a++) {
+		for (int b = 0; b <= a; b++) {
+			float sum = _hessian(_free[a], _free[b]);
+
+			for (int k = 0; k < b; k++) {
+				sum -= _factor(a, k) * _factor(b, k);
+			}
+
+			if (a == b) {
+				if (sum <= FLT_EPSILON) {
+					return false;
+				}
+
+				_factor(a, a) = sqrtf(sum);
+
+			} else {
+				_factor(a, b) = sum / _factor(b, b);
+			}
+		}
+	}
+
+	// forward substitution (L y = r_f)
+	ActuatorVector y;
+
+	for (int a = 0; a < _num_free; a++) {
+		float sum = r(_free[a]);
+
+		for (int k = 0; k < a; k++) {
+			sum -= _factor(a, k) * y(k);
+		}
+
+		y(a) = sum / _factor(a, a);
+	}
+
+	// back substitution (L^T x = y)
+	for (int a = _num_free - 1; a >= 0; a--) {
+		float sum = y(a);
+
+		for (int k = a + 1; k < _num_free; k++) {
+			sum -= _factor(k, a) * p(_free[k]);
+		}
+
+		p(_free[a]) = sum / _factor(a, a);
+	}
+
+	return true;
+}
+
+void
+ControlAllocationActiveSet::allocate()
+{
+	//Compute new gains if needed
+	if (updatePseudoInverse()) {
+		updateHessian();
+	}
+
+	_prev_actuator_sp = _actuator_sp;
+
+	const matrix::Vector<float, NUM_AXES> control_delta = _control_sp - _control_trim;
+
+	// linear term gamma * Bs^T Wv^2 v + u_d, with the pseudo-inverse solution u_d
+	const ActuatorVector linear = _control_weight * control_delta + _mix * control_delta;
+
+	// bounds relative to the trim, warm start from the previous working set
+	ActuatorVector lower;
+	ActuatorVector upper;
+	ActuatorVector u;
+	_num_free = 0;
+
+	for (int i = 0; i < _num_actuators; i++) {
+		if (_actuator_max(i) < _actuator_min(i)) {
+			// disabled actuator, keep at trim and never free it
+			lower(i) = 0.f;
+			upper(i) = 0.f;
+			_working_set[i] = 1;
+
+		} else {
+			lower(i) = _actuator_min(i) - _actuator_trim(i);
+			upper(i) = _actuator_max(i) - _actuator_trim(i);
+		}
+
+		if (_working_set[i] < 0) {
+			u(i) = lower(i);
+
+		} else if (_working_set[i] > 0) {
+			u(i) = upper(i);
+
+		} else {
+			u(i) = math::constrain(_solution(i), lower(i), upper(i));
+			_free[_num_free++] = i;
+		}
+	}
+
+	_converged = false;
+	_iterations = 0;
+	ActuatorVector r;
+	ActuatorVector p;
+
+	while (_iterations < MAX_ITERATIONS) {
+		_iterations++;
+
+		// r = -gradient / 2
+		for (int i = 0; i < _num_actuators; i++) {
+			float sum = linear(i);
+
+			for (int j = 0; j < _num_actuators; j++) {
+				sum -= _hessian(i, j) * u(j);
+			}
+
+			r(i) = sum;
+		}
+
+		// optimal step for the free actuators
+		if (!solveFree(r, p)) {
+			break;
+		}
+
+		// largest feasible step length along p
+		float alpha = 1.f;
+		int blocking = -1;
+		int8_t blocking_bound = 0;
+
+		for (int f = 0; f < _num_free; f++) {
+			const int i = _free[f];
+
+			if (u(i) + p(i) < lower(i)) {
+				const float step = (lower(i) - u(i)) / p(i);
+
+				if (step < alpha) {
+					alpha = step;
+					blocking = f;
+					blocking_bound = -1;
+				}
+
+			} else if (u(i) + p(i) > upper(i)) {
+				const float step = (upper(i) - u(i)) / p(i);
+
+				if (step < alpha) {
+					alpha = step;
+					blocking = f;
+					blocking_bound = 1;
+				}
+			}
+		}
+
+		for (int f = 0; f < _num_free; f++) {
+			u(_free[f]) += alpha * p(_free[f]);
+		}
+
+		if (blocking >= 0) {
+			// a limit was hit: fix the actuator and continue with the remaining ones
+			const int i = _free[blocking];
+			u(i) = (blocking_bound < 0) ? lower(i) : upper(i);
+			_working_set[i] = blocking_bound;
+			_free[blocking] = _free[--_num_free];
+			continue;
+		}
+
+		// full step: check the Lagrange multipliers of the active limits
+		int release = -1;
+		float lambda_min = -1e-5f;
+
+		for (int i = 0; i < _num_actuators; i++) {
+			if (_working_set[i] != 0 && upper(i) > lower(i)) {
+				float sum = linear(i);
+
+				for (int j = 0; j < _num_actuators; j++) {
+					sum -= _hessian(i, j) * u(j);
+				}
+
+				const float lambda = _working_set[i] * sum;
+
+				if (lambda < lambda_min) {
+					lambda_min = lambda;
+					release = i;
+				}
+			}
+		}
+
+		if (release < 0) {
+			_converged = true;
+			break;
+		}
+
+		_working_set[release] = 0;
+		_free[_num_free++] = release;
+	}
+
+	_solution = u;
+	_actuator_sp = _actuator_trim + u;
+}
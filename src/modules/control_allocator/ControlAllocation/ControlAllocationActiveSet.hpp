@@ -0,0 +1,106 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file ControlAllocationActiveSet.hpp
+ *
+ * Weighted least squares control allocation with actuator limits.
+ *
+ * Solves the box-constrained problem
+ *   min gamma * |Wv (B u - v)|^2 + |u - u_d|^2   subject to   u_min <= u <= u_max
+ * with an active set method, where u_d is the unconstrained pseudo-inverse solution.
+ * The result is therefore identical to the pseudo-inverse while it is feasible. When actuators
+ * saturate, the remaining control authority is distributed according to the axis weights Wv
+ * (roll/pitch before thrust before yaw) instead of being lost by clipping.
+ *
+ * The solver is warm-started with the working set of the previous call and runs a fixed
+ * maximum number of iterations, which bounds the execution time. If the budget is exhausted
+ * the current iterate is used, which is always within the actuator limits.
+ *
+ * Reference: O. Härkegård, "Efficient active set algorithms for solving constrained least
+ * squares problems in aircraft control allocation", IEEE CDC 2002.
+ */
+
+#pragma once
+
+#include "ControlAllocationPseudoInverse.hpp"
+
+class ControlAllocationActiveSet: public ControlAllocationPseudoInverse
+{
+public:
+	ControlAllocationActiveSet() = default;
+	virtual ~ControlAllocationActiveSet() = default;
+
+	/// iteration budget per allocation, a cold start typically needs one iteration per saturated actuator
+	static constexpr int MAX_ITERATIONS = NUM_ACTUATORS;
+
+	void allocate() override;
+
+	/**
+	 * Number of iterations used by the last call to allocate()
+	 */
+	int getIterations() const { return _iterations; }
+
+	/**
+	 * True if the last call to allocate() found the optimum within the iteration budget
+	 */
+	bool converged() const { return _converged; }
+
+private:
+
+	/**
+	 * Recompute the hessian and linear term weights after an effectiveness update.
+	 */
+	void updateHessian();
+
+	/**
+	 * Solve H_ff p_f = r_f for the free actuators (Cholesky). p is 0 for all other actuators.
+	 *
+	 * @return false if the sub-matrix is not positive definite
+	 */
+	bool solveFree(const ActuatorVector &r, ActuatorVector &p);
+
+	static constexpr float GAMMA = 1000.f; ///< weight of the control error relative to the actuator deviation
+
+	matrix::SquareMatrix<float, NUM_ACTUATORS> _hessian;      ///< gamma * Bs^T Wv^2 Bs + I
+	matrix::Matrix<float, NUM_ACTUATORS, NUM_AXES> _control_weight; ///< gamma * Bs^T Wv^2
+	matrix::SquareMatrix<float, NUM_ACTUATORS> _factor;       ///< Cholesky factor of the free sub-matrix
+
+	ActuatorVector _solution;                 ///< last solution relative to the trim (warm start)
+	int8_t _working_set[NUM_ACTUATORS] {};    ///< -1: at lower limit, 1: at upper limit, 0: free
+	uint8_t _free[NUM_ACTUATORS] {};          ///< indexes of the free actuators
+	int _num_free{0};
+
+	int _iterations{0};
+	bool _converged{false};
+};
@@ -0,0 +1,321 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file ControlAllocationActiveSetTest.cpp
+ *
+ * Tests and benchmark for the active set allocation.
+ *
+ * The benchmark is disabled, run it with --gtest_also_run_disabled_tests. It can use
+ * recorded setpoints: export a log with
+ * `ulog2csv -m vehicle_torque_setpoint,vehicle_thrust_setpoint log.ulg` and set
+ * CA_BENCHMARK_LOG to the prefix of the generated files (e.g. "log").
+ */
+
+#include <gtest/gtest.h>
+#include <ControlAllocationActiveSet.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace matrix;
+
+static constexpr int NUM_ACTUATORS = ControlAllocation::NUM_ACTUATORS;
+static constexpr int NUM_AXES = ControlAllocation::NUM_AXES;
+
+// Flat multirotor with num_rotors evenly spaced rotors of alternating spin direction
+static Matrix<float, NUM_AXES, NUM_ACTUATORS> multirotorEffectiveness(int num_rotors)
+{
+	Matrix<float, NUM_AXES, NUM_ACTUATORS> effectiveness;
+
+	for (int i = 0; i < num_rotors; i++) {
+		const float angle = 2.f * M_PI_F * (i + 0.5f) / num_rotors;
+		effectiveness(ControlAllocation::ROLL, i) = -sinf(angle);
+		effectiveness(ControlAllocation::PITCH, i) = cosf(angle);
+		effectiveness(ControlAllocation::YAW, i) = (i % 2 == 0) ? 0.05f : -0.05f;
+		effectiveness(ControlAllocation::THRUST_Z, i) = -1.f;
+	}
+
+	return effectiveness;
+}
+
+static void setup(ControlAllocation &method, int num_rotors)
+{
+	method.setNormalizeRPY(true);
+	method.setEffectivenessMatrix(multirotorEffectiveness(num_rotors), ControlAllocation::ActuatorVector{},
+				      ControlAllocation::ActuatorVector{}, num_rotors, true);
+	ControlAllocation::ActuatorVector actuator_max;
+	actuator_max.setAll(1.f);
+	method.setActuatorMin(ControlAllocation::ActuatorVector{});
+	method.setActuatorMax(actuator_max);
+}
+
+static Vector<float, NUM_AXES> controlSetpoint(float roll, float pitch, float yaw, float thrust)
+{
+	Vector<float, NUM_AXES> control_sp;
+	control_sp(ControlAllocation::ROLL) = roll;
+	control_sp(ControlAllocation::PITCH) = pitch;
+	control_sp(ControlAllocation::YAW) = yaw;
+	control_sp(ControlAllocation::THRUST_Z) = thrust;
+	return control_sp;
+}
+
+// weighted allocation error (same priorities as the allocator would use: roll/pitch first)
+static float allocationError(ControlAllocation &method)
+{
+	method.clipActuatorSetpoint();
+	const Vector<float, NUM_AXES> error = method.getAllocatedControl() - method.getControlSetpoint();
+	return Vector2f(error(ControlAllocation::ROLL), error(ControlAllocation::PITCH)).norm();
+}
+
+TEST(ControlAllocationActiveSetTest, UnsaturatedMatchesPseudoInverse)
+{
+	for (int num_rotors : {4, 8, 16}) {
+		ControlAllocationActiveSet active_set;
+		ControlAllocationPseudoInverse pseudo_inverse;
+		setup(active_set, num_rotors);
+		setup(pseudo_inverse, num_rotors);
+
+		const Vector<float, NUM_AXES> control_sp = controlSetpoint(0.05f, -0.03f, 0.02f, -0.5f);
+		active_set.setControlSetpoint(control_sp);
+		pseudo_inverse.setControlSetpoint(control_sp);
+		active_set.allocate();
+		pseudo_inverse.allocate();
+
+		EXPECT_TRUE(active_set.converged());
+
+		for (int i = 0; i < num_rotors; i++) {
+			EXPECT_NEAR(active_set.getActuatorSetpoint()(i), pseudo_inverse.getActuatorSetpoint()(i), 1e-4f);
+		}
+	}
+}
+
+TEST(ControlAllocationActiveSetTest, SaturatedWithinLimits)
+{
+	for (int num_rotors : {4, 8, 16}) {
+		ControlAllocationActiveSet active_set;
+		ControlAllocationPseudoInverse pseudo_inverse;
+		setup(active_set, num_rotors);
+		setup(pseudo_inverse, num_rotors);
+
+		// high thrust and roll: clipping loses roll authority, the active set trades thrust for roll
+		const Vector<float, NUM_AXES> control_sp = controlSetpoint(0.6f, 0.f, 0.3f, -0.9f);
+		active_set.setControlSetpoint(control_sp);
+		pseudo_inverse.setControlSetpoint(control_sp);
+		active_set.allocate();
+		pseudo_inverse.allocate();
+
+		EXPECT_TRUE(active_set.converged()) << num_rotors << " rotors, " << active_set.getIterations() << " iterations";
+
+		for (int i = 0; i < num_rotors; i++) {
+			EXPECT_GE(active_set.getActuatorSetpoint()(i), 0.f);
+			EXPECT_LE(active_set.getActuatorSetpoint()(i), 1.f);
+		}
+
+		EXPECT_LT(allocationError(active_set), allocationError(pseudo_inverse));
+	}
+}
+
+TEST(ControlAllocationActiveSetTest, WarmStart)
+{
+	ControlAllocationActiveSet active_set;
+	setup(active_set, 8);
+
+	const Vector<float, NUM_AXES> control_sp = controlSetpoint(0.6f, 0.2f, 0.3f, -0.9f);
+	active_set.setControlSetpoint(control_sp);
+	active_set.allocate();
+	const int cold_iterations = active_set.getIterations();
+	const ControlAllocation::ActuatorVector cold_solution = active_set.getActuatorSetpoint();
+
+	// same setpoint again: the previous working set is optimal
+	active_set.allocate();
+	EXPECT_TRUE(active_set.converged());
+	EXPECT_EQ(active_set.getIterations(), 1);
+	EXPECT_LE(active_set.getIterations(), cold_iterations);
+
+	for (int i = 0; i < 8; i++) {
+		EXPECT_NEAR(active_set.getActuatorSetpoint()(i), cold_solution(i), 1e-5f);
+	}
+}
+
+struct SetpointSample {
+	uint64_t timestamp;
+	float xyz[3];
+};
+
+// read the timestamp and xyz columns of a ulog2csv file
+static std::vector<SetpointSample> readSetpointCsv(const char *file_name)
+{
+	std::vector<SetpointSample> samples;
+	FILE *fp = fopen(file_name, "r");
+
+	if (fp == nullptr) {
+		return samples;
+	}
+
+	char line[1024];
+	int columns[4] {-1, -1, -1, -1};
+
+	if (fgets(line, sizeof(line), fp)) {
+		int column = 0;
+
+		for (char *token = strtok(line, ",\n"); token != nullptr; token = strtok(nullptr, ",\n"), column++) {
+			if (strcmp(token, "timestamp") == 0) { columns[0] = column; }
+
+			for (int i = 0; i < 3; i++) {
+				char name[16];
+				snprintf(name, sizeof(name), "xyz[%i]", i);
+
+				if (strcmp(token, name) == 0) { columns[i + 1] = column; }
+			}
+		}
+	}
+
+	while (fgets(line, sizeof(line), fp)) {
+		SetpointSample sample{};
+		int column = 0;
+
+		for (char *token = strtok(line, ",\n"); token != nullptr; token = strtok(nullptr, ",\n"), column++) {
+			if (column == columns[0]) { sample.timestamp = strtoull(token, nullptr, 10); }
+
+			for (int i = 0; i < 3; i++) {
+				if (column == columns[i + 1]) { sample.xyz[i] = strtof(token, nullptr); }
+			}
+		}
+
+		samples.push_back(sample);
+	}
+
+	fclose(fp);
+	return samples;
+}
+
+static std::vector<Vector<float, NUM_AXES>> benchmarkSetpoints()
+{
+	std::vector<Vector<float, NUM_AXES>> setpoints;
+	const char *log_prefix = getenv("CA_BENCHMARK_LOG");
+
+	if (log_prefix) {
+		char file_name[256];
+		snprintf(file_name, sizeof(file_name), "%s_vehicle_torque_setpoint_0.csv", log_prefix);
+		const std::vector<SetpointSample> torque = readSetpointCsv(file_name);
+		snprintf(file_name, sizeof(file_name), "%s_vehicle_thrust_setpoint_0.csv", log_prefix);
+		const std::vector<SetpointSample> thrust = readSetpointCsv(file_name);
+
+		size_t thrust_index = 0;
+
+		for (const SetpointSample &torque_sample : torque) {
+			// latest thrust setpoint at the time of the torque setpoint
+			while (thrust_index + 1 < thrust.size() && thrust[thrust_index + 1].timestamp <= torque_sample.timestamp) {
+				thrust_index++;
+			}
+
+			if (thrust_index < thrust.size()) {
+				const SetpointSample &thrust_sample = thrust[thrust_index];
+				Vector<float, NUM_AXES> control_sp;
+
+				for (int i = 0; i < 3; i++) {
+					control_sp(i) = torque_sample.xyz[i];
+					control_sp(i + 3) = thrust_sample.xyz[i];
+				}
+
+				setpoints.push_back(control_sp);
+			}
+		}
+
+		printf("%zu setpoints from %s\n", setpoints.size(), log_prefix);
+	}
+
+	if (setpoints.empty()) {
+		// aggressive synthetic maneuvers, saturating part of the time
+		for (int i = 0; i < 20000; i++) {
+			const float t = i * 0.004f;
+			setpoints.push_back(controlSetpoint(0.6f * sinf(1.3f * t), 0.5f * sinf(0.7f * t), 0.3f * cosf(0.9f * t),
+							    -0.55f - 0.4f * sinf(0.5f * t)));
+		}
+	}
+
+	return setpoints;
+}
+
+// not part of the unit tests, run with --gtest_also_run_disabled_tests
+TEST(ControlAllocationActiveSetTest, DISABLED_Benchmark)
+{
+	const std::vector<Vector<float, NUM_AXES>> setpoints = benchmarkSetpoints();
+
+	for (int num_rotors : {4, 8, 16}) {
+		ControlAllocationActiveSet active_set;
+		ControlAllocationPseudoInverse pseudo_inverse;
+		ControlAllocation *methods[] {&pseudo_inverse, &active_set};
+		const char *names[] {"pseudo-inverse", "active set"};
+
+		for (int m = 0; m < 2; m++) {
+			ControlAllocation &method = *methods[m];
+			setup(method, num_rotors);
+
+			double time_sum = 0.;
+			double time_max = 0.;
+			double error_sum = 0.;
+			double error_max = 0.;
+			int max_iterations = 0;
+
+			for (const Vector<float, NUM_AXES> &control_sp : setpoints) {
+				method.setControlSetpoint(control_sp);
+
+				const auto start = std::chrono::steady_clock::now();
+				method.allocate();
+				const auto end = std::chrono::steady_clock::now();
+
+				const double time_us = std::chrono::duration<double, std::micro>(end - start).count();
+				time_sum += time_us;
+				time_max = fmax(time_max, time_us);
+
+				const double error = allocationError(method);
+				error_sum += error;
+				error_max = fmax(error_max, error);
+
+				if (m == 1) {
+					max_iterations = std::max(max_iterations, active_set.getIterations());
+				}
+			}
+
+			printf("%2d actuators, %-14s: time mean %.3f us, max %.3f us, roll/pitch error mean %.4f, max %.4f, max iterations %d\n",
+			       num_rotors, names[m], time_sum / setpoints.size(), time_max, error_sum / setpoints.size(), error_max,
+			       max_iterations);
+		}
+	}
+}
@@ -53,11 +53,11 @@ ControlAllocationPseudoInverse::setEffectivenessMatrix(
 	_normalization_needs_update = update_normalization_scale;
 }
 
-void
+bool
 ControlAllocationPseudoInverse::updatePseudoInverse()
 {
 	if (_mix_update_needed) {
-		matrix::geninv(_effectiveness, _mix);
+		computeOrGetCachedPseudoInverse();
 
 		if (_normalization_needs_update && !_had_actuator_failure) {
 			updateControlAllocationMatrixScale();
@@ -66,7 +66,60 @@ ControlAllocationPseudoInverse::updatePseudoInverse()
 
 		normalizeControlAllocationMatrix();
 		_mix_update_needed = false;
+		return true;
+	}
+
+	return false;
+}
+
+void
+ControlAllocationPseudoInverse::enableMixCache()
+{
+	if (_mix_cache == nullptr) {
+		_mix_cache = new MixCacheEntry[MIX_CACHE_SIZE] {};
+	}
+}
+
+void
+ControlAllocationPseudoInverse::computeOrGetCachedPseudoInverse()
+{
+	if (_mix_cache == nullptr) {
+		matrix::geninv(_effectiveness, _mix);
+		return;
 	}
+
+	for (int k = 0; k < MIX_CACHE_SIZE; k++) {
+		const MixCacheEntry &entry = _mix_cache[k];
+
+		if (!entry.valid) {
+			continue;
+		}
+
+		// exact match only, the cache must not change the result
+		bool equal = true;
+
+		for (int i = 0; i < NUM_AXES && equal; i++) {
+			for (int j = 0; j < NUM_ACTUATORS; j++) {
+				if (entry.effectiveness(i, j) != _effectiveness(i, j)) {
+					equal = false;
+					break;
+				}
+			}
+		}
+
+		if (equal) {
+			_mix = entry.mix;
+			return;
+		}
+	}
+
+	matrix::geninv(_effectiveness, _mix);
+
+	MixCacheEntry &entry = _mix_cache[_mix_cache_next];
+	entry.effectiveness = _effectiveness;
+	entry.mix = _mix;
+	entry.valid = true;
+	_mix_cache_next = (_mix_cache_next + 1) % MIX_CACHE_SIZE;
 }
 
 void
@@ -51,7 +51,13 @@ class ControlAllocationPseudoInverse: public ControlAllocation
 {
 public:
 	ControlAllocationPseudoInverse() = default;
-	virtual ~ControlAllocationPseudoInverse() = default;
+	virtual ~ControlAllocationPseudoInverse() { delete[] _mix_cache; }
+
+	/**
+	 * Cache the pseudo-inverses of the last effectiveness matrices.
+	 * Only worth its RAM if the effectiveness keeps alternating between few matrices (tilting actuators).
+	 */
+	void enableMixCache();
 
 	void allocate() override;
 	void setEffectivenessMatrix(const matrix::Matrix<float, NUM_AXES, NUM_ACTUATORS> &effectiveness,
@@ -66,11 +72,29 @@ protected:
 	/**
 	 * Recalculate pseudo inverse if required.
 	 *
+	 * @return true if _mix was updated
 	 */
-	void updatePseudoInverse();
+	bool updatePseudoInverse();
 
 private:
 	void normalizeControlAllocationMatrix();
 	void updateControlAllocationMatrixScale();
+
+	/**
+	 * Get the (non-normalized) pseudo inverse of _effectiveness from the cache if enabled, or compute and add it.
+	 */
+	void computeOrGetCachedPseudoInverse();
+
 	bool _normalization_needs_update{false};
+
+	static constexpr int MIX_CACHE_SIZE = 4;
+
+	struct MixCacheEntry {
+		matrix::Matrix<float, NUM_AXES, NUM_ACTUATORS> effectiveness;
+		matrix::Matrix<float, NUM_ACTUATORS, NUM_AXES> mix;
+		bool valid{false};
+	};
+
+	MixCacheEntry *_mix_cache{nullptr}; ///< MIX_CACHE_SIZE entries, allocated by enableMixCache()
+	int _mix_cache_next{0}; ///< next entry to replace (round-robin)
 };
@@ -45,7 +45,9 @@ void
 ControlAllocationSequentialDesaturation::allocate()
 {
 	//Compute new gains if needed
-	updatePseudoInverse();
+	if (updatePseudoInverse()) {
+		updateMixColumns();
+	}
 
 	_prev_actuator_sp = _actuator_sp;
 
@@ -64,6 +66,34 @@ ControlAllocationSequentialDesaturation::allocate()
 	}
 }
 
+void
+ControlAllocationSequentialDesaturation::updateMixColumns()
+{
+	for (int axis = 0; axis < NUM_AXES; axis++) {
+		for (int i = 0; i < NUM_ACTUATORS; i++) {
+			_mix_columns[axis](i) = _mix(i, axis);
+		}
+	}
+}
+
+void
+ControlAllocationSequentialDesaturation::mix(const matrix::Vector<float, NUM_AXES> &control_delta)
+{
+	for (int i = 0; i < _num_actuators; i++) {
+		_actuator_sp(i) = _actuator_trim(i);
+	}
+
+	// axis by axis, so that the inner loop is a contiguous multiply-add over all actuators
+	for (int axis = 0; axis < NUM_AXES; axis++) {
+		const ActuatorVector &column = _mix_columns[axis];
+		const float delta = control_delta(axis);
+
+		for (int i = 0; i < _num_actuators; i++) {
+			_actuator_sp(i) += column(i) * delta;
+		}
+	}
+}
+
 void ControlAllocationSequentialDesaturation::desaturateActuators(
 	ActuatorVector &actuator_sp,
 	const ActuatorVector &desaturation_vector, bool increase_only)
@@ -91,27 +121,18 @@ float ControlAllocationSequentialDesaturation::computeDesaturationGain(const Act
 	float k_min = 0.f;
 	float k_max = 0.f;
 
+	// Branch-free so that the compiler can vectorize it: non-saturated actuators contribute k = 0,
+	// which does not change k_min <= 0 <= k_max.
 	for (int i = 0; i < _num_actuators; i++) {
 		// Do not use try to desaturate using an actuator with weak effectiveness to avoid large desaturation gains
-		if (fabsf(desaturation_vector(i)) < 0.2f) {
-			continue;
-		}
-
-		if (actuator_sp(i) < _actuator_min(i)) {
-			float k = (_actuator_min(i) - actuator_sp(i)) / desaturation_vector(i);
-
-			if (k < k_min) { k_min = k; }
-
-			if (k > k_max) { k_max = k; }
-		}
+		const float d = desaturation_vector(i);
+		const float d_inv = (fabsf(d) < 0.2f) ? 0.f : 1.f / d;
 
-		if (actuator_sp(i) > _actuator_max(i)) {
-			float k = (_actuator_max(i) - actuator_sp(i)) / desaturation_vector(i);
+		const float k_lower = (actuator_sp(i) < _actuator_min(i)) ? (_actuator_min(i) - actuator_sp(i)) * d_inv : 0.f;
+		const float k_upper = (actuator_sp(i) > _actuator_max(i)) ? (_actuator_max(i) - actuator_sp(i)) * d_inv : 0.f;
 
-			if (k < k_min) { k_min = k; }
-
-			if (k > k_max) { k_max = k; }
-		}
+		k_min = fminf(k_min, fminf(k_lower, k_upper));
+		k_max = fmaxf(k_max, fmaxf(k_lower, k_upper));
 	}
 
 	// Reduce the saturation as much as possible
@@ -124,19 +145,11 @@ ControlAllocationSequentialDesaturation::mixAirmodeRP()
 	// Airmode for roll and pitch, but not yaw
 
 	// Mix without yaw
-	ActuatorVector thrust_z;
+	matrix::Vector<float, NUM_AXES> control_delta = _control_sp - _control_trim;
+	control_delta(ControlAxis::YAW) = 0.f;
+	mix(control_delta);
 
-	for (int i = 0; i < _num_actuators; i++) {
-		_actuator_sp(i) = _actuator_trim(i) +
-				  _mix(i, ControlAxis::ROLL) * (_control_sp(ControlAxis::ROLL) - _control_trim(ControlAxis::ROLL)) +
-				  _mix(i, ControlAxis::PITCH) * (_control_sp(ControlAxis::PITCH) - _control_trim(ControlAxis::PITCH)) +
-				  _mix(i, ControlAxis::THRUST_X) * (_control_sp(ControlAxis::THRUST_X) - _control_trim(ControlAxis::THRUST_X)) +
-				  _mix(i, ControlAxis::THRUST_Y) * (_control_sp(ControlAxis::THRUST_Y) - _control_trim(ControlAxis::THRUST_Y)) +
-				  _mix(i, ControlAxis::THRUST_Z) * (_control_sp(ControlAxis::THRUST_Z) - _control_trim(ControlAxis::THRUST_Z));
-		thrust_z(i) = _mix(i, ControlAxis::THRUST_Z);
-	}
-
-	desaturateActuators(_actuator_sp, thrust_z);
+	desaturateActuators(_actuator_sp, _mix_columns[ControlAxis::THRUST_Z]);
 
 	// Mix yaw independently
 	mixYaw();
@@ -148,26 +161,13 @@ ControlAllocationSequentialDesaturation::mixAirmodeRPY()
 	// Airmode for roll, pitch and yaw
 
 	// Do full mixing
-	ActuatorVector thrust_z;
-	ActuatorVector yaw;
-
-	for (int i = 0; i < _num_actuators; i++) {
-		_actuator_sp(i) = _actuator_trim(i) +
-				  _mix(i, ControlAxis::ROLL) * (_control_sp(ControlAxis::ROLL) - _control_trim(ControlAxis::ROLL)) +
-				  _mix(i, ControlAxis::PITCH) * (_control_sp(ControlAxis::PITCH) - _control_trim(ControlAxis::PITCH)) +
-				  _mix(i, ControlAxis::YAW) * (_control_sp(ControlAxis::YAW) - _control_trim(ControlAxis::YAW)) +
-				  _mix(i, ControlAxis::THRUST_X) * (_control_sp(ControlAxis::THRUST_X) - _control_trim(ControlAxis::THRUST_X)) +
-				  _mix(i, ControlAxis::THRUST_Y) * (_control_sp(ControlAxis::THRUST_Y) - _control_trim(ControlAxis::THRUST_Y)) +
-				  _mix(i, ControlAxis::THRUST_Z) * (_control_sp(ControlAxis::THRUST_Z) - _control_trim(ControlAxis::THRUST_Z));
-		thrust_z(i) = _mix(i, ControlAxis::THRUST_Z);
-		yaw(i) = _mix(i, ControlAxis::YAW);
-	}
+	mix(_control_sp - _control_trim);
 
-	desaturateActuators(_actuator_sp, thrust_z);
+	desaturateActuators(_actuator_sp, _mix_columns[ControlAxis::THRUST_Z]);
 
 	// Unsaturate yaw (in case upper and lower bounds are exceeded)
 	// to prioritize roll/pitch over yaw.
-	desaturateActuators(_actuator_sp, yaw);
+	desaturateActuators(_actuator_sp, _mix_columns[ControlAxis::YAW]);
 }
 
 void
@@ -176,28 +176,16 @@ ControlAllocationSequentialDesaturation::mixAirmodeDisabled()
 	// Airmode disabled: never allow to increase the thrust to unsaturate a motor
 
 	// Mix without yaw
-	ActuatorVector thrust_z;
-	ActuatorVector roll;
-	ActuatorVector pitch;
-
-	for (int i = 0; i < _num_actuators; i++) {
-		_actuator_sp(i) = _actuator_trim(i) +
-				  _mix(i, ControlAxis::ROLL) * (_control_sp(ControlAxis::ROLL) - _control_trim(ControlAxis::ROLL)) +
-				  _mix(i, ControlAxis::PITCH) * (_control_sp(ControlAxis::PITCH) - _control_trim(ControlAxis::PITCH)) +
-				  _mix(i, ControlAxis::THRUST_X) * (_control_sp(ControlAxis::THRUST_X) - _control_trim(ControlAxis::THRUST_X)) +
-				  _mix(i, ControlAxis::THRUST_Y) * (_control_sp(ControlAxis::THRUST_Y) - _control_trim(ControlAxis::THRUST_Y)) +
-				  _mix(i, ControlAxis::THRUST_Z) * (_control_sp(ControlAxis::THRUST_Z) - _control_trim(ControlAxis::THRUST_Z));
-		thrust_z(i) = _mix(i, ControlAxis::THRUST_Z);
-		roll(i) = _mix(i, ControlAxis::ROLL);
-		pitch(i) = _mix(i, ControlAxis::PITCH);
-	}
+	matrix::Vector<float, NUM_AXES> control_delta = _control_sp - _control_trim;
+	control_delta(ControlAxis::YAW) = 0.f;
+	mix(control_delta);
 
 	// only reduce thrust
-	desaturateActuators(_actuator_sp, thrust_z, true);
+	desaturateActuators(_actuator_sp, _mix_columns[ControlAxis::THRUST_Z], true);
 
 	// Reduce roll/pitch acceleration if needed to unsaturate
-	desaturateActuators(_actuator_sp, roll);
-	desaturateActuators(_actuator_sp, pitch);
+	desaturateActuators(_actuator_sp, _mix_columns[ControlAxis::ROLL]);
+	desaturateActuators(_actuator_sp, _mix_columns[ControlAxis::PITCH]);
 
 	// Mix yaw independently
 	mixYaw();
@@ -207,13 +195,11 @@ void
 ControlAllocationSequentialDesaturation::mixYaw()
 {
 	// Add yaw to outputs
-	ActuatorVector yaw;
-	ActuatorVector thrust_z;
+	const ActuatorVector &yaw = _mix_columns[ControlAxis::YAW];
+	const float yaw_delta = _control_sp(ControlAxis::YAW) - _control_trim(ControlAxis::YAW);
 
 	for (int i = 0; i < _num_actuators; i++) {
-		_actuator_sp(i) += _mix(i, ControlAxis::YAW) * (_control_sp(ControlAxis::YAW) - _control_trim(ControlAxis::YAW));
-		yaw(i) = _mix(i, ControlAxis::YAW);
-		thrust_z(i) = _mix(i, ControlAxis::THRUST_Z);
+		_actuator_sp(i) += yaw(i) * yaw_delta;
 	}
 
 	// Change yaw acceleration to unsaturate the outputs if needed (do not change roll/pitch),
@@ -224,7 +210,7 @@ ControlAllocationSequentialDesaturation::mixYaw()
 	_actuator_max = max_prev;
 
 	// reduce thrust only
-	desaturateActuators(_actuator_sp, thrust_z, true);
+	desaturateActuators(_actuator_sp, _mix_columns[ControlAxis::THRUST_Z], true);
 }
 
 void
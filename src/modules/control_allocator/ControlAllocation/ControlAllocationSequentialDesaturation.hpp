@@ -59,6 +59,19 @@ public:
 	void updateParameters() override;
 private:
 
+	/**
+	 * Copy the columns of _mix into _mix_columns, so that the mixing and desaturation
+	 * loops run over contiguous memory.
+	 */
+	void updateMixColumns();
+
+	/**
+	 * Set the actuator setpoint to trim + mix * control_delta.
+	 *
+	 * @param control_delta control setpoint relative to the trim, set an axis to 0 to exclude it
+	 */
+	void mix(const matrix::Vector<float, NUM_AXES> &control_delta);
+
 	/**
 	 * Minimize the saturation of the actuators by adding or substracting a fraction of desaturation_vector.
 	 * desaturation_vector is the vector that added to the output outputs, modifies the thrust or angular
@@ -122,6 +135,8 @@ private:
 	 */
 	void mixYaw();
 
+	ActuatorVector _mix_columns[NUM_AXES]; ///< columns of _mix (one vector per axis)
+
 	DEFINE_PARAMETERS(
 		(ParamInt<px4::params::MC_AIRMODE>) _param_mc_airmode   ///< air-mode
 	);
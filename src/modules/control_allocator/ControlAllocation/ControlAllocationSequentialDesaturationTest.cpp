@@ -0,0 +1,230 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2022 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file ControlAllocationSequentialDesaturationTest.cpp
+ *
+ * Tests and benchmark (disabled by default) for the sequential desaturation allocation
+ */
+
+#include <gtest/gtest.h>
+#include <ControlAllocationSequentialDesaturation.hpp>
+#include <drivers/drv_hrt.h>
+#include <parameters/param.h>
+
+using namespace matrix;
+
+static constexpr int NUM_ACTUATORS = ControlAllocation::NUM_ACTUATORS;
+static constexpr int NUM_AXES = ControlAllocation::NUM_AXES;
+
+// Flat multirotor with num_rotors evenly spaced rotors of alternating spin direction
+static Matrix<float, NUM_AXES, NUM_ACTUATORS> multirotorEffectiveness(int num_rotors, float tilt = 0.f)
+{
+	Matrix<float, NUM_AXES, NUM_ACTUATORS> effectiveness;
+
+	for (int i = 0; i < num_rotors; i++) {
+		const float angle = 2.f * M_PI_F * (i + 0.5f) / num_rotors;
+		const float moment_ratio = (i % 2 == 0) ? 0.05f : -0.05f;
+		effectiveness(ControlAllocation::ROLL, i) = -sinf(angle);
+		effectiveness(ControlAllocation::PITCH, i) = cosf(angle);
+		effectiveness(ControlAllocation::YAW, i) = moment_ratio;
+		effectiveness(ControlAllocation::THRUST_X, i) = sinf(tilt);
+		effectiveness(ControlAllocation::THRUST_Z, i) = -cosf(tilt);
+	}
+
+	return effectiveness;
+}
+
+static void setAirmode(int32_t airmode)
+{
+	param_set(param_find("MC_AIRMODE"), &airmode);
+}
+
+static void setup(ControlAllocationSequentialDesaturation &method, int num_rotors)
+{
+	method.updateParameters();
+	method.setNormalizeRPY(true);
+	method.setEffectivenessMatrix(multirotorEffectiveness(num_rotors), ControlAllocation::ActuatorVector{},
+				      ControlAllocation::ActuatorVector{}, num_rotors, true);
+	ControlAllocation::ActuatorVector actuator_max;
+	actuator_max.setAll(1.f);
+	method.setActuatorMin(ControlAllocation::ActuatorVector{});
+	method.setActuatorMax(actuator_max);
+}
+
+TEST(ControlAllocationSequentialDesaturationTest, Unsaturated)
+{
+	for (int airmode = 0; airmode <= 2; airmode++) {
+		setAirmode(airmode);
+
+		for (int num_rotors : {4, 8, 16}) {
+			ControlAllocationSequentialDesaturation method;
+			setup(method, num_rotors);
+
+			Vector<float, NUM_AXES> control_sp;
+			control_sp(ControlAllocation::ROLL) = 0.05f;
+			control_sp(ControlAllocation::PITCH) = -0.03f;
+			control_sp(ControlAllocation::YAW) = 0.02f;
+			control_sp(ControlAllocation::THRUST_Z) = -0.5f;
+			method.setControlSetpoint(control_sp);
+			method.allocate();
+			method.clipActuatorSetpoint();
+
+			const Vector<float, NUM_AXES> control_allocated = method.getAllocatedControl();
+
+			for (int axis : {ControlAllocation::ROLL, ControlAllocation::PITCH, ControlAllocation::YAW, ControlAllocation::THRUST_Z}) {
+				EXPECT_NEAR(control_allocated(axis), control_sp(axis), 1e-4f) << "airmode " << airmode << " rotors " << num_rotors;
+			}
+		}
+	}
+
+	setAirmode(0);
+}
+
+TEST(ControlAllocationSequentialDesaturationTest, SaturatedRollPrioritizedOverYaw)
+{
+	setAirmode(0);
+
+	for (int num_rotors : {4, 8, 16}) {
+		ControlAllocationSequentialDesaturation method;
+		setup(method, num_rotors);
+
+		Vector<float, NUM_AXES> control_sp;
+		control_sp(ControlAllocation::ROLL) = 0.8f;
+		control_sp(ControlAllocation::YAW) = 0.8f;
+		control_sp(ControlAllocation::THRUST_Z) = -0.9f;
+		method.setControlSetpoint(control_sp);
+		method.allocate();
+
+		// only small violations are allowed (up to 15% on the upper end for yaw)
+		const ControlAllocation::ActuatorVector actuator_sp = method.getActuatorSetpoint();
+
+		for (int i = 0; i < num_rotors; i++) {
+			EXPECT_GE(actuator_sp(i), -1e-4f);
+			EXPECT_LE(actuator_sp(i), 1.15f + 1e-4f);
+		}
+
+		method.clipActuatorSetpoint();
+		const Vector<float, NUM_AXES> control_allocated = method.getAllocatedControl();
+		EXPECT_GT(control_allocated(ControlAllocation::ROLL), 0.f);
+		EXPECT_LE(control_allocated(ControlAllocation::YAW), control_sp(ControlAllocation::YAW) + 1e-4f);
+	}
+}
+
+TEST(ControlAllocationSequentialDesaturationTest, CachedPseudoInverse)
+{
+	// alternating between a few matrices (as with a tiltrotor) must give the same result as a fresh instance
+	setAirmode(1);
+	ControlAllocationSequentialDesaturation method;
+	setup(method, 4);
+	method.enableMixCache();
+
+	Vector<float, NUM_AXES> control_sp;
+	control_sp(ControlAllocation::ROLL) = 0.3f;
+	control_sp(ControlAllocation::PITCH) = 0.1f;
+	control_sp(ControlAllocation::THRUST_Z) = -0.7f;
+
+	for (int i = 0; i < 10; i++) {
+		const Matrix<float, NUM_AXES, NUM_ACTUATORS> effectiveness = multirotorEffectiveness(4, 0.1f * (i % 3));
+		method.setEffectivenessMatrix(effectiveness, ControlAllocation::ActuatorVector{}, ControlAllocation::ActuatorVector{},
+					      4, false);
+		method.setControlSetpoint(control_sp);
+		method.allocate();
+
+		ControlAllocationSequentialDesaturation reference;
+		setup(reference, 4);
+		reference.setEffectivenessMatrix(effectiveness, ControlAllocation::ActuatorVector{}, ControlAllocation::ActuatorVector{},
+						 4, false);
+		reference.setControlSetpoint(control_sp);
+		reference.allocate();
+
+		EXPECT_EQ(method.getActuatorSetpoint(), reference.getActuatorSetpoint());
+	}
+
+	setAirmode(0);
+}
+
+// not part of the unit tests, run with --gtest_also_run_disabled_tests
+TEST(ControlAllocationSequentialDesaturationTest, DISABLED_Benchmark)
+{
+	static constexpr int ITERATIONS = 10000;
+
+	for (int airmode = 0; airmode <= 2; airmode++) {
+		setAirmode(airmode);
+
+		for (int num_rotors : {4, 8, 16}) {
+			ControlAllocationSequentialDesaturation method;
+			setup(method, num_rotors);
+			method.enableMixCache();
+
+			Vector<float, NUM_AXES> control_sp;
+			control_sp(ControlAllocation::THRUST_Z) = -0.8f;
+
+			// allocation with a constant matrix
+			hrt_abstime start = hrt_absolute_time();
+
+			for (int i = 0; i < ITERATIONS; i++) {
+				control_sp(ControlAllocation::ROLL) = 0.5f * sinf(i * 0.01f);
+				control_sp(ControlAllocation::YAW) = 0.5f * cosf(i * 0.01f);
+				method.setControlSetpoint(control_sp);
+				method.allocate();
+			}
+
+			const float allocate_us = (float)hrt_elapsed_time(&start) / ITERATIONS;
+
+			// allocation with the effectiveness changing between 4 tilt buckets each cycle
+			Matrix<float, NUM_AXES, NUM_ACTUATORS> effectiveness[4];
+
+			for (int j = 0; j < 4; j++) {
+				effectiveness[j] = multirotorEffectiveness(num_rotors, 0.02f * j);
+			}
+
+			start = hrt_absolute_time();
+
+			for (int i = 0; i < ITERATIONS; i++) {
+				method.setEffectivenessMatrix(effectiveness[i % 4], ControlAllocation::ActuatorVector{},
+							      ControlAllocation::ActuatorVector{}, num_rotors, false);
+				method.setControlSetpoint(control_sp);
+				method.allocate();
+			}
+
+			const float update_us = (float)hrt_elapsed_time(&start) / ITERATIONS;
+
+			printf("airmode %d, %2d actuators: allocate %.3f us, with effectiveness update %.3f us\n",
+			       airmode, num_rotors, (double)allocate_us, (double)update_us);
+		}
+	}
+
+	setAirmode(0);
+}
@@ -176,13 +176,19 @@ ControlAllocator::update_allocation_method(bool force)
 				method = desired_methods[i];
 			}
 
+			ControlAllocationPseudoInverse *pseudo_inverse = nullptr;
+
 			switch (method) {
 			case AllocationMethod::PSEUDO_INVERSE:
-				_control_allocation[i] = new ControlAllocationPseudoInverse();
+				pseudo_inverse = new ControlAllocationPseudoInverse();
 				break;
 
 			case AllocationMethod::SEQUENTIAL_DESATURATION:
-				_control_allocation[i] = new ControlAllocationSequentialDesaturation();
+				pseudo_inverse = new ControlAllocationSequentialDesaturation();
+				break;
+
+			case AllocationMethod::ACTIVE_SET:
+				pseudo_inverse = new ControlAllocationActiveSet();
 				break;
 
 			default:
@@ -190,6 +196,8 @@ ControlAllocator::update_allocation_method(bool force)
 				break;
 			}
 
+			_control_allocation[i] = pseudo_inverse;
+
 			if (_control_allocation[i] == nullptr) {
 				PX4_ERR("alloc failed");
 				_num_control_allocation = 0;
@@ -197,6 +205,11 @@ ControlAllocator::update_allocation_method(bool force)
 			} else {
 				_control_allocation[i]->setNormalizeRPY(normalize_rpy[i]);
 				_control_allocation[i]->setActuatorSetpoint(actuator_sp[i]);
+
+				// the tilt changes the effectiveness matrix in flight, but snapped to a grid
+				if (_effectiveness_source_id == EffectivenessSource::TILTROTOR_VTOL) {
+					pseudo_inverse->enableMixCache();
+				}
 			}
 		}
 
@@ -0,0 +1,513 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+#include "DatamanJournal.hpp"
+
+#include <crc32.h>
+#include <errno.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+DatamanJournal::~DatamanJournal()
+{
+	free(_index);
+}
+
+int DatamanJournal::init(int fd, uint32_t journal_offset, uint32_t journal_size)
+{
+	if ((fd < 0) || (journal_size < HEADER_SIZE + (MAX_GROUPS + 1) * RECORD_HEADER_SIZE + MAX_PAYLOAD)) {
+		return -EINVAL;
+	}
+
+	_fd = fd;
+	_journal_offset = journal_offset;
+	_journal_end = journal_offset + journal_size;
+	_index_size = 0;
+	_full_checkpoints = 0;
+
+	for (Group &group : _groups) {
+		group = Group{};
+	}
+
+	int replayed = 0;
+	uint32_t next_epoch = 1;
+	Header header;
+
+	if (read_at(_journal_offset, &header, sizeof(header))
+	    && (header.magic == HEADER_MAGIC) && (header.crc == header_crc(header))) {
+
+		_epoch = header.epoch;
+		next_epoch = _epoch + 1;
+
+		// open transaction of each group: sequence number, first record and number of data records
+		struct {
+			bool open;
+			uint32_t sequence;
+			uint32_t begin;
+			uint32_t records;
+		} transactions[MAX_GROUPS] {};
+
+		uint32_t pos = _journal_offset + HEADER_SIZE;
+		RecordHeader record;
+
+		// replay all complete transactions, the journal ends at the first invalid or torn record
+		while (read_record(pos, record) && (record.group < MAX_GROUPS)) {
+			auto &transaction = transactions[record.group];
+
+			if (record.type == (uint8_t)RecordType::Data) {
+				// a new sequence number starts a new transaction, the previous one was discarded
+				if (!transaction.open || (record.sequence != transaction.sequence)) {
+					transaction.open = true;
+					transaction.sequence = record.sequence;
+					transaction.begin = pos;
+					transaction.records = 0;
+				}
+
+				transaction.records++;
+
+			} else if (record.type == (uint8_t)RecordType::Commit) {
+				if (transaction.open && (record.sequence == transaction.sequence) && (record.offset == transaction.records)) {
+					if (!apply(transaction.begin, pos, record.group, record.sequence)) {
+						return -EIO;
+					}
+
+					replayed++;
+				}
+
+				transaction.open = false;
+
+			} else {
+				break;
+			}
+
+			pos += RECORD_HEADER_SIZE + record.length;
+		}
+
+	} else {
+		// the header might have been torn when starting a new epoch, make sure stale records are not picked up again
+		RecordHeader record;
+
+		if (read_at(_journal_offset + HEADER_SIZE, &record, sizeof(record)) && (record.magic == RECORD_MAGIC)) {
+			next_epoch = record.epoch + 1;
+		}
+	}
+
+	// the replayed items need to be on the storage before the journal is dropped
+	if (fsync(_fd) != 0) {
+		return -errno;
+	}
+
+	const int ret = reset(next_epoch);
+
+	return (ret < 0) ? ret : replayed;
+}
+
+ssize_t DatamanJournal::write(unsigned group, uint32_t offset, const void *buf, size_t count)
+{
+	if (_fd < 0) {
+		return -EBADF;
+	}
+
+	if ((group >= MAX_GROUPS) || (count > MAX_PAYLOAD) || (offset + count > _journal_offset)) {
+		return -EINVAL;
+	}
+
+	if (_index_size == _index_capacity) {
+		IndexEntry *index = (IndexEntry *)realloc(_index, (_index_capacity + INDEX_CHUNK) * sizeof(IndexEntry));
+
+		if (index == nullptr) {
+			return -ENOMEM;
+		}
+
+		_index = index;
+		_index_capacity += INDEX_CHUNK;
+	}
+
+	// keep space for the commit records
+	const uint32_t required = RECORD_HEADER_SIZE + count + commit_reserve(group);
+
+	if (_write_pos + required > _journal_end) {
+		// drop the committed records, the pending ones are kept
+		const int ret = checkpoint();
+
+		if (ret < 0) {
+			return ret;
+		}
+
+		_full_checkpoints++;
+
+		if (_write_pos + required > _journal_end) {
+			return -ENOSPC;
+		}
+	}
+
+	const uint32_t pos = _write_pos;
+
+	if (!append(RecordType::Data, group, offset, buf, count)) {
+		return -EIO;
+	}
+
+	Group &g = _groups[group];
+
+	if ((g.records == 0) || (offset < g.begin)) {
+		g.begin = offset;
+	}
+
+	if ((g.records == 0) || (offset + count > g.end)) {
+		g.end = offset + count;
+	}
+
+	g.records++;
+
+	_index[_index_size++] = IndexEntry{offset, pos, (uint16_t)count, (uint8_t)group};
+
+	return count;
+}
+
+ssize_t DatamanJournal::read_pending(uint32_t offset, void *buf, size_t count)
+{
+	bool in_range = false;
+
+	for (const Group &group : _groups) {
+		if ((group.records > 0) && (offset >= group.begin) && (offset < group.end)) {
+			in_range = true;
+			break;
+		}
+	}
+
+	// reads of items without pending writes don't need to search the index
+	if (!in_range) {
+		return 0;
+	}
+
+	// the latest write wins
+	for (uint32_t i = _index_size; i > 0; i--) {
+		const IndexEntry &entry = _index[i - 1];
+
+		if (entry.offset == offset) {
+			const size_t length = (count < entry.length) ? count : entry.length;
+
+			if (!read_at(entry.pos + RECORD_HEADER_SIZE, buf, length)) {
+				return -EIO;
+			}
+
+			return length;
+		}
+	}
+
+	return 0;
+}
+
+int DatamanJournal::commit(unsigned group)
+{
+	if (!pending(group)) {
+		return 0;
+	}
+
+	Group &g = _groups[group];
+
+	if (!append(RecordType::Commit, group, g.records, nullptr, 0)) {
+		return -EIO;
+	}
+
+	// group commit: a single flush makes the whole transaction durable
+	if (fsync(_fd) != 0) {
+		return -errno;
+	}
+
+	// on failure the transaction is still complete in the journal and replayed on the next start
+	if (!remove_pending(group, true)) {
+		return -EIO;
+	}
+
+	// keep the journal short while nothing is pending, this is cheap
+	bool any_pending = false;
+
+	for (const Group &other : _groups) {
+		any_pending = any_pending || (other.records > 0);
+	}
+
+	if (!any_pending && (used() > (_journal_end - _journal_offset) / 4)) {
+		return checkpoint();
+	}
+
+	return 0;
+}
+
+void DatamanJournal::discard(unsigned group)
+{
+	if (!pending(group)) {
+		return;
+	}
+
+	// the records stay in the journal without a commit record, the next transaction uses a new sequence number
+	remove_pending(group, false);
+}
+
+int DatamanJournal::checkpoint()
+{
+	if (_fd < 0) {
+		return -EBADF;
+	}
+
+	// the applied items need to be on the storage before the committed records are dropped
+	if (fsync(_fd) != 0) {
+		return -errno;
+	}
+
+	if (_index_size == 0) {
+		return reset(_epoch + 1);
+	}
+
+	Header header{};
+	header.magic = HEADER_MAGIC;
+	header.epoch = _epoch + 1;
+	header.crc = header_crc(header);
+
+	if (!write_at(_journal_offset, &header, sizeof(header))) {
+		return -EIO;
+	}
+
+	_epoch = header.epoch;
+
+	// move the pending records to the front, in order: the destination never overlaps a record not moved yet
+	uint32_t pos = _journal_offset + HEADER_SIZE;
+
+	for (uint32_t i = 0; i < _index_size; i++) {
+		IndexEntry &entry = _index[i];
+		const size_t size = RECORD_HEADER_SIZE + entry.length;
+
+		if (!read_at(entry.pos, _buffer, size)) {
+			return -EIO;
+		}
+
+		RecordHeader record;
+		memcpy(&record, _buffer, sizeof(record));
+		record.epoch = _epoch;
+		record.crc = record_crc(record, _buffer + RECORD_HEADER_SIZE);
+		memcpy(_buffer, &record, sizeof(record));
+
+		if (!write_at(pos, _buffer, size)) {
+			return -EIO;
+		}
+
+		entry.pos = pos;
+		pos += size;
+	}
+
+	_write_pos = pos;
+
+	// invalidate the record behind the moved ones, the journal of the new epoch ends there
+	if (_write_pos + RECORD_HEADER_SIZE <= _journal_end) {
+		memset(_buffer, 0, RECORD_HEADER_SIZE);
+
+		if (!write_at(_write_pos, _buffer, RECORD_HEADER_SIZE)) {
+			return -EIO;
+		}
+	}
+
+	// the dropped records must not be replayed again after a later in-place write of the items
+	if (fsync(_fd) != 0) {
+		return -errno;
+	}
+
+	return 0;
+}
+
+bool DatamanJournal::read_at(uint32_t pos, void *buf, size_t count)
+{
+	if (lseek(_fd, pos, SEEK_SET) != (off_t)pos) {
+		return false;
+	}
+
+	return ::read(_fd, buf, count) == (ssize_t)count;
+}
+
+bool DatamanJournal::write_at(uint32_t pos, const void *buf, size_t count)
+{
+	if (lseek(_fd, pos, SEEK_SET) != (off_t)pos) {
+		return false;
+	}
+
+	return ::write(_fd, buf, count) == (ssize_t)count;
+}
+
+bool DatamanJournal::read_record(uint32_t pos, RecordHeader &record)
+{
+	if ((pos + RECORD_HEADER_SIZE > _journal_end) || !read_at(pos, &record, sizeof(record))) {
+		return false;
+	}
+
+	if ((record.magic != RECORD_MAGIC) || (record.epoch != _epoch) || (record.length > MAX_PAYLOAD)
+	    || (pos + RECORD_HEADER_SIZE + record.length > _journal_end)) {
+		return false;
+	}
+
+	if ((record.length > 0) && !read_at(pos + RECORD_HEADER_SIZE, _buffer, record.length)) {
+		return false;
+	}
+
+	return record.crc == record_crc(record, _buffer);
+}
+
+bool DatamanJournal::append(RecordType type, unsigned group, uint32_t offset, const void *buf, size_t count)
+{
+	RecordHeader record{};
+	record.magic = RECORD_MAGIC;
+	record.epoch = _epoch;
+	record.sequence = _groups[group].sequence;
+	record.offset = offset;
+	record.length = count;
+	record.type = (uint8_t)type;
+	record.group = group;
+	record.crc = record_crc(record, buf);
+
+	// record header and payload in a single write
+	memcpy(_buffer, &record, sizeof(record));
+
+	if (count > 0) {
+		memcpy(_buffer + RECORD_HEADER_SIZE, buf, count);
+	}
+
+	if (!write_at(_write_pos, _buffer, RECORD_HEADER_SIZE + count)) {
+		return false;
+	}
+
+	_write_pos += RECORD_HEADER_SIZE + count;
+
+	return true;
+}
+
+bool DatamanJournal::apply(uint32_t begin, uint32_t end, unsigned group, uint32_t sequence)
+{
+	RecordHeader record;
+
+	for (uint32_t pos = begin; pos < end; pos += RECORD_HEADER_SIZE + record.length) {
+		if (!read_record(pos, record)) {
+			return false;
+		}
+
+		// records of the other groups are interleaved
+		if ((record.type == (uint8_t)RecordType::Data) && (record.group == group) && (record.sequence == sequence)) {
+			if ((record.offset + record.length > _journal_offset) || !write_at(record.offset, _buffer, record.length)) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+bool DatamanJournal::remove_pending(unsigned group, bool apply)
+{
+	bool ret = true;
+	uint32_t kept = 0;
+
+	for (uint32_t i = 0; i < _index_size; i++) {
+		const IndexEntry &entry = _index[i];
+
+		if (entry.group != group) {
+			_index[kept++] = entry;
+
+		} else if (apply && ret) {
+			ret = read_at(entry.pos + RECORD_HEADER_SIZE, _buffer, entry.length)
+			      && write_at(entry.offset, _buffer, entry.length);
+		}
+	}
+
+	_index_size = kept;
+
+	Group &g = _groups[group];
+	g.sequence++;
+	g.records = 0;
+
+	return ret;
+}
+
+uint32_t DatamanJournal::commit_reserve(unsigned group) const
+{
+	uint32_t groups = 0;
+
+	for (unsigned i = 0; i < MAX_GROUPS; i++) {
+		if ((_groups[i].records > 0) || (i == group)) {
+			groups++;
+		}
+	}
+
+	return groups * RECORD_HEADER_SIZE;
+}
+
+int DatamanJournal::reset(uint32_t epoch)
+{
+	Header header{};
+	header.magic = HEADER_MAGIC;
+	header.epoch = epoch;
+	header.crc = header_crc(header);
+
+	// also invalidate the first record, the journal of the new epoch ends there
+	memset(_buffer, 0, HEADER_SIZE + RECORD_HEADER_SIZE);
+	memcpy(_buffer, &header, sizeof(header));
+
+	if (!write_at(_journal_offset, _buffer, HEADER_SIZE + RECORD_HEADER_SIZE) || (fsync(_fd) != 0)) {
+		return -EIO;
+	}
+
+	_epoch = epoch;
+	_write_pos = _journal_offset + HEADER_SIZE;
+
+	// pending writes are dropped
+	_index_size = 0;
+
+	for (Group &group : _groups) {
+		group.records = 0;
+	}
+
+	return 0;
+}
+
+uint32_t DatamanJournal::header_crc(const Header &header)
+{
+	return crc32((const uint8_t *)&header, offsetof(Header, crc));
+}
+
+uint32_t DatamanJournal::record_crc(const RecordHeader &record, const void *payload)
+{
+	RecordHeader header = record;
+	header.crc = 0;
+
+	const uint32_t crc = crc32((const uint8_t *)&header, sizeof(header));
+
+	return (record.length > 0) ? crc32part((const uint8_t *)payload, record.length, crc) : crc;
+}
@@ -0,0 +1,210 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file DatamanJournal.hpp
+ *
+ * Append-only write-ahead journal for the dataman file.
+ *
+ * The journal area is located behind the item storage of the file. Writes are appended to the journal
+ * and only applied to the item storage once the transaction they belong to is committed, which takes
+ * a single fsync. A transaction therefore is applied either completely or not at all, also on power
+ * loss: on startup committed transactions are replayed and an incomplete tail is discarded.
+ *
+ * Each write belongs to a group (the dataman item type), and the groups are committed independently:
+ * the records of the groups are interleaved in the journal, and a commit record only covers the records
+ * of its group and transaction sequence number. The pending writes are indexed in RAM, so that reads and
+ * commits don't need to scan the journal.
+ *
+ * Journal area layout: a header with the current epoch, followed by records (record header + payload).
+ * The journal ends at the first record which is not valid for the current epoch.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+class DatamanJournal
+{
+public:
+	static constexpr size_t HEADER_SIZE = 16;
+	static constexpr size_t RECORD_HEADER_SIZE = 24;
+	static constexpr size_t MAX_PAYLOAD = 128;
+	static constexpr unsigned MAX_GROUPS = 8;
+
+	DatamanJournal() = default;
+	~DatamanJournal();
+
+	DatamanJournal(const DatamanJournal &) = delete;
+	DatamanJournal &operator=(const DatamanJournal &) = delete;
+
+	/**
+	 * Attach to a file and replay the committed transactions found in its journal area.
+	 * The journal is empty afterwards.
+	 * @param fd file descriptor, opened for reading and writing
+	 * @param journal_offset start of the journal area (size of the item storage)
+	 * @param journal_size size of the journal area in bytes
+	 * @return number of replayed transactions, < 0 on error
+	 */
+	int init(int fd, uint32_t journal_offset, uint32_t journal_size);
+
+	/**
+	 * Append a write to the item storage to the open transaction of a group.
+	 * The writes of different groups must not overlap. If the journal is full, the committed records
+	 * are dropped to make room (checkpoint).
+	 * @return count on success, -ENOSPC if the pending writes of all groups don't fit into the journal,
+	 *         < 0 on other errors
+	 */
+	ssize_t write(unsigned group, uint32_t offset, const void *buf, size_t count);
+
+	/**
+	 * Read the latest uncommitted write to an offset of the item storage.
+	 * @return number of bytes read, 0 if there is no uncommitted write to this offset, < 0 on error
+	 */
+	ssize_t read_pending(uint32_t offset, void *buf, size_t count);
+
+	/**
+	 * Commit the open transaction of a group: the journal is flushed to the storage and the writes are applied.
+	 * @return 0 on success, < 0 on error
+	 */
+	int commit(unsigned group);
+
+	/**
+	 * Discard the pending writes of a group, they are never applied.
+	 */
+	void discard(unsigned group);
+
+	/**
+	 * Flush the item storage and drop the committed records from the journal.
+	 * The pending writes are kept and can still be committed.
+	 * @return 0 on success, < 0 on error
+	 */
+	int checkpoint();
+
+	bool pending(unsigned group) const { return (group < MAX_GROUPS) && (_groups[group].records > 0); }
+
+	/** number of checkpoints to make room for new writes */
+	unsigned full_checkpoints() const { return _full_checkpoints; }
+
+	/** bytes used in the journal area */
+	uint32_t used() const { return _write_pos - _journal_offset; }
+
+private:
+	enum class RecordType : uint8_t {
+		Data = 1,
+		Commit = 2,
+	};
+
+	struct Header {
+		uint32_t magic;
+		uint32_t epoch;
+		uint32_t reserved;
+		uint32_t crc;
+	};
+
+	struct RecordHeader {
+		uint32_t magic;
+		uint32_t epoch;
+		uint32_t sequence;	///< transaction sequence number of the group
+		uint32_t offset;	///< offset in the item storage, number of data records for a commit record
+		uint16_t length;	///< payload length
+		uint8_t type;
+		uint8_t group;
+		uint32_t crc;		///< CRC32 over the record header (with crc = 0) and payload
+	};
+
+	static_assert(sizeof(Header) == HEADER_SIZE, "unexpected journal header size");
+	static_assert(sizeof(RecordHeader) == RECORD_HEADER_SIZE, "unexpected journal record header size");
+
+	static constexpr uint32_t HEADER_MAGIC = 0x4a4d4444; // "DDMJ"
+	static constexpr uint32_t RECORD_MAGIC = 0x434d4444; // "DDMC"
+
+	struct Group {
+		uint32_t sequence;	///< sequence number of the open transaction
+		uint32_t records;	///< number of pending data records
+		uint32_t begin;		///< lowest item storage offset with a pending write
+		uint32_t end;		///< end of the highest item storage offset with a pending write
+	};
+
+	/** pending data record */
+	struct IndexEntry {
+		uint32_t offset;	///< offset in the item storage
+		uint32_t pos;		///< position of the record in the file
+		uint16_t length;	///< payload length
+		uint8_t group;
+	};
+
+	static constexpr uint32_t INDEX_CHUNK = 32;
+
+	bool read_at(uint32_t pos, void *buf, size_t count);
+	bool write_at(uint32_t pos, const void *buf, size_t count);
+
+	/** read and validate the record at pos, the payload is stored in _buffer */
+	bool read_record(uint32_t pos, RecordHeader &record);
+
+	bool append(RecordType type, unsigned group, uint32_t offset, const void *buf, size_t count);
+
+	/** replay: write the payloads of the data records of a transaction in [begin, end) to the item storage */
+	bool apply(uint32_t begin, uint32_t end, unsigned group, uint32_t sequence);
+
+	/** remove the index entries of a group, optionally writing their payloads to the item storage */
+	bool remove_pending(unsigned group, bool apply);
+
+	/** bytes to keep free for the commit records of the groups with pending writes */
+	uint32_t commit_reserve(unsigned group) const;
+
+	/** start a new, empty journal */
+	int reset(uint32_t epoch);
+
+	static uint32_t header_crc(const Header &header);
+	static uint32_t record_crc(const RecordHeader &record, const void *payload);
+
+	int _fd{-1};
+	uint32_t _journal_offset{0};
+	uint32_t _journal_end{0};
+
+	uint32_t _epoch{0};
+	uint32_t _write_pos{0};			///< end of the journal
+
+	Group _groups[MAX_GROUPS] {};
+
+	IndexEntry *_index{nullptr};		///< pending data records, in journal order
+	uint32_t _index_size{0};
+	uint32_t _index_capacity{0};
+
+	unsigned _full_checkpoints{0};
+
+	uint8_t _buffer[RECORD_HEADER_SIZE + MAX_PAYLOAD] {};
+};
@@ -0,0 +1,465 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2022 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file DatamanJournalTest.cpp
+ *
+ * Tests for the dataman write-ahead journal, including power loss while writing
+ * (simulated by truncating the file at every byte of a transaction) and independent groups.
+ */
+
+#include <gtest/gtest.h>
+#include "DatamanJournal.hpp"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+static constexpr uint32_t STORAGE_SIZE = 256;
+static constexpr uint32_t ITEM_SIZE = 64;
+static constexpr uint32_t JOURNAL_SIZE = 4096;
+
+class DatamanJournalTest : public ::testing::Test
+{
+public:
+	void SetUp() override
+	{
+		_file = tmpfile();
+		ASSERT_NE(_file, nullptr);
+		_fd = fileno(_file);
+	}
+
+	void TearDown() override
+	{
+		fclose(_file);
+	}
+
+	// write an item of the storage through the journal
+	ssize_t writeItem(DatamanJournal &journal, unsigned index, uint32_t value, unsigned group = 0)
+	{
+		uint8_t item[ITEM_SIZE];
+		memset(item, value, sizeof(item));
+		return journal.write(group, index * ITEM_SIZE, item, sizeof(item));
+	}
+
+	// read an item directly from the storage, returns the value if all bytes are the same, -1 otherwise
+	int readStorageItem(int fd, unsigned index)
+	{
+		uint8_t item[ITEM_SIZE] {};
+
+		if ((lseek(fd, index * ITEM_SIZE, SEEK_SET) != index * ITEM_SIZE) || (read(fd, item, sizeof(item)) < 0)) {
+			return -1;
+		}
+
+		for (unsigned i = 1; i < ITEM_SIZE; i++) {
+			if (item[i] != item[0]) {
+				return -1;
+			}
+		}
+
+		return item[0];
+	}
+
+	void readBytes(int fd, uint32_t pos, uint8_t *buf, size_t count)
+	{
+		ASSERT_EQ(lseek(fd, pos, SEEK_SET), (off_t)pos);
+		ASSERT_EQ(read(fd, buf, count), (ssize_t)count);
+	}
+
+	void writeBytes(int fd, uint32_t pos, const uint8_t *buf, size_t count)
+	{
+		ASSERT_EQ(lseek(fd, pos, SEEK_SET), (off_t)pos);
+		ASSERT_EQ(write(fd, buf, count), (ssize_t)count);
+	}
+
+	FILE *_file{nullptr};
+	int _fd{-1};
+};
+
+TEST_F(DatamanJournalTest, CommitAppliesWrites)
+{
+	DatamanJournal journal;
+	ASSERT_EQ(journal.init(_fd, STORAGE_SIZE, JOURNAL_SIZE), 0);
+
+	EXPECT_EQ(writeItem(journal, 0, 1), ITEM_SIZE);
+	EXPECT_EQ(writeItem(journal, 1, 2), ITEM_SIZE);
+	EXPECT_EQ(writeItem(journal, 0, 3), ITEM_SIZE);
+	EXPECT_TRUE(journal.pending(0));
+
+	// not applied yet, but readable from the journal (latest write wins)
+	EXPECT_EQ(readStorageItem(_fd, 0), 0);
+
+	uint8_t item[ITEM_SIZE] {};
+	EXPECT_EQ(journal.read_pending(0, item, sizeof(item)), ITEM_SIZE);
+	EXPECT_EQ(item[0], 3);
+	EXPECT_EQ(journal.read_pending(ITEM_SIZE, item, 4), 4);
+	EXPECT_EQ(item[0], 2);
+	EXPECT_EQ(journal.read_pending(2 * ITEM_SIZE, item, sizeof(item)), 0);
+
+	EXPECT_EQ(journal.commit(0), 0);
+	EXPECT_FALSE(journal.pending(0));
+	EXPECT_EQ(journal.read_pending(0, item, sizeof(item)), 0);
+
+	EXPECT_EQ(readStorageItem(_fd, 0), 3);
+	EXPECT_EQ(readStorageItem(_fd, 1), 2);
+}
+
+TEST_F(DatamanJournalTest, InvalidWritesRejected)
+{
+	DatamanJournal journal;
+	EXPECT_LT(writeItem(journal, 0, 1), 0); // not initialized
+	EXPECT_LT(journal.init(_fd, STORAGE_SIZE, 64), 0); // too small
+
+	ASSERT_EQ(journal.init(_fd, STORAGE_SIZE, JOURNAL_SIZE), 0);
+
+	uint8_t item[DatamanJournal::MAX_PAYLOAD + 1] {};
+	EXPECT_LT(journal.write(0, 0, item, sizeof(item)), 0);
+	EXPECT_LT(journal.write(DatamanJournal::MAX_GROUPS, 0, item, ITEM_SIZE), 0);
+	EXPECT_LT(writeItem(journal, STORAGE_SIZE / ITEM_SIZE, 1), 0); // would overwrite the journal
+	EXPECT_FALSE(journal.pending(0));
+}
+
+TEST_F(DatamanJournalTest, UncommittedWritesDiscardedOnRestart)
+{
+	{
+		DatamanJournal journal;
+		ASSERT_EQ(journal.init(_fd, STORAGE_SIZE, JOURNAL_SIZE), 0);
+		EXPECT_EQ(writeItem(journal, 0, 1), ITEM_SIZE);
+		EXPECT_EQ(journal.commit(0), 0);
+
+		EXPECT_EQ(writeItem(journal, 0, 2), ITEM_SIZE);
+		EXPECT_EQ(writeItem(journal, 1, 2), ITEM_SIZE);
+		// power loss before the commit
+	}
+
+	DatamanJournal journal;
+	EXPECT_EQ(journal.init(_fd, STORAGE_SIZE, JOURNAL_SIZE), 1); // the first transaction is replayed again
+	EXPECT_FALSE(journal.pending(0));
+	EXPECT_EQ(readStorageItem(_fd, 0), 1);
+	EXPECT_EQ(readStorageItem(_fd, 1), 0);
+
+	// the old records are not picked up after another restart
+	EXPECT_EQ(writeItem(journal, 1, 3), ITEM_SIZE);
+	EXPECT_EQ(journal.commit(0), 0);
+
+	DatamanJournal journal2;
+	EXPECT_EQ(journal2.init(_fd, STORAGE_SIZE, JOURNAL_SIZE), 1);
+	EXPECT_EQ(readStorageItem(_fd, 0), 1);
+	EXPECT_EQ(readStorageItem(_fd, 1), 3);
+}
+
+TEST_F(DatamanJournalTest, PowerLossDuringTransaction)
+{
+	const unsigned num_items = STORAGE_SIZE / ITEM_SIZE;
+	uint8_t storage_before[STORAGE_SIZE];
+	uint8_t journal_area[JOURNAL_SIZE];
+	uint32_t transaction_begin = 0;
+	uint32_t transaction_end = 0;
+
+	{
+		DatamanJournal journal;
+		ASSERT_EQ(journal.init(_fd, STORAGE_SIZE, JOURNAL_SIZE), 0);
+
+		for (unsigned i = 0; i < num_items; i++) {
+			EXPECT_EQ(writeItem(journal, i, 1), ITEM_SIZE);
+		}
+
+		EXPECT_EQ(journal.commit(0), 0);
+		readBytes(_fd, 0, storage_before, sizeof(storage_before));
+		transaction_begin = journal.used();
+
+		// replace all items in one transaction
+		for (unsigned i = 0; i < num_items; i++) {
+			EXPECT_EQ(writeItem(journal, i, 2), ITEM_SIZE);
+		}
+
+		EXPECT_EQ(journal.commit(0), 0);
+		transaction_end = journal.used();
+		ASSERT_LE(transaction_end, JOURNAL_SIZE);
+		readBytes(_fd, STORAGE_SIZE, journal_area, transaction_end);
+	}
+
+	// file content at the time of a power loss after 'cut' bytes of the journal were written
+	for (uint32_t cut = transaction_begin; cut <= transaction_end; cut++) {
+		ASSERT_EQ(ftruncate(_fd, 0), 0);
+		writeBytes(_fd, 0, storage_before, sizeof(storage_before));
+		writeBytes(_fd, STORAGE_SIZE, journal_area, cut);
+
+		DatamanJournal journal;
+		const int replayed = journal.init(_fd, STORAGE_SIZE, JOURNAL_SIZE);
+		const int expected = (cut == transaction_end) ? 2 : 1;
+
+		EXPECT_EQ(replayed, expected) << "cut at " << cut;
+
+		// all or nothing
+		for (unsigned i = 0; i < num_items; i++) {
+			EXPECT_EQ(readStorageItem(_fd, i), expected) << "cut at " << cut << ", item " << i;
+		}
+	}
+}
+
+TEST_F(DatamanJournalTest, PowerLossWhileApplying)
+{
+	uint8_t journal_area[JOURNAL_SIZE];
+	uint32_t journal_used = 0;
+
+	{
+		DatamanJournal journal;
+		ASSERT_EQ(journal.init(_fd, STORAGE_SIZE, JOURNAL_SIZE), 0);
+		EXPECT_EQ(writeItem(journal, 0, 5), ITEM_SIZE);
+		EXPECT_EQ(writeItem(journal, 1, 5), ITEM_SIZE);
+		EXPECT_EQ(journal.commit(0), 0);
+		journal_used = journal.used();
+		readBytes(_fd, STORAGE_SIZE, journal_area, journal_used);
+	}
+
+	// the commit record is on the storage, but only the first item got applied
+	uint8_t storage[STORAGE_SIZE] {};
+	memset(storage, 5, ITEM_SIZE);
+	ASSERT_EQ(ftruncate(_fd, 0), 0);
+	writeBytes(_fd, 0, storage, sizeof(storage));
+	writeBytes(_fd, STORAGE_SIZE, journal_area, journal_used);
+
+	DatamanJournal journal;
+	EXPECT_EQ(journal.init(_fd, STORAGE_SIZE, JOURNAL_SIZE), 1);
+	EXPECT_EQ(readStorageItem(_fd, 0), 5);
+	EXPECT_EQ(readStorageItem(_fd, 1), 5);
+}
+
+TEST_F(DatamanJournalTest, CorruptedRecordEndsJournal)
+{
+	uint32_t first_transaction_end = 0;
+
+	{
+		DatamanJournal journal;
+		ASSERT_EQ(journal.init(_fd, STORAGE_SIZE, JOURNAL_SIZE), 0);
+		EXPECT_EQ(writeItem(journal, 0, 1), ITEM_SIZE);
+		EXPECT_EQ(journal.commit(0), 0);
+		first_transaction_end = journal.used();
+		EXPECT_EQ(writeItem(journal, 0, 2), ITEM_SIZE);
+		EXPECT_EQ(journal.commit(0), 0);
+	}
+
+	// flip a payload bit of the second transaction
+	uint8_t byte;
+	const uint32_t pos = STORAGE_SIZE + first_transaction_end + DatamanJournal::RECORD_HEADER_SIZE + 10;
+	readBytes(_fd, pos, &byte, 1);
+	byte ^= 0x1;
+	writeBytes(_fd, pos, &byte, 1);
+
+	// restore the storage to the state after the first transaction
+	uint8_t storage[STORAGE_SIZE] {};
+	memset(storage, 1, ITEM_SIZE);
+	writeBytes(_fd, 0, storage, sizeof(storage));
+
+	DatamanJournal journal;
+	EXPECT_EQ(journal.init(_fd, STORAGE_SIZE, JOURNAL_SIZE), 1);
+	EXPECT_EQ(readStorageItem(_fd, 0), 1);
+}
+
+TEST_F(DatamanJournalTest, TornHeader)
+{
+	{
+		DatamanJournal journal;
+		ASSERT_EQ(journal.init(_fd, STORAGE_SIZE, JOURNAL_SIZE), 0);
+		EXPECT_EQ(writeItem(journal, 0, 1), ITEM_SIZE);
+		EXPECT_EQ(journal.commit(0), 0);
+	}
+
+	// corrupt the epoch in the header, the records must not be replayed
+	const uint8_t garbage[4] {0xff, 0x00, 0xff, 0x00};
+	writeBytes(_fd, STORAGE_SIZE + 4, garbage, sizeof(garbage));
+	uint8_t storage[STORAGE_SIZE] {};
+	writeBytes(_fd, 0, storage, sizeof(storage));
+
+	DatamanJournal journal;
+	EXPECT_EQ(journal.init(_fd, STORAGE_SIZE, JOURNAL_SIZE), 0);
+	EXPECT_EQ(readStorageItem(_fd, 0), 0);
+
+	// and the journal is usable again
+	EXPECT_EQ(writeItem(journal, 0, 4), ITEM_SIZE);
+	EXPECT_EQ(journal.commit(0), 0);
+
+	DatamanJournal journal2;
+	EXPECT_EQ(journal2.init(_fd, STORAGE_SIZE, JOURNAL_SIZE), 1);
+	EXPECT_EQ(readStorageItem(_fd, 0), 4);
+}
+
+TEST_F(DatamanJournalTest, IndependentGroups)
+{
+	{
+		DatamanJournal journal;
+		ASSERT_EQ(journal.init(_fd, STORAGE_SIZE, JOURNAL_SIZE), 0);
+
+		// interleaved writes of two groups
+		EXPECT_EQ(writeItem(journal, 0, 1, 0), ITEM_SIZE);
+		EXPECT_EQ(writeItem(journal, 2, 2, 1), ITEM_SIZE);
+		EXPECT_EQ(writeItem(journal, 1, 1, 0), ITEM_SIZE);
+		EXPECT_EQ(writeItem(journal, 3, 2, 1), ITEM_SIZE);
+
+		// the commit of a group does not apply the writes of the other one
+		EXPECT_EQ(journal.commit(1), 0);
+		EXPECT_FALSE(journal.pending(1));
+		EXPECT_TRUE(journal.pending(0));
+		EXPECT_EQ(readStorageItem(_fd, 0), 0);
+		EXPECT_EQ(readStorageItem(_fd, 2), 2);
+		EXPECT_EQ(readStorageItem(_fd, 3), 2);
+
+		uint8_t item[ITEM_SIZE] {};
+		EXPECT_EQ(journal.read_pending(ITEM_SIZE, item, sizeof(item)), ITEM_SIZE);
+		EXPECT_EQ(item[0], 1);
+		EXPECT_EQ(journal.read_pending(2 * ITEM_SIZE, item, sizeof(item)), 0);
+		// power loss while group 0 is still open
+	}
+
+	uint8_t storage[STORAGE_SIZE] {};
+	writeBytes(_fd, 0, storage, sizeof(storage));
+
+	DatamanJournal journal;
+	EXPECT_EQ(journal.init(_fd, STORAGE_SIZE, JOURNAL_SIZE), 1);
+	EXPECT_EQ(readStorageItem(_fd, 0), 0);
+	EXPECT_EQ(readStorageItem(_fd, 1), 0);
+	EXPECT_EQ(readStorageItem(_fd, 2), 2);
+	EXPECT_EQ(readStorageItem(_fd, 3), 2);
+}
+
+TEST_F(DatamanJournalTest, DiscardedWritesNotApplied)
+{
+	{
+		DatamanJournal journal;
+		ASSERT_EQ(journal.init(_fd, STORAGE_SIZE, JOURNAL_SIZE), 0);
+
+		EXPECT_EQ(writeItem(journal, 0, 1), ITEM_SIZE);
+		EXPECT_EQ(writeItem(journal, 1, 1), ITEM_SIZE);
+		journal.discard(0);
+		EXPECT_FALSE(journal.pending(0));
+
+		uint8_t item[ITEM_SIZE] {};
+		EXPECT_EQ(journal.read_pending(0, item, sizeof(item)), 0);
+
+		// the next transaction only contains the writes after the discard
+		EXPECT_EQ(writeItem(journal, 0, 2), ITEM_SIZE);
+		EXPECT_EQ(journal.commit(0), 0);
+		EXPECT_EQ(readStorageItem(_fd, 0), 2);
+		EXPECT_EQ(readStorageItem(_fd, 1), 0);
+	}
+
+	uint8_t storage[STORAGE_SIZE] {};
+	writeBytes(_fd, 0, storage, sizeof(storage));
+
+	DatamanJournal journal;
+	EXPECT_EQ(journal.init(_fd, STORAGE_SIZE, JOURNAL_SIZE), 1);
+	EXPECT_EQ(readStorageItem(_fd, 0), 2);
+	EXPECT_EQ(readStorageItem(_fd, 1), 0);
+}
+
+TEST_F(DatamanJournalTest, CheckpointKeepsPendingWrites)
+{
+	{
+		DatamanJournal journal;
+		ASSERT_EQ(journal.init(_fd, STORAGE_SIZE, JOURNAL_SIZE), 0);
+
+		EXPECT_EQ(writeItem(journal, 0, 1, 0), ITEM_SIZE);
+		EXPECT_EQ(writeItem(journal, 1, 1, 1), ITEM_SIZE);
+		EXPECT_EQ(journal.commit(1), 0);
+		EXPECT_EQ(writeItem(journal, 2, 1, 0), ITEM_SIZE);
+
+		const uint32_t used = journal.used();
+		EXPECT_EQ(journal.checkpoint(), 0);
+		EXPECT_LT(journal.used(), used);
+		EXPECT_TRUE(journal.pending(0));
+
+		uint8_t item[ITEM_SIZE] {};
+		EXPECT_EQ(journal.read_pending(2 * ITEM_SIZE, item, sizeof(item)), ITEM_SIZE);
+		EXPECT_EQ(item[0], 1);
+
+		EXPECT_EQ(journal.commit(0), 0);
+	}
+
+	uint8_t storage[STORAGE_SIZE] {};
+	writeBytes(_fd, 0, storage, sizeof(storage));
+
+	// the committed records of group 1 were dropped by the checkpoint
+	DatamanJournal journal;
+	EXPECT_EQ(journal.init(_fd, STORAGE_SIZE, JOURNAL_SIZE), 1);
+	EXPECT_EQ(readStorageItem(_fd, 0), 1);
+	EXPECT_EQ(readStorageItem(_fd, 1), 0);
+	EXPECT_EQ(readStorageItem(_fd, 2), 1);
+}
+
+TEST_F(DatamanJournalTest, FullJournal)
+{
+	// room for a few items and the commit records of two groups only
+	const uint32_t journal_size = DatamanJournal::HEADER_SIZE + 4 * (DatamanJournal::RECORD_HEADER_SIZE + ITEM_SIZE)
+				      + 2 * DatamanJournal::RECORD_HEADER_SIZE;
+
+	DatamanJournal journal;
+	ASSERT_EQ(journal.init(_fd, STORAGE_SIZE, journal_size), 0);
+
+	// items 0-2 belong to group 0, item 3 to group 1, which keeps a write pending
+	EXPECT_EQ(writeItem(journal, 3, 9, 1), ITEM_SIZE);
+
+	// committed records are dropped to make room, the pending one is kept
+	for (unsigned round = 1; round <= 5; round++) {
+		for (unsigned i = 0; i < 3; i++) {
+			EXPECT_EQ(writeItem(journal, i, round), ITEM_SIZE);
+			EXPECT_EQ(journal.commit(0), 0);
+		}
+	}
+
+	EXPECT_GT(journal.full_checkpoints(), 0u);
+	EXPECT_TRUE(journal.pending(1));
+
+	for (unsigned i = 0; i < 3; i++) {
+		EXPECT_EQ(readStorageItem(_fd, i), 5);
+	}
+
+	// a transaction is never split: it fails if the pending writes don't fit
+	for (unsigned i = 0; i < 3; i++) {
+		EXPECT_EQ(writeItem(journal, i, 6), ITEM_SIZE);
+	}
+
+	EXPECT_EQ(writeItem(journal, 0, 7), -ENOSPC);
+	journal.discard(0);
+
+	for (unsigned i = 0; i < 3; i++) {
+		EXPECT_EQ(readStorageItem(_fd, i), 5);
+	}
+
+	EXPECT_EQ(writeItem(journal, 0, 8), ITEM_SIZE);
+	EXPECT_EQ(journal.commit(0), 0);
+	EXPECT_EQ(journal.commit(1), 0);
+	EXPECT_EQ(readStorageItem(_fd, 0), 8);
+	EXPECT_EQ(readStorageItem(_fd, 3), 9);
+}
@@ -50,14 +50,25 @@
 #include <drivers/drv_hrt.h>
 #include <lib/parameters/param.h>
 #include <lib/perf/perf_counter.h>
+#include <px4_platform_common/atomic.h>
 #include <stdlib.h>
 
+#if defined(__PX4_POSIX) && !defined(__PX4_QURT)
+#define DM_MMAP_BACKEND
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 #include "dataman.h"
+#include "DatamanJournal.hpp"
 
 __BEGIN_DECLS
 __EXPORT int dataman_main(int argc, char *argv[]);
 __END_DECLS
 
+using namespace time_literals;
+
 static constexpr int TASK_STACK_SIZE = 1220;
 
 /* Private File based Operations */
@@ -66,6 +77,8 @@ static ssize_t _file_read(dm_item_t item, unsigned index, void *buf, size_t coun
 static int  _file_clear(dm_item_t item);
 static int _file_initialize(unsigned max_offset);
 static void _file_shutdown();
+static int _file_flush();
+static int _file_wait(px4_sem_t *sem);
 
 /* Private Ram based Operations */
 static ssize_t _ram_write(dm_item_t item, unsigned index, const void *buf, size_t count);
@@ -73,34 +86,92 @@ static ssize_t _ram_read(dm_item_t item, unsigned index, void *buf, size_t count
 static int  _ram_clear(dm_item_t item);
 static int _ram_initialize(unsigned max_offset);
 static void _ram_shutdown();
+static int _ram_flush();
+
+/* Private range Operations of the backends served by the worker task */
+static ssize_t _read_range(dm_item_t item, unsigned index, unsigned num_items, void *buf, size_t item_len);
+static ssize_t _write_range(dm_item_t item, unsigned index, unsigned num_items, const void *buf, size_t item_len);
+
+#if defined(DM_MMAP_BACKEND)
+/* Private memory-mapped file based Operations, called directly in the caller's context */
+static ssize_t _mmap_write(dm_item_t item, unsigned index, const void *buf, size_t count);
+static ssize_t _mmap_read(dm_item_t item, unsigned index, void *buf, size_t count);
+static int  _mmap_clear(dm_item_t item);
+static ssize_t _mmap_read_range(dm_item_t item, unsigned index, unsigned num_items, void *buf, size_t item_len);
+static ssize_t _mmap_write_range(dm_item_t item, unsigned index, unsigned num_items, const void *buf,
+				 size_t item_len);
+static int _mmap_initialize(unsigned max_offset);
+static void _mmap_shutdown();
+static int _mmap_flush();
+static int _mmap_wait(px4_sem_t *sem);
+#endif // DM_MMAP_BACKEND
 
 typedef struct dm_operations_t {
 	ssize_t (*write)(dm_item_t item, unsigned index, const void *buf, size_t count);
 	ssize_t (*read)(dm_item_t item, unsigned index, void *buf, size_t count);
 	int (*clear)(dm_item_t item);
+	ssize_t (*read_range)(dm_item_t item, unsigned index, unsigned num_items, void *buf, size_t item_len);
+	ssize_t (*write_range)(dm_item_t item, unsigned index, unsigned num_items, const void *buf, size_t item_len);
 	int (*initialize)(unsigned max_offset);
 	void (*shutdown)();
+	int (*flush)();
 	int (*wait)(px4_sem_t *sem);
+	bool direct; /* operations are thread-safe and called in the caller's context instead of the worker task */
 } dm_operations_t;
 
 static constexpr dm_operations_t dm_file_operations = {
 	.write   = _file_write,
 	.read    = _file_read,
 	.clear   = _file_clear,
+	.read_range = _read_range,
+	.write_range = _write_range,
 	.initialize = _file_initialize,
 	.shutdown = _file_shutdown,
-	.wait = px4_sem_wait,
+	.flush = _file_flush,
+	.wait = _file_wait,
+	.direct = false,
 };
 
 static constexpr dm_operations_t dm_ram_operations = {
 	.write   = _ram_write,
 	.read    = _ram_read,
 	.clear   = _ram_clear,
+	.read_range = _read_range,
+	.write_range = _write_range,
 	.initialize = _ram_initialize,
 	.shutdown = _ram_shutdown,
+	.flush = _ram_flush,
 	.wait = px4_sem_wait,
+	.direct = false,
 };
 
+#if defined(DM_MMAP_BACKEND)
+static constexpr dm_operations_t dm_mmap_operations = {
+	.write   = _mmap_write,
+	.read    = _mmap_read,
+	.clear   = _mmap_clear,
+	.read_range = _mmap_read_range,
+	.write_range = _mmap_write_range,
+	.initialize = _mmap_initialize,
+	.shutdown = _mmap_shutdown,
+	.flush = _mmap_flush,
+	.wait = _mmap_wait,
+	.direct = true,
+};
+
+/* Dirty data of the mmap backend is written back to the file in batches */
+static constexpr hrt_abstime DM_MMAP_FLUSH_INTERVAL = 200_ms;
+static struct hrt_call g_mmap_flush_call;
+#endif // DM_MMAP_BACKEND
+
+/* Writes of the file backend go to a journal behind the items and are committed per item type */
+static constexpr hrt_abstime DM_JOURNAL_COMMIT_INTERVAL = 100_ms;
+static DatamanJournal g_journal;
+static struct hrt_call g_journal_commit_call;
+static unsigned g_failed_transactions = 0;
+
+static_assert(DM_KEY_NUM_KEYS <= DatamanJournal::MAX_GROUPS, "the journal needs a group per item type");
+
 static const dm_operations_t *g_dm_ops;
 
 static struct {
@@ -113,6 +184,16 @@ static struct {
 			uint8_t *data_end;
 		} ram;
 	};
+#if defined(DM_MMAP_BACKEND)
+	/* the mmap backend accesses the mapping through ram.data */
+	struct {
+		int fd;
+		unsigned size;
+		unsigned dirty_begin;
+		unsigned dirty_end;
+		pthread_mutex_t dirty_lock;
+	} mmap;
+#endif // DM_MMAP_BACKEND
 	bool running;
 	bool silence = false;
 } dm_operations_data;
@@ -122,6 +203,10 @@ typedef enum {
 	dm_write_func = 0,
 	dm_read_func,
 	dm_clear_func,
+	dm_read_range_func,
+	dm_write_range_func,
+	dm_transaction_begin_func,
+	dm_transaction_commit_func,
 	dm_number_of_funcs
 } dm_function_t;
 
@@ -148,13 +233,30 @@ typedef struct {
 		struct {
 			dm_item_t item;
 		} clear_params;
+		struct {
+			dm_item_t item;
+			unsigned index;
+			unsigned num_items;
+			void *buf;
+			size_t item_len;
+		} read_range_params;
+		struct {
+			dm_item_t item;
+			unsigned index;
+			unsigned num_items;
+			const void *buf;
+			size_t item_len;
+		} write_range_params;
+		struct {
+			dm_item_t item;
+		} transaction_params;
 	};
 } work_q_item_t;
 
 const size_t k_work_item_allocation_chunk_size = 8;
 
 /* Usage statistics */
-static unsigned g_func_counts[dm_number_of_funcs];
+static px4::atomic<unsigned> g_func_counts[dm_number_of_funcs];
 
 /* table of maximum number of instances for each item type */
 static const unsigned g_per_item_max_index[DM_KEY_NUM_KEYS] = {
@@ -178,6 +280,9 @@ static constexpr size_t g_per_item_size[DM_KEY_NUM_KEYS] = {
 	sizeof(struct dataman_compat_s) + DM_SECTOR_HDR_SIZE
 };
 
+static_assert(sizeof(struct mission_item_s) + DM_SECTOR_HDR_SIZE <= DatamanJournal::MAX_PAYLOAD, "item too large");
+static_assert(sizeof(struct mission_s) + DM_SECTOR_HDR_SIZE <= DatamanJournal::MAX_PAYLOAD, "item too large");
+
 /* Table of offset for index 0 of each item type */
 static unsigned int g_key_offsets[DM_KEY_NUM_KEYS];
 
@@ -186,6 +291,38 @@ static px4_sem_t *g_item_locks[DM_KEY_NUM_KEYS];
 static px4_sem_t g_sys_state_mutex_mission;
 static px4_sem_t g_sys_state_mutex_fence;
 
+/* Item types with an open transaction, their writes are committed together (only accessed by the worker task) */
+static bool g_item_in_transaction[DM_KEY_NUM_KEYS];
+
+/* Open transactions which did not fit into the journal, their writes are discarded on commit */
+static bool g_item_transaction_failed[DM_KEY_NUM_KEYS];
+
+#if defined(DM_MMAP_BACKEND)
+/* Item type reader/writer locks for direct access (single items are read and written atomically) */
+static pthread_rwlock_t g_item_rwlocks[DM_KEY_NUM_KEYS];
+#endif // DM_MMAP_BACKEND
+
+/* Callers inside a direct operation, the backend is only shut down once all of them have left */
+static px4::atomic<int> g_direct_callers{0};
+static px4::atomic_bool g_direct_closing{false};
+
+static bool direct_enter()
+{
+	g_direct_callers.fetch_add(1);
+
+	if (g_direct_closing.load()) {
+		g_direct_callers.fetch_sub(1);
+		return false;
+	}
+
+	return true;
+}
+
+static void direct_leave()
+{
+	g_direct_callers.fetch_sub(1);
+}
+
 static perf_counter_t _dm_read_perf{nullptr};
 static perf_counter_t _dm_write_perf{nullptr};
 
@@ -197,6 +334,7 @@ static enum {
 	BACKEND_NONE = 0,
 	BACKEND_FILE,
 	BACKEND_RAM,
+	BACKEND_MMAP,
 	BACKEND_LAST
 } backend = BACKEND_NONE;
 
@@ -425,6 +563,13 @@ static ssize_t _ram_write(dm_item_t item, unsigned index, const void *buf, size_
 	return count;
 }
 
+static void
+wake_worker_callout(void *arg)
+{
+	/* wake up the worker task to commit the journal or write back the mapping */
+	px4_sem_post(&g_work_queued_sema);
+}
+
 /* write to the data manager file */
 static ssize_t
 _file_write(dm_item_t item, unsigned index, const void *buf, size_t count)
@@ -454,49 +599,32 @@ _file_write(dm_item_t item, unsigned index, const void *buf, size_t count)
 		memcpy(buffer + DM_SECTOR_HDR_SIZE, buf, count);
 	}
 
-	count += DM_SECTOR_HDR_SIZE;
-
-	bool write_success = false;
-
-	for (int i = 0; i < 2; i++) {
-		int ret_seek = lseek(dm_operations_data.file.fd, offset, SEEK_SET);
-
-		if (ret_seek < 0) {
-			PX4_ERR("file write lseek failed %d", errno);
-			continue;
-		}
-
-		if (ret_seek != offset) {
-			PX4_ERR("file write lseek failed, incorrect offset %d vs %d", ret_seek, offset);
-			continue;
-		}
-
-		int ret_write = write(dm_operations_data.file.fd, buffer, count);
+	if (g_item_transaction_failed[item]) {
+		return -1;
+	}
 
-		if (ret_write < 0) {
-			PX4_ERR("file write failed %d", errno);
-			continue;
-		}
+	/* Append to the journal, the items are updated when the journal is committed */
+	ssize_t ret = g_journal.write(item, offset, buffer, count + DM_SECTOR_HDR_SIZE);
 
-		if (ret_write != (ssize_t)count) {
-			PX4_ERR("file write failed, wrote %d bytes, expected %zu", ret_write, count);
-			continue;
+	if (ret < 0) {
+		PX4_ERR("journal write failed %zd", ret);
 
-		} else {
-			write_success = true;
-			break;
+		/* a transaction is applied completely or not at all */
+		if (g_item_in_transaction[item]) {
+			g_journal.discard(item);
+			g_item_transaction_failed[item] = true;
 		}
-	}
 
-	if (!write_success) {
 		return -1;
 	}
 
-	/* Make sure data is written to physical media */
-	fsync(dm_operations_data.file.fd);
+	/* Writes outside of a transaction are committed by the group commit timer */
+	if (!g_item_in_transaction[item] && hrt_called(&g_journal_commit_call)) {
+		hrt_call_after(&g_journal_commit_call, DM_JOURNAL_COMMIT_INTERVAL, wake_worker_callout, nullptr);
+	}
 
 	/* All is well... return the number of user data written */
-	return count - DM_SECTOR_HDR_SIZE;
+	return count;
 }
 
 /* Retrieve from the data manager RAM buffer*/
@@ -561,10 +689,11 @@ _file_read(dm_item_t item, unsigned index, void *buf, size_t count)
 		return -E2BIG;
 	}
 
-	int len = -1;
-	bool read_success = false;
+	/* Uncommitted writes are only in the journal */
+	int len = g_journal.read_pending(offset, buffer, count + DM_SECTOR_HDR_SIZE);
+	bool read_success = (len > 0);
 
-	for (int i = 0; i < 2; i++) {
+	for (int i = 0; (i < 2) && !read_success; i++) {
 		int ret_seek = lseek(dm_operations_data.file.fd, offset, SEEK_SET);
 
 		if ((ret_seek < 0) && !dm_operations_data.silence) {
@@ -658,6 +787,14 @@ _file_clear(dm_item_t item)
 		return -1;
 	}
 
+	/* The items are cleared in place: the pending writes are superseded, and the committed ones
+	 * must not be replayed from the journal afterwards */
+	g_journal.discard(item);
+
+	if (g_journal.checkpoint() < 0) {
+		return -1;
+	}
+
 	/* Clear all items of this type */
 	for (i = 0; (unsigned)i < g_per_item_max_index[item]; i++) {
 		char buf[1];
@@ -739,16 +876,37 @@ _file_initialize(unsigned max_offset)
 		return -1;
 	}
 
+	/* The journal holds a write of every item at once, so that the uploads of all item types fit into it.
+	 * A transaction only fails if it writes the same items repeatedly. */
+	unsigned journal_size = DatamanJournal::HEADER_SIZE + max_offset + DM_KEY_NUM_KEYS * DatamanJournal::RECORD_HEADER_SIZE;
+
+	for (unsigned i = 0; i < DM_KEY_NUM_KEYS; i++) {
+		journal_size += g_per_item_max_index[i] * DatamanJournal::RECORD_HEADER_SIZE;
+	}
+
+	/* Complete the transactions interrupted by a power loss, the journal is located behind the items */
+	int ret = g_journal.init(dm_operations_data.file.fd, max_offset, journal_size);
+
+	if (ret < 0) {
+		close(dm_operations_data.file.fd);
+		PX4_WARN("Could not initialize data manager journal (%d)", ret);
+		px4_sem_post(&g_init_sema); /* Don't want to hang startup */
+		return -1;
+
+	} else if (ret > 0) {
+		PX4_INFO("replayed %d transactions from the journal", ret);
+	}
+
 	/* Write current compat info */
 	struct dataman_compat_s compat_state;
 	compat_state.key = DM_COMPAT_KEY;
-	int ret = g_dm_ops->write(DM_KEY_COMPAT, 0, &compat_state, sizeof(compat_state));
+	ret = g_dm_ops->write(DM_KEY_COMPAT, 0, &compat_state, sizeof(compat_state));
 
 	if (ret != sizeof(compat_state)) {
 		PX4_ERR("Failed writing compat: %d", ret);
 	}
 
-	fsync(dm_operations_data.file.fd);
+	g_journal.commit(DM_KEY_COMPAT);
 	dm_operations_data.running = true;
 
 	return 0;
@@ -776,6 +934,18 @@ _ram_initialize(unsigned max_offset)
 static void
 _file_shutdown()
 {
+	hrt_cancel(&g_journal_commit_call);
+
+	/* open transactions are discarded */
+	for (unsigned i = 0; i < DM_KEY_NUM_KEYS; i++) {
+		if (g_item_in_transaction[i]) {
+			g_journal.discard(i);
+		}
+	}
+
+	_file_flush();
+	g_journal.checkpoint();
+
 	close(dm_operations_data.file.fd);
 	dm_operations_data.running = false;
 }
@@ -787,6 +957,329 @@ _ram_shutdown()
 	dm_operations_data.running = false;
 }
 
+/* commit the pending writes of all item types without an open transaction */
+static int
+_file_flush()
+{
+	int result = 0;
+
+	for (unsigned i = 0; i < DM_KEY_NUM_KEYS; i++) {
+		if (!g_item_in_transaction[i] && g_journal.pending(i)) {
+			const int ret = g_journal.commit(i);
+
+			if (ret < 0) {
+				PX4_ERR("journal commit failed %d", ret);
+				result = -1;
+			}
+		}
+	}
+
+	return result;
+}
+
+/* wait for work, committing the journal once the group commit timer expired */
+static int
+_file_wait(px4_sem_t *sem)
+{
+	int ret = px4_sem_wait(sem);
+
+	/* not armed (anymore): nothing is pending outside of a transaction, or the timer expired */
+	if (hrt_called(&g_journal_commit_call)) {
+		_file_flush();
+	}
+
+	return ret;
+}
+
+static int
+_ram_flush()
+{
+	return 0;
+}
+
+/* Retrieve consecutive items one by one, all within the same worker task request */
+static ssize_t
+_read_range(dm_item_t item, unsigned index, unsigned num_items, void *buf, size_t item_len)
+{
+	uint8_t *buffer = (uint8_t *)buf;
+	unsigned i = 0;
+
+	for (; i < num_items; i++) {
+		if (g_dm_ops->read(item, index + i, buffer + i * item_len, item_len) != (ssize_t)item_len) {
+			break;
+		}
+	}
+
+	return i;
+}
+
+/* Write consecutive items one by one and flush once at the end */
+static ssize_t
+_write_range(dm_item_t item, unsigned index, unsigned num_items, const void *buf, size_t item_len)
+{
+	const uint8_t *buffer = (const uint8_t *)buf;
+	unsigned i = 0;
+
+	for (; i < num_items; i++) {
+		if (g_dm_ops->write(item, index + i, buffer + i * item_len, item_len) != (ssize_t)item_len) {
+			break;
+		}
+	}
+
+	if (!g_item_in_transaction[item] && (i > 0)) {
+		g_dm_ops->flush();
+	}
+
+	return i;
+}
+
+#if defined(DM_MMAP_BACKEND)
+/* mark a range of the mapping for write back, the worker task is woken up to flush it after a while */
+static void _mmap_mark_dirty(unsigned begin, unsigned end)
+{
+	pthread_mutex_lock(&dm_operations_data.mmap.dirty_lock);
+	const bool was_clean = (dm_operations_data.mmap.dirty_end == 0);
+
+	if (was_clean || (begin < dm_operations_data.mmap.dirty_begin)) {
+		dm_operations_data.mmap.dirty_begin = begin;
+	}
+
+	if (end > dm_operations_data.mmap.dirty_end) {
+		dm_operations_data.mmap.dirty_end = end;
+	}
+
+	if (was_clean) {
+		hrt_call_after(&g_mmap_flush_call, DM_MMAP_FLUSH_INTERVAL, wake_worker_callout, nullptr);
+	}
+
+	pthread_mutex_unlock(&dm_operations_data.mmap.dirty_lock);
+}
+
+/* write back the dirty range of the mapping */
+static int _mmap_flush()
+{
+	pthread_mutex_lock(&dm_operations_data.mmap.dirty_lock);
+	unsigned begin = dm_operations_data.mmap.dirty_begin;
+	const unsigned end = dm_operations_data.mmap.dirty_end;
+	dm_operations_data.mmap.dirty_begin = 0;
+	dm_operations_data.mmap.dirty_end = 0;
+	pthread_mutex_unlock(&dm_operations_data.mmap.dirty_lock);
+
+	if (end > begin) {
+		/* msync needs a page aligned address */
+		const unsigned page_size = sysconf(_SC_PAGESIZE);
+		begin -= begin % page_size;
+
+		if (msync(dm_operations_data.ram.data + begin, end - begin, MS_SYNC) != 0) {
+			PX4_ERR("mmap flush failed %d", errno);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static ssize_t _mmap_write(dm_item_t item, unsigned index, const void *buf, size_t count)
+{
+	if (item >= DM_KEY_NUM_KEYS) {
+		return -1;
+	}
+
+	pthread_rwlock_wrlock(&g_item_rwlocks[item]);
+	ssize_t ret = _ram_write(item, index, buf, count);
+	pthread_rwlock_unlock(&g_item_rwlocks[item]);
+
+	if (ret >= 0) {
+		const unsigned offset = calculate_offset(item, index);
+		_mmap_mark_dirty(offset, offset + g_per_item_size[item]);
+	}
+
+	return ret;
+}
+
+static ssize_t _mmap_read(dm_item_t item, unsigned index, void *buf, size_t count)
+{
+	if (item >= DM_KEY_NUM_KEYS) {
+		return -1;
+	}
+
+	pthread_rwlock_rdlock(&g_item_rwlocks[item]);
+	ssize_t ret = _ram_read(item, index, buf, count);
+	pthread_rwlock_unlock(&g_item_rwlocks[item]);
+
+	return ret;
+}
+
+static ssize_t _mmap_read_range(dm_item_t item, unsigned index, unsigned num_items, void *buf, size_t item_len)
+{
+	uint8_t *buffer = (uint8_t *)buf;
+	unsigned i = 0;
+
+	pthread_rwlock_rdlock(&g_item_rwlocks[item]);
+
+	for (; i < num_items; i++) {
+		if (_ram_read(item, index + i, buffer + i * item_len, item_len) != (ssize_t)item_len) {
+			break;
+		}
+	}
+
+	pthread_rwlock_unlock(&g_item_rwlocks[item]);
+
+	return i;
+}
+
+static ssize_t _mmap_write_range(dm_item_t item, unsigned index, unsigned num_items, const void *buf,
+				 size_t item_len)
+{
+	const uint8_t *buffer = (const uint8_t *)buf;
+	unsigned i = 0;
+
+	/* the whole range is updated atomically */
+	pthread_rwlock_wrlock(&g_item_rwlocks[item]);
+
+	for (; i < num_items; i++) {
+		if (_ram_write(item, index + i, buffer + i * item_len, item_len) != (ssize_t)item_len) {
+			break;
+		}
+	}
+
+	pthread_rwlock_unlock(&g_item_rwlocks[item]);
+
+	if (i > 0) {
+		const unsigned offset = calculate_offset(item, index);
+		_mmap_mark_dirty(offset, offset + i * g_per_item_size[item]);
+	}
+
+	return i;
+}
+
+static int _mmap_clear(dm_item_t item)
+{
+	if (item >= DM_KEY_NUM_KEYS) {
+		return -1;
+	}
+
+	pthread_rwlock_wrlock(&g_item_rwlocks[item]);
+	int ret = _ram_clear(item);
+	pthread_rwlock_unlock(&g_item_rwlocks[item]);
+
+	if (ret == 0) {
+		const unsigned offset = calculate_offset(item, 0);
+		_mmap_mark_dirty(offset, offset + g_per_item_max_index[item] * g_per_item_size[item]);
+	}
+
+	return ret;
+}
+
+static int
+_mmap_initialize(unsigned max_offset)
+{
+	for (unsigned i = 0; i < DM_KEY_NUM_KEYS; i++) {
+		pthread_rwlock_init(&g_item_rwlocks[i], nullptr);
+	}
+
+	pthread_mutex_init(&dm_operations_data.mmap.dirty_lock, nullptr);
+	dm_operations_data.mmap.dirty_begin = 0;
+	dm_operations_data.mmap.dirty_end = 0;
+	g_direct_closing.store(false);
+
+	/* Open or create the data manager file */
+	dm_operations_data.mmap.fd = open(k_data_manager_device_path, O_RDWR | O_CREAT | O_BINARY, PX4_O_MODE_666);
+
+	if (dm_operations_data.mmap.fd < 0) {
+		PX4_WARN("Could not open data manager file %s", k_data_manager_device_path);
+		px4_sem_post(&g_init_sema); /* Don't want to hang startup */
+		return -1;
+	}
+
+	struct stat st;
+	const bool size_ok = (fstat(dm_operations_data.mmap.fd, &st) == 0) && (st.st_size == (off_t)max_offset);
+
+	if (!size_ok && (ftruncate(dm_operations_data.mmap.fd, max_offset) != 0)) {
+		close(dm_operations_data.mmap.fd);
+		PX4_WARN("Could not resize data manager file %s", k_data_manager_device_path);
+		px4_sem_post(&g_init_sema); /* Don't want to hang startup */
+		return -1;
+	}
+
+	void *data = mmap(nullptr, max_offset, PROT_READ | PROT_WRITE, MAP_SHARED, dm_operations_data.mmap.fd, 0);
+
+	if (data == MAP_FAILED) {
+		close(dm_operations_data.mmap.fd);
+		PX4_WARN("Could not map data manager file %s", k_data_manager_device_path);
+		px4_sem_post(&g_init_sema); /* Don't want to hang startup */
+		return -1;
+	}
+
+	dm_operations_data.ram.data = (uint8_t *)data;
+	dm_operations_data.ram.data_end = &dm_operations_data.ram.data[max_offset - 1];
+	dm_operations_data.mmap.size = max_offset;
+
+	/* Check the compat key, discard the content if incompatible */
+	struct dataman_compat_s compat_state {};
+	ssize_t ret = _ram_read(DM_KEY_COMPAT, 0, &compat_state, sizeof(compat_state));
+
+	if (!size_ok || (ret != sizeof(compat_state)) || (compat_state.key != DM_COMPAT_KEY)) {
+		memset(dm_operations_data.ram.data, 0, max_offset);
+
+		/* Write current compat info */
+		compat_state.key = DM_COMPAT_KEY;
+		ret = _ram_write(DM_KEY_COMPAT, 0, &compat_state, sizeof(compat_state));
+
+		if (ret != sizeof(compat_state)) {
+			PX4_ERR("Failed writing compat: %zd", ret);
+		}
+
+		msync(dm_operations_data.ram.data, max_offset, MS_SYNC);
+	}
+
+	dm_operations_data.running = true;
+
+	return 0;
+}
+
+static void
+_mmap_shutdown()
+{
+	/* stop new direct callers and wait for the ones still accessing the mapping or the locks */
+	g_direct_closing.store(true);
+
+	while (g_direct_callers.load() > 0) {
+		px4_usleep(1000);
+	}
+
+	hrt_cancel(&g_mmap_flush_call);
+	_mmap_flush();
+	munmap(dm_operations_data.ram.data, dm_operations_data.mmap.size);
+	close(dm_operations_data.mmap.fd);
+	dm_operations_data.running = false;
+
+	pthread_mutex_destroy(&dm_operations_data.mmap.dirty_lock);
+
+	for (unsigned i = 0; i < DM_KEY_NUM_KEYS; i++) {
+		pthread_rwlock_destroy(&g_item_rwlocks[i]);
+	}
+}
+
+/* wait for work, flushing dirty data after it has been collected for a while */
+static int
+_mmap_wait(px4_sem_t *sem)
+{
+	int ret = px4_sem_wait(sem);
+
+	/* the flush timer is started when the mapping gets dirty */
+	pthread_mutex_lock(&dm_operations_data.mmap.dirty_lock);
+	const bool flush = (dm_operations_data.mmap.dirty_end > 0) && hrt_called(&g_mmap_flush_call);
+	pthread_mutex_unlock(&dm_operations_data.mmap.dirty_lock);
+
+	if (flush) {
+		_mmap_flush();
+	}
+
+	return ret;
+}
+#endif // DM_MMAP_BACKEND
+
 /** Write to the data manager file */
 __EXPORT ssize_t
 dm_write(dm_item_t item, unsigned index, const void *buf, size_t count)
@@ -800,6 +1293,19 @@ dm_write(dm_item_t item, unsigned index, const void *buf, size_t count)
 
 	perf_begin(_dm_write_perf);
 
+	if (g_dm_ops->direct) {
+		ssize_t ret = -1;
+
+		if (direct_enter()) {
+			g_func_counts[dm_write_func].fetch_add(1);
+			ret = g_dm_ops->write(item, index, buf, count);
+			direct_leave();
+		}
+
+		perf_end(_dm_write_perf);
+		return ret;
+	}
+
 	/* get a work item and queue up a write request */
 	if ((work = create_work_item()) == nullptr) {
 		PX4_ERR("dm_write create_work_item failed");
@@ -832,6 +1338,19 @@ dm_read(dm_item_t item, unsigned index, void *buf, size_t count)
 
 	perf_begin(_dm_read_perf);
 
+	if (g_dm_ops->direct) {
+		ssize_t ret = -1;
+
+		if (direct_enter()) {
+			g_func_counts[dm_read_func].fetch_add(1);
+			ret = g_dm_ops->read(item, index, buf, count);
+			direct_leave();
+		}
+
+		perf_end(_dm_read_perf);
+		return ret;
+	}
+
 	/* get a work item and queue up a read request */
 	if ((work = create_work_item()) == nullptr) {
 		PX4_ERR("dm_read create_work_item failed");
@@ -862,6 +1381,17 @@ dm_clear(dm_item_t item)
 		return -1;
 	}
 
+	if (g_dm_ops->direct) {
+		if (!direct_enter()) {
+			return -1;
+		}
+
+		g_func_counts[dm_clear_func].fetch_add(1);
+		int ret = g_dm_ops->clear(item);
+		direct_leave();
+		return ret;
+	}
+
 	/* get a work item and queue up a clear request */
 	if ((work = create_work_item()) == nullptr) {
 		PX4_ERR("dm_clear create_work_item failed");
@@ -875,6 +1405,163 @@ dm_clear(dm_item_t item)
 	return enqueue_work_item_and_wait_for_result(work);
 }
 
+/* Check that a range of items is valid for the item type */
+static bool
+valid_range(dm_item_t item, unsigned index, unsigned num_items, size_t item_len)
+{
+	if (item >= DM_KEY_NUM_KEYS) {
+		return false;
+	}
+
+	if ((num_items == 0) || (index >= g_per_item_max_index[item]) || (num_items > g_per_item_max_index[item] - index)) {
+		return false;
+	}
+
+	return item_len <= (g_per_item_size[item] - DM_SECTOR_HDR_SIZE);
+}
+
+/** Retrieve a range of items from the data manager file */
+__EXPORT ssize_t
+dm_read_range(dm_item_t item, unsigned index, unsigned num_items, void *buf, size_t item_len)
+{
+	work_q_item_t *work;
+
+	/* Make sure data manager has been started and is not shutting down */
+	if (!is_running() || g_task_should_exit) {
+		return -1;
+	}
+
+	if (!valid_range(item, index, num_items, item_len)) {
+		return -1;
+	}
+
+	if (g_dm_ops->direct) {
+		if (!direct_enter()) {
+			return -1;
+		}
+
+		g_func_counts[dm_read_range_func].fetch_add(1);
+		ssize_t ret = g_dm_ops->read_range(item, index, num_items, buf, item_len);
+		direct_leave();
+		return ret;
+	}
+
+	/* get a work item and queue up a range read request */
+	if ((work = create_work_item()) == nullptr) {
+		PX4_ERR("dm_read_range create_work_item failed");
+		return -1;
+	}
+
+	work->func = dm_read_range_func;
+	work->read_range_params.item = item;
+	work->read_range_params.index = index;
+	work->read_range_params.num_items = num_items;
+	work->read_range_params.buf = buf;
+	work->read_range_params.item_len = item_len;
+
+	/* Enqueue the item on the work queue and wait for the worker thread to complete processing it */
+	return (ssize_t)enqueue_work_item_and_wait_for_result(work);
+}
+
+/** Write a range of items to the data manager file */
+__EXPORT ssize_t
+dm_write_range(dm_item_t item, unsigned index, unsigned num_items, const void *buf, size_t item_len)
+{
+	work_q_item_t *work;
+
+	/* Make sure data manager has been started and is not shutting down */
+	if (!is_running() || g_task_should_exit) {
+		return -1;
+	}
+
+	if (!valid_range(item, index, num_items, item_len)) {
+		return -1;
+	}
+
+	if (g_dm_ops->direct) {
+		if (!direct_enter()) {
+			return -1;
+		}
+
+		g_func_counts[dm_write_range_func].fetch_add(1);
+		ssize_t ret = g_dm_ops->write_range(item, index, num_items, buf, item_len);
+		direct_leave();
+		return ret;
+	}
+
+	/* get a work item and queue up a range write request */
+	if ((work = create_work_item()) == nullptr) {
+		PX4_ERR("dm_write_range create_work_item failed");
+		return -1;
+	}
+
+	work->func = dm_write_range_func;
+	work->write_range_params.item = item;
+	work->write_range_params.index = index;
+	work->write_range_params.num_items = num_items;
+	work->write_range_params.buf = buf;
+	work->write_range_params.item_len = item_len;
+
+	/* Enqueue the item on the work queue and wait for the worker thread to complete processing it */
+	return (ssize_t)enqueue_work_item_and_wait_for_result(work);
+}
+
+/* Queue a transaction begin or commit request */
+static int
+transaction_request(dm_item_t item, dm_function_t func)
+{
+	work_q_item_t *work;
+
+	/* Make sure data manager has been started and is not shutting down */
+	if (!is_running() || g_task_should_exit) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	/* Only the items uploaded in bulk support transactions */
+	if (item != DM_KEY_SAFE_POINTS && item != DM_KEY_FENCE_POINTS &&
+	    item != DM_KEY_WAYPOINTS_OFFBOARD_0 && item != DM_KEY_WAYPOINTS_OFFBOARD_1) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	if (g_dm_ops->direct) {
+		/* direct backends batch the write back anyway, flush on commit */
+		if (!direct_enter()) {
+			return -1;
+		}
+
+		g_func_counts[func].fetch_add(1);
+		int ret = (func == dm_transaction_commit_func) ? g_dm_ops->flush() : 0;
+		direct_leave();
+		return ret;
+	}
+
+	/* get a work item and queue up the request */
+	if ((work = create_work_item()) == nullptr) {
+		PX4_ERR("dm_transaction create_work_item failed");
+		return -1;
+	}
+
+	work->func = func;
+	work->transaction_params.item = item;
+
+	/* Enqueue the item on the work queue and wait for the worker thread to complete processing it */
+	return enqueue_work_item_and_wait_for_result(work);
+}
+
+__EXPORT int
+dm_transaction_begin(dm_item_t item)
+{
+	return transaction_request(item, dm_transaction_begin_func);
+}
+
+__EXPORT int
+dm_transaction_commit(dm_item_t item)
+{
+	return transaction_request(item, dm_transaction_commit_func);
+}
+
 __EXPORT int
 dm_lock(dm_item_t item)
 {
@@ -950,6 +1637,13 @@ task_main(int argc, char *argv[])
 		g_dm_ops = &dm_ram_operations;
 		break;
 
+#if defined(DM_MMAP_BACKEND)
+
+	case BACKEND_MMAP:
+		g_dm_ops = &dm_mmap_operations;
+		break;
+#endif // DM_MMAP_BACKEND
+
 	default:
 		PX4_WARN("No valid backend set.");
 		return -1;
@@ -968,7 +1662,7 @@ task_main(int argc, char *argv[])
 			      g_per_item_size[DM_KEY_NUM_KEYS - 1]);
 
 	for (unsigned i = 0; i < dm_number_of_funcs; i++) {
-		g_func_counts[i] = 0;
+		g_func_counts[i].store(0);
 	}
 
 	/* Initialize the item type locks, for now only DM_KEY_MISSION_STATE & DM_KEY_FENCE_POINTS supports locking */
@@ -977,6 +1671,8 @@ task_main(int argc, char *argv[])
 
 	for (unsigned i = 0; i < DM_KEY_NUM_KEYS; i++) {
 		g_item_locks[i] = nullptr;
+		g_item_in_transaction[i] = false;
+		g_item_transaction_failed[i] = false;
 	}
 
 	g_item_locks[DM_KEY_MISSION_STATE] = &g_sys_state_mutex_mission;
@@ -1013,6 +1709,10 @@ task_main(int argc, char *argv[])
 		PX4_INFO("data manager RAM size is %u bytes", max_offset);
 		break;
 
+	case BACKEND_MMAP:
+		PX4_INFO("data manager file '%s' (memory-mapped) size is %u bytes", k_data_manager_device_path, max_offset);
+		break;
+
 	default:
 		break;
 	}
@@ -1035,22 +1735,60 @@ task_main(int argc, char *argv[])
 			/* handle each work item with the appropriate handler */
 			switch (work->func) {
 			case dm_write_func:
-				g_func_counts[dm_write_func]++;
+				g_func_counts[dm_write_func].fetch_add(1);
 				work->result =
 					g_dm_ops->write(work->write_params.item, work->write_params.index, work->write_params.buf, work->write_params.count);
 				break;
 
 			case dm_read_func:
-				g_func_counts[dm_read_func]++;
+				g_func_counts[dm_read_func].fetch_add(1);
 				work->result =
 					g_dm_ops->read(work->read_params.item, work->read_params.index, work->read_params.buf, work->read_params.count);
 				break;
 
 			case dm_clear_func:
-				g_func_counts[dm_clear_func]++;
+				g_func_counts[dm_clear_func].fetch_add(1);
 				work->result = g_dm_ops->clear(work->clear_params.item);
 				break;
 
+			case dm_read_range_func:
+				g_func_counts[dm_read_range_func].fetch_add(1);
+				work->result =
+					g_dm_ops->read_range(work->read_range_params.item, work->read_range_params.index, work->read_range_params.num_items,
+							     work->read_range_params.buf, work->read_range_params.item_len);
+				break;
+
+			case dm_write_range_func:
+				g_func_counts[dm_write_range_func].fetch_add(1);
+				work->result =
+					g_dm_ops->write_range(work->write_range_params.item, work->write_range_params.index,
+							      work->write_range_params.num_items, work->write_range_params.buf, work->write_range_params.item_len);
+				break;
+
+			case dm_transaction_begin_func:
+				g_func_counts[dm_transaction_begin_func].fetch_add(1);
+				/* earlier writes are not part of the transaction */
+				g_dm_ops->flush();
+				g_item_in_transaction[work->transaction_params.item] = true;
+				g_item_transaction_failed[work->transaction_params.item] = false;
+				work->result = 0;
+				break;
+
+			case dm_transaction_commit_func:
+				g_func_counts[dm_transaction_commit_func].fetch_add(1);
+				g_item_in_transaction[work->transaction_params.item] = false;
+
+				if (g_item_transaction_failed[work->transaction_params.item]) {
+					g_item_transaction_failed[work->transaction_params.item] = false;
+					g_failed_transactions++;
+					work->result = -1;
+
+				} else {
+					work->result = g_dm_ops->flush();
+				}
+
+				break;
+
 			default: /* should never happen */
 				work->result = -1;
 				break;
@@ -1127,12 +1865,21 @@ static void
 status()
 {
 	/* display usage statistics */
-	PX4_INFO("Writes   %u", g_func_counts[dm_write_func]);
-	PX4_INFO("Reads    %u", g_func_counts[dm_read_func]);
-	PX4_INFO("Clears   %u", g_func_counts[dm_clear_func]);
+	PX4_INFO("Writes   %u", g_func_counts[dm_write_func].load());
+	PX4_INFO("Reads    %u", g_func_counts[dm_read_func].load());
+	PX4_INFO("Clears   %u", g_func_counts[dm_clear_func].load());
+	PX4_INFO("Range writes %u, reads %u", g_func_counts[dm_write_range_func].load(),
+		 g_func_counts[dm_read_range_func].load());
+	PX4_INFO("Transactions %u, commits %u", g_func_counts[dm_transaction_begin_func].load(),
+		 g_func_counts[dm_transaction_commit_func].load());
 	PX4_INFO("Max Q lengths work %u, free %u", g_work_q.max_size, g_free_q.max_size);
 	perf_print_counter(_dm_read_perf);
 	perf_print_counter(_dm_write_perf);
+
+	if (backend == BACKEND_FILE) {
+		PX4_INFO("Journal %u bytes used, %u checkpoints when full, %u failed transactions", (unsigned)g_journal.used(),
+			 g_journal.full_checkpoints(), g_failed_transactions);
+	}
 }
 
 static void
@@ -1152,6 +1899,8 @@ usage()
 Module to provide persistent storage for the rest of the system in form of a simple database through a C API.
 Multiple backends are supported:
 - a file (eg. on the SD card)
+- a memory-mapped file (POSIX only): reads and writes are served directly in the caller's context and
+  written back to the file in batches
 - RAM (this is obviously not persistent)
 
 It is used to store structured data of different types: mission waypoints, mission state and geofence polygons.
@@ -1161,6 +1910,16 @@ Each type has a specific type and a fixed maximum amount of storage items, so th
 Reading and writing a single item is always atomic. If multiple items need to be read/modified atomically, there is
 an additional lock per item type via `dm_lock`.
 
+The file backend appends all writes to a journal behind the items. The writes of each item type are committed
+independently with a single flush: at the end of a transaction or range write, or 100 ms after the first uncommitted
+write outside of a transaction, and only then applied to the items. Committed transactions which were interrupted by a
+power loss are completed on startup, so that a transaction is applied either completely or not at all. The journal
+fits a write of every item; a transaction which does not fit is discarded and its commit fails.
+
+Consecutive items can be read and written with a single request via `dm_read_range` and `dm_write_range`, which
+flush to the storage only once. Mission, fence and safe point uploads are wrapped in a transaction
+(`dm_transaction_begin` / `dm_transaction_commit`), so that the single writes are flushed once on commit.
+
 **DM_KEY_FENCE_POINTS** and **DM_KEY_SAFE_POINTS** items: the first data element is a `mission_stats_entry_s` struct,
 which stores the number of items for these types. These items are always updated atomically in one transaction (from
 the mavlink mission manager). During that time, navigator will try to acquire the geofence item lock, fail, and will not
@@ -1171,15 +1930,16 @@ check for geofence violations.
 	PRINT_MODULE_USAGE_NAME("dataman", "system");
 	PRINT_MODULE_USAGE_COMMAND("start");
 	PRINT_MODULE_USAGE_PARAM_STRING('f', nullptr, "<file>", "Storage file", true);
+	PRINT_MODULE_USAGE_PARAM_STRING('m', nullptr, "<file>", "Memory-mapped storage file (POSIX only)", true);
 	PRINT_MODULE_USAGE_PARAM_FLAG('r', "Use RAM backend (NOT persistent)", true);
-	PRINT_MODULE_USAGE_PARAM_COMMENT("The options -f and -r are mutually exclusive. If nothing is specified, a file 'dataman' is used");
+	PRINT_MODULE_USAGE_PARAM_COMMENT("The options -f, -m and -r are mutually exclusive. If nothing is specified, a file 'dataman' is used");
 	PRINT_MODULE_USAGE_DEFAULT_COMMANDS();
 }
 
 static int backend_check()
 {
 	if (backend != BACKEND_NONE) {
-		PX4_WARN("-f and -r are mutually exclusive");
+		PX4_WARN("-f, -m and -r are mutually exclusive");
 		usage();
 		return -1;
 	}
@@ -1208,7 +1968,7 @@ dataman_main(int argc, char *argv[])
 
 		/* jump over start and look at options first */
 
-		while ((ch = px4_getopt(argc, argv, "f:r", &dmoptind, &dmoptarg)) != EOF) {
+		while ((ch = px4_getopt(argc, argv, "f:m:r", &dmoptind, &dmoptarg)) != EOF) {
 			switch (ch) {
 			case 'f':
 				if (backend_check()) {
@@ -1220,6 +1980,19 @@ dataman_main(int argc, char *argv[])
 				PX4_INFO("dataman file set to: %s", k_data_manager_device_path);
 				break;
 
+#if defined(DM_MMAP_BACKEND)
+
+			case 'm':
+				if (backend_check()) {
+					return -1;
+				}
+
+				backend = BACKEND_MMAP;
+				k_data_manager_device_path = strdup(dmoptarg);
+				PX4_INFO("dataman memory-mapped file set to: %s", k_data_manager_device_path);
+				break;
+#endif // DM_MMAP_BACKEND
+
 			case 'r':
 				if (backend_check()) {
 					return -1;
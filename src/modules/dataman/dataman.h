@@ -108,6 +108,54 @@ dm_write(
 	size_t buflen			/* Length in bytes of data to retrieve */
 );
 
+/**
+ * Retrieve a range of consecutive items of a type with a single data manager request.
+ * Items are stored in the caller buffer with a stride of item_len bytes.
+ * @return number of items read completely (stops at the first item with a different length), -1 on error
+ */
+__EXPORT ssize_t
+dm_read_range(
+	dm_item_t item,			/* The item type to retrieve */
+	unsigned index,			/* The index of the first item */
+	unsigned num_items,		/* The number of items to retrieve */
+	void *buffer,			/* Pointer to caller data buffer, at least num_items * item_len bytes */
+	size_t item_len			/* Length in bytes of each item */
+);
+
+/**
+ * Write a range of consecutive items of a type with a single data manager request.
+ * The data is flushed to the storage once after all items have been written.
+ * @return number of items written, -1 on error
+ */
+__EXPORT ssize_t
+dm_write_range(
+	dm_item_t item,			/* The item type to store */
+	unsigned index,			/* The index of the first item */
+	unsigned num_items,		/* The number of items to store */
+	const void *buffer,		/* Pointer to caller data buffer, at least num_items * item_len bytes */
+	size_t item_len			/* Length in bytes of each item */
+);
+
+/**
+ * Begin a transaction on the mission, fence or safe point items: writes of this type are no longer flushed
+ * to the storage individually until the transaction is committed.
+ * Note that this does not lock the items, use dm_lock in addition if other writers are expected.
+ * @return 0 on success, -1 on error (errno set)
+ */
+__EXPORT int
+dm_transaction_begin(
+	dm_item_t item			/* The item type to write in a transaction */
+);
+
+/**
+ * Commit a transaction started with dm_transaction_begin, flushing all items written in the meantime.
+ * @return 0 on success, -1 on error (errno set)
+ */
+__EXPORT int
+dm_transaction_commit(
+	dm_item_t item			/* The item type of the transaction */
+);
+
 /**
  * Lock all items of a type. Can be used for atomic updates of multiple items (single items are always updated
  * atomically).
@@ -38,6 +38,7 @@
  * @value -1 Disabled
  * @value 0 default (SD card)
  * @value 1 RAM (not persistent)
+ * @value 2 Memory-mapped file (POSIX only)
  * @boolean
  * @reboot_required true
  */
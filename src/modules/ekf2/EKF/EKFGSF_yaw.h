@@ -88,10 +88,10 @@ public:
 private:
 
 	// Parameters - these could be made tuneable
-	const float _gyro_noise{1.0e-1f}; 	// yaw rate noise used for covariance prediction (rad/sec)
-	const float _accel_noise{2.0f};		// horizontal accel noise used for covariance prediction (m/sec**2)
-	const float _tilt_gain{0.2f};		// gain from tilt error to gyro correction for complementary filter (1/sec)
-	const float _gyro_bias_gain{0.04f};	// gain applied to integral of gyro correction for complementary filter (1/sec)
+	float _gyro_noise{1.0e-1f}; 	// yaw rate noise used for covariance prediction (rad/sec)
+	float _accel_noise{2.0f};		// horizontal accel noise used for covariance prediction (m/sec**2)
+	float _tilt_gain{0.2f};		// gain from tilt error to gyro correction for complementary filter (1/sec)
+	float _gyro_bias_gain{0.04f};	// gain applied to integral of gyro correction for complementary filter (1/sec)
 
 	// Declarations used by the bank of N_MODELS_EKFGSF AHRS complementary filters
 
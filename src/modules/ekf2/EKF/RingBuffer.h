@@ -46,12 +46,37 @@ class RingBuffer
 {
 public:
 	explicit RingBuffer(size_t size) { allocate(size); }
-	RingBuffer() = delete;
+	RingBuffer() = default; // not allocated
 	~RingBuffer() { delete[] _buffer; }
 
-	// no copy, assignment, move, move assignment
-	RingBuffer(const RingBuffer &) = delete;
-	RingBuffer &operator=(const RingBuffer &) = delete;
+	// copy and assignment copy the content (e.g. to checkpoint the estimator), no move, move assignment
+	RingBuffer(const RingBuffer &other) { *this = other; }
+	RingBuffer &operator=(const RingBuffer &other)
+	{
+		if (this == &other) {
+			return *this;
+		}
+
+		if (!other.valid()) {
+			delete[] _buffer;
+			_buffer = nullptr;
+			_size = 0;
+
+		} else if (!allocate(other._size)) {
+			return *this;
+		}
+
+		for (uint8_t i = 0; i < _size; i++) {
+			_buffer[i] = other._buffer[i];
+		}
+
+		_head = other._head;
+		_tail = other._tail;
+		_first_write = other._first_write;
+
+		return *this;
+	}
+
 	RingBuffer(RingBuffer &&) = delete;
 	RingBuffer &operator=(RingBuffer &&) = delete;
 
@@ -85,12 +85,12 @@ void Ekf::controlFusionModes()
 		}
 	}
 
-	if (_baro_buffer) {
+	if (_baro_buffer.valid()) {
 		// check for intermittent data
 		_baro_hgt_intermittent = !isRecent(_time_last_baro, 2 * BARO_MAX_INTERVAL);
 
 		const uint64_t baro_time_prev = _baro_sample_delayed.time_us;
-		_baro_data_ready = _baro_buffer->pop_first_older_than(_imu_sample_delayed.time_us, &_baro_sample_delayed);
+		_baro_data_ready = _baro_buffer.pop_first_older_than(_imu_sample_delayed.time_us, &_baro_sample_delayed);
 
 		// if we have a new baro sample save the delta time between this sample and the last sample which is
 		// used below for baro offset calculations
@@ -100,12 +100,12 @@ void Ekf::controlFusionModes()
 	}
 
 
-	if (_gps_buffer) {
+	if (_gps_buffer.valid()) {
 		_gps_intermittent = !isRecent(_time_last_gps, 2 * GPS_MAX_INTERVAL);
 
 		// check for arrival of new sensor data at the fusion time horizon
 		_time_prev_gps_us = _gps_sample_delayed.time_us;
-		_gps_data_ready = _gps_buffer->pop_first_older_than(_imu_sample_delayed.time_us, &_gps_sample_delayed);
+		_gps_data_ready = _gps_buffer.pop_first_older_than(_imu_sample_delayed.time_us, &_gps_sample_delayed);
 
 		if (_gps_data_ready) {
 			// correct velocity for offset relative to IMU
@@ -123,9 +123,9 @@ void Ekf::controlFusionModes()
 		}
 	}
 
-	if (_range_buffer) {
+	if (_range_buffer.valid()) {
 		// Get range data from buffer and check validity
-		_rng_data_ready = _range_buffer->pop_first_older_than(_imu_sample_delayed.time_us, _range_sensor.getSampleAddress());
+		_rng_data_ready = _range_buffer.pop_first_older_than(_imu_sample_delayed.time_us, _range_sensor.getSampleAddress());
 		_range_sensor.setDataReadiness(_rng_data_ready);
 
 		// update range sensor angle parameters in case they have changed
@@ -152,26 +152,26 @@ void Ekf::controlFusionModes()
 		_control_status.flags.rng_kin_consistent = _rng_consistency_check.isKinematicallyConsistent();
 	}
 
-	if (_flow_buffer) {
+	if (_flow_buffer.valid()) {
 		// We don't fuse flow data immediately because we have to wait for the mid integration point to fall behind the fusion time horizon.
 		// This means we stop looking for new data until the old data has been fused, unless we are not fusing optical flow,
 		// in this case we need to empty the buffer
 		if (!_flow_data_ready || (!_control_status.flags.opt_flow && !_hagl_sensor_status.flags.flow)) {
-			_flow_data_ready = _flow_buffer->pop_first_older_than(_imu_sample_delayed.time_us, &_flow_sample_delayed);
+			_flow_data_ready = _flow_buffer.pop_first_older_than(_imu_sample_delayed.time_us, &_flow_sample_delayed);
 		}
 	}
 
-	if (_ext_vision_buffer) {
+	if (_ext_vision_buffer.valid()) {
 		const uint64_t time_prev = _ev_sample_delayed.time_us;
-		_ev_data_ready = _ext_vision_buffer->pop_first_older_than(_imu_sample_delayed.time_us, &_ev_sample_delayed);
+		_ev_data_ready = _ext_vision_buffer.pop_first_older_than(_imu_sample_delayed.time_us, &_ev_sample_delayed);
 
 		if (_ev_data_ready && time_prev != 0) {
 			_delta_time_ev_us = _ev_sample_delayed.time_us - time_prev;
 		}
 	}
 
-	if (_airspeed_buffer) {
-		_tas_data_ready = _airspeed_buffer->pop_first_older_than(_imu_sample_delayed.time_us, &_airspeed_sample_delayed);
+	if (_airspeed_buffer.valid()) {
+		_tas_data_ready = _airspeed_buffer.pop_first_older_than(_imu_sample_delayed.time_us, &_airspeed_sample_delayed);
 	}
 
 	// run EKF-GSF yaw estimator once per _imu_sample_delayed update after all main EKF data samples available
@@ -552,8 +552,8 @@ void Ekf::controlHeightSensorTimeouts()
 			// check if vision data is available
 			bool ev_data_available = false;
 
-			if (_ext_vision_buffer) {
-				const extVisionSample &ev_init = _ext_vision_buffer->get_newest();
+			if (_ext_vision_buffer.valid()) {
+				const extVisionSample &ev_init = _ext_vision_buffer.get_newest();
 				ev_data_available = isRecent(ev_init.time_us, 2 * EV_MAX_INTERVAL);
 			}
 
@@ -938,7 +938,7 @@ void Ekf::controlBetaFusion()
 
 void Ekf::controlDragFusion()
 {
-	if ((_params.fusion_mode & SensorFusionMask::USE_DRAG) && _drag_buffer &&
+	if ((_params.fusion_mode & SensorFusionMask::USE_DRAG) && _drag_buffer.valid() &&
 	    !_using_synthetic_position && _control_status.flags.in_air) {
 
 		if (!_control_status.flags.wind) {
@@ -949,7 +949,7 @@ void Ekf::controlDragFusion()
 
 		dragSample drag_sample;
 
-		if (_drag_buffer->pop_first_older_than(_imu_sample_delayed.time_us, &drag_sample)) {
+		if (_drag_buffer.pop_first_older_than(_imu_sample_delayed.time_us, &drag_sample)) {
 			fuseDrag(drag_sample);
 		}
 	}
@@ -957,10 +957,10 @@ void Ekf::controlDragFusion()
 
 void Ekf::controlAuxVelFusion()
 {
-	if (_auxvel_buffer) {
+	if (_auxvel_buffer.valid()) {
 		auxVelSample auxvel_sample_delayed;
 
-		if (_auxvel_buffer->pop_first_older_than(_imu_sample_delayed.time_us, &auxvel_sample_delayed)) {
+		if (_auxvel_buffer.pop_first_older_than(_imu_sample_delayed.time_us, &auxvel_sample_delayed)) {
 
 			updateVelocityAidSrcStatus(auxvel_sample_delayed.time_us, auxvel_sample_delayed.vel, auxvel_sample_delayed.velVar, fmaxf(_params.auxvel_gate, 1.f), _aid_src_aux_vel);
 
@@ -143,10 +143,10 @@ bool Ekf::initialiseFilter()
 	}
 
 	// Sum the magnetometer measurements
-	if (_mag_buffer) {
+	if (_mag_buffer.valid()) {
 		magSample mag_sample;
 
-		if (_mag_buffer->pop_first_older_than(_imu_sample_delayed.time_us, &mag_sample)) {
+		if (_mag_buffer.pop_first_older_than(_imu_sample_delayed.time_us, &mag_sample)) {
 			if (mag_sample.time_us != 0) {
 				if (_mag_counter == 0) {
 					_mag_lpf.reset(mag_sample.mag);
@@ -161,7 +161,7 @@ bool Ekf::initialiseFilter()
 	}
 
 	// accumulate enough height measurements to be confident in the quality of the data
-	if (_baro_buffer && _baro_buffer->pop_first_older_than(_imu_sample_delayed.time_us, &_baro_sample_delayed)) {
+	if (_baro_buffer.valid() && _baro_buffer.pop_first_older_than(_imu_sample_delayed.time_us, &_baro_sample_delayed)) {
 		if (_baro_sample_delayed.time_us != 0) {
 			if (_baro_counter == 0) {
 				_baro_hgt_offset = _baro_sample_delayed.hgt;
@@ -44,19 +44,6 @@
 
 #include <mathlib/mathlib.h>
 
-EstimatorInterface::~EstimatorInterface()
-{
-	delete _gps_buffer;
-	delete _mag_buffer;
-	delete _baro_buffer;
-	delete _range_buffer;
-	delete _airspeed_buffer;
-	delete _flow_buffer;
-	delete _ext_vision_buffer;
-	delete _drag_buffer;
-	delete _auxvel_buffer;
-}
-
 // Accumulate imu data and store to buffer at desired rate
 void EstimatorInterface::setIMUData(const imuSample &imu_sample)
 {
@@ -100,15 +87,9 @@ void EstimatorInterface::setMagData(const magSample &mag_sample)
 	}
 
 	// Allocate the required buffer size if not previously done
-	if (_mag_buffer == nullptr) {
-		_mag_buffer = new RingBuffer<magSample>(_obs_buffer_length);
-
-		if (_mag_buffer == nullptr || !_mag_buffer->valid()) {
-			delete _mag_buffer;
-			_mag_buffer = nullptr;
-			printBufferAllocationFailed("mag");
-			return;
-		}
+	if (!_mag_buffer.valid() && !_mag_buffer.allocate(_obs_buffer_length)) {
+		printBufferAllocationFailed("mag");
+		return;
 	}
 
 	// limit data rate to prevent data being lost
@@ -123,7 +104,7 @@ void EstimatorInterface::setMagData(const magSample &mag_sample)
 
 		mag_sample_new.mag = mag_sample.mag;
 
-		_mag_buffer->push(mag_sample_new);
+		_mag_buffer.push(mag_sample_new);
 	} else {
 		ECL_ERR("mag data too fast %" PRIu64, mag_sample.time_us - _time_last_mag);
 	}
@@ -136,15 +117,9 @@ void EstimatorInterface::setGpsData(const gpsMessage &gps)
 	}
 
 	// Allocate the required buffer size if not previously done
-	if (_gps_buffer == nullptr) {
-		_gps_buffer = new RingBuffer<gpsSample>(_obs_buffer_length);
-
-		if (_gps_buffer == nullptr || !_gps_buffer->valid()) {
-			delete _gps_buffer;
-			_gps_buffer = nullptr;
-			printBufferAllocationFailed("GPS");
-			return;
-		}
+	if (!_gps_buffer.valid() && !_gps_buffer.allocate(_obs_buffer_length)) {
+		printBufferAllocationFailed("GPS");
+		return;
 	}
 
 	if ((gps.time_usec - _time_last_gps) > _min_obs_interval_us) {
@@ -182,7 +157,7 @@ void EstimatorInterface::setGpsData(const gpsMessage &gps)
 			gps_sample_new.pos(1) = 0.0f;
 		}
 
-		_gps_buffer->push(gps_sample_new);
+		_gps_buffer.push(gps_sample_new);
 	} else {
 		ECL_ERR("GPS data too fast %" PRIu64, gps.time_usec - _time_last_gps);
 	}
@@ -195,15 +170,9 @@ void EstimatorInterface::setBaroData(const baroSample &baro_sample)
 	}
 
 	// Allocate the required buffer size if not previously done
-	if (_baro_buffer == nullptr) {
-		_baro_buffer = new RingBuffer<baroSample>(_obs_buffer_length);
-
-		if (_baro_buffer == nullptr || !_baro_buffer->valid()) {
-			delete _baro_buffer;
-			_baro_buffer = nullptr;
-			printBufferAllocationFailed("baro");
-			return;
-		}
+	if (!_baro_buffer.valid() && !_baro_buffer.allocate(_obs_buffer_length)) {
+		printBufferAllocationFailed("baro");
+		return;
 	}
 
 	// limit data rate to prevent data being lost
@@ -217,7 +186,7 @@ void EstimatorInterface::setBaroData(const baroSample &baro_sample)
 		baro_sample_new.time_us -= static_cast<uint64_t>(_params.baro_delay_ms * 1000);
 		baro_sample_new.time_us -= static_cast<uint64_t>(_dt_ekf_avg * 5e5f); // seconds to microseconds divided by 2
 
-		_baro_buffer->push(baro_sample_new);
+		_baro_buffer.push(baro_sample_new);
 	} else {
 		ECL_ERR("baro data too fast %" PRIu64, baro_sample.time_us - _time_last_baro);
 	}
@@ -230,15 +199,9 @@ void EstimatorInterface::setAirspeedData(const airspeedSample &airspeed_sample)
 	}
 
 	// Allocate the required buffer size if not previously done
-	if (_airspeed_buffer == nullptr) {
-		_airspeed_buffer = new RingBuffer<airspeedSample>(_obs_buffer_length);
-
-		if (_airspeed_buffer == nullptr || !_airspeed_buffer->valid()) {
-			delete _airspeed_buffer;
-			_airspeed_buffer = nullptr;
-			printBufferAllocationFailed("airspeed");
-			return;
-		}
+	if (!_airspeed_buffer.valid() && !_airspeed_buffer.allocate(_obs_buffer_length)) {
+		printBufferAllocationFailed("airspeed");
+		return;
 	}
 
 	// limit data rate to prevent data being lost
@@ -250,7 +213,7 @@ void EstimatorInterface::setAirspeedData(const airspeedSample &airspeed_sample)
 		airspeed_sample_new.time_us -= static_cast<uint64_t>(_params.airspeed_delay_ms * 1000);
 		airspeed_sample_new.time_us -= static_cast<uint64_t>(_dt_ekf_avg * 5e5f); // seconds to microseconds divided by 2
 
-		_airspeed_buffer->push(airspeed_sample_new);
+		_airspeed_buffer.push(airspeed_sample_new);
 	}
 }
 
@@ -261,15 +224,9 @@ void EstimatorInterface::setRangeData(const rangeSample &range_sample)
 	}
 
 	// Allocate the required buffer size if not previously done
-	if (_range_buffer == nullptr) {
-		_range_buffer = new RingBuffer<rangeSample>(_obs_buffer_length);
-
-		if (_range_buffer == nullptr || !_range_buffer->valid()) {
-			delete _range_buffer;
-			_range_buffer = nullptr;
-			printBufferAllocationFailed("range");
-			return;
-		}
+	if (!_range_buffer.valid() && !_range_buffer.allocate(_obs_buffer_length)) {
+		printBufferAllocationFailed("range");
+		return;
 	}
 
 	// limit data rate to prevent data being lost
@@ -280,7 +237,7 @@ void EstimatorInterface::setRangeData(const rangeSample &range_sample)
 		range_sample_new.time_us -= static_cast<uint64_t>(_params.range_delay_ms * 1000);
 		range_sample_new.time_us -= static_cast<uint64_t>(_dt_ekf_avg * 5e5f); // seconds to microseconds divided by 2
 
-		_range_buffer->push(range_sample_new);
+		_range_buffer.push(range_sample_new);
 	}
 }
 
@@ -291,15 +248,9 @@ void EstimatorInterface::setOpticalFlowData(const flowSample &flow)
 	}
 
 	// Allocate the required buffer size if not previously done
-	if (_flow_buffer == nullptr) {
-		_flow_buffer = new RingBuffer<flowSample>(_imu_buffer_length);
-
-		if (_flow_buffer == nullptr || !_flow_buffer->valid()) {
-			delete _flow_buffer;
-			_flow_buffer = nullptr;
-			printBufferAllocationFailed("flow");
-			return;
-		}
+	if (!_flow_buffer.valid() && !_flow_buffer.allocate(_imu_buffer_length)) {
+		printBufferAllocationFailed("flow");
+		return;
 	}
 
 	// limit data rate to prevent data being lost
@@ -311,7 +262,7 @@ void EstimatorInterface::setOpticalFlowData(const flowSample &flow)
 		optflow_sample_new.time_us -= static_cast<uint64_t>(_params.flow_delay_ms * 1000);
 		optflow_sample_new.time_us -= static_cast<uint64_t>(_dt_ekf_avg * 5e5f); // seconds to microseconds divided by 2
 
-		_flow_buffer->push(optflow_sample_new);
+		_flow_buffer.push(optflow_sample_new);
 	}
 }
 
@@ -323,15 +274,9 @@ void EstimatorInterface::setExtVisionData(const extVisionSample &evdata)
 	}
 
 	// Allocate the required buffer size if not previously done
-	if (_ext_vision_buffer == nullptr) {
-		_ext_vision_buffer = new RingBuffer<extVisionSample>(_obs_buffer_length);
-
-		if (_ext_vision_buffer == nullptr || !_ext_vision_buffer->valid()) {
-			delete _ext_vision_buffer;
-			_ext_vision_buffer = nullptr;
-			printBufferAllocationFailed("vision");
-			return;
-		}
+	if (!_ext_vision_buffer.valid() && !_ext_vision_buffer.allocate(_obs_buffer_length)) {
+		printBufferAllocationFailed("vision");
+		return;
 	}
 
 	// limit data rate to prevent data being lost
@@ -343,7 +288,7 @@ void EstimatorInterface::setExtVisionData(const extVisionSample &evdata)
 		ev_sample_new.time_us -= static_cast<uint64_t>(_params.ev_delay_ms * 1000);
 		ev_sample_new.time_us -= static_cast<uint64_t>(_dt_ekf_avg * 5e5f); // seconds to microseconds divided by 2
 
-		_ext_vision_buffer->push(ev_sample_new);
+		_ext_vision_buffer.push(ev_sample_new);
 
 	} else {
 		ECL_ERR("EV data too fast %" PRIu64, evdata.time_us - _time_last_ext_vision);
@@ -357,15 +302,9 @@ void EstimatorInterface::setAuxVelData(const auxVelSample &auxvel_sample)
 	}
 
 	// Allocate the required buffer size if not previously done
-	if (_auxvel_buffer == nullptr) {
-		_auxvel_buffer = new RingBuffer<auxVelSample>(_obs_buffer_length);
-
-		if (_auxvel_buffer == nullptr || !_auxvel_buffer->valid()) {
-			delete _auxvel_buffer;
-			_auxvel_buffer = nullptr;
-			printBufferAllocationFailed("aux vel");
-			return;
-		}
+	if (!_auxvel_buffer.valid() && !_auxvel_buffer.allocate(_obs_buffer_length)) {
+		printBufferAllocationFailed("aux vel");
+		return;
 	}
 
 	// limit data rate to prevent data being lost
@@ -377,7 +316,7 @@ void EstimatorInterface::setAuxVelData(const auxVelSample &auxvel_sample)
 		auxvel_sample_new.time_us -= static_cast<uint64_t>(_params.auxvel_delay_ms * 1000);
 		auxvel_sample_new.time_us -= static_cast<uint64_t>(_dt_ekf_avg * 5e5f); // seconds to microseconds divided by 2
 
-		_auxvel_buffer->push(auxvel_sample_new);
+		_auxvel_buffer.push(auxvel_sample_new);
 	}
 }
 
@@ -388,15 +327,9 @@ void EstimatorInterface::setDragData(const imuSample &imu)
 	if ((_params.fusion_mode & SensorFusionMask::USE_DRAG)) {
 
 		// Allocate the required buffer size if not previously done
-		if (_drag_buffer == nullptr) {
-			_drag_buffer = new RingBuffer<dragSample>(_obs_buffer_length);
-
-			if (_drag_buffer == nullptr || !_drag_buffer->valid()) {
-				delete _drag_buffer;
-				_drag_buffer = nullptr;
-				printBufferAllocationFailed("drag");
-				return;
-			}
+		if (!_drag_buffer.valid() && !_drag_buffer.allocate(_obs_buffer_length)) {
+			printBufferAllocationFailed("drag");
+			return;
 		}
 
 		_drag_sample_count ++;
@@ -421,7 +354,7 @@ void EstimatorInterface::setDragData(const imuSample &imu)
 			_drag_down_sampled.time_us /= _drag_sample_count;
 
 			// write to buffer
-			_drag_buffer->push(_drag_down_sampled);
+			_drag_buffer.push(_drag_down_sampled);
 
 			// reset accumulators
 			_drag_sample_count = 0;
@@ -547,36 +480,36 @@ void EstimatorInterface::print_status()
 
 	printf("minimum observation interval %d us\n", _min_obs_interval_us);
 
-	if (_gps_buffer) {
-		printf("gps buffer: %d/%d (%d Bytes)\n", _gps_buffer->entries(), _gps_buffer->get_length(), _gps_buffer->get_total_size());
+	if (_gps_buffer.valid()) {
+		printf("gps buffer: %d/%d (%d Bytes)\n", _gps_buffer.entries(), _gps_buffer.get_length(), _gps_buffer.get_total_size());
 	}
 
-	if (_mag_buffer) {
-		printf("mag buffer: %d/%d (%d Bytes)\n", _mag_buffer->entries(), _mag_buffer->get_length(), _mag_buffer->get_total_size());
+	if (_mag_buffer.valid()) {
+		printf("mag buffer: %d/%d (%d Bytes)\n", _mag_buffer.entries(), _mag_buffer.get_length(), _mag_buffer.get_total_size());
 	}
 
-	if (_baro_buffer) {
-		printf("baro buffer: %d/%d (%d Bytes)\n", _baro_buffer->entries(), _baro_buffer->get_length(), _baro_buffer->get_total_size());
+	if (_baro_buffer.valid()) {
+		printf("baro buffer: %d/%d (%d Bytes)\n", _baro_buffer.entries(), _baro_buffer.get_length(), _baro_buffer.get_total_size());
 	}
 
-	if (_range_buffer) {
-		printf("range buffer: %d/%d (%d Bytes)\n", _range_buffer->entries(), _range_buffer->get_length(), _range_buffer->get_total_size());
+	if (_range_buffer.valid()) {
+		printf("range buffer: %d/%d (%d Bytes)\n", _range_buffer.entries(), _range_buffer.get_length(), _range_buffer.get_total_size());
 	}
 
-	if (_airspeed_buffer) {
-		printf("airspeed buffer: %d/%d (%d Bytes)\n", _airspeed_buffer->entries(), _airspeed_buffer->get_length(), _airspeed_buffer->get_total_size());
+	if (_airspeed_buffer.valid()) {
+		printf("airspeed buffer: %d/%d (%d Bytes)\n", _airspeed_buffer.entries(), _airspeed_buffer.get_length(), _airspeed_buffer.get_total_size());
 	}
 
-	if (_flow_buffer) {
-		printf("flow buffer: %d/%d (%d Bytes)\n", _flow_buffer->entries(), _flow_buffer->get_length(), _flow_buffer->get_total_size());
+	if (_flow_buffer.valid()) {
+		printf("flow buffer: %d/%d (%d Bytes)\n", _flow_buffer.entries(), _flow_buffer.get_length(), _flow_buffer.get_total_size());
 	}
 
-	if (_ext_vision_buffer) {
-		printf("vision buffer: %d/%d (%d Bytes)\n", _ext_vision_buffer->entries(), _ext_vision_buffer->get_length(), _ext_vision_buffer->get_total_size());
+	if (_ext_vision_buffer.valid()) {
+		printf("vision buffer: %d/%d (%d Bytes)\n", _ext_vision_buffer.entries(), _ext_vision_buffer.get_length(), _ext_vision_buffer.get_total_size());
 	}
 
-	if (_drag_buffer) {
-		printf("drag buffer: %d/%d (%d Bytes)\n", _drag_buffer->entries(), _drag_buffer->get_length(), _drag_buffer->get_total_size());
+	if (_drag_buffer.valid()) {
+		printf("drag buffer: %d/%d (%d Bytes)\n", _drag_buffer.entries(), _drag_buffer.get_length(), _drag_buffer.get_total_size());
 	}
 
 	printf("output buffer: %d/%d (%d Bytes)\n", _output_buffer.entries(), _output_buffer.get_length(), _output_buffer.get_total_size());
@@ -260,7 +260,7 @@ public:
 protected:
 
 	EstimatorInterface() = default;
-	virtual ~EstimatorInterface();
+	virtual ~EstimatorInterface() = default;
 
 	virtual bool init(uint64_t timestamp) = 0;
 
@@ -350,15 +350,16 @@ protected:
 	RingBuffer<outputSample> _output_buffer{12};
 	RingBuffer<outputVert> _output_vert_buffer{12};
 
-	RingBuffer<gpsSample> *_gps_buffer{nullptr};
-	RingBuffer<magSample> *_mag_buffer{nullptr};
-	RingBuffer<baroSample> *_baro_buffer{nullptr};
-	RingBuffer<rangeSample> *_range_buffer{nullptr};
-	RingBuffer<airspeedSample> *_airspeed_buffer{nullptr};
-	RingBuffer<flowSample> 	*_flow_buffer{nullptr};
-	RingBuffer<extVisionSample> *_ext_vision_buffer{nullptr};
-	RingBuffer<dragSample> *_drag_buffer{nullptr};
-	RingBuffer<auxVelSample> *_auxvel_buffer{nullptr};
+	// observation buffers, allocated when the first sample arrives
+	RingBuffer<gpsSample> _gps_buffer{};
+	RingBuffer<magSample> _mag_buffer{};
+	RingBuffer<baroSample> _baro_buffer{};
+	RingBuffer<rangeSample> _range_buffer{};
+	RingBuffer<airspeedSample> _airspeed_buffer{};
+	RingBuffer<flowSample> _flow_buffer{};
+	RingBuffer<extVisionSample> _ext_vision_buffer{};
+	RingBuffer<dragSample> _drag_buffer{};
+	RingBuffer<auxVelSample> _auxvel_buffer{};
 
 	// timestamps of latest in buffer saved measurement in microseconds
 	uint64_t _time_last_imu{0};
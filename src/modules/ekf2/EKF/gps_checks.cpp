@@ -90,9 +90,10 @@ bool Ekf::collect_gps(const gpsMessage &gps)
 		const bool declination_was_valid = PX4_ISFINITE(_mag_declination_gps);
 
 		// set the magnetic field data returned by the geo library using the current GPS position
-		_mag_declination_gps = get_mag_declination_radians(lat, lon);
-		_mag_inclination_gps = get_mag_inclination_radians(lat, lon);
-		_mag_strength_gps = get_mag_strength_gauss(lat, lon);
+		const MagField mag_field = get_mag_field(lat, lon);
+		_mag_declination_gps = mag_field.declination;
+		_mag_inclination_gps = mag_field.inclination;
+		_mag_strength_gps = mag_field.strength;
 
 		// request a reset of the yaw using the new declination
 		if (!declination_was_valid && PX4_ISFINITE(_mag_declination_gps)
@@ -119,9 +120,10 @@ bool Ekf::collect_gps(const gpsMessage &gps)
 			const double lon = gps.lon * 1.0e-7;
 
 			// set the magnetic field data returned by the geo library using the current GPS position
-			_mag_declination_gps = get_mag_declination_radians(lat, lon);
-			_mag_inclination_gps = get_mag_inclination_radians(lat, lon);
-			_mag_strength_gps = get_mag_strength_gauss(lat, lon);
+			const MagField mag_field = get_mag_field(lat, lon);
+			_mag_declination_gps = mag_field.declination;
+			_mag_inclination_gps = mag_field.inclination;
+			_mag_strength_gps = mag_field.strength;
 
 			// request a reset of the yaw using the new declination
 			if (!declination_was_valid && PX4_ISFINITE(_mag_declination_gps)
@@ -7,6 +7,19 @@ ImuDownSampler::ImuDownSampler(int32_t &target_dt_us) : _target_dt_us(target_dt_
 	reset();
 }
 
+ImuDownSampler &ImuDownSampler::operator=(const ImuDownSampler &other)
+{
+	_imu_down_sampled = other._imu_down_sampled;
+	_delta_angle_accumulated = other._delta_angle_accumulated;
+	_accumulated_samples = other._accumulated_samples;
+	_required_samples = other._required_samples;
+	_target_dt_s = other._target_dt_s;
+	_min_dt_s = other._min_dt_s;
+	_delta_ang_dt_avg = other._delta_ang_dt_avg;
+
+	return *this;
+}
+
 // integrate imu samples until target dt reached
 // assumes that dt of the gyroscope is close to the dt of the accelerometer
 // returns true if target dt is reached
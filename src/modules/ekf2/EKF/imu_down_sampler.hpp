@@ -51,6 +51,10 @@ public:
 	explicit ImuDownSampler(int32_t &target_dt_us);
 	~ImuDownSampler() = default;
 
+	// the target interval is a reference into the parameters of the owner, it is kept on assignment
+	ImuDownSampler(const ImuDownSampler &) = delete;
+	ImuDownSampler &operator=(const ImuDownSampler &other);
+
 	bool update(const imuSample &imu_sample_new);
 
 	imuSample getDownSampledImuAndTriggerReset()
@@ -45,8 +45,8 @@ void Ekf::controlMagFusion()
 
 	magSample mag_sample;
 
-	if (_mag_buffer) {
-		mag_data_ready = _mag_buffer->pop_first_older_than(_imu_sample_delayed.time_us, &mag_sample);
+	if (_mag_buffer.valid()) {
+		mag_data_ready = _mag_buffer.pop_first_older_than(_imu_sample_delayed.time_us, &mag_sample);
 
 		if (mag_data_ready) {
 			_mag_lpf.update(mag_sample.mag);
@@ -43,6 +43,7 @@ pthread_mutex_t ekf2_module_mutex = PTHREAD_MUTEX_INITIALIZER;
 static px4::atomic<EKF2 *> _objects[EKF2_MAX_INSTANCES] {};
 #if !defined(CONSTRAINED_FLASH)
 static px4::atomic<EKF2Selector *> _ekf2_selector {nullptr};
+static px4::atomic<ImuDeltaCache *> _imu_delta_cache {nullptr};
 #endif // !CONSTRAINED_FLASH
 
 EKF2::EKF2(bool multi_mode, const px4::wq_config_t &config, bool replay_mode):
@@ -182,6 +183,8 @@ EKF2::EKF2(bool multi_mode, const px4::wq_config_t &config, bool replay_mode):
 
 EKF2::~EKF2()
 {
+	_checkpoints.clear();
+
 	perf_free(_ecl_ekf_update_perf);
 	perf_free(_ecl_ekf_update_full_perf);
 	perf_free(_msg_missed_imu_perf);
@@ -240,6 +243,72 @@ bool EKF2::multi_init(int imu, int mag)
 	return false;
 }
 
+void EKF2::SaveCheckpoint(const hrt_abstime &timestamp)
+{
+	EkfCheckpoint *checkpoint = nullptr;
+
+	for (EkfCheckpoint *c : _checkpoints) {
+		if (c->timestamp == timestamp) {
+			checkpoint = c;
+			break;
+		}
+	}
+
+	if (checkpoint == nullptr) {
+		checkpoint = new EkfCheckpoint();
+
+		if (checkpoint == nullptr) {
+			PX4_ERR("%d - checkpoint alloc failed", _instance);
+			return;
+		}
+
+		checkpoint->timestamp = timestamp;
+		_checkpoints.add(checkpoint);
+	}
+
+	checkpoint->ekf = _ekf;
+}
+
+bool EKF2::RestoreCheckpoint(const hrt_abstime &timestamp)
+{
+	for (EkfCheckpoint *checkpoint : _checkpoints) {
+		if (checkpoint->timestamp == timestamp) {
+			const parameters params{*_params};
+			_ekf = checkpoint->ekf;
+			*_params = params;
+
+			// time goes backwards, restart the time slip monitoring and the rate limited publications
+			_start_time_us = 0;
+			_integrated_time_us = 0;
+			_last_time_slip_us = 0;
+			_gps_alttitude_ellipsoid_previous_timestamp = 0;
+			_last_sensor_bias_published = 0;
+			_last_gps_status_published = 0;
+			_last_event_flags_publish = 0;
+			_last_status_flags_publish = 0;
+			_status_airspeed_pub_last = 0;
+			_status_baro_hgt_pub_last = 0;
+			_status_rng_hgt_pub_last = 0;
+			_status_fake_pos_pub_last = 0;
+			_status_ev_yaw_pub_last = 0;
+			_status_ev_vel_pub_last = 0;
+			_status_ev_pos_pub_last = 0;
+			_status_gnss_yaw_pub_last = 0;
+			_status_gnss_vel_pub_last = 0;
+			_status_gnss_pos_pub_last = 0;
+			_status_mag_pub_last = 0;
+			_status_mag_heading_pub_last = 0;
+			_status_aux_vel_pub_last = 0;
+
+			PX4_INFO("%d - restored checkpoint at %" PRIu64, _instance, timestamp);
+			return true;
+		}
+	}
+
+	PX4_ERR("%d - no checkpoint at %" PRIu64, _instance, timestamp);
+	return false;
+}
+
 int EKF2::print_status()
 {
 	PX4_INFO_RAW("ekf2:%d EKF dt: %.4fs, IMU dt: %.4fs, attitude: %d, local position: %d, global position: %d\n",
@@ -258,6 +327,10 @@ int EKF2::print_status()
 	perf_print_counter(_msg_missed_odometry_perf);
 	perf_print_counter(_msg_missed_optical_flow_perf);
 
+	if (!_checkpoints.empty()) {
+		PX4_INFO_RAW("replay checkpoints: %zu (%zu bytes each)\n", _checkpoints.size(), sizeof(EkfCheckpoint));
+	}
+
 #if defined(DEBUG_BUILD)
 	_ekf.print_status();
 #endif // DEBUG_BUILD
@@ -359,6 +432,17 @@ void EKF2::Run()
 					PX4_ERR("%d - Failed to set new NED origin (LLA): %3.10f, %3.10f, %4.3f\n",
 						_instance, latitude, longitude, static_cast<double>(altitude));
 				}
+
+			} else if (_replay_mode && (vehicle_command.command == vehicle_command_s::VEHICLE_CMD_ESTIMATOR_CHECKPOINT)) {
+				// the checkpoint is taken before the IMU sample at this timestamp is processed
+				const hrt_abstime timestamp = static_cast<hrt_abstime>(vehicle_command.param5);
+
+				if (static_cast<int>(vehicle_command.param1) == 1) {
+					RestoreCheckpoint(timestamp);
+
+				} else {
+					SaveCheckpoint(timestamp);
+				}
 			}
 		}
 	}
@@ -369,11 +453,24 @@ void EKF2::Run()
 	hrt_abstime imu_dt = 0; // for tracking time slip later
 
 	if (_multi_mode) {
-		const unsigned last_generation = _vehicle_imu_sub.get_last_generation();
+		const unsigned last_generation = _imu_generation;
 		vehicle_imu_s imu;
-		imu_updated = _vehicle_imu_sub.update(&imu);
 
-		if (imu_updated && (_vehicle_imu_sub.get_last_generation() != last_generation + 1)) {
+#if !defined(CONSTRAINED_FLASH)
+		ImuDeltaCache *imu_delta_cache = _imu_delta_cache.load();
+
+		if (imu_delta_cache) {
+			// shared with the other instances using this IMU
+			imu_updated = imu_delta_cache->update(_vehicle_imu_sub.get_instance(), _imu_generation, imu);
+
+		} else
+#endif // !CONSTRAINED_FLASH
+		{
+			imu_updated = _vehicle_imu_sub.update(&imu);
+			_imu_generation = _vehicle_imu_sub.get_last_generation();
+		}
+
+		if (imu_updated && (_imu_generation != last_generation + 1)) {
 			perf_count(_msg_missed_imu_perf);
 		}
 
@@ -2072,6 +2169,43 @@ int EKF2::custom_command(int argc, char *argv[])
 	return print_usage("unknown command");
 }
 
+#if !defined(CONSTRAINED_FLASH)
+// pin a Multi-EKF work queue to the n-th CPU of the mask (wrapping around)
+static void SetWorkQueueCpuAffinity(const px4::wq_config_t &wq_config, uint8_t wq_index, uint32_t cpu_mask)
+{
+	static constexpr int MASK_BITS = sizeof(cpu_mask) * 8;
+	int num_cpus = 0;
+
+	for (int cpu = 0; cpu < MASK_BITS; cpu++) {
+		if (cpu_mask & (1u << cpu)) {
+			num_cpus++;
+		}
+	}
+
+	if (num_cpus == 0) {
+		return;
+	}
+
+	int n = wq_index % num_cpus;
+
+	for (int cpu = 0; cpu < MASK_BITS; cpu++) {
+		if (cpu_mask & (1u << cpu)) {
+			if (n == 0) {
+				px4::WorkQueue *wq = px4::WorkQueueFindOrCreate(wq_config);
+
+				if ((wq == nullptr) || !wq->SetCpuAffinity(cpu)) {
+					PX4_WARN("%s: CPU affinity not supported", wq_config.name);
+				}
+
+				return;
+			}
+
+			n--;
+		}
+	}
+}
+#endif // !CONSTRAINED_FLASH
+
 int EKF2::task_spawn(int argc, char *argv[])
 {
 	bool success = false;
@@ -2136,6 +2270,21 @@ int EKF2::task_spawn(int argc, char *argv[])
 	}
 
 	if (multi_mode) {
+		int32_t cpu_mask = 0;
+		param_get(param_find("EKF2_MULTI_CPU"), &cpu_mask);
+
+		// Allocate the shared IMU cache before any instance starts
+		if (_imu_delta_cache.load() == nullptr) {
+			ImuDeltaCache *imu_delta_cache = new ImuDeltaCache();
+
+			if (imu_delta_cache) {
+				_imu_delta_cache.store(imu_delta_cache);
+
+			} else {
+				PX4_ERR("Failed to create IMU cache");
+			}
+		}
+
 		// Start EKF2Selector if it's not already running
 		if (_ekf2_selector.load() == nullptr) {
 			EKF2Selector *inst = new EKF2Selector();
@@ -2177,7 +2326,20 @@ int EKF2::task_spawn(int argc, char *argv[])
 					if ((vehicle_mag_sub.advertised() || mag == 0) && (vehicle_imu_sub.advertised())) {
 
 						if (!ekf2_instance_created[imu][mag]) {
-							EKF2 *ekf2_inst = new EKF2(true, px4::ins_instance_to_wq(imu), false);
+#if defined(__PX4_POSIX)
+							// one work queue (thread) per instance so that the instances run in parallel
+							const uint8_t wq_index = multi_instances_allocated % MAX_NUM_INS_WQ;
+#else
+							// instances using the same IMU share a work queue
+							const uint8_t wq_index = imu;
+#endif // __PX4_POSIX
+							const px4::wq_config_t &wq_config = px4::ins_instance_to_wq(wq_index);
+
+							if (cpu_mask != 0) {
+								SetWorkQueueCpuAffinity(wq_config, wq_index, (uint32_t)cpu_mask);
+							}
+
+							EKF2 *ekf2_inst = new EKF2(true, wq_config, false);
 
 							if (ekf2_inst && ekf2_inst->multi_init(imu, mag)) {
 								int actual_instance = ekf2_inst->instance(); // match uORB instance numbering
@@ -2380,6 +2542,13 @@ extern "C" __EXPORT int ekf2_main(int argc, char *argv[])
 				}
 			}
 
+#if !defined(CONSTRAINED_FLASH)
+			// all instances stopped
+			ImuDeltaCache *imu_delta_cache = _imu_delta_cache.load();
+			_imu_delta_cache.store(nullptr);
+			delete imu_delta_cache;
+#endif // !CONSTRAINED_FLASH
+
 			if (!was_running) {
 				PX4_WARN("not running");
 			}
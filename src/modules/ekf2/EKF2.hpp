@@ -42,12 +42,14 @@
 #define EKF2_HPP
 
 #include "EKF/ekf.h"
+#include "Utility/ImuDeltaCache.hpp"
 #include "Utility/PreFlightChecker.hpp"
 
 #include "EKF2Selector.hpp"
 
 #include <float.h>
 
+#include <containers/List.hpp>
 #include <containers/LockGuard.hpp>
 #include <drivers/drv_hrt.h>
 #include <lib/mathlib/mathlib.h>
@@ -132,9 +134,17 @@ private:
 
 	static constexpr uint8_t MAX_NUM_IMUS = 4;
 	static constexpr uint8_t MAX_NUM_MAGS = 4;
+	static constexpr uint8_t MAX_NUM_INS_WQ = 6; // INS0 - INS5
 
 	void Run() override;
 
+	/*
+	 * Replay checkpoints of the complete estimator state, requested by the replay module to seek in the log.
+	 * The current parameters are kept when restoring a checkpoint.
+	 */
+	void SaveCheckpoint(const hrt_abstime &timestamp);
+	bool RestoreCheckpoint(const hrt_abstime &timestamp);
+
 	void PublishAidSourceStatus(const hrt_abstime &timestamp);
 	void PublishAttitude(const hrt_abstime &timestamp);
 	void PublishBaroBias(const hrt_abstime &timestamp);
@@ -234,6 +244,8 @@ private:
 	uint64_t _gps_alttitude_ellipsoid_previous_timestamp{0}; ///< storage for previous timestamp to compute dt
 	float   _wgs84_hgt_offset = 0;  ///< height offset between AMSL and WGS84
 
+	unsigned _imu_generation{0}; ///< uORB generation of the last vehicle_imu sample (multi mode)
+
 	uint8_t _accel_calibration_count{0};
 	uint8_t _baro_calibration_count{0};
 	uint8_t _gyro_calibration_count{0};
@@ -363,6 +375,13 @@ private:
 
 	parameters *_params;	///< pointer to ekf parameter struct (located in _ekf class instance)
 
+	struct EkfCheckpoint : public ListNode<EkfCheckpoint *> {
+		hrt_abstime timestamp{0};
+		Ekf ekf{};
+	};
+
+	List<EkfCheckpoint *> _checkpoints;	///< replay mode only
+
 	DEFINE_PARAMETERS(
 		(ParamExtInt<px4::params::EKF2_PREDICT_US>) _param_ekf2_predict_us,
 		(ParamExtFloat<px4::params::EKF2_MAG_DELAY>)
@@ -0,0 +1,114 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file ImuDeltaCache.hpp
+ *
+ * Shared cache of the latest vehicle_imu sample per IMU for the Multi-EKF instances.
+ *
+ * With several EKF instances per IMU (multi-mag) running in parallel, every instance
+ * copying the same vehicle_imu message contends on the uORB node lock with the publisher
+ * and each other. The cache copies each message from uORB once, the other instances
+ * read it from the cache.
+ */
+
+#pragma once
+
+#include <pthread.h>
+
+#include <containers/LockGuard.hpp>
+#include <uORB/Subscription.hpp>
+#include <uORB/topics/vehicle_imu.h>
+
+class ImuDeltaCache final
+{
+public:
+	static constexpr uint8_t MAX_NUM_IMUS = 4;
+
+	ImuDeltaCache()
+	{
+		for (auto &lock : _lock) {
+			pthread_mutex_init(&lock, nullptr);
+		}
+	}
+
+	~ImuDeltaCache()
+	{
+		for (auto &lock : _lock) {
+			pthread_mutex_destroy(&lock);
+		}
+	}
+
+	/**
+	 * Get the latest sample of an IMU if it's newer than the last one seen by the caller.
+	 *
+	 * @param instance vehicle_imu instance
+	 * @param generation uORB generation of the last sample seen by the caller, updated on success
+	 * @param imu latest sample
+	 * @return true if there was a new sample
+	 */
+	bool update(uint8_t instance, unsigned &generation, vehicle_imu_s &imu)
+	{
+		if (instance >= MAX_NUM_IMUS) {
+			return false;
+		}
+
+		LockGuard lg{_lock[instance]};
+
+		// only the first instance after a new publication copies from uORB
+		if (_subscription[instance].updated()) {
+			_subscription[instance].update(&_imu[instance]);
+		}
+
+		const unsigned latest_generation = _subscription[instance].get_last_generation();
+
+		if ((_imu[instance].timestamp != 0) && (latest_generation != generation)) {
+			imu = _imu[instance];
+			generation = latest_generation;
+			return true;
+		}
+
+		return false;
+	}
+
+private:
+	uORB::Subscription _subscription[MAX_NUM_IMUS] {
+		{ORB_ID(vehicle_imu), 0},
+		{ORB_ID(vehicle_imu), 1},
+		{ORB_ID(vehicle_imu), 2},
+		{ORB_ID(vehicle_imu), 3},
+	};
+
+	vehicle_imu_s _imu[MAX_NUM_IMUS] {};
+	pthread_mutex_t _lock[MAX_NUM_IMUS] {};
+};
@@ -56,3 +56,26 @@ PARAM_DEFINE_INT32(EKF2_MULTI_IMU, 0);
  * @max 4
  */
 PARAM_DEFINE_INT32(EKF2_MULTI_MAG, 0);
+
+/**
+ * Multi-EKF CPU affinity.
+ *
+ * Bitmask of the CPUs the Multi-EKF instances are distributed over (Linux only).
+ * Each instance runs on its own work queue, the n-th queue is pinned to the
+ * n-th CPU set in the mask (wrapping around). Set 0 to leave the placement to
+ * the OS scheduler.
+ *
+ * @group EKF2
+ * @reboot_required true
+ * @min 0
+ * @max 255
+ * @bit 0 CPU 0
+ * @bit 1 CPU 1
+ * @bit 2 CPU 2
+ * @bit 3 CPU 3
+ * @bit 4 CPU 4
+ * @bit 5 CPU 5
+ * @bit 6 CPU 6
+ * @bit 7 CPU 7
+ */
+PARAM_DEFINE_INT32(EKF2_MULTI_CPU, 0);
@@ -0,0 +1,142 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 ECL Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * Test restoring the complete filter from a copy of the Ekf (checkpoint),
+ * as done by the ekf2 module to seek in a replayed log.
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+
+#include "EKF/ekf.h"
+#include "sensor_simulator/sensor_simulator.h"
+#include "sensor_simulator/ekf_wrapper.h"
+
+class EkfCheckpointTest : public ::testing::Test
+{
+public:
+	EkfCheckpointTest(): ::testing::Test(),
+		_ekf{std::make_shared<Ekf>()},
+		_sensor_simulator(_ekf),
+		_ekf_wrapper(_ekf),
+		_ekf_restored{std::make_shared<Ekf>()},
+		_sensor_simulator_restored(_ekf_restored),
+		_ekf_wrapper_restored(_ekf_restored) {};
+
+	void SetUp() override
+	{
+		// both filters are fed with the same data, only the first one fuses GPS
+		_sensor_simulator.loadSensorDataFromFile(TEST_DATA_PATH"/replay_data/iris_gps.csv");
+		_sensor_simulator_restored.loadSensorDataFromFile(TEST_DATA_PATH"/replay_data/iris_gps.csv");
+		_sensor_simulator.startGps();
+		_sensor_simulator_restored.startGps();
+		_ekf_wrapper.enableGpsFusion();
+		_ekf_wrapper_restored.disableGpsFusion();
+	}
+
+	std::shared_ptr<Ekf> _ekf;
+	SensorSimulator _sensor_simulator;
+	EkfWrapper _ekf_wrapper;
+
+	std::shared_ptr<Ekf> _ekf_restored;
+	SensorSimulator _sensor_simulator_restored;
+	EkfWrapper _ekf_wrapper_restored;
+};
+
+TEST_F(EkfCheckpointTest, restoreCheckpoint)
+{
+	// GIVEN: a checkpoint of the filter taken while fusing GPS
+	_sensor_simulator.runReplaySeconds(20.f);
+	Ekf checkpoint;
+	checkpoint = *_ekf;
+	EXPECT_TRUE(checkpoint.control_status_flags().gps);
+
+	// AND: a second filter, which did not fuse GPS, restored from the checkpoint at the same time of the log
+	_sensor_simulator_restored.runReplaySeconds(20.f);
+	EXPECT_FALSE(_ekf_restored->control_status_flags().gps);
+	*_ekf_restored = checkpoint;
+
+	// WHEN: both filters continue with the same data
+	_sensor_simulator.runReplaySeconds(10.f);
+	_sensor_simulator_restored.runReplaySeconds(10.f);
+
+	// THEN: the restored filter should produce the exact same estimate
+	EXPECT_TRUE(_ekf_restored->control_status_flags().gps);
+	EXPECT_EQ(_ekf->control_status().value, _ekf_restored->control_status().value);
+
+	const matrix::Vector<float, 24> state = _ekf->getStateAtFusionHorizonAsVector();
+	const matrix::Vector<float, 24> state_restored = _ekf_restored->getStateAtFusionHorizonAsVector();
+	const matrix::SquareMatrix<float, 24> &P = _ekf->covariances();
+	const matrix::SquareMatrix<float, 24> &P_restored = _ekf_restored->covariances();
+
+	for (int i = 0; i < 24; i++) {
+		EXPECT_EQ(state(i), state_restored(i)) << "state " << i;
+
+		for (int j = 0; j < 24; j++) {
+			EXPECT_EQ(P(i, j), P_restored(i, j)) << "covariance " << i << ", " << j;
+		}
+	}
+
+	const Vector3f pos = _ekf->getPosition();
+	const Vector3f pos_restored = _ekf_restored->getPosition();
+	EXPECT_EQ(pos(0), pos_restored(0));
+	EXPECT_EQ(pos(1), pos_restored(1));
+	EXPECT_EQ(pos(2), pos_restored(2));
+
+	// AND: the checkpoint should not be affected by the restored filter
+	EXPECT_LT(checkpoint.get_imu_sample_delayed().time_us, _ekf_restored->get_imu_sample_delayed().time_us);
+}
+
+// not part of the unit tests, run with --gtest_also_run_disabled_tests
+TEST_F(EkfCheckpointTest, DISABLED_Benchmark)
+{
+	_sensor_simulator.runReplaySeconds(20.f);
+
+	static constexpr int NUM_CHECKPOINTS = 1000;
+	Ekf checkpoint;
+
+	const auto start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < NUM_CHECKPOINTS; i++) {
+		checkpoint = *_ekf;
+	}
+
+	const double duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	printf("checkpoint: %zu bytes (+ buffers), %.2f us per copy\n", sizeof(Ekf), duration * 1e6 / NUM_CHECKPOINTS);
+}
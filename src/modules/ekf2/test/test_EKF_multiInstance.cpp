@@ -0,0 +1,190 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * Benchmark of parallel Multi-EKF execution: wall time per IMU epoch for
+ * 1 - 6 instances running sequentially (shared work queue) and in parallel
+ * (one thread per instance, as with a work queue per instance on POSIX).
+ * Only the estimator core is covered: the instances run on plain threads,
+ * not on the EKF2 module work queues.
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "EKF/ekf.h"
+#include "sensor_simulator/sensor_simulator.h"
+
+static constexpr int MAX_INSTANCES = 6;
+static constexpr uint32_t IMU_INTERVAL_US = 5000; // 200 Hz sensor simulator IMU
+static constexpr int NUM_EPOCHS = 2000;
+
+// all instances are triggered by the same IMU publication, the next epoch starts when all are done
+class EpochBarrier
+{
+public:
+	explicit EpochBarrier(int count) : _count(count) {}
+
+	void wait()
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		const int generation = _generation;
+
+		if (++_waiting == _count) {
+			_waiting = 0;
+			_generation++;
+			_cv.notify_all();
+
+		} else {
+			_cv.wait(lock, [&] { return _generation != generation; });
+		}
+	}
+
+private:
+	std::mutex _mutex;
+	std::condition_variable _cv;
+	const int _count;
+	int _waiting{0};
+	int _generation{0};
+};
+
+struct EkfInstance {
+	EkfInstance() :
+		ekf{std::make_shared<Ekf>()},
+		sensor_simulator(ekf)
+	{
+		ekf->init(0);
+		sensor_simulator.runSeconds(0.1);
+		ekf->set_in_air_status(false);
+		ekf->set_vehicle_at_rest(true);
+		sensor_simulator.startGps();
+		sensor_simulator.runSeconds(2);
+	}
+
+	std::shared_ptr<Ekf> ekf;
+	SensorSimulator sensor_simulator;
+};
+
+static double runSequential(std::vector<std::unique_ptr<EkfInstance>> &instances)
+{
+	const auto start = std::chrono::steady_clock::now();
+
+	for (int epoch = 0; epoch < NUM_EPOCHS; epoch++) {
+		for (auto &instance : instances) {
+			instance->sensor_simulator.runMicroseconds(IMU_INTERVAL_US);
+		}
+	}
+
+	const auto end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::micro>(end - start).count() / NUM_EPOCHS;
+}
+
+static double runParallel(std::vector<std::unique_ptr<EkfInstance>> &instances)
+{
+	EpochBarrier barrier(instances.size());
+	std::vector<std::thread> threads;
+
+	const auto start = std::chrono::steady_clock::now();
+
+	for (auto &instance : instances) {
+		EkfInstance *ekf_instance = instance.get();
+
+		threads.emplace_back([ekf_instance, &barrier]() {
+			for (int epoch = 0; epoch < NUM_EPOCHS; epoch++) {
+				ekf_instance->sensor_simulator.runMicroseconds(IMU_INTERVAL_US);
+				barrier.wait();
+			}
+		});
+	}
+
+	for (auto &thread : threads) {
+		thread.join();
+	}
+
+	const auto end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::micro>(end - start).count() / NUM_EPOCHS;
+}
+
+TEST(EkfMultiInstanceTest, parallelMatchesSequential)
+{
+	// GIVEN: identical instances, one of them run in parallel with others
+	std::vector<std::unique_ptr<EkfInstance>> sequential;
+	std::vector<std::unique_ptr<EkfInstance>> parallel;
+
+	for (int i = 0; i < 3; i++) {
+		sequential.emplace_back(new EkfInstance());
+		parallel.emplace_back(new EkfInstance());
+	}
+
+	runSequential(sequential);
+	runParallel(parallel);
+
+	// THEN: instances don't share state, the results are identical
+	for (int i = 0; i < 3; i++) {
+		const matrix::Vector<float, 24> state_sequential = sequential[i]->ekf->getStateAtFusionHorizonAsVector();
+		const matrix::Vector<float, 24> state_parallel = parallel[i]->ekf->getStateAtFusionHorizonAsVector();
+
+		for (int s = 0; s < 24; s++) {
+			EXPECT_EQ(state_sequential(s), state_parallel(s));
+		}
+	}
+}
+
+// not part of the unit tests, run with --gtest_also_run_disabled_tests
+TEST(EkfMultiInstanceTest, DISABLED_benchmark)
+{
+	printf("instances, sequential [us/epoch], parallel [us/epoch] (%u hardware threads)\n",
+	       std::thread::hardware_concurrency());
+
+	for (int num_instances = 1; num_instances <= MAX_INSTANCES; num_instances++) {
+		std::vector<std::unique_ptr<EkfInstance>> sequential;
+		std::vector<std::unique_ptr<EkfInstance>> parallel;
+
+		for (int i = 0; i < num_instances; i++) {
+			sequential.emplace_back(new EkfInstance());
+			parallel.emplace_back(new EkfInstance());
+		}
+
+		const double sequential_us = runSequential(sequential);
+		const double parallel_us = runParallel(parallel);
+
+		printf("%d, %.1f, %.1f\n", num_instances, sequential_us, parallel_us);
+	}
+}
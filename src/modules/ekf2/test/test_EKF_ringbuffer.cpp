@@ -158,3 +158,32 @@ TEST_F(EkfRingBufferTest, reallocateBuffer)
 	EXPECT_EQ(3, _buffer->get_length());
 
 }
+
+TEST_F(EkfRingBufferTest, copyBuffer)
+{
+	ASSERT_EQ(true, _buffer->allocate(3));
+	_buffer->push(_x);
+	_buffer->push(_y);
+
+	// GIVEN: a copy of an allocated and filled buffer
+	RingBuffer<sample> copy(5);
+	copy = *_buffer;
+	EXPECT_EQ(3, copy.get_length());
+
+	// WHEN: the original buffer is modified
+	_buffer->push(_z);
+	sample pop = {};
+	EXPECT_EQ(true, _buffer->pop_first_older_than(_y.time_us + 1, &pop));
+
+	// THEN: the copy should keep its own content
+	EXPECT_EQ(_x.time_us, copy.get_oldest().time_us);
+	EXPECT_EQ(_y.time_us, copy.get_newest().time_us);
+	EXPECT_EQ(2, copy.entries());
+
+	// WHEN: a buffer is copied from a buffer which is not allocated
+	RingBuffer<sample> empty;
+	copy = empty;
+
+	// THEN: the copy should not be allocated either
+	EXPECT_FALSE(copy.valid());
+}
@@ -57,6 +57,7 @@ GyroFFT::~GyroFFT()
 	perf_free(_cycle_perf);
 	perf_free(_cycle_interval_perf);
 	perf_free(_fft_perf);
+	perf_free(_sliding_dft_perf);
 	perf_free(_gyro_generation_gap_perf);
 	perf_free(_gyro_fifo_generation_gap_perf);
 
@@ -147,6 +148,19 @@ bool GyroFFT::init()
 			arm_float_to_q15(&hanning_value, &_hanning_window[n], 1);
 		}
 
+		if (_param_imu_gyro_fft_trk.get()) {
+			_sliding_dft_enabled = _sliding_dft[0].init(_imu_gyro_fft_len)
+					       && _sliding_dft[1].init(_imu_gyro_fft_len)
+					       && _sliding_dft[2].init(_imu_gyro_fft_len);
+
+			if (_sliding_dft_enabled) {
+				_sliding_dft_perf = perf_alloc(PC_ELAPSED, MODULE_NAME": sliding DFT");
+
+			} else {
+				PX4_ERR("failed to allocate sliding DFT buffers");
+			}
+		}
+
 		if (!SensorSelectionUpdate(true)) {
 			ScheduleDelayed(500_ms);
 		}
@@ -255,42 +269,14 @@ void GyroFFT::VehicleIMUStatusUpdate(bool force)
 	}
 }
 
-// helper function used for frequency estimation
-static inline float tau(float x)
-{
-	// tau(x) = 1/4 * log(3x^2 + 6x + 1) – sqrt(6)/24 * log((x + 1 – sqrt(2/3))  /  (x + 1 + sqrt(2/3)))
-	float p1 = logf(3.f * powf(x, 2.f) + 6.f * x + 1.f);
-	float part1 = x + 1.f - sqrtf(2.f / 3.f);
-	float part2 = x + 1.f + sqrtf(2.f / 3.f);
-	float p2 = logf(part1 / part2);
-	return (0.25f * p1 - sqrtf(6.f) / 24.f * p2);
-}
-
 float GyroFFT::EstimatePeakFrequencyBin(q15_t fft[], int peak_index)
 {
 	if (peak_index >= 2) {
-		// find peak location using Quinn's Second Estimator (2020-06-14: http://dspguru.com/dsp/howtos/how-to-interpolate-fft-peak/)
+		// find peak location using Quinn's Second Estimator
 		float real[3] { (float)fft[peak_index - 2], (float)fft[peak_index], (float)fft[peak_index + 2]     };
 		float imag[3] { (float)fft[peak_index - 2 + 1], (float)fft[peak_index + 1], (float)fft[peak_index + 2 + 1] };
 
-		static constexpr int k = 1;
-
-		const float divider = (real[k] * real[k] + imag[k] * imag[k]);
-
-		// ap = (X[k + 1].r * X[k].r + X[k+1].i * X[k].i) / (X[k].r * X[k].r + X[k].i * X[k].i)
-		float ap = (real[k + 1] * real[k] + imag[k + 1] * imag[k]) / divider;
-
-		// dp = -ap / (1 – ap)
-		float dp = -ap  / (1.f - ap);
-
-		// am = (X[k - 1].r * X[k].r + X[k – 1].i * X[k].i) / (X[k].r * X[k].r + X[k].i * X[k].i)
-		float am = (real[k - 1] * real[k] + imag[k - 1] * imag[k]) / divider;
-
-		// dm = am / (1 – am)
-		float dm = am / (1.f - am);
-
-		// d = (dp + dm) / 2 + tau(dp * dp) – tau(dm * dm)
-		float d = (dp + dm) / 2.f + tau(dp * dp) - tau(dm * dm);
+		const float d = gyro_fft::QuinnsSecondEstimator(real, imag);
 
 		// k’ = k + d
 		return peak_index + 2.f * d;
@@ -299,6 +285,18 @@ float GyroFFT::EstimatePeakFrequencyBin(q15_t fft[], int peak_index)
 	return NAN;
 }
 
+void GyroFFT::ResetBuffers()
+{
+	for (int axis = 0; axis < 3; axis++) {
+		_fft_buffer_index[axis] = 0;
+
+		if (_sliding_dft_enabled) {
+			_sliding_dft[axis].reset();
+			_sliding_dft_samples[axis] = 0;
+		}
+	}
+}
+
 void GyroFFT::Run()
 {
 	if (should_exit()) {
@@ -336,9 +334,7 @@ void GyroFFT::Run()
 		while (_sensor_gyro_fifo_sub.update(&sensor_gyro_fifo)) {
 			if (_sensor_gyro_fifo_sub.get_last_generation() != _gyro_last_generation + 1) {
 				// force reset if we've missed a sample
-				_fft_buffer_index[0] = 0;
-				_fft_buffer_index[1] = 0;
-				_fft_buffer_index[2] = 0;
+				ResetBuffers();
 
 				perf_count(_gyro_fifo_generation_gap_perf);
 			}
@@ -347,9 +343,7 @@ void GyroFFT::Run()
 
 			if (fabsf(sensor_gyro_fifo.scale - _fifo_last_scale) > FLT_EPSILON) {
 				// force reset if scale has changed
-				_fft_buffer_index[0] = 0;
-				_fft_buffer_index[1] = 0;
-				_fft_buffer_index[2] = 0;
+				ResetBuffers();
 
 				_fifo_last_scale = sensor_gyro_fifo.scale;
 			}
@@ -365,9 +359,7 @@ void GyroFFT::Run()
 		while (_sensor_gyro_sub.update(&sensor_gyro)) {
 			if (_sensor_gyro_sub.get_last_generation() != _gyro_last_generation + 1) {
 				// force reset if we've missed a sample
-				_fft_buffer_index[0] = 0;
-				_fft_buffer_index[1] = 0;
-				_fft_buffer_index[2] = 0;
+				ResetBuffers();
 
 				perf_count(_gyro_generation_gap_perf);
 			}
@@ -406,6 +398,17 @@ void GyroFFT::Update(const hrt_abstime &timestamp_sample, int16_t *input[], uint
 				buffer_index++;
 			}
 
+			if (_sliding_dft_enabled) {
+				// the sliding DFT sees every sample, even if the FFT buffer is full
+				_sliding_dft[axis].update(input[axis][n] / 2);
+				_sliding_dft_samples[axis]++;
+
+				if ((_sliding_dft_samples[axis] >= SLIDING_DFT_DECIMATION) && _sliding_dft[axis].ready()) {
+					TrackPeaks(timestamp_sample, axis);
+					_sliding_dft_samples[axis] = 0;
+				}
+			}
+
 			// if we have enough samples begin processing, but only one FFT per cycle
 			if ((buffer_index >= _imu_gyro_fft_len) && !_fft_updated) {
 				perf_begin(_fft_perf);
@@ -417,6 +420,26 @@ void GyroFFT::Update(const hrt_abstime &timestamp_sample, int16_t *input[], uint
 
 				FindPeaks(timestamp_sample, axis, _fft_outupt_buffer);
 
+				if (_sliding_dft_enabled) {
+					// track the published peaks until the next FFT of this axis
+					const float *peak_frequencies[] {_sensor_gyro_fft.peak_frequencies_x, _sensor_gyro_fft.peak_frequencies_y, _sensor_gyro_fft.peak_frequencies_z};
+					const float *peak_snr[] {_sensor_gyro_fft.peak_snr_x, _sensor_gyro_fft.peak_snr_y, _sensor_gyro_fft.peak_snr_z};
+					const float resolution_hz = _gyro_sample_rate_hz / _imu_gyro_fft_len;
+
+					int center_bins[MAX_NUM_PEAKS] {};
+					int num_peaks = 0;
+
+					for (int i = 0; i < MAX_NUM_PEAKS; i++) {
+						if (PX4_ISFINITE(peak_frequencies[axis][i]) && (peak_frequencies[axis][i] > 0.f)) {
+							center_bins[num_peaks] = (int)roundf(peak_frequencies[axis][i] / resolution_hz);
+							_sliding_dft_snr[axis][num_peaks] = peak_snr[axis][i];
+							num_peaks++;
+						}
+					}
+
+					_sliding_dft[axis].setPeaks(center_bins, num_peaks);
+				}
+
 				// reset
 				// shift buffer (3/4 overlap)
 				const int overlap_start = _imu_gyro_fft_len / 4;
@@ -429,6 +452,36 @@ void GyroFFT::Update(const hrt_abstime &timestamp_sample, int16_t *input[], uint
 	}
 }
 
+void GyroFFT::TrackPeaks(const hrt_abstime &timestamp_sample, int axis)
+{
+	perf_begin(_sliding_dft_perf);
+
+	const float resolution_hz = _gyro_sample_rate_hz / _imu_gyro_fft_len;
+
+	int num_peaks_found = 0;
+	float peak_frequencies[MAX_NUM_PEAKS] {};
+	float peak_snr[MAX_NUM_PEAKS] {};
+
+	for (int peak = 0; peak < _sliding_dft[axis].numPeaks(); peak++) {
+		const float freq = resolution_hz * _sliding_dft[axis].peakBin(peak);
+
+		if (PX4_ISFINITE(freq)
+		    && (freq >= _param_imu_gyro_fft_min.get())
+		    && (freq <= _param_imu_gyro_fft_max.get())) {
+
+			peak_frequencies[num_peaks_found] = freq;
+			peak_snr[num_peaks_found] = _sliding_dft_snr[axis][peak]; // SNR of the last FFT
+			num_peaks_found++;
+		}
+	}
+
+	if (num_peaks_found > 0) {
+		UpdateOutput(timestamp_sample, axis, peak_frequencies, peak_snr, num_peaks_found);
+	}
+
+	perf_end(_sliding_dft_perf);
+}
+
 void GyroFFT::FindPeaks(const hrt_abstime &timestamp_sample, int axis, q15_t *fft_outupt_buffer)
 {
 	const float resolution_hz = _gyro_sample_rate_hz / _imu_gyro_fft_len;
@@ -706,6 +759,7 @@ int GyroFFT::print_status()
 	perf_print_counter(_cycle_perf);
 	perf_print_counter(_cycle_interval_perf);
 	perf_print_counter(_fft_perf);
+	perf_print_counter(_sliding_dft_perf);
 	perf_print_counter(_gyro_generation_gap_perf);
 	perf_print_counter(_gyro_fifo_generation_gap_perf);
 	return 0;
@@ -56,6 +56,8 @@
 #include "arm_math.h"
 #include "arm_const_structs.h"
 
+#include "SlidingDFT.hpp"
+
 using namespace time_literals;
 
 class GyroFFT : public ModuleBase<GyroFFT>, public ModuleParams, public px4::ScheduledWorkItem
@@ -85,9 +87,11 @@ private:
 			sensor_gyro_fft_s::peak_frequencies_x[0]);
 
 	void Run() override;
+	inline void ResetBuffers();
 	inline void FindPeaks(const hrt_abstime &timestamp_sample, int axis, q15_t *fft_outupt_buffer);
 	inline float EstimatePeakFrequencyBin(q15_t fft[], int peak_index);
 	inline void Publish();
+	inline void TrackPeaks(const hrt_abstime &timestamp_sample, int axis);
 	bool SensorSelectionUpdate(bool force = false);
 	void Update(const hrt_abstime &timestamp_sample, int16_t *input[], uint8_t N);
 	inline void UpdateOutput(const hrt_abstime &timestamp_sample, int axis, float peak_frequencies[MAX_NUM_PEAKS],
@@ -125,6 +129,7 @@ private:
 	perf_counter_t _cycle_perf{perf_alloc(PC_ELAPSED, MODULE_NAME": cycle")};
 	perf_counter_t _cycle_interval_perf{perf_alloc(PC_INTERVAL, MODULE_NAME": cycle interval")};
 	perf_counter_t _fft_perf{perf_alloc(PC_ELAPSED, MODULE_NAME": FFT")};
+	perf_counter_t _sliding_dft_perf{nullptr};
 	perf_counter_t _gyro_generation_gap_perf{nullptr};
 	perf_counter_t _gyro_fifo_generation_gap_perf{nullptr};
 
@@ -149,6 +154,13 @@ private:
 
 	int _fft_buffer_index[3] {};
 
+	// peak tracking between FFTs
+	static constexpr int SLIDING_DFT_DECIMATION = 16; // peak update interval (samples)
+	gyro_fft::SlidingDFT<MAX_NUM_PEAKS> _sliding_dft[3] {};
+	float _sliding_dft_snr[3][MAX_NUM_PEAKS] {};
+	int _sliding_dft_samples[3] {};
+	bool _sliding_dft_enabled{false};
+
 	unsigned _gyro_last_generation{0};
 
 	math::MedianFilter<float, 7> _median_filter[3][MAX_NUM_PEAKS] {};
@@ -166,7 +178,8 @@ private:
 		(ParamInt<px4::params::IMU_GYRO_FFT_LEN>) _param_imu_gyro_fft_len,
 		(ParamFloat<px4::params::IMU_GYRO_FFT_MIN>) _param_imu_gyro_fft_min,
 		(ParamFloat<px4::params::IMU_GYRO_FFT_MAX>) _param_imu_gyro_fft_max,
-		(ParamFloat<px4::params::IMU_GYRO_FFT_SNR>) _param_imu_gyro_fft_snr
+		(ParamFloat<px4::params::IMU_GYRO_FFT_SNR>) _param_imu_gyro_fft_snr,
+		(ParamBool<px4::params::IMU_GYRO_FFT_TRK>) _param_imu_gyro_fft_trk
 	)
 };
 
@@ -0,0 +1,291 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file SlidingDFT.hpp
+ *
+ * Sliding DFT of a few bins around tracked spectral peaks.
+ *
+ * Each new sample updates the tracked bins in O(1) per bin
+ *   X_k <- (X_k - x_oldest + x_newest) * e^(j2*pi*k/N)
+ * so peak frequencies can be refined every few samples between full FFTs.
+ * The bins are (re-)seeded with a direct DFT of the sample history whenever new peaks
+ * are set, which also bounds the accumulation of floating point errors.
+ *
+ * The bin state is stored as structure of arrays so that the update loop vectorizes
+ * (NEON/SSE) on POSIX targets.
+ */
+
+#pragma once
+
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <px4_platform_common/defines.h>
+
+namespace gyro_fft
+{
+
+// helper function used for frequency estimation
+static inline float tau(float x)
+{
+	// tau(x) = 1/4 * log(3x^2 + 6x + 1) – sqrt(6)/24 * log((x + 1 – sqrt(2/3))  /  (x + 1 + sqrt(2/3)))
+	float p1 = logf(3.f * powf(x, 2.f) + 6.f * x + 1.f);
+	float part1 = x + 1.f - sqrtf(2.f / 3.f);
+	float part2 = x + 1.f + sqrtf(2.f / 3.f);
+	float p2 = logf(part1 / part2);
+	return (0.25f * p1 - sqrtf(6.f) / 24.f * p2);
+}
+
+/**
+ * Quinn's Second Estimator (2020-06-14: http://dspguru.com/dsp/howtos/how-to-interpolate-fft-peak/)
+ *
+ * @param real real parts of bins k-1, k, k+1
+ * @param imag imaginary parts of bins k-1, k, k+1
+ * @return offset of the peak relative to bin k (in bins)
+ */
+static inline float QuinnsSecondEstimator(const float real[3], const float imag[3])
+{
+	static constexpr int k = 1;
+
+	const float divider = (real[k] * real[k] + imag[k] * imag[k]);
+
+	// ap = (X[k + 1].r * X[k].r + X[k+1].i * X[k].i) / (X[k].r * X[k].r + X[k].i * X[k].i)
+	float ap = (real[k + 1] * real[k] + imag[k + 1] * imag[k]) / divider;
+
+	// dp = -ap / (1 – ap)
+	float dp = -ap  / (1.f - ap);
+
+	// am = (X[k - 1].r * X[k].r + X[k – 1].i * X[k].i) / (X[k].r * X[k].r + X[k].i * X[k].i)
+	float am = (real[k - 1] * real[k] + imag[k - 1] * imag[k]) / divider;
+
+	// dm = am / (1 – am)
+	float dm = am / (1.f - am);
+
+	// d = (dp + dm) / 2 + tau(dp * dp) – tau(dm * dm)
+	return (dp + dm) / 2.f + tau(dp * dp) - tau(dm * dm);
+}
+
+template<int MAX_PEAKS>
+class SlidingDFT
+{
+public:
+	SlidingDFT() = default;
+	~SlidingDFT() { delete[] _history; }
+
+	/**
+	 * Allocate the sample history.
+	 *
+	 * @param length DFT length N
+	 */
+	bool init(int length)
+	{
+		delete[] _history;
+		_history = new int16_t[length];
+		_length = (_history != nullptr) ? length : 0;
+		reset();
+		return _history != nullptr;
+	}
+
+	/**
+	 * Clear the sample history and stop tracking (eg after a data gap).
+	 */
+	void reset()
+	{
+		if (_history) {
+			memset(_history, 0, sizeof(int16_t) * _length);
+		}
+
+		_index = 0;
+		_count = 0;
+		_num_peaks = 0;
+	}
+
+	/**
+	 * Add a new sample (oldest sample leaves the window).
+	 */
+	void update(int16_t sample)
+	{
+		if (_length == 0) {
+			return;
+		}
+
+		const float delta = (float)sample - (float)_history[_index];
+		_history[_index] = sample;
+		_index = (_index + 1 < _length) ? _index + 1 : 0;
+
+		if (_count < _length) {
+			_count++;
+		}
+
+		const int num_bins = _num_peaks * BINS_PER_PEAK;
+
+		for (int b = 0; b < num_bins; b++) {
+			const float re = _re[b] + delta;
+			const float im = _im[b];
+			_re[b] = re * _twiddle_re[b] - im * _twiddle_im[b];
+			_im[b] = re * _twiddle_im[b] + im * _twiddle_re[b];
+		}
+	}
+
+	/**
+	 * Start tracking peaks and seed their bins with a direct DFT of the sample history.
+	 *
+	 * @param center_bins peak bin indexes
+	 * @param num_peaks number of peaks (up to MAX_PEAKS)
+	 */
+	void setPeaks(const int center_bins[], int num_peaks)
+	{
+		_num_peaks = 0;
+
+		for (int peak = 0; (peak < num_peaks) && (_num_peaks < MAX_PEAKS); peak++) {
+			const int k = center_bins[peak];
+
+			if ((k < 2) || (k >= _length / 2 - 1)) {
+				continue;
+			}
+
+			_center_bin[_num_peaks] = k;
+
+			for (int i = 0; i < BINS_PER_PEAK; i++) {
+				const int b = _num_peaks * BINS_PER_PEAK + i;
+				const float omega = 2.f * M_PI_F * (k - 1 + i) / _length;
+				_twiddle_re[b] = cosf(omega);
+				_twiddle_im[b] = sinf(omega);
+				seedBin(b);
+			}
+
+			_seed_magnitude[_num_peaks] = peakMagnitude(_num_peaks);
+			_num_peaks++;
+		}
+	}
+
+	/**
+	 * @return true if a full window of samples is available and peaks are tracked
+	 */
+	bool ready() const { return (_count >= _length) && (_num_peaks > 0); }
+
+	int numPeaks() const { return _num_peaks; }
+
+	/**
+	 * Estimate the frequency of a tracked peak (in bins).
+	 *
+	 * @return NAN if the peak faded (magnitude below a quarter of the magnitude when seeded)
+	 */
+	float peakBin(int peak) const
+	{
+		if (!ready() || (peak >= _num_peaks) || (peakMagnitude(peak) < 0.25f * _seed_magnitude[peak])) {
+			return NAN;
+		}
+
+		const float *real = &_re[peak * BINS_PER_PEAK];
+		const float *imag = &_im[peak * BINS_PER_PEAK];
+
+		const float d = QuinnsSecondEstimator(real, imag);
+
+		// the peak must stay within the tracked bins
+		if (!PX4_ISFINITE(d) || (fabsf(d) > 1.f)) {
+			return NAN;
+		}
+
+		return _center_bin[peak] + d;
+	}
+
+private:
+	static constexpr int BINS_PER_PEAK = 3; // k-1, k, k+1
+	static constexpr int MAX_BINS = MAX_PEAKS * BINS_PER_PEAK;
+
+	void seedBin(int b)
+	{
+		// X_k = sum(x[n] * e^(-j2*pi*k*n/N)), n = 0 is the oldest sample
+		float re = 0.f;
+		float im = 0.f;
+
+		// e^(-j2*pi*k*n/N) by repeated rotation, starting at n = 0
+		float phase_re = 1.f;
+		float phase_im = 0.f;
+		const float step_re = _twiddle_re[b];
+		const float step_im = -_twiddle_im[b];
+
+		int index = _index;
+
+		for (int n = 0; n < _length; n++) {
+			const float x = _history[index];
+			re += x * phase_re;
+			im += x * phase_im;
+
+			const float phase_re_next = phase_re * step_re - phase_im * step_im;
+			phase_im = phase_re * step_im + phase_im * step_re;
+			phase_re = phase_re_next;
+
+			index = (index + 1 < _length) ? index + 1 : 0;
+		}
+
+		_re[b] = re;
+		_im[b] = im;
+	}
+
+	float peakMagnitude(int peak) const
+	{
+		float magnitude_max = 0.f;
+
+		for (int i = 0; i < BINS_PER_PEAK; i++) {
+			const int b = peak * BINS_PER_PEAK + i;
+			const float magnitude = sqrtf(_re[b] * _re[b] + _im[b] * _im[b]);
+
+			if (magnitude > magnitude_max) {
+				magnitude_max = magnitude;
+			}
+		}
+
+		return magnitude_max;
+	}
+
+	int16_t *_history{nullptr}; ///< last N samples (ring buffer)
+	int _length{0};
+	int _index{0}; ///< oldest sample
+	int _count{0};
+
+	int _num_peaks{0};
+	int _center_bin[MAX_PEAKS] {};
+	float _seed_magnitude[MAX_PEAKS] {};
+
+	float _re[MAX_BINS] {};
+	float _im[MAX_BINS] {};
+	float _twiddle_re[MAX_BINS] {};
+	float _twiddle_im[MAX_BINS] {};
+};
+
+} // namespace gyro_fft
@@ -0,0 +1,275 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file SlidingDFTTest.cpp
+ *
+ * Tests and benchmark for the sliding DFT peak tracking. The benchmark is disabled by default,
+ * run it with --gtest_also_run_disabled_tests.
+ */
+
+#include <gtest/gtest.h>
+#include "SlidingDFT.hpp"
+
+#include <chrono>
+#include <cstdio>
+
+using namespace gyro_fft;
+
+static constexpr int FFT_LENGTH = 256;
+static constexpr int MAX_PEAKS = 3;
+static constexpr int DECIMATION = 16; // matches GyroFFT::SLIDING_DFT_DECIMATION
+static constexpr float AMPLITUDE = 8000.f;
+
+// phase continuous sine with a frequency given in bins
+class SineGenerator
+{
+public:
+	int16_t next(float frequency_bins)
+	{
+		_phase += 2.f * M_PI_F * frequency_bins / FFT_LENGTH;
+
+		if (_phase > 2.f * M_PI_F) {
+			_phase -= 2.f * M_PI_F;
+		}
+
+		return (int16_t)(AMPLITUDE * sinf(_phase));
+	}
+
+private:
+	float _phase{0.f};
+};
+
+// block update reference: FFT of the last window every FFT_LENGTH / 4 samples (3/4 overlap)
+static float blockPeakBin(const int16_t window[FFT_LENGTH], int center_bin)
+{
+	float real[3];
+	float imag[3];
+
+	for (int i = 0; i < 3; i++) {
+		const int k = center_bin - 1 + i;
+		real[i] = 0.f;
+		imag[i] = 0.f;
+
+		for (int n = 0; n < FFT_LENGTH; n++) {
+			const float omega = 2.f * M_PI_F * k * n / FFT_LENGTH;
+			real[i] += window[n] * cosf(omega);
+			imag[i] -= window[n] * sinf(omega);
+		}
+	}
+
+	return center_bin + QuinnsSecondEstimator(real, imag);
+}
+
+TEST(SlidingDFTTest, NotReadyBeforeFullWindow)
+{
+	SlidingDFT<MAX_PEAKS> sdft;
+	ASSERT_TRUE(sdft.init(FFT_LENGTH));
+
+	SineGenerator sine;
+
+	for (int n = 0; n < FFT_LENGTH - 1; n++) {
+		sdft.update(sine.next(20.f));
+	}
+
+	const int center_bins[] {20};
+	sdft.setPeaks(center_bins, 1);
+	EXPECT_FALSE(sdft.ready());
+	EXPECT_FALSE(PX4_ISFINITE(sdft.peakBin(0)));
+
+	sdft.update(sine.next(20.f));
+	EXPECT_TRUE(sdft.ready());
+	EXPECT_NEAR(sdft.peakBin(0), 20.f, 0.05f);
+}
+
+TEST(SlidingDFTTest, TracksSine)
+{
+	SlidingDFT<MAX_PEAKS> sdft;
+	ASSERT_TRUE(sdft.init(FFT_LENGTH));
+
+	SineGenerator sine;
+	const float frequency = 30.3f;
+
+	for (int n = 0; n < FFT_LENGTH; n++) {
+		sdft.update(sine.next(frequency));
+	}
+
+	const int center_bins[] {(int)roundf(frequency)};
+	sdft.setPeaks(center_bins, 1);
+	ASSERT_EQ(sdft.numPeaks(), 1);
+
+	// the estimate stays accurate while sliding, without re-seeding
+	for (int n = 0; n < 20 * FFT_LENGTH; n++) {
+		sdft.update(sine.next(frequency));
+
+		if (n % DECIMATION == 0) {
+			EXPECT_NEAR(sdft.peakBin(0), frequency, 0.05f);
+		}
+	}
+}
+
+TEST(SlidingDFTTest, InvalidPeaksIgnored)
+{
+	SlidingDFT<MAX_PEAKS> sdft;
+	ASSERT_TRUE(sdft.init(FFT_LENGTH));
+
+	const int center_bins[] {0, 1, FFT_LENGTH / 2, 40, 50, 60, 70};
+	sdft.setPeaks(center_bins, 7);
+
+	// out of range bins dropped, at most MAX_PEAKS
+	EXPECT_EQ(sdft.numPeaks(), MAX_PEAKS);
+
+	sdft.reset();
+	EXPECT_EQ(sdft.numPeaks(), 0);
+}
+
+TEST(SlidingDFTTest, FadedPeakRejected)
+{
+	SlidingDFT<MAX_PEAKS> sdft;
+	ASSERT_TRUE(sdft.init(FFT_LENGTH));
+
+	SineGenerator sine;
+
+	for (int n = 0; n < FFT_LENGTH; n++) {
+		sdft.update(sine.next(40.f));
+	}
+
+	const int center_bins[] {40};
+	sdft.setPeaks(center_bins, 1);
+	EXPECT_TRUE(PX4_ISFINITE(sdft.peakBin(0)));
+
+	// signal stops
+	for (int n = 0; n < FFT_LENGTH; n++) {
+		sdft.update(0);
+	}
+
+	EXPECT_FALSE(PX4_ISFINITE(sdft.peakBin(0)));
+}
+
+TEST(SlidingDFTTest, StepLatency)
+{
+	// frequency step within the tracked bins, compare the latency until the new frequency is
+	// reported against a block update every FFT_LENGTH / 4 samples
+	const float frequency_before = 50.f;
+	const float frequency_after = 50.8f;
+	const float tolerance = 0.2f;
+
+	SlidingDFT<MAX_PEAKS> sdft;
+	ASSERT_TRUE(sdft.init(FFT_LENGTH));
+
+	SineGenerator sine;
+	int16_t window[FFT_LENGTH] {};
+
+	for (int n = 0; n < FFT_LENGTH; n++) {
+		const int16_t x = sine.next(frequency_before);
+		sdft.update(x);
+		window[n] = x;
+	}
+
+	const int center_bins[] {(int)frequency_before};
+	sdft.setPeaks(center_bins, 1);
+
+	int sdft_latency = -1;
+	int block_latency = -1;
+
+	for (int n = 1; n <= 4 * FFT_LENGTH; n++) {
+		const int16_t x = sine.next(frequency_after);
+		sdft.update(x);
+
+		memmove(&window[0], &window[1], sizeof(window) - sizeof(window[0]));
+		window[FFT_LENGTH - 1] = x;
+
+		if ((sdft_latency < 0) && (n % DECIMATION == 0) && (fabsf(sdft.peakBin(0) - frequency_after) < tolerance)) {
+			sdft_latency = n;
+		}
+
+		if ((block_latency < 0) && (n % (FFT_LENGTH / 4) == 0)
+		    && (fabsf(blockPeakBin(window, center_bins[0]) - frequency_after) < tolerance)) {
+			block_latency = n;
+		}
+	}
+
+	printf("step latency: sliding DFT %d samples, block update %d samples\n", sdft_latency, block_latency);
+
+	ASSERT_GT(sdft_latency, 0);
+	ASSERT_GT(block_latency, 0);
+	EXPECT_LE(sdft_latency, block_latency);
+}
+
+// not part of the unit tests, run with --gtest_also_run_disabled_tests
+TEST(SlidingDFTTest, DISABLED_Benchmark)
+{
+	SlidingDFT<MAX_PEAKS> sdft[3];
+	SineGenerator sine1;
+	SineGenerator sine2;
+
+	for (int axis = 0; axis < 3; axis++) {
+		ASSERT_TRUE(sdft[axis].init(FFT_LENGTH));
+	}
+
+	static constexpr int NUM_SAMPLES = 100000;
+	static int16_t samples[NUM_SAMPLES];
+
+	for (int n = 0; n < NUM_SAMPLES; n++) {
+		samples[n] = sine1.next(25.4f) / 2 + sine2.next(60.7f) / 2;
+	}
+
+	const int center_bins[MAX_PEAKS] {25, 61, 90};
+
+	for (int axis = 0; axis < 3; axis++) {
+		for (int n = 0; n < FFT_LENGTH; n++) {
+			sdft[axis].update(samples[n]);
+		}
+
+		sdft[axis].setPeaks(center_bins, MAX_PEAKS);
+	}
+
+	volatile float sink = 0.f;
+	const auto start = std::chrono::steady_clock::now();
+
+	for (int n = 0; n < NUM_SAMPLES; n++) {
+		for (int axis = 0; axis < 3; axis++) {
+			sdft[axis].update(samples[n]);
+
+			if (n % DECIMATION == 0) {
+				sink = sink + sdft[axis].peakBin(0);
+			}
+		}
+	}
+
+	const auto end = std::chrono::steady_clock::now();
+	const double ns = std::chrono::duration<double, std::nano>(end - start).count();
+
+	printf("sliding DFT (%d peaks, peak estimate every %d samples): %.1f ns/sample/axis\n",
+	       MAX_PEAKS, DECIMATION, ns / NUM_SAMPLES / 3);
+}
@@ -83,3 +83,15 @@ PARAM_DEFINE_INT32(IMU_GYRO_FFT_LEN, 512);
 * @group Sensors
 */
 PARAM_DEFINE_FLOAT(IMU_GYRO_FFT_SNR, 10.f);
+
+/**
+* IMU gyro FFT peak tracking.
+*
+* Track the detected peaks with a sliding DFT between FFTs, which updates
+* the peak frequencies every few gyro samples instead of once per FFT.
+*
+* @boolean
+* @reboot_required true
+* @group Sensors
+*/
+PARAM_DEFINE_INT32(IMU_GYRO_FFT_TRK, 0);
@@ -183,8 +183,16 @@ int Logger::task_spawn(int argc, char *argv[])
 int Logger::print_status()
 {
 	PX4_INFO("Running in mode: %s", configured_backend_mode());
-	PX4_INFO("Number of subscriptions: %i (%i bytes)", _num_subscriptions,
-		 (int)(_num_subscriptions * sizeof(LoggerSubscription)));
+	PX4_INFO("Number of subscriptions: %i (%i bytes)%s", _num_subscriptions,
+		 (int)(_num_subscriptions * sizeof(LoggerSubscription)), _event_driven ? ", event-driven" : "");
+
+	for (int i = 0; i < _num_subscriptions; ++i) {
+		const LoggerSubscription &sub = _subscriptions[i];
+
+		if (sub.dropped > 0) {
+			PX4_INFO("Dropped samples: %s (%i): %u", sub.get_topic()->o_name, sub.get_instance(), (unsigned)sub.dropped);
+		}
+	}
 
 	bool is_logging = false;
 
@@ -251,12 +259,13 @@ Logger *Logger::instantiate(int argc, char *argv[])
 	bool log_name_timestamp = false;
 	LogWriter::Backend backend = LogWriter::BackendAll;
 	const char *poll_topic = nullptr;
+	bool event_driven = false;
 
 	int myoptind = 1;
 	int ch;
 	const char *myoptarg = nullptr;
 
-	while ((ch = px4_getopt(argc, argv, "r:b:etfm:p:xc:", &myoptind, &myoptarg)) != EOF) {
+	while ((ch = px4_getopt(argc, argv, "r:b:etfm:p:xc:u", &myoptind, &myoptarg)) != EOF) {
 		switch (ch) {
 		case 'r': {
 				unsigned long r = strtoul(myoptarg, nullptr, 10);
@@ -327,6 +336,10 @@ Logger *Logger::instantiate(int argc, char *argv[])
 			poll_topic = myoptarg;
 			break;
 
+		case 'u':
+			event_driven = true;
+			break;
+
 		case '?':
 			error_flag = true;
 			break;
@@ -343,7 +356,7 @@ Logger *Logger::instantiate(int argc, char *argv[])
 	}
 
 	Logger *logger = new Logger(backend, log_buffer_size, log_interval, poll_topic, log_mode, log_name_timestamp,
-				    rate_factor);
+				    rate_factor, event_driven);
 
 #if defined(DBGPRINT) && defined(__PX4_NUTTX)
 	struct mallinfo alloc_info = mallinfo();
@@ -371,10 +384,11 @@ Logger *Logger::instantiate(int argc, char *argv[])
 }
 
 Logger::Logger(LogWriter::Backend backend, size_t buffer_size, uint32_t log_interval, const char *poll_topic_name,
-	       LogMode log_mode, bool log_name_timestamp, float rate_factor) :
+	       LogMode log_mode, bool log_name_timestamp, float rate_factor, bool event_driven) :
 	ModuleParams(nullptr),
 	_log_mode(log_mode),
 	_log_name_timestamp(log_name_timestamp),
+	_event_driven(event_driven),
 	_event_subscription(ORB_ID::event),
 	_writer(backend, buffer_size),
 	_log_interval(log_interval),
@@ -403,7 +417,9 @@ Logger::~Logger()
 	}
 
 	delete[](_msg_buffer);
+	delete[](_update_callbacks);
 	delete[](_subscriptions);
+	delete[](_updated_topics);
 }
 
 void Logger::update_params()
@@ -444,14 +460,21 @@ bool Logger::copy_if_updated(int sub_idx, void *buffer, bool try_to_subscribe)
 			if (updated && (sub.get_last_generation() != last_generation + 1)) {
 				// error, missed a message
 				_message_gaps++;
+				const unsigned dropped = sub.dropped + sub.get_last_generation() - last_generation - 1;
+				sub.dropped = (dropped < UINT16_MAX) ? dropped : UINT16_MAX;
 			}
 
 		} else {
 			updated = sub.update(buffer);
+
+			if (!updated && _update_callbacks && sub.data_pending()) {
+				// the interval did not pass yet, keep the topic marked for the next iteration
+				_update_callbacks[sub_idx].call();
+			}
 		}
 
 	} else if (try_to_subscribe) {
-		if (sub.subscribe()) {
+		if (subscribe(sub_idx)) {
 			write_add_logged_msg(LogType::Full, sub);
 
 			if (sub_idx < _num_mission_subs) {
@@ -466,6 +489,72 @@ bool Logger::copy_if_updated(int sub_idx, void *buffer, bool try_to_subscribe)
 	return updated;
 }
 
+bool Logger::subscribe(int sub_idx)
+{
+	if (!_subscriptions[sub_idx].subscribe()) {
+		return false;
+	}
+
+	if (_update_callbacks) {
+		_update_callbacks[sub_idx].registerCallback();
+	}
+
+	return true;
+}
+
+void Logger::write_subscription_data(int sub_idx, bool try_to_subscribe, hrt_abstime loop_time, uint32_t &total_bytes)
+{
+	LoggerSubscription &sub = _subscriptions[sub_idx];
+
+	/* if this topic has been updated, copy the new data into the message buffer
+	 * and write a message to the log
+	 */
+	bool updated = copy_if_updated(sub_idx, _msg_buffer + sizeof(ulog_message_data_s), try_to_subscribe);
+
+	while (updated) {
+		// each message consists of a header followed by an orb data object
+		const size_t msg_size = sizeof(ulog_message_data_s) + sub.get_topic()->o_size_no_padding;
+		const uint16_t write_msg_size = static_cast<uint16_t>(msg_size - ULOG_MSG_HEADER_LEN);
+		const uint16_t write_msg_id = sub.msg_id;
+
+		//write one byte after another (necessary because of alignment)
+		_msg_buffer[0] = (uint8_t)write_msg_size;
+		_msg_buffer[1] = (uint8_t)(write_msg_size >> 8);
+		_msg_buffer[2] = static_cast<uint8_t>(ULogMessageType::DATA);
+		_msg_buffer[3] = (uint8_t)write_msg_id;
+		_msg_buffer[4] = (uint8_t)(write_msg_id >> 8);
+
+		// PX4_INFO("topic: %s, size = %zu, out_size = %zu", sub.get_topic()->o_name, sub.get_topic()->o_size, msg_size);
+
+		// full log
+		if (write_message(LogType::Full, _msg_buffer, msg_size)) {
+
+#ifdef DBGPRINT
+			total_bytes += msg_size;
+#endif /* DBGPRINT */
+		}
+
+		// mission log
+		if (sub_idx < _num_mission_subs) {
+			if (_writer.is_started(LogType::Mission)) {
+				if (_mission_subscriptions[sub_idx].next_write_time < (loop_time / 100000)) {
+					unsigned delta_time = _mission_subscriptions[sub_idx].min_delta_ms;
+
+					if (delta_time > 0) {
+						_mission_subscriptions[sub_idx].next_write_time = (loop_time / 100000) + delta_time / 100;
+					}
+
+					write_message(LogType::Mission, _msg_buffer, msg_size);
+				}
+			}
+		}
+
+		// in event-driven mode, drain the queue of full-rate topics so that every sample is logged
+		updated = _event_driven && (sub.get_interval_us() == 0) && copy_if_updated(sub_idx,
+				_msg_buffer + sizeof(ulog_message_data_s), false);
+	}
+}
+
 const char *Logger::configured_backend_mode() const
 {
 	switch (_writer.backend()) {
@@ -535,8 +624,12 @@ bool Logger::initialize_topics()
 	memcpy(_excluded_optional_topic_ids, logged_topics.subscriptions().excluded_optional_topic_ids,
 	       sizeof(_excluded_optional_topic_ids));
 
+	delete[](_update_callbacks);
+	_update_callbacks = nullptr;
 	delete[](_subscriptions);
 	_subscriptions = nullptr;
+	delete[](_updated_topics);
+	_updated_topics = nullptr;
 
 	if (logged_topics.subscriptions().count > 0) {
 		_subscriptions = new LoggerSubscription[logged_topics.subscriptions().count];
@@ -546,10 +639,30 @@ bool Logger::initialize_topics()
 			return false;
 		}
 
+		if (_event_driven) {
+			const int num_words = (logged_topics.subscriptions().count + 31) / 32;
+			_updated_topics = new px4::atomic<uint32_t>[num_words];
+			_update_callbacks = new LoggerUpdateCallback[logged_topics.subscriptions().count];
+
+			if (!_updated_topics || !_update_callbacks) {
+				PX4_ERR("alloc failed");
+				return false;
+			}
+
+			for (int i = 0; i < num_words; ++i) {
+				_updated_topics[i].store(0);
+			}
+		}
+
 		for (int i = 0; i < logged_topics.subscriptions().count; ++i) {
 			const LoggedTopics::RequestedSubscription &sub = logged_topics.subscriptions().sub[i];
 			_subscriptions[i] = LoggerSubscription(sub.id, sub.interval_ms, sub.instance);
-			_subscriptions[i].subscribe();
+
+			if (_update_callbacks) {
+				_update_callbacks[i] = LoggerUpdateCallback(sub.id, sub.instance, &_updated_topics[i / 32], 1u << (i % 32));
+			}
+
+			subscribe(i);
 		}
 	}
 
@@ -710,6 +823,11 @@ void Logger::run()
 
 			if (!was_started) {
 				adjust_subscription_updates();
+
+				// log the current state of all topics
+				for (int i = 0; _updated_topics && i < (_num_subscriptions + 31) / 32; ++i) {
+					_updated_topics[i].store(UINT32_MAX);
+				}
 			}
 
 			/* check if we need to output the process load */
@@ -738,50 +856,25 @@ void Logger::run()
 			/* wait for lock on log buffer */
 			_writer.lock();
 
-			for (int sub_idx = 0; sub_idx < _num_subscriptions; ++sub_idx) {
-				LoggerSubscription &sub = _subscriptions[sub_idx];
-				/* if this topic has been updated, copy the new data into the message buffer
-				 * and write a message to the log
-				 */
-				const bool try_to_subscribe = (sub_idx == next_subscribe_topic_index);
-
-				if (copy_if_updated(sub_idx, _msg_buffer + sizeof(ulog_message_data_s), try_to_subscribe)) {
-					// each message consists of a header followed by an orb data object
-					const size_t msg_size = sizeof(ulog_message_data_s) + sub.get_topic()->o_size_no_padding;
-					const uint16_t write_msg_size = static_cast<uint16_t>(msg_size - ULOG_MSG_HEADER_LEN);
-					const uint16_t write_msg_id = sub.msg_id;
+			if (_updated_topics) {
+				// only visit the topics marked by the uORB callbacks (and the one to try to subscribe)
+				for (int word = 0; word < (_num_subscriptions + 31) / 32; ++word) {
+					uint32_t updated = _updated_topics[word].fetch_and(0);
 
-					//write one byte after another (necessary because of alignment)
-					_msg_buffer[0] = (uint8_t)write_msg_size;
-					_msg_buffer[1] = (uint8_t)(write_msg_size >> 8);
-					_msg_buffer[2] = static_cast<uint8_t>(ULogMessageType::DATA);
-					_msg_buffer[3] = (uint8_t)write_msg_id;
-					_msg_buffer[4] = (uint8_t)(write_msg_id >> 8);
-
-					// PX4_INFO("topic: %s, size = %zu, out_size = %zu", sub.get_topic()->o_name, sub.get_topic()->o_size, msg_size);
-
-					// full log
-					if (write_message(LogType::Full, _msg_buffer, msg_size)) {
-
-#ifdef DBGPRINT
-						total_bytes += msg_size;
-#endif /* DBGPRINT */
+					for (int sub_idx = word * 32; (updated != 0) && (sub_idx < _num_subscriptions); ++sub_idx, updated >>= 1) {
+						if (updated & 1) {
+							write_subscription_data(sub_idx, sub_idx == next_subscribe_topic_index, loop_time, total_bytes);
+						}
 					}
+				}
 
-					// mission log
-					if (sub_idx < _num_mission_subs) {
-						if (_writer.is_started(LogType::Mission)) {
-							if (_mission_subscriptions[sub_idx].next_write_time < (loop_time / 100000)) {
-								unsigned delta_time = _mission_subscriptions[sub_idx].min_delta_ms;
-
-								if (delta_time > 0) {
-									_mission_subscriptions[sub_idx].next_write_time = (loop_time / 100000) + delta_time / 100;
-								}
+				if ((next_subscribe_topic_index != -1) && !_subscriptions[next_subscribe_topic_index].valid()) {
+					write_subscription_data(next_subscribe_topic_index, true, loop_time, total_bytes);
+				}
 
-								write_message(LogType::Mission, _msg_buffer, msg_size);
-							}
-						}
-					}
+			} else {
+				for (int sub_idx = 0; sub_idx < _num_subscriptions; ++sub_idx) {
+					write_subscription_data(sub_idx, sub_idx == next_subscribe_topic_index, loop_time, total_bytes);
 				}
 			}
 
@@ -867,7 +960,7 @@ void Logger::run()
 			// - we'll get the data immediately once we start logging (no need to wait for the next subscribe timeout)
 			if (next_subscribe_topic_index != -1) {
 				if (!_subscriptions[next_subscribe_topic_index].valid()) {
-					_subscriptions[next_subscribe_topic_index].subscribe();
+					subscribe(next_subscribe_topic_index);
 				}
 
 				if (++next_subscribe_topic_index >= _num_subscriptions) {
@@ -1647,32 +1740,20 @@ void Logger::write_format(LogType type, const orb_metadata &meta, WrittenFormats
 	// Write the current format (we don't need to check if we already added it to written_formats)
 	int format_len = snprintf(msg.format, sizeof(msg.format), "%s:", meta.o_name);
 
-	for (int format_idx = 0; meta.o_fields[format_idx] != 0;) {
-		const char *end_field = strchr(meta.o_fields + format_idx, ';');
-
-		if (!end_field) {
-			PX4_ERR("Format error in %s", meta.o_fields);
-			return;
-		}
+	orb_field_iterator it;
+	orb_field_iterator_init(&it, &meta);
+	orb_field_descriptor field;
 
-		const char *c_type = orb_get_c_type(meta.o_fields[format_idx]);
+	while (orb_next_field(&it, &field)) {
+		const int len = orb_get_field_format(&meta, &field, msg.format + format_len, sizeof(msg.format) - format_len);
 
-		if (c_type) {
-			format_len += snprintf(msg.format + format_len, sizeof(msg.format) - format_len, "%s", c_type);
-			++format_idx;
-		}
-
-		int len = end_field - (meta.o_fields + format_idx) + 1;
-
-		if (len >= (int)sizeof(msg.format) - format_len) {
+		if (len < 0 || len >= (int)sizeof(msg.format) - format_len) {
 			PX4_WARN("skip topic %s, format string is too large, max is %zu", meta.o_name,
 				 sizeof(ulog_message_format_s::format));
 			return;
 		}
 
-		memcpy(msg.format + format_len, meta.o_fields + format_idx, len);
 		format_len += len;
-		format_idx += len;
 	}
 
 	msg.format[format_len] = '\0';
@@ -1685,64 +1766,20 @@ void Logger::write_format(LogType type, const orb_metadata &meta, WrittenFormats
 		PX4_ERR("Array too small");
 	}
 
-	// Now go through the fields and check for nested type usages.
-	// o_fields looks like this for example: "<chr> timestamp;<chr>[5] array;"
-	const char *fmt = meta.o_fields;
-
-	while (fmt && *fmt) {
-		// extract the type name
-		char type_name[64];
-		const char *space = strchr(fmt, ' ');
-
-		if (!space) {
-			PX4_ERR("invalid format %s", fmt);
-			break;
-		}
-
-		const char *array_start = strchr(fmt, '['); // check for an array
-
-		int type_length;
+	// Now go through the fields and check for nested type usages
+	orb_field_iterator_init(&it, &meta);
 
-		if (array_start && array_start < space) {
-			type_length = array_start - fmt;
+	while (orb_next_field(&it, &field)) {
+		if (field.type == ORB_FIELD_TYPE_NESTED) {
+			const orb_metadata *nested = get_orb_meta(static_cast<ORB_ID>(field.nested_id));
 
-		} else {
-			type_length = space - fmt;
-		}
-
-		if (type_length >= (int)sizeof(type_name)) {
-			PX4_ERR("buf len too small");
-			break;
-		}
-
-		memcpy(type_name, fmt, type_length);
-		type_name[type_length] = '\0';
-
-		// ignore built-in types
-		if (orb_get_c_type(type_name[0]) == nullptr) {
-
-			// find orb meta for type
-			const orb_metadata *const *topics = orb_get_topics();
-			const orb_metadata *found_topic = nullptr;
-
-			for (size_t i = 0; i < orb_topics_count(); i++) {
-				if (strcmp(topics[i]->o_name, type_name) == 0) {
-					found_topic = topics[i];
-				}
-			}
-
-			if (found_topic) {
-
-				write_format(type, *found_topic, written_formats, msg, subscription_index, level + 1);
+			if (nested) {
+				write_format(type, *nested, written_formats, msg, subscription_index, level + 1);
 
 			} else {
-				PX4_ERR("No definition for topic %s found", fmt);
+				PX4_ERR("No definition for nested topic in %s found", meta.o_name);
 			}
 		}
-
-		fmt = strchr(fmt, ';');
-
-		if (fmt) { ++fmt; }
 	}
 }
 
@@ -2315,7 +2352,10 @@ The normal log is always a superset of the mission log.
 ### Implementation
 The implementation uses two threads:
 - The main thread, running at a fixed rate (or polling on a topic if started with -p) and checking for
-  data updates
+  data updates. If started with -u, uORB callbacks mark the updated topics, so that only those are
+  checked, and all queued samples of topics logged at full rate are written (not only the latest).
+  Samples that were overwritten in the queue before they could be logged are reported per topic
+  in `logger status`.
 - The writer thread, writing data to the file
 
 In between there is a write buffer with configurable size (and another fixed-size buffer for
@@ -2341,6 +2381,7 @@ $ logger on
 	PRINT_MODULE_USAGE_PARAM_STRING('p', nullptr, "<topic_name>",
 					 "Poll on a topic instead of running with fixed rate (Log rate and topic intervals are ignored if this is set)", true);
 	PRINT_MODULE_USAGE_PARAM_FLOAT('c', 1.0, 0.2, 2.0, "Log rate factor (higher is faster)", true);
+	PRINT_MODULE_USAGE_PARAM_FLAG('u', "Event-driven: only check topics updated since the last iteration", true);
 	PRINT_MODULE_USAGE_COMMAND_DESCR("on", "start logging now, override arming (logger must be running)");
 	PRINT_MODULE_USAGE_COMMAND_DESCR("off", "stop logging now, override arming (logger must be running)");
 	PRINT_MODULE_USAGE_DEFAULT_COMMANDS();
@@ -38,6 +38,7 @@
 #include "messages.h"
 #include <containers/Array.hpp>
 #include "util.h"
+#include <px4_platform_common/atomic.h>
 #include <px4_platform_common/defines.h>
 #include <drivers/drv_hrt.h>
 #include <version/version.h>
@@ -48,6 +49,7 @@
 
 #include <uORB/PublicationMulti.hpp>
 #include <uORB/Subscription.hpp>
+#include <uORB/SubscriptionCallback.hpp>
 #include <uORB/SubscriptionInterval.hpp>
 #include <uORB/topics/logger_status.h>
 #include <uORB/topics/log_message.h>
@@ -77,7 +79,34 @@ struct LoggerSubscription : public uORB::SubscriptionInterval {
 		uORB::SubscriptionInterval(id, interval_ms * 1000, instance)
 	{}
 
+	/** check for new data, ignoring the interval */
+	bool data_pending() { return _subscription.updated(); }
+
 	uint8_t msg_id{MSG_ID_INVALID};
+	uint16_t dropped{0}; ///< number of samples that were overwritten in the queue before being logged (saturating)
+};
+
+/**
+ * Event-driven mode only: uORB callback marking a logged topic as updated in the updated topics bitmap.
+ * Kept separate from LoggerSubscription, so that the default mode does not pay for the callback state.
+ */
+class LoggerUpdateCallback : public uORB::SubscriptionCallback
+{
+public:
+	LoggerUpdateCallback() : uORB::SubscriptionCallback(nullptr) {}
+
+	LoggerUpdateCallback(ORB_ID id, uint8_t instance, px4::atomic<uint32_t> *updated_word, uint32_t mask) :
+		uORB::SubscriptionCallback(get_orb_meta(id), 0, instance),
+		_updated_word(updated_word),
+		_updated_mask(mask)
+	{}
+
+	/** mark the topic as updated (called from the publisher context) */
+	void call() override { _updated_word->fetch_or(_updated_mask); }
+
+private:
+	px4::atomic<uint32_t> *_updated_word{nullptr};
+	uint32_t _updated_mask{0};
 };
 
 class Logger : public ModuleBase<Logger>, public ModuleParams
@@ -91,7 +120,7 @@ public:
 	};
 
 	Logger(LogWriter::Backend backend, size_t buffer_size, uint32_t log_interval, const char *poll_topic_name,
-	       LogMode log_mode, bool log_name_timestamp, float rate_factor);
+	       LogMode log_mode, bool log_name_timestamp, float rate_factor, bool event_driven);
 
 	~Logger();
 
@@ -267,6 +296,19 @@ private:
 
 	inline bool copy_if_updated(int sub_idx, void *buffer, bool try_to_subscribe);
 
+	/**
+	 * Subscribe to a logged topic and, in event-driven mode, register its update callback
+	 * (once the topic exists, so that registering does not create it).
+	 */
+	bool subscribe(int sub_idx);
+
+	/**
+	 * Write the updated data of a subscription to the full and mission log.
+	 * In event-driven mode all queued samples of full-rate topics are written.
+	 * Must be called with _writer.lock() held.
+	 */
+	void write_subscription_data(int sub_idx, bool try_to_subscribe, hrt_abstime loop_time, uint32_t &total_bytes);
+
 	/**
 	 * Write exactly one ulog message to the logger and handle dropouts.
 	 * Must be called with _writer.lock() held.
@@ -339,6 +381,9 @@ private:
 
 	LoggerSubscription	 			*_subscriptions{nullptr}; ///< all subscriptions for full & mission log (in front)
 	int						_num_subscriptions{0};
+	px4::atomic<uint32_t>				*_updated_topics{nullptr}; ///< bitmap of updated subscriptions (event-driven mode only)
+	LoggerUpdateCallback				*_update_callbacks{nullptr}; ///< callbacks setting _updated_topics (event-driven mode only)
+	const bool					_event_driven; ///< only visit topics marked as updated by uORB callbacks
 	MissionSubscription 				_mission_subscriptions[MAX_MISSION_TOPICS_NUM] {}; ///< additional data for mission subscriptions
 	int						_num_mission_subs{0};
 	LoggerSubscription				_event_subscription; ///< Subscription for the event topic (handled separately)
@@ -44,6 +44,11 @@ MagBiasEstimator::MagBiasEstimator() :
 	ScheduledWorkItem(MODULE_NAME, px4::wq_configurations::lp_default)
 {
 	_magnetometer_bias_estimate_pub.advertise();
+
+	for (auto &ellipsoid_fit : _ellipsoid_fit) {
+		ellipsoid_fit.setFieldNorm(0.5f);
+		ellipsoid_fit.setForgettingFactor(0.999f);
+	}
 }
 
 MagBiasEstimator::~MagBiasEstimator()
@@ -106,6 +111,16 @@ void MagBiasEstimator::Run()
 
 	// only run when disarmed
 	if (_arming_state == vehicle_status_s::ARMING_STATE_ARMED) {
+		// except for the ellipsoid fit, which doesn't need the angular velocity
+		for (int mag_index = 0; mag_index < MAX_SENSOR_COUNT; mag_index++) {
+			sensor_mag_s sensor_mag;
+
+			while (_sensor_mag_subs[mag_index].update(&sensor_mag)) {
+				_calibration[mag_index].set_device_id(sensor_mag.device_id);
+				_ellipsoid_fit[mag_index].update(_calibration[mag_index].Correct(Vector3f{sensor_mag.x, sensor_mag.y, sensor_mag.z}));
+			}
+		}
+
 		return;
 	}
 
@@ -124,6 +139,7 @@ void MagBiasEstimator::Run()
 
 			if (calibration_count != _calibration[mag_index].calibration_count()) {
 				_reset_field_estimator[mag_index] = true;
+				_ellipsoid_fit[mag_index].reset();
 			}
 
 			_bias_estimator[mag_index].setLearningGain(_param_mbe_learn_gain.get());
@@ -142,6 +158,10 @@ void MagBiasEstimator::Run()
 				for (auto &reset : _reset_field_estimator) {
 					reset = true;
 				}
+
+				for (auto &ellipsoid_fit : _ellipsoid_fit) {
+					ellipsoid_fit.reset();
+				}
 			}
 		}
 	}
@@ -174,6 +194,8 @@ void MagBiasEstimator::Run()
 
 				const Vector3f mag_calibrated = _calibration[mag_index].Correct(Vector3f{sensor_mag.x, sensor_mag.y, sensor_mag.z});
 
+				_ellipsoid_fit[mag_index].update(mag_calibrated);
+
 				float dt = (sensor_mag.timestamp_sample - _timestamp_last_update[mag_index]) * 1e-6f;
 				_timestamp_last_update[mag_index] = sensor_mag.timestamp_sample;
 
@@ -272,6 +294,21 @@ int MagBiasEstimator::print_status()
 				 (double)bias(0),
 				 (double)bias(1),
 				 (double)bias(2));
+
+			Vector3f offset;
+			Vector3f diag;
+			Vector3f offdiag;
+			float radius;
+
+			if (_ellipsoid_fit[mag_index].getCalibration(offset, diag, offdiag, radius)) {
+				PX4_INFO("%d (%" PRIu32 ") fit offset: [% 05.3f % 05.3f % 05.3f] radius: %.3f, coverage: %.0f%%",
+					 mag_index, _calibration[mag_index].device_id(),
+					 (double)offset(0),
+					 (double)offset(1),
+					 (double)offset(2),
+					 (double)radius,
+					 (double)(_ellipsoid_fit[mag_index].coverage() * 100.f));
+			}
 		}
 	}
 
@@ -288,6 +325,9 @@ int MagBiasEstimator::print_usage(const char *reason)
 		R"DESCR_STR(
 ### Description
 Online magnetometer bias estimator.
+
+Additionally an online sphere fit of the calibrated data runs continuously, also in flight, and tracks the residual offset
+(see print_status).
 )DESCR_STR");
 
 	PRINT_MODULE_USAGE_NAME("mag_bias_estimator", "system");
@@ -35,6 +35,7 @@
 
 #include <drivers/drv_hrt.h>
 #include <lib/field_sensor_bias_estimator/FieldSensorBiasEstimator.hpp>
+#include <lib/field_sensor_ellipsoid_fit/FieldSensorEllipsoidFit.hpp>
 #include <lib/mathlib/mathlib.h>
 #include <lib/perf/perf_counter.h>
 #include <lib/sensor_calibration/Magnetometer.hpp>
@@ -85,6 +86,7 @@ private:
 	static constexpr int MAX_SENSOR_COUNT = 4;
 
 	FieldSensorBiasEstimator _bias_estimator[MAX_SENSOR_COUNT];
+	FieldSensorEllipsoidFit _ellipsoid_fit[MAX_SENSOR_COUNT]; // residual offset of the calibrated data, also in flight
 	hrt_abstime _timestamp_last_update[MAX_SENSOR_COUNT] {};
 
 	uORB::SubscriptionMultiArray<sensor_mag_s, MAX_SENSOR_COUNT> _sensor_mag_subs{ORB_ID::sensor_mag};
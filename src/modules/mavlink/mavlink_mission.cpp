@@ -144,6 +144,36 @@ MavlinkMissionManager::load_safepoint_stats()
 	return ret;
 }
 
+void
+MavlinkMissionManager::begin_dataman_transaction(dm_item_t dataman_id)
+{
+	// a failed transaction is not fatal, the items are then flushed one by one
+	if (dm_transaction_begin(dataman_id) == 0) {
+		_dataman_transaction = true;
+		_dataman_transaction_id = dataman_id;
+
+	} else {
+		PX4_DEBUG("WPM: dataman transaction failed (%i)", errno);
+	}
+}
+
+int
+MavlinkMissionManager::commit_dataman_transaction()
+{
+	if (!_dataman_transaction) {
+		return PX4_OK;
+	}
+
+	_dataman_transaction = false;
+
+	if (dm_transaction_commit(_dataman_transaction_id) != 0) {
+		PX4_ERR("WPM: dataman commit failed");
+		return PX4_ERROR;
+	}
+
+	return PX4_OK;
+}
+
 /**
  * Publish mission topic to notify navigator about changes.
  */
@@ -209,7 +239,10 @@ MavlinkMissionManager::update_geofence_count(unsigned count)
 	int res = dm_write(DM_KEY_FENCE_POINTS, 0, &stats, sizeof(mission_stats_entry_s));
 
 	if (res == sizeof(mission_stats_entry_s)) {
-		_count[MAV_MISSION_TYPE_FENCE] = count;
+		// within a transaction the count is updated once the transaction is committed
+		if (!_dataman_transaction) {
+			_count[MAV_MISSION_TYPE_FENCE] = count;
+		}
 
 	} else {
 
@@ -236,7 +269,10 @@ MavlinkMissionManager::update_safepoint_count(unsigned count)
 	int res = dm_write(DM_KEY_SAFE_POINTS, 0, &stats, sizeof(mission_stats_entry_s));
 
 	if (res == sizeof(mission_stats_entry_s)) {
-		_count[MAV_MISSION_TYPE_RALLY] = count;
+		// within a transaction the count is updated once the transaction is committed
+		if (!_dataman_transaction) {
+			_count[MAV_MISSION_TYPE_RALLY] = count;
+		}
 
 	} else {
 
@@ -971,6 +1007,24 @@ MavlinkMissionManager::handle_mission_count(const mavlink_message_t *msg)
 				}
 			}
 
+			// write all items in one transaction, so that they are flushed to the storage only once
+			switch (_mission_type) {
+			case MAV_MISSION_TYPE_MISSION:
+				begin_dataman_transaction(_transfer_dataman_id);
+				break;
+
+			case MAV_MISSION_TYPE_FENCE:
+				begin_dataman_transaction(DM_KEY_FENCE_POINTS);
+				break;
+
+			case MAV_MISSION_TYPE_RALLY:
+				begin_dataman_transaction(DM_KEY_SAFE_POINTS);
+				break;
+
+			default:
+				break;
+			}
+
 		} else if (_state == MAVLINK_WPM_STATE_GETLIST) {
 			_time_last_recv = hrt_absolute_time();
 
@@ -1006,6 +1060,9 @@ MavlinkMissionManager::handle_mission_count(const mavlink_message_t *msg)
 void
 MavlinkMissionManager::switch_to_idle_state()
 {
+	// an aborted transfer still needs to close the transaction
+	commit_dataman_transaction();
+
 	// when switching to idle, we *always* check if the lock was held and release it.
 	// This is to ensure we don't end up in a state where we forget to release it.
 	if (_geofence_locked) {
@@ -1226,7 +1283,7 @@ MavlinkMissionManager::handle_mission_item_both(const mavlink_message_t *msg)
 
 			switch (_mission_type) {
 			case MAV_MISSION_TYPE_MISSION:
-				ret = update_active_mission(_transfer_dataman_id, _transfer_count, _transfer_current_seq);
+				// the mission state is a separate item, it is updated once the items are committed
 				break;
 
 			case MAV_MISSION_TYPE_FENCE:
@@ -1242,6 +1299,20 @@ MavlinkMissionManager::handle_mission_item_both(const mavlink_message_t *msg)
 				break;
 			}
 
+			// the new geofence and safe point count is committed together with the items, so that they are replaced atomically
+			if (commit_dataman_transaction() != PX4_OK) {
+				ret = PX4_ERROR;
+
+			} else if ((ret == PX4_OK)
+				   && ((_mission_type == MAV_MISSION_TYPE_FENCE) || (_mission_type == MAV_MISSION_TYPE_RALLY))) {
+				_count[_mission_type] = _transfer_count;
+			}
+
+			// the items need to be on the storage before the mission state switches to them
+			if ((ret == PX4_OK) && (_mission_type == MAV_MISSION_TYPE_MISSION)) {
+				ret = update_active_mission(_transfer_dataman_id, _transfer_count, _transfer_current_seq);
+			}
+
 			// Note: the switch to idle needs to happen after update_geofence_count is called, for proper unlocking order
 			switch_to_idle_state();
 
@@ -133,6 +133,8 @@ private:
 	static uint16_t		_geofence_update_counter;
 	static uint16_t		_safepoint_update_counter;
 	bool			_geofence_locked{false};		///< if true, we currently hold the dm_lock for the geofence (transaction in progress)
+	bool			_dataman_transaction{false};		///< if true, the items of the current transmission are written in a dataman transaction
+	dm_item_t		_dataman_transaction_id{DM_KEY_WAYPOINTS_OFFBOARD_1};	///< Dataman storage ID of the open transaction
 
 	MavlinkRateLimiter	_slow_rate_limiter{100 * 1000};		///< Rate limit sending of the current WP sequence to 10 Hz
 
@@ -173,6 +175,12 @@ private:
 	/** load safe point stats from dataman */
 	int load_safepoint_stats();
 
+	/** start writing the items of the current transmission to dataman, they are flushed once on commit */
+	void begin_dataman_transaction(dm_item_t dataman_id);
+
+	/** flush the items of the current transmission to dataman */
+	int commit_dataman_transaction();
+
 	/**
 	 *  @brief Sends an waypoint ack message
 	 */
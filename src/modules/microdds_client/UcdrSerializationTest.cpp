@@ -0,0 +1,189 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * Tests the generated CDR serialization of all messages against the field by field reference,
+ * and compares their performance (benchmark disabled by default).
+ */
+
+#include <gtest/gtest.h>
+
+#define UCDR_FIELDWISE_REFERENCE
+#include <uORB/ucdr/uORBTopics.hpp>
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static constexpr size_t MAX_SIZE = 4096;
+
+template<typename T>
+using SerializeFunction = bool (*)(const T &, ucdrBuffer &);
+
+template<typename T>
+using DeserializeFunction = bool (*)(ucdrBuffer &, T &);
+
+template<typename T>
+static void fill_random(T &topic)
+{
+	uint8_t *data = (uint8_t *)&topic;
+
+	for (size_t i = 0; i < sizeof(T); i++) {
+		data[i] = rand();
+	}
+}
+
+template<typename T>
+static bool serialize(SerializeFunction<T> function, const T &topic, uint8_t *buffer, int size)
+{
+	memset(buffer, 0, MAX_SIZE);
+	ucdrBuffer buf{};
+	ucdr_init_buffer(&buf, buffer, size);
+	return function(topic, buf) && (buf.offset == (size_t)size);
+}
+
+template<typename T>
+static bool check_serialization(const char *name, SerializeFunction<T> serialize_fast,
+				SerializeFunction<T> serialize_fieldwise, DeserializeFunction<T> deserialize, int size)
+{
+	static uint8_t fast[MAX_SIZE];
+	static uint8_t fieldwise[MAX_SIZE];
+	T topic;
+	fill_random(topic);
+
+	if ((size > (int)MAX_SIZE) || !serialize(serialize_fast, topic, fast, size)
+	    || !serialize(serialize_fieldwise, topic, fieldwise, size)) {
+		printf("%s: serialization failed\n", name);
+		return false;
+	}
+
+	if (memcmp(fast, fieldwise, size) != 0) {
+		printf("%s: serialized data differs\n", name);
+		return false;
+	}
+
+	// too small buffer
+	ucdrBuffer buf{};
+	ucdr_init_buffer(&buf, fast, size - 1);
+
+	if (serialize_fast(topic, buf)) {
+		printf("%s: buffer overflow\n", name);
+		return false;
+	}
+
+	// deserialize and serialize again
+	T deserialized{};
+	ucdr_init_buffer(&buf, fast, size);
+
+	if (!deserialize(buf, deserialized) || (buf.offset != (size_t)size)
+	    || !serialize(serialize_fieldwise, deserialized, fieldwise, size)) {
+		printf("%s: deserialization failed\n", name);
+		return false;
+	}
+
+	if (memcmp(fast, fieldwise, size) != 0) {
+		printf("%s: deserialized data differs\n", name);
+		return false;
+	}
+
+	return true;
+}
+
+template<typename T>
+static double benchmark(SerializeFunction<T> function, const T &topic, int size)
+{
+	static constexpr int N = 10000;
+	static uint8_t buffer[MAX_SIZE];
+	uint32_t checksum = 0;
+
+	const auto start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < N; i++) {
+		ucdrBuffer buf{};
+		ucdr_init_buffer(&buf, buffer, size);
+		function(topic, buf);
+		checksum += buffer[i % size];
+	}
+
+	const auto end = std::chrono::steady_clock::now();
+
+	volatile uint32_t sink = checksum;
+	(void)sink;
+
+	return std::chrono::duration<double, std::nano>(end - start).count() / N;
+}
+
+TEST(UcdrSerializationTest, AllMessages)
+{
+	srand(0);
+
+#define CHECK_MSG(msg) \
+	EXPECT_TRUE(check_serialization<msg##_s>(#msg, ucdr_serialize_##msg, ucdr_serialize_fieldwise_##msg, \
+			ucdr_deserialize_##msg, ucdr_topic_size_##msg()));
+
+	UCDR_FOR_EACH_MSG(CHECK_MSG)
+
+#undef CHECK_MSG
+}
+
+// not part of the unit tests, run with --gtest_also_run_disabled_tests
+TEST(UcdrSerializationTest, DISABLED_Benchmark)
+{
+	double total_fieldwise = 0.;
+	double total_fast = 0.;
+	int num_fields = 0;
+	int num_copies = 0;
+
+	printf("%-40s %6s %8s %14s %14s\n", "message", "size", "copies", "fieldwise ns", "memcpy ns");
+
+#define BENCHMARK_MSG(msg) \
+	{ \
+		msg##_s topic; \
+		fill_random(topic); \
+		const double fieldwise = benchmark<msg##_s>(ucdr_serialize_fieldwise_##msg, topic, ucdr_topic_size_##msg()); \
+		const double fast = benchmark<msg##_s>(ucdr_serialize_##msg, topic, ucdr_topic_size_##msg()); \
+		printf("%-40s %6d %8d %14.1f %14.1f\n", #msg, ucdr_topic_size_##msg(), ucdr_num_copies_##msg(), fieldwise, fast); \
+		total_fieldwise += fieldwise; \
+		total_fast += fast; \
+		num_fields += ucdr_num_fields_##msg(); \
+		num_copies += ucdr_num_copies_##msg(); \
+	}
+
+	UCDR_FOR_EACH_MSG(BENCHMARK_MSG)
+
+#undef BENCHMARK_MSG
+
+	printf("total: %d fields in %d copies, fieldwise: %.1f ns, memcpy: %.1f ns\n", num_fields, num_copies,
+	       total_fieldwise, total_fast);
+}
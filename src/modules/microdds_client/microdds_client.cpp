@@ -33,7 +33,6 @@
 
 #include <px4_platform_common/getopt.h>
 #include <px4_platform_common/cli.h>
-#include <uORB/topics/vehicle_imu.h>
 
 #include "microdds_client.h"
 
@@ -127,7 +126,7 @@ void MicroddsClient::run()
 		return;
 	}
 
-	int polling_topic_sub = orb_subscribe(ORB_ID(vehicle_imu));
+	apply_topic_rates();
 
 	while (!should_exit()) {
 		bool got_response = false;
@@ -220,27 +219,16 @@ void MicroddsClient::run()
 		bool had_ping_reply = false;
 		uint32_t last_num_payload_sent{};
 		uint32_t last_num_payload_received{};
-		bool error_printed = false;
+		uint32_t last_num_batches_sent{};
 		hrt_abstime last_read = hrt_absolute_time();
 
 		while (!should_exit() && _connected) {
-			px4_pollfd_struct_t fds[1];
-			fds[0].fd = polling_topic_sub;
-			fds[0].events = POLLIN;
+			// woken up by the publications of the sent topics (respecting their rate limit)
 			// we could poll on the uart/udp fd as well (on nuttx)
-			int pret = px4_poll(fds, 1, 20);
+			_subs->wait(WAKEUP_TIMEOUT_US);
 
-			if (pret < 0) {
-				if (!error_printed) {
-					PX4_ERR("poll failed (%i)", pret);
-					error_printed = true;
-				}
-
-			} else if (pret != 0) {
-				if (fds[0].revents & POLLIN) {
-					vehicle_imu_s data;
-					orb_copy(ORB_ID(vehicle_imu), polling_topic_sub, &data);
-				}
+			if (_topic_interval_changed.load()) {
+				apply_topic_rates();
 			}
 
 			_subs->update(data_out);
@@ -270,8 +258,11 @@ void MicroddsClient::run()
 				float dt = (now - last_status_update) / 1e6f;
 				_last_payload_tx_rate = (_subs->num_payload_sent - last_num_payload_sent) / dt;
 				_last_payload_rx_rate = (_pubs->num_payload_received - last_num_payload_received) / dt;
+				_last_batch_tx_rate = (_subs->num_batches_sent - last_num_batches_sent) / dt;
 				last_num_payload_sent = _subs->num_payload_sent;
 				last_num_payload_received = _pubs->num_payload_received;
+				last_num_batches_sent = _subs->num_batches_sent;
+				_subs->update_rates(dt);
 				last_status_update = now;
 			}
 
@@ -298,10 +289,9 @@ void MicroddsClient::run()
 
 		uxr_delete_session_retries(&session, _connected ? 1 : 0);
 		_last_payload_tx_rate = 0;
-		_last_payload_tx_rate = 0;
+		_last_payload_rx_rate = 0;
+		_last_batch_tx_rate = 0;
 	}
-
-	orb_unsubscribe(polling_topic_sub);
 }
 
 int MicroddsClient::setBaudrate(int fd, unsigned baud)
@@ -407,9 +397,49 @@ int microdds_client_main(int argc, char *argv[])
 
 int MicroddsClient::custom_command(int argc, char *argv[])
 {
+	if (!is_running()) {
+		PX4_INFO("not running");
+		return PX4_ERROR;
+	}
+
+	if ((argc >= 3) && (strcmp(argv[0], "rate") == 0)) {
+		return get_instance()->set_topic_rate(argv[1], strtof(argv[2], nullptr));
+	}
+
 	return print_usage("unknown command");
 }
 
+int MicroddsClient::set_topic_rate(const char *topic_name, float rate)
+{
+	const int index = SendTopicsSubs::topic_index(topic_name);
+
+	if (index < 0) {
+		PX4_ERR("%s is not sent", topic_name);
+		return PX4_ERROR;
+	}
+
+	if (!PX4_ISFINITE(rate) || (rate < 0.f)) {
+		PX4_ERR("invalid rate");
+		return PX4_ERROR;
+	}
+
+	// the subscriptions are only accessed by the client task, it applies the new interval
+	_topic_interval_us[index].store((rate > 0.f) ? (uint32_t)(1e6f / rate) : 0);
+	_topic_interval_changed.store(true);
+
+	return PX4_OK;
+}
+
+void MicroddsClient::apply_topic_rates()
+{
+	// cleared first, a concurrent change is applied on the next iteration
+	_topic_interval_changed.store(false);
+
+	for (int i = 0; i < SendTopicsSubs::NUM_TOPICS; i++) {
+		_subs->set_interval_us(i, _topic_interval_us[i].load());
+	}
+}
+
 int MicroddsClient::task_spawn(int argc, char *argv[])
 {
 	_task_id = px4_task_spawn_cmd("microdds_client",
@@ -432,6 +462,12 @@ int MicroddsClient::print_status()
 	PX4_INFO("Running, %s", _connected ? "connected" : "disconnected");
 	PX4_INFO("Payload tx: %i B/s", _last_payload_tx_rate);
 	PX4_INFO("Payload rx: %i B/s", _last_payload_rx_rate);
+	PX4_INFO("Batches tx: %i Hz", _last_batch_tx_rate);
+
+	if (_subs) {
+		_subs->print_status();
+	}
+
 	return 0;
 }
 
@@ -528,6 +564,10 @@ MicroDDS Client used to communicate uORB topics with an Agent over serial or UDP
 ### Examples
 $ microdds_client start -t serial -d /dev/ttyS3 -b 921600
 $ microdds_client start -t udp -h 127.0.0.1 -p 15555
+
+The sent topics are serviced on every publication and batched into a single XRCE message.
+Their rate can be limited per topic:
+$ microdds_client rate sensor_combined 50
 )DESCR_STR");
 
 	PRINT_MODULE_USAGE_NAME("microdds_client", "system");
@@ -538,6 +578,8 @@ $ microdds_client start -t udp -h 127.0.0.1 -p 15555
 	PRINT_MODULE_USAGE_PARAM_STRING('h', "127.0.0.1", "<IP>", "Host IP", true);
 	PRINT_MODULE_USAGE_PARAM_INT('p', 15555, 0, 3000000, "Remote Port", true);
 	PRINT_MODULE_USAGE_PARAM_FLAG('l', "Restrict to localhost (use in combination with ROS_LOCALHOST_ONLY=1)", true);
+	PRINT_MODULE_USAGE_COMMAND_DESCR("rate", "Limit the rate of a sent topic");
+	PRINT_MODULE_USAGE_ARG("<topic> <rate>", "Topic name and rate in Hz (0 = every publication)", false);
 	PRINT_MODULE_USAGE_DEFAULT_COMMANDS();
 
 	return 0;
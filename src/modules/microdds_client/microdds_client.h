@@ -33,6 +33,7 @@
 
 #pragma once
 
+#include <px4_platform_common/atomic.h>
 #include <px4_platform_common/module.h>
 
 #include <src/modules/micrortps_bridge/micrortps_client/dds_topics.h>
@@ -71,9 +72,20 @@ public:
 	/** @see ModuleBase::print_status() */
 	int print_status() override;
 
+	/**
+	 * Limit the rate at which a topic is sent.
+	 * @param rate in Hz, 0 to send every publication
+	 */
+	int set_topic_rate(const char *topic_name, float rate);
+
 private:
 	int setBaudrate(int fd, unsigned baud);
 
+	/** hand the topic intervals requested by set_topic_rate() over to the subscriptions */
+	void apply_topic_rates();
+
+	static constexpr uint32_t WAKEUP_TIMEOUT_US = 5000; ///< to service the received data without publications
+
 	const bool _localhost_only;
 
 	SendTopicsSubs *_subs{nullptr};
@@ -86,6 +98,11 @@ private:
 
 	int _last_payload_tx_rate{}; ///< in B/s
 	int _last_payload_rx_rate{}; ///< in B/s
+	int _last_batch_tx_rate{}; ///< in Hz
+
+	/// requested by set_topic_rate(), applied to the subscriptions by the client loop
+	px4::atomic<uint32_t> _topic_interval_us[SendTopicsSubs::NUM_TOPICS] {};
+	px4::atomic_bool _topic_interval_changed{false};
 	bool _connected{false};
 };
 
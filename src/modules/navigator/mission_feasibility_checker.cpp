@@ -60,6 +60,9 @@ MissionFeasibilityChecker::checkMissionFeasible(const mission_s &mission,
 	// Reset warning flag
 	_navigator->get_mission_result()->warning = false;
 
+	// The mission might have changed since the last check
+	_item_buffer_count = 0;
+
 	// trivial case: A mission with length zero cannot be valid
 	if ((int)mission.count <= 0) {
 		return false;
@@ -101,6 +104,34 @@ MissionFeasibilityChecker::checkMissionFeasible(const mission_s &mission,
 	return !failed;
 }
 
+bool
+MissionFeasibilityChecker::readMissionItem(const mission_s &mission, size_t index, mission_item_s &mission_item)
+{
+	if ((_item_buffer_count == 0) || (_item_buffer_dataman_id != mission.dataman_id)
+	    || (index < _item_buffer_start) || (index >= _item_buffer_start + _item_buffer_count)) {
+
+		if (index >= mission.count) {
+			return false;
+		}
+
+		const unsigned num_items = math::min((unsigned)(mission.count - index), ITEM_BUFFER_SIZE);
+		const ssize_t ret = dm_read_range((dm_item_t)mission.dataman_id, index, num_items, _item_buffer,
+						  sizeof(mission_item_s));
+
+		if (ret <= 0) {
+			_item_buffer_count = 0;
+			return false;
+		}
+
+		_item_buffer_start = index;
+		_item_buffer_count = ret;
+		_item_buffer_dataman_id = mission.dataman_id;
+	}
+
+	mission_item = _item_buffer[index - _item_buffer_start];
+	return true;
+}
+
 bool
 MissionFeasibilityChecker::checkRotarywing(const mission_s &mission, float home_alt)
 {
@@ -147,9 +178,8 @@ MissionFeasibilityChecker::checkGeofence(const mission_s &mission, float home_al
 	if (_navigator->get_geofence().valid()) {
 		for (size_t i = 0; i < mission.count; i++) {
 			struct mission_item_s missionitem = {};
-			const ssize_t len = sizeof(missionitem);
 
-			if (dm_read((dm_item_t)mission.dataman_id, i, &missionitem, len) != len) {
+			if (!readMissionItem(mission, i, missionitem)) {
 				/* not supposed to happen unless the datamanager can't access the SD card, etc. */
 				return false;
 			}
@@ -184,9 +214,8 @@ MissionFeasibilityChecker::checkHomePositionAltitude(const mission_s &mission, f
 	/* Check if all waypoints are above the home altitude */
 	for (size_t i = 0; i < mission.count; i++) {
 		struct mission_item_s missionitem = {};
-		const ssize_t len = sizeof(struct mission_item_s);
 
-		if (dm_read((dm_item_t)mission.dataman_id, i, &missionitem, len) != len) {
+		if (!readMissionItem(mission, i, missionitem)) {
 			_navigator->get_mission_result()->warning = true;
 			/* not supposed to happen unless the datamanager can't access the SD card, etc. */
 			return false;
@@ -227,9 +256,8 @@ MissionFeasibilityChecker::checkMissionItemValidity(const mission_s &mission)
 	// do not allow mission if we find unsupported item
 	for (size_t i = 0; i < mission.count; i++) {
 		struct mission_item_s missionitem;
-		const ssize_t len = sizeof(struct mission_item_s);
 
-		if (dm_read((dm_item_t)mission.dataman_id, i, &missionitem, len) != len) {
+		if (!readMissionItem(mission, i, missionitem)) {
 			// not supposed to happen unless the datamanager can't access the SD card, etc.
 			mavlink_log_critical(_navigator->get_mavlink_log_pub(), "Mission rejected: Cannot access SD card\t");
 			events::send(events::ID("navigator_mis_sd_failure"), events::Log::Error,
@@ -330,9 +358,8 @@ MissionFeasibilityChecker::checkTakeoff(const mission_s &mission, float home_alt
 
 	for (size_t i = 0; i < mission.count; i++) {
 		struct mission_item_s missionitem = {};
-		const ssize_t len = sizeof(struct mission_item_s);
 
-		if (dm_read((dm_item_t)mission.dataman_id, i, &missionitem, len) != len) {
+		if (!readMissionItem(mission, i, missionitem)) {
 			/* not supposed to happen unless the datamanager can't access the SD card, etc. */
 			return false;
 		}
@@ -385,9 +412,8 @@ MissionFeasibilityChecker::checkTakeoff(const mission_s &mission, float home_alt
 		// one of the bellow mission items
 		for (size_t i = 0; i < (size_t)takeoff_index; i++) {
 			struct mission_item_s missionitem = {};
-			const ssize_t len = sizeof(struct mission_item_s);
 
-			if (dm_read((dm_item_t)mission.dataman_id, i, &missionitem, len) != len) {
+			if (!readMissionItem(mission, i, missionitem)) {
 				/* not supposed to happen unless the datamanager can't access the SD card, etc. */
 				return false;
 			}
@@ -463,9 +489,8 @@ MissionFeasibilityChecker::checkFixedWingLanding(const mission_s &mission, bool
 
 	for (size_t i = 0; i < mission.count; i++) {
 		struct mission_item_s missionitem;
-		const ssize_t len = sizeof(missionitem);
 
-		if (dm_read((dm_item_t)mission.dataman_id, i, &missionitem, len) != len) {
+		if (!readMissionItem(mission, i, missionitem)) {
 			/* not supposed to happen unless the datamanager can't access the SD card, etc. */
 			return false;
 		}
@@ -503,7 +528,7 @@ MissionFeasibilityChecker::checkFixedWingLanding(const mission_s &mission, bool
 			if (i > 0) {
 				landing_approach_index = i - 1;
 
-				if (dm_read((dm_item_t)mission.dataman_id, landing_approach_index, &missionitem_previous, len) != len) {
+				if (!readMissionItem(mission, landing_approach_index, missionitem_previous)) {
 					/* not supposed to happen unless the datamanager can't access the SD card, etc. */
 					return false;
 				}
@@ -652,9 +677,8 @@ MissionFeasibilityChecker::checkVTOLLanding(const mission_s &mission, bool land_
 
 	for (size_t i = 0; i < mission.count; i++) {
 		struct mission_item_s missionitem;
-		const ssize_t len = sizeof(missionitem);
 
-		if (dm_read((dm_item_t)mission.dataman_id, i, &missionitem, len) != len) {
+		if (!readMissionItem(mission, i, missionitem)) {
 			/* not supposed to happen unless the datamanager can't access the SD card, etc. */
 			return false;
 		}
@@ -679,7 +703,7 @@ MissionFeasibilityChecker::checkVTOLLanding(const mission_s &mission, bool land_
 			if (i > 0) {
 				landing_approach_index = i - 1;
 
-				if (dm_read((dm_item_t)mission.dataman_id, landing_approach_index, &missionitem_previous, len) != len) {
+				if (!readMissionItem(mission, landing_approach_index, missionitem_previous)) {
 					/* not supposed to happen unless the datamanager can't access the SD card, etc. */
 					return false;
 				}
@@ -734,7 +758,7 @@ MissionFeasibilityChecker::checkDistanceToFirstWaypoint(const mission_s &mission
 
 		struct mission_item_s mission_item {};
 
-		if (!(dm_read((dm_item_t)mission.dataman_id, i, &mission_item, sizeof(mission_item_s)) == sizeof(mission_item_s))) {
+		if (!readMissionItem(mission, i, mission_item)) {
 			/* error reading, mission is invalid */
 			mavlink_log_info(_navigator->get_mavlink_log_pub(), "Error reading offboard mission.\t");
 			events::send(events::ID("navigator_mis_storage_failure"), events::Log::Error,
@@ -790,7 +814,7 @@ MissionFeasibilityChecker::checkDistancesBetweenWaypoints(const mission_s &missi
 
 		struct mission_item_s mission_item {};
 
-		if (!(dm_read((dm_item_t)mission.dataman_id, i, &mission_item, sizeof(mission_item_s)) == sizeof(mission_item_s))) {
+		if (!readMissionItem(mission, i, mission_item)) {
 			/* error reading, mission is invalid */
 			mavlink_log_info(_navigator->get_mavlink_log_pub(), "Error reading offboard mission.\t");
 			events::send(events::ID("navigator_mis_storage_failure2"), events::Log::Error,
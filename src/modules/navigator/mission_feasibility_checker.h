@@ -54,6 +54,16 @@ class MissionFeasibilityChecker: public ModuleParams
 private:
 	Navigator *_navigator{nullptr};
 
+	/* Mission items are read from dataman in chunks, as every check iterates over the whole mission */
+	static constexpr unsigned ITEM_BUFFER_SIZE = 8;
+	mission_item_s _item_buffer[ITEM_BUFFER_SIZE] {};
+	unsigned _item_buffer_start{0};
+	unsigned _item_buffer_count{0};
+	uint8_t _item_buffer_dataman_id{0};
+
+	/* Read a mission item, the following items are fetched in the same dataman request */
+	bool readMissionItem(const mission_s &mission, size_t index, mission_item_s &mission_item);
+
 	/* Checks for all airframes */
 	bool checkGeofence(const mission_s &mission, float home_alt, bool home_valid);
 
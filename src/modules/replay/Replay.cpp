@@ -48,6 +48,8 @@
 #include <px4_platform_common/shutdown.h>
 #include <lib/parameters/param.h>
 
+#include <algorithm>
+#include <chrono>
 #include <cstring>
 #include <float.h>
 #include <fstream>
@@ -244,7 +246,6 @@ Replay::readFileDefinitions(std::ifstream &file)
 			break;
 
 		case (int)ULogMessageType::ADD_LOGGED_MSG:
-			_data_section_start = file.tellg() - (streamoff)ULOG_MSG_HEADER_LEN;
 			return true;
 
 		case (int)ULogMessageType::INFO: //skip
@@ -303,8 +304,8 @@ Replay::readFlagBits(std::ifstream &file, uint16_t msg_size)
 
 		if (appended_offsets[0] > 0) {
 			// the appended data is currently only used for hardfault dumps, so it's safe to ignore it.
+			// It is not indexed.
 			PX4_INFO("Log contains appended data. Replay will ignore this data");
-			_read_until_file_position = appended_offsets[0];
 		}
 	}
 
@@ -338,62 +339,45 @@ Replay::readFormat(std::ifstream &file, uint16_t msg_size)
 }
 
 
-string Replay::parseOrbFields(const string &fields)
+string Replay::parseOrbFields(const orb_metadata *meta)
 {
 	string ret{};
 
-	// convert o_fields from "<chr> timestamp;<chr>[5] array;" to "uint64_t timestamp;int8_t[5] array;"
-	for (int format_idx = 0; format_idx < (int)fields.length();) {
-		const char *end_field = strchr(fields.c_str() + format_idx, ';');
+	// convert the fields to "uint64_t timestamp;int8_t[5] array;"
+	orb_field_iterator it;
+	orb_field_iterator_init(&it, meta);
+	orb_field_descriptor field;
+	char field_format[128];
 
-		if (!end_field) {
-			PX4_ERR("Format error in %s", fields.c_str());
-			return "";
-		}
-
-		const char *c_type = orb_get_c_type(fields[format_idx]);
+	while (orb_next_field(&it, &field)) {
+		const int len = orb_get_field_format(meta, &field, field_format, sizeof(field_format));
 
-		if (c_type) {
-			string str_type = c_type;
-			ret += str_type;
-			++format_idx;
+		if (len < 0 || len >= (int)sizeof(field_format)) {
+			PX4_ERR("Format error in %s", meta->o_name);
+			return "";
 		}
 
-		int len = end_field - (fields.c_str() + format_idx) + 1;
-		ret += fields.substr(format_idx, len);
-		format_idx += len;
+		ret.append(field_format, len);
 	}
 
 	return ret;
 }
 
-bool
-Replay::readAndAddSubscription(std::ifstream &file, uint16_t msg_size)
+void
+Replay::addSubscription(const uint8_t *message, uint16_t msg_size)
 {
-	_read_buffer.reserve(msg_size + 1);
-	char *message = (char *)_read_buffer.data();
-	streampos this_message_pos = file.tellg() - (streamoff)ULOG_MSG_HEADER_LEN;
-	file.read(message, msg_size);
-	message[msg_size] = 0;
-
-	if (!file) {
-		return false;
-	}
-
-	if (file.tellg() <= _subscription_file_pos) { //already read this subscription
-		return true;
+	if (msg_size <= 3) {
+		return;
 	}
 
-	_subscription_file_pos = file.tellg();
-
-	uint8_t multi_id = *(uint8_t *)message;
+	uint8_t multi_id = message[0];
 	uint16_t msg_id = ((uint16_t) message[1]) | (((uint16_t) message[2]) << 8);
-	string topic_name(message + 3);
+	string topic_name((const char *)message + 3, strnlen((const char *)message + 3, msg_size - 3));
 	const orb_metadata *orb_meta = findTopic(topic_name);
 
 	if (!orb_meta) {
 		PX4_WARN("Topic %s not found internally. Will ignore it", topic_name.c_str());
-		return true;
+		return;
 	}
 
 	CompatBase *compat = nullptr;
@@ -402,7 +386,7 @@ Replay::readAndAddSubscription(std::ifstream &file, uint16_t msg_size)
 	// FIXME: this should check recursively, all used nested types
 	string file_format = _file_formats[topic_name];
 
-	const string orb_fields = parseOrbFields(orb_meta->o_fields);
+	const string orb_fields = parseOrbFields(orb_meta);
 
 	if (file_format != orb_fields) {
 		// check if we have a compatibility conversion available
@@ -469,7 +453,7 @@ Replay::readAndAddSubscription(std::ifstream &file, uint16_t msg_size)
 				}
 			}
 
-			return true; // not a fatal error
+			return; // not a fatal error
 		}
 	}
 
@@ -484,30 +468,22 @@ Replay::readAndAddSubscription(std::ifstream &file, uint16_t msg_size)
 
 	if (!timestamp_found) {
 		delete subscription;
-		return true;
+		return;
 	}
 
 	if (field_size != 8) {
 		PX4_ERR("Unsupported timestamp with size %i, ignoring the topic %s", field_size, orb_meta->o_name);
 		delete subscription;
-		return true;
+		return;
 	}
 
 	//find first data message (and the timestamp)
-	streampos cur_pos = file.tellg();
-	subscription->next_read_pos = this_message_pos; //this will be skipped
-
-	if (!nextDataMessage(file, *subscription, msg_id)) {
-		delete subscription;
-		return false;
-	}
+	subscription->next_index = 0;
 
-	file.seekg(cur_pos);
-
-	if (!subscription->orb_meta) {
+	if (!readDataMessage(*subscription, msg_id) && !nextDataMessage(*subscription, msg_id)) {
 		//no message found. This is not a fatal error
 		delete subscription;
-		return true;
+		return;
 	}
 
 	PX4_DEBUG("adding subscription for %s (msg_id %i)", subscription->orb_meta->o_name, msg_id);
@@ -517,11 +493,10 @@ Replay::readAndAddSubscription(std::ifstream &file, uint16_t msg_size)
 		_subscriptions.resize(msg_id + 1);
 	}
 
+	delete _subscriptions[msg_id];
 	_subscriptions[msg_id] = subscription;
 
 	onSubscriptionAdded(*_subscriptions[msg_id], msg_id);
-
-	return true;
 }
 
 bool
@@ -555,37 +530,50 @@ Replay::findFieldOffset(const string &format, const string &field_name, int &off
 	return false;
 }
 
-bool
-Replay::readAndHandleAdditionalMessages(std::ifstream &file, std::streampos end_position)
+void
+Replay::handleAdditionalMessages(uint64_t end_offset)
 {
-	ulog_message_header_s message_header;
+	const std::vector<uint64_t> &additional_messages = _index.additionalMessages();
 
-	while (file.tellg() < end_position) {
-		file.read((char *)&message_header, ULOG_MSG_HEADER_LEN);
+	for (; _next_additional_message < additional_messages.size(); ++_next_additional_message) {
+		const uint64_t offset = additional_messages[_next_additional_message];
 
-		if (!file) {
-			return false;
+		if (offset >= end_offset) {
+			break;
 		}
 
-		switch (message_header.msg_type) {
-		case (int)ULogMessageType::PARAMETER:
-			if (!readAndApplyParameter(file, message_header.msg_size)) {
-				return false;
-			}
+		uint8_t msg_type;
+		uint16_t msg_size;
+		_index.messageHeader(offset, msg_type, msg_size);
+		const uint8_t *message = _index.messagePayload(offset);
 
+		switch (msg_type) {
+		case (int)ULogMessageType::PARAMETER:
+			applyParameter(message, msg_size);
 			break;
 
 		case (int)ULogMessageType::DROPOUT:
-			readDropout(file, message_header.msg_size);
+			if (msg_size >= sizeof(uint16_t)) {
+				uint16_t duration;
+				memcpy(&duration, message, sizeof(duration));
+				PX4_ERR("Dropout in replayed log, %i ms", (int)duration);
+			}
+
 			break;
 
-		default: //skip all others
-			file.seekg(message_header.msg_size, ios::cur);
+		default:
 			break;
 		}
 	}
+}
 
-	return true;
+void
+Replay::skipAdditionalMessages(uint64_t end_offset)
+{
+	const std::vector<uint64_t> &additional_messages = _index.additionalMessages();
+
+	_next_additional_message = std::lower_bound(additional_messages.begin(), additional_messages.end(), end_offset)
+				   - additional_messages.begin();
 }
 
 bool
@@ -599,7 +587,18 @@ Replay::readAndApplyParameter(std::ifstream &file, uint16_t msg_size)
 		return false;
 	}
 
+	return applyParameter(message, msg_size);
+}
+
+bool
+Replay::applyParameter(const uint8_t *message, uint16_t msg_size)
+{
 	uint8_t key_len = message[0];
+
+	if (1 + key_len + sizeof(int32_t) > msg_size) {
+		return false;
+	}
+
 	string key((char *)message + 1, key_len);
 
 	size_t pos = key.find(' ');
@@ -630,100 +629,46 @@ Replay::readAndApplyParameter(std::ifstream &file, uint16_t msg_size)
 	return true;
 }
 
-bool
-Replay::readDropout(std::ifstream &file, uint16_t msg_size)
-{
-	uint16_t duration;
-	file.read((char *)&duration, sizeof(duration));
-
-	PX4_ERR("Dropout in replayed log, %i ms", (int)duration);
-	return file.good();
-}
 
 bool
-Replay::nextDataMessage(std::ifstream &file, Subscription &subscription, int msg_id)
+Replay::readDataMessage(Subscription &subscription, uint16_t msg_id)
 {
-	ulog_message_header_s message_header;
-	file.seekg(subscription.next_read_pos);
-	//ignore the first message (it's data we already read)
-	file.read((char *)&message_header, ULOG_MSG_HEADER_LEN);
+	// a subscription might have no (more) data messages
+	const ULogIndex::DataMessage *data_message = _index.dataMessage(msg_id, subscription.next_index);
 
-	if (file) {
-		file.seekg(message_header.msg_size, ios::cur);
+	if (!data_message) {
+		return false;
 	}
 
-	uint16_t file_msg_id;
-	bool done = false;
-
-	while (file && !done) {
-		streampos cur_pos = file.tellg();
-		file.read((char *)&message_header, ULOG_MSG_HEADER_LEN);
-
-		if (!file) {
-			break;
-		}
-
-		if (((streamoff)cur_pos) + ULOG_MSG_HEADER_LEN + message_header.msg_size > _read_until_file_position) {
-			file.setstate(std::ios::eofbit);
-			break;
-		}
-
-		switch (message_header.msg_type) {
-		case (int)ULogMessageType::ADD_LOGGED_MSG:
-			readAndAddSubscription(file, message_header.msg_size);
-			break;
-
-		case (int)ULogMessageType::DATA:
-			file.read((char *)&file_msg_id, sizeof(file_msg_id));
-
-			if (file) {
-				if (msg_id == file_msg_id) {
-					if (message_header.msg_size == subscription.orb_meta->o_size_no_padding + 2) {
-						subscription.next_read_pos = cur_pos;
-						file.seekg(subscription.timestamp_offset, ios::cur);
-						file.read((char *)&subscription.next_timestamp, sizeof(subscription.next_timestamp));
-						done = true;
-
-					} else { //sanity check failed!
-						PX4_ERR("data message %s has wrong size %i (expected %i). Skipping",
-							subscription.orb_meta->o_name, message_header.msg_size,
-							subscription.orb_meta->o_size_no_padding + 2);
-						file.seekg(message_header.msg_size - sizeof(file_msg_id), ios::cur);
-					}
+	uint8_t msg_type;
+	uint16_t msg_size;
+	_index.messageHeader(data_message->offset, msg_type, msg_size);
 
-				} else { //not the one we are looking for
-					file.seekg(message_header.msg_size - sizeof(file_msg_id), ios::cur);
-				}
-			}
+	if (msg_size != subscription.orb_meta->o_size_no_padding + 2) { //sanity check failed!
+		PX4_ERR("data message %s has wrong size %i (expected %i). Skipping",
+			subscription.orb_meta->o_name, msg_size, subscription.orb_meta->o_size_no_padding + 2);
+		return false;
+	}
 
-			break;
+	subscription.next_read_pos = data_message->offset;
+	subscription.next_timestamp = data_message->timestamp;
+	return true;
+}
 
-		case (int)ULogMessageType::REMOVE_LOGGED_MSG: //skip these
-		case (int)ULogMessageType::PARAMETER:
-		case (int)ULogMessageType::DROPOUT:
-		case (int)ULogMessageType::INFO:
-		case (int)ULogMessageType::INFO_MULTIPLE:
-		case (int)ULogMessageType::SYNC:
-		case (int)ULogMessageType::LOGGING:
-		case (int)ULogMessageType::PARAMETER_DEFAULT:
-			file.seekg(message_header.msg_size, ios::cur);
-			break;
+bool
+Replay::nextDataMessage(Subscription &subscription, uint16_t msg_id)
+{
+	const size_t num_messages = _index.dataMessages(msg_id).size();
 
-		default:
-			//this really should not happen
-			PX4_ERR("unknown log message type %i, size %i (offset %i)",
-				(int)message_header.msg_type, (int)message_header.msg_size, (int)file.tellg());
-			file.seekg(message_header.msg_size, ios::cur);
-			break;
+	while (++subscription.next_index < num_messages) {
+		if (readDataMessage(subscription, msg_id)) {
+			return true;
 		}
 	}
 
-	if (file.eof()) { //no more data messages for this subscription
-		subscription.orb_meta = nullptr;
-		file.clear();
-	}
-
-	return file.good();
+	//no more data messages for this subscription
+	subscription.orb_meta = nullptr;
+	return false;
 }
 
 const orb_metadata *
@@ -829,6 +774,42 @@ Replay::readDefinitionsAndApplyParams(std::ifstream &file)
 	return true;
 }
 
+bool
+Replay::openIndex()
+{
+	if (!_index.open(_replay_file)) {
+		PX4_ERR("Failed to map replay file");
+		return false;
+	}
+
+	const char *index_cache = getenv(replay::ENV_INDEX_CACHE);
+	const bool use_index_cache = index_cache && strcmp(index_cache, "1") == 0;
+	const string index_file_name = string(_replay_file) + ".index";
+
+	if (use_index_cache && _index.load(index_file_name.c_str())) {
+		PX4_INFO("Loaded index from %s", index_file_name.c_str());
+		return true;
+	}
+
+	// throughput is measured in wall-clock time (hrt is driven by the replay in lockstep)
+	const auto index_start = std::chrono::steady_clock::now();
+
+	if (!_index.build()) {
+		PX4_ERR("Failed to index replay file");
+		return false;
+	}
+
+	const double index_duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - index_start).count();
+	PX4_INFO("Indexed %zu data messages (%.1lf MB) in %.3lf s (%.1lf MB/s)", _index.numDataMessages(),
+		 (double)_index.indexedSize() / 1.e6, index_duration, (double)_index.indexedSize() / 1.e6 / index_duration);
+
+	if (use_index_cache && !_index.save(index_file_name.c_str())) {
+		PX4_WARN("Failed to store index to %s", index_file_name.c_str());
+	}
+
+	return true;
+}
+
 void
 Replay::run()
 {
@@ -838,6 +819,12 @@ Replay::run()
 		return;
 	}
 
+	replay_file.close();
+
+	if (!openIndex()) {
+		return;
+	}
+
 	_speed_factor = 1.f;
 	const char *speedup = getenv("PX4_SIM_SPEED_FACTOR");
 
@@ -845,81 +832,71 @@ Replay::run()
 		_speed_factor = atof(speedup);
 	}
 
+	for (uint64_t offset : _index.subscriptionMessages()) {
+		uint8_t msg_type;
+		uint16_t msg_size;
+		_index.messageHeader(offset, msg_type, msg_size);
+		addSubscription(_index.messagePayload(offset), msg_size);
+	}
+
 	onEnterMainLoop();
 
 	_replay_start_time = hrt_absolute_time();
+	const auto replay_start_wall_time = std::chrono::steady_clock::now();
 
 	PX4_INFO("Replay in progress...");
 
-	ulog_message_header_s message_header;
-	replay_file.seekg(_data_section_start);
+	//Messages from different subscriptions don't need to be in chronological order, so the cursor
+	//merges the data messages of all subscriptions that are published in the main loop
+	ULogIndex::Cursor cursor(_index);
 
-	//we know the next message must be an ADD_LOGGED_MSG
-	replay_file.read((char *)&message_header, ULOG_MSG_HEADER_LEN);
+	for (size_t i = 0; i < _subscriptions.size(); ++i) {
+		const Subscription *subscription = _subscriptions[i];
 
-	if (!readAndAddSubscription(replay_file, message_header.msg_size)) {
-		PX4_ERR("Failed to read subscription");
-		return;
+		if (subscription && subscription->orb_meta && !subscription->ignored) {
+			cursor.add(i, subscription->next_index);
+		}
 	}
 
 	const uint64_t timestamp_offset = getTimestampOffset();
 	uint32_t nr_published_messages = 0;
-	streampos last_additional_message_pos = _data_section_start;
-
-	while (!should_exit() && replay_file) {
-
-		//Find the next message to publish. Messages from different subscriptions don't need
-		//to be in chronological order, so we need to check all subscriptions
-		uint64_t next_file_time = 0;
-		int next_msg_id = -1;
-		bool first_time = true;
+	uint16_t next_msg_id;
+	size_t next_index;
 
-		for (size_t i = 0; i < _subscriptions.size(); ++i) {
-			const Subscription *subscription = _subscriptions[i];
+	while (!should_exit() && cursor.next(next_msg_id, next_index)) {
 
-			if (!subscription) {
-				continue;
-			}
+		Subscription &sub = *_subscriptions[next_msg_id];
 
-			if (subscription->orb_meta && !subscription->ignored) {
-				if (first_time || subscription->next_timestamp < next_file_time) {
-					first_time = false;
-					next_msg_id = (int)i;
-					next_file_time = subscription->next_timestamp;
-				}
-			}
+		if (!sub.orb_meta) {
+			continue;
 		}
 
-		if (next_msg_id == -1) {
-			break; //no active subscription anymore. We're done.
+		sub.next_index = next_index;
+
+		if (!readDataMessage(sub, next_msg_id)) {
+			continue;
 		}
 
-		Subscription &sub = *_subscriptions[next_msg_id];
+		const uint64_t next_file_time = sub.next_timestamp;
 
 		if (next_file_time == 0) {
 			//someone didn't set the timestamp properly. Consider the message invalid
-			nextDataMessage(replay_file, sub, next_msg_id);
 			continue;
 		}
 
 		//handle additional messages between last and next published data
-		replay_file.seekg(last_additional_message_pos);
-		streampos next_additional_message_pos = sub.next_read_pos;
-		readAndHandleAdditionalMessages(replay_file, next_additional_message_pos);
-		last_additional_message_pos = next_additional_message_pos;
+		handleAdditionalMessages(sub.next_read_pos);
 
 		const uint64_t publish_timestamp = handleTopicDelay(next_file_time, timestamp_offset);
 
 		// It's time to publish
-		readTopicDataToBuffer(sub, replay_file);
+		readTopicDataToBuffer(sub);
 		memcpy(_read_buffer.data() + sub.timestamp_offset, &publish_timestamp, sizeof(uint64_t)); //adjust the timestamp
 
-		if (handleTopicUpdate(sub, _read_buffer.data(), replay_file)) {
+		if (handleTopicUpdate(sub, _read_buffer.data())) {
 			++nr_published_messages;
 		}
 
-		nextDataMessage(replay_file, sub, next_msg_id);
-
 		// TODO: output status (eg. every sec), including total duration...
 	}
 
@@ -940,14 +917,17 @@ Replay::run()
 	}
 
 	if (!should_exit()) {
-		PX4_INFO("Replay done (published %u msgs, %.3lf s)", nr_published_messages,
-			 (double)hrt_elapsed_time(&_replay_start_time) / 1.e6);
+		const double wall_time = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+					 replay_start_wall_time).count();
+		PX4_INFO("Replay done (published %u msgs, %.3lf s, %.1lf MB/s)", nr_published_messages,
+			 (double)hrt_elapsed_time(&_replay_start_time) / 1.e6, (double)_index.indexedSize() / 1.e6 / wall_time);
 	}
 
 	onExitMainLoop();
 
-	if (!should_exit()) {
-		replay_file.close();
+	_index.close();
+
+	if (!should_exit() && shutdownWhenDone()) {
 		px4_shutdown_request();
 		// we need to ensure the shutdown logic gets updated and eventually triggers shutdown
 		hrt_abstime t = hrt_absolute_time();
@@ -962,17 +942,16 @@ Replay::run()
 }
 
 void
-Replay::readTopicDataToBuffer(const Subscription &sub, std::ifstream &replay_file)
+Replay::readTopicDataToBuffer(const Subscription &sub)
 {
 	const size_t msg_read_size = sub.orb_meta->o_size_no_padding;
 	const size_t msg_write_size = sub.orb_meta->o_size;
 	_read_buffer.reserve(msg_write_size);
-	replay_file.seekg(sub.next_read_pos + (streamoff)(ULOG_MSG_HEADER_LEN + 2)); //skip header & msg id
-	replay_file.read((char *)_read_buffer.data(), msg_read_size);
+	memcpy(_read_buffer.data(), _index.messagePayload(sub.next_read_pos) + 2, msg_read_size); //skip msg id
 }
 
 bool
-Replay::handleTopicUpdate(Subscription &sub, void *data, std::ifstream &replay_file)
+Replay::handleTopicUpdate(Subscription &sub, void *data)
 {
 	return publishTopic(sub, data);
 }
@@ -1067,6 +1046,23 @@ Replay::custom_command(int argc, char *argv[])
 		return Replay::task_spawn(argc, argv);
 	}
 
+	if (!strcmp(argv[0], "seek")) {
+		if (argc < 2) {
+			return print_usage("missing time");
+		}
+
+		if (is_running()) {
+			PX4_ERR("replay still running");
+			return -1;
+		}
+
+		if (!ReplayEkf2::setSeekTime(atof(argv[1]))) {
+			return -1;
+		}
+
+		return Replay::task_spawn(argc, argv);
+	}
+
 	return print_usage("unknown command");
 }
 
@@ -1167,6 +1163,14 @@ the log file to be replayed. The second is the mode, specified via `replay_mode`
 - Generic otherwise: this can be used to replay any module(s), but the replay will be done with the same speed as the
   log was recorded.
 
+In ekf2 mode, `replay_checkpoint_interval` can be set to a time in seconds: the estimator state is then saved
+periodically while replaying, and the system keeps running when the replay is done. `replay seek <time>` restarts the
+replay from the latest checkpoint before the given time, using the parameters from the log and `replay_params.txt`
+again. This allows to iterate on estimator parameters for an event late in a long log within seconds.
+
+The log file is memory-mapped and indexed before the replay starts. Set `replay_index_cache=1` to store the index
+next to the log file (`<file>.index`) and reuse it when replaying the same log again.
+
 The module is typically used together with uORB publisher rules, to specify which messages should be replayed.
 The replay module will just publish all messages that are found in the log. It also applies the parameters from
 the log.
@@ -1179,6 +1183,8 @@ page.
 	PRINT_MODULE_USAGE_COMMAND_DESCR("start", "Start replay, using log file from ENV variable 'replay'");
 	PRINT_MODULE_USAGE_COMMAND_DESCR("trystart", "Same as 'start', but silently exit if no log file given");
 	PRINT_MODULE_USAGE_COMMAND_DESCR("tryapplyparams", "Try to apply the parameters from the log file");
+	PRINT_MODULE_USAGE_COMMAND_DESCR("seek", "Restart an ekf2 replay from the latest checkpoint before a given time");
+	PRINT_MODULE_USAGE_ARG("<time>", "Time since the start of the log in seconds", false);
 	PRINT_MODULE_USAGE_DEFAULT_COMMANDS();
 
 	return 0;
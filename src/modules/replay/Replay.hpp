@@ -40,6 +40,7 @@
 #include <string>
 
 #include "definitions.hpp"
+#include "ULogIndex.hpp"
 
 #include <px4_platform_common/module.h>
 #include <uORB/topics/uORBTopics.hpp>
@@ -51,9 +52,10 @@ namespace px4
 /**
  * @class Replay
  * Parses an ULog file and replays it in 'real-time'. The timestamp of each replayed message is offset
- * to match the starting time of replay. It keeps a stream for each subscription to find the next message
- * to replay. This is necessary because data messages from different subscriptions don't need to be in
- * monotonic increasing order.
+ * to match the starting time of replay. The data section of the file is memory-mapped and indexed in a
+ * single pass, and the messages are replayed with a cursor that merges the data messages of all
+ * subscriptions in timestamp order. This is necessary because data messages from different subscriptions
+ * don't need to be in monotonic increasing order.
  */
 class Replay : public ModuleBase<Replay>
 {
@@ -134,8 +136,9 @@ protected:
 
 		bool ignored = false; ///< if true, it will not be considered for publication in the main loop
 
-		std::streampos next_read_pos;
-		uint64_t next_timestamp; ///< timestamp of the file
+		size_t next_index = 0; ///< index into the data messages of the subscription
+		uint64_t next_read_pos = 0; ///< file offset of the next data message
+		uint64_t next_timestamp = 0; ///< timestamp of the file
 
 		CompatBase *compat = nullptr;
 
@@ -189,22 +192,38 @@ protected:
 	 * handle the publication of a topic update
 	 * @return true if published, false otherwise
 	 */
-	virtual bool handleTopicUpdate(Subscription &sub, void *data, std::ifstream &replay_file);
+	virtual bool handleTopicUpdate(Subscription &sub, void *data);
 
 	/**
 	 * read a topic from the file (offset given by the subscription) into _read_buffer
 	 */
-	void readTopicDataToBuffer(const Subscription &sub, std::ifstream &replay_file);
+	void readTopicDataToBuffer(const Subscription &sub);
 
 	/**
-	 * Find next data message for this subscription, starting with the stored file offset.
-	 * Skip the first message, and if found, read the timestamp and store the new file offset.
-	 * This also takes care of new subscriptions and parameter updates. When reaching EOF,
-	 * the subscription is set to invalid.
-	 * File seek position is arbitrary after this call.
-	 * @return false on file error
+	 * Advance to the next data message of this subscription and store its file offset and timestamp.
+	 * Messages with an unexpected size are skipped. When reaching the end of the log, the subscription
+	 * is set to invalid.
+	 * @return false if there are no more data messages for this subscription
 	 */
-	bool nextDataMessage(std::ifstream &file, Subscription &subscription, int msg_id);
+	bool nextDataMessage(Subscription &subscription, uint16_t msg_id);
+
+	/**
+	 * Check the data message at subscription.next_index and store its file offset and timestamp.
+	 * @return false if the message has an unexpected size
+	 */
+	bool readDataMessage(Subscription &subscription, uint16_t msg_id);
+
+	/**
+	 * Skip the parameter changes and dropouts located before a file offset
+	 */
+	void skipAdditionalMessages(uint64_t end_offset);
+
+	/**
+	 * @return true if the system should be shut down when the replay is done
+	 */
+	virtual bool shutdownWhenDone() { return true; }
+
+	uint64_t getFileStartTime() const { return _file_start_time; }
 
 	virtual uint64_t getTimestampOffset()
 	{
@@ -216,6 +235,8 @@ protected:
 	std::vector<Subscription *> _subscriptions;
 	std::vector<uint8_t> _read_buffer;
 
+	ULogIndex _index;
+
 	float _speed_factor{1.f}; ///< from PX4_SIM_SPEED_FACTOR env variable (set to 0 to avoid usleep = unlimited rate)
 
 private:
@@ -224,12 +245,8 @@ private:
 
 	uint64_t _file_start_time;
 	uint64_t _replay_start_time;
-	std::streampos _data_section_start; ///< first ADD_LOGGED_MSG message
-
-	/** keep track of file position to avoid adding a subscription multiple times. */
-	std::streampos _subscription_file_pos = 0;
 
-	int64_t _read_until_file_position = 1ULL << 60; ///< read limit if log contains appended data
+	size_t _next_additional_message{0}; ///< index into the additional messages of the index
 
 	float _accumulated_delay{0.f};
 
@@ -244,9 +261,19 @@ private:
 
 	///file parsing methods. They return false, when further parsing should be aborted.
 	bool readFormat(std::ifstream &file, uint16_t msg_size);
-	bool readAndAddSubscription(std::ifstream &file, uint16_t msg_size);
 	bool readFlagBits(std::ifstream &file, uint16_t msg_size);
 
+	/**
+	 * Add a subscription from an ADD_LOGGED_MSG message and find its first data message
+	 */
+	void addSubscription(const uint8_t *message, uint16_t msg_size);
+
+	/**
+	 * Map the replay file and build the index (or load it from the sidecar file, if enabled)
+	 * @return true on success
+	 */
+	bool openIndex();
+
 	/**
 	 * Read the file header and definitions sections. Apply the parameters from this section
 	 * and apply user-defined overridden parameters.
@@ -255,14 +282,13 @@ private:
 	bool readDefinitionsAndApplyParams(std::ifstream &file);
 
 	/**
-	 * Read and handle additional messages starting at current file position, while position < end_position.
+	 * Handle the additional messages which are located before end_offset in the file and not handled yet.
 	 * This handles dropout and parameter update messages.
 	 * We need to handle these separately, because they have no timestamp. We look at the file position instead.
-	 * @return false on file error
 	 */
-	bool readAndHandleAdditionalMessages(std::ifstream &file, std::streampos end_position);
-	bool readDropout(std::ifstream &file, uint16_t msg_size);
+	void handleAdditionalMessages(uint64_t end_offset);
 	bool readAndApplyParameter(std::ifstream &file, uint16_t msg_size);
+	bool applyParameter(const uint8_t *message, uint16_t msg_size);
 
 	static const orb_metadata *findTopic(const std::string &name);
 
@@ -277,7 +303,8 @@ private:
 
 	void setUserParams(const char *filename);
 
-	std::string parseOrbFields(const std::string &fields);
+	/** get the field definitions of a topic in the same format as in the log file */
+	std::string parseOrbFields(const orb_metadata *meta);
 
 	static char *_replay_file;
 };
@@ -52,17 +52,37 @@
 
 #include "ReplayEkf2.hpp"
 
+#include <algorithm>
+#include <stdlib.h>
+
 namespace px4
 {
 
+std::vector<uint64_t> ReplayEkf2::_checkpoints;
+float ReplayEkf2::_seek_time = -1.f;
+
 bool
-ReplayEkf2::handleTopicUpdate(Subscription &sub, void *data, std::ifstream &replay_file)
+ReplayEkf2::setSeekTime(float seek_time)
+{
+	if (_checkpoints.empty()) {
+		PX4_ERR("no checkpoints, replay with %s set first", replay::ENV_CHECKPOINT_INTERVAL);
+		return false;
+	}
+
+	_seek_time = (seek_time > 0.f) ? seek_time : 0.f;
+	return true;
+}
+
+bool
+ReplayEkf2::handleTopicUpdate(Subscription &sub, void *data)
 {
 	if (sub.orb_meta == ORB_ID(ekf2_timestamps)) {
 		ekf2_timestamps_s ekf2_timestamps;
 		memcpy(&ekf2_timestamps, data, sub.orb_meta->o_size);
 
-		if (!publishEkf2Topics(ekf2_timestamps, replay_file)) {
+		handleCheckpoint(ekf2_timestamps.timestamp);
+
+		if (!publishEkf2Topics(ekf2_timestamps)) {
 			return false;
 		}
 
@@ -102,6 +122,9 @@ ReplayEkf2::onSubscriptionAdded(Subscription &sub, uint16_t msg_id)
 
 	} else if (sub.orb_meta == ORB_ID(vehicle_visual_odometry)) {
 		_vehicle_visual_odometry_msg_id = msg_id;
+
+	} else if (sub.orb_meta == ORB_ID(ekf2_timestamps)) {
+		_ekf2_timestamps_msg_id = msg_id;
 	}
 
 	// the main loop should only handle publication of the following topics, the sensor topics are
@@ -112,13 +135,13 @@ ReplayEkf2::onSubscriptionAdded(Subscription &sub, uint16_t msg_id)
 }
 
 bool
-ReplayEkf2::publishEkf2Topics(const ekf2_timestamps_s &ekf2_timestamps, std::ifstream &replay_file)
+ReplayEkf2::publishEkf2Topics(const ekf2_timestamps_s &ekf2_timestamps)
 {
 	auto handle_sensor_publication = [&](int16_t timestamp_relative, uint16_t msg_id) {
 		if (timestamp_relative != ekf2_timestamps_s::RELATIVE_TIMESTAMP_INVALID) {
 			// timestamp_relative is already given in 0.1 ms
 			uint64_t t = timestamp_relative + ekf2_timestamps.timestamp / 100; // in 0.1 ms
-			findTimestampAndPublish(t, msg_id, replay_file);
+			findTimestampAndPublish(t, msg_id);
 		}
 	};
 
@@ -130,7 +153,7 @@ ReplayEkf2::publishEkf2Topics(const ekf2_timestamps_s &ekf2_timestamps, std::ifs
 	handle_sensor_publication(ekf2_timestamps.visual_odometry_timestamp_rel, _vehicle_visual_odometry_msg_id);
 
 	// sensor_combined: publish last because ekf2 is polling on this
-	if (!findTimestampAndPublish(ekf2_timestamps.timestamp / 100, _sensor_combined_msg_id, replay_file)) {
+	if (!findTimestampAndPublish(ekf2_timestamps.timestamp / 100, _sensor_combined_msg_id)) {
 		if (_sensor_combined_msg_id == msg_id_invalid) {
 			// subscription not found yet or sensor_combined not contained in log
 			return false;
@@ -140,7 +163,7 @@ ReplayEkf2::publishEkf2Topics(const ekf2_timestamps_s &ekf2_timestamps, std::ifs
 
 		} else {
 			// we should publish a topic, just publish the same again
-			readTopicDataToBuffer(*_subscriptions[_sensor_combined_msg_id], replay_file);
+			readTopicDataToBuffer(*_subscriptions[_sensor_combined_msg_id]);
 			publishTopic(*_subscriptions[_sensor_combined_msg_id], _read_buffer.data());
 		}
 	}
@@ -149,7 +172,7 @@ ReplayEkf2::publishEkf2Topics(const ekf2_timestamps_s &ekf2_timestamps, std::ifs
 }
 
 bool
-ReplayEkf2::findTimestampAndPublish(uint64_t timestamp, uint16_t msg_id, std::ifstream &replay_file)
+ReplayEkf2::findTimestampAndPublish(uint64_t timestamp, uint16_t msg_id)
 {
 	if (msg_id == msg_id_invalid) {
 		// could happen if a topic is not logged
@@ -159,7 +182,7 @@ ReplayEkf2::findTimestampAndPublish(uint64_t timestamp, uint16_t msg_id, std::if
 	Subscription &sub = *_subscriptions[msg_id];
 
 	while (sub.next_timestamp / 100 < timestamp && sub.orb_meta) {
-		nextDataMessage(replay_file, sub, msg_id);
+		nextDataMessage(sub, msg_id);
 	}
 
 	if (!sub.orb_meta) { // no messages anymore
@@ -174,15 +197,132 @@ ReplayEkf2::findTimestampAndPublish(uint64_t timestamp, uint16_t msg_id, std::if
 		return false;
 	}
 
-	readTopicDataToBuffer(sub, replay_file);
+	readTopicDataToBuffer(sub);
 	publishTopic(sub, _read_buffer.data());
 	return true;
 }
 
+void
+ReplayEkf2::handleCheckpoint(uint64_t timestamp)
+{
+	if (_restore_checkpoint != 0) {
+		if (timestamp == _restore_checkpoint) {
+			publishCheckpointCommand(true, timestamp);
+		}
+
+		_restore_checkpoint = 0;
+
+	} else if (_checkpoint_interval > 0 && timestamp >= _next_checkpoint) {
+		publishCheckpointCommand(false, timestamp);
+		_checkpoints.push_back(timestamp);
+		_next_checkpoint = timestamp + _checkpoint_interval;
+	}
+}
+
+void
+ReplayEkf2::publishCheckpointCommand(bool restore, uint64_t timestamp)
+{
+	vehicle_command_s vehicle_command{};
+	vehicle_command.command = vehicle_command_s::VEHICLE_CMD_ESTIMATOR_CHECKPOINT;
+	vehicle_command.param1 = restore ? 1.f : 0.f;
+	vehicle_command.param5 = static_cast<double>(timestamp);
+	vehicle_command.timestamp = timestamp;
+	_vehicle_command_pub.publish(vehicle_command);
+}
+
+bool
+ReplayEkf2::seek(uint64_t checkpoint)
+{
+	if (_ekf2_timestamps_msg_id == msg_id_invalid) {
+		return false;
+	}
+
+	// sensor samples are matched with a relative timestamp (int16_t in 0.1 ms) to the ekf2 update
+	static constexpr uint64_t max_relative_timestamp = 3300000;
+
+	for (size_t msg_id = 0; msg_id < _subscriptions.size(); ++msg_id) {
+		Subscription *sub = _subscriptions[msg_id];
+
+		if (!sub || !sub->orb_meta) {
+			continue;
+		}
+
+		const std::vector<ULogIndex::DataMessage> &messages = _index.dataMessages(msg_id);
+		uint64_t start = checkpoint;
+
+		if (sub->ignored) {
+			start = (checkpoint > max_relative_timestamp) ? checkpoint - max_relative_timestamp : 0;
+		}
+
+		size_t index = std::lower_bound(messages.begin(), messages.end(), start,
+		[](const ULogIndex::DataMessage & message, uint64_t timestamp) { return message.timestamp < timestamp; })
+		- messages.begin();
+
+		// publish the last vehicle state before the checkpoint again
+		if ((sub->orb_meta == ORB_ID(vehicle_status) || sub->orb_meta == ORB_ID(vehicle_land_detected)) && index > 0) {
+			--index;
+		}
+
+		if (index >= messages.size()) {
+			sub->orb_meta = nullptr;
+			continue;
+		}
+
+		sub->next_index = index;
+
+		if (!readDataMessage(*sub, msg_id)) {
+			nextDataMessage(*sub, msg_id);
+		}
+	}
+
+	const Subscription *ekf2_timestamps = _subscriptions[_ekf2_timestamps_msg_id];
+
+	if (!ekf2_timestamps->orb_meta || ekf2_timestamps->next_timestamp != checkpoint) {
+		return false;
+	}
+
+	// parameter changes before the checkpoint are already contained in the replay parameters
+	skipAdditionalMessages(ekf2_timestamps->next_read_pos);
+	return true;
+}
+
 void
 ReplayEkf2::onEnterMainLoop()
 {
 	_speed_factor = 0.f; // iterate as fast as possible
+
+	if (_seek_time >= 0.f) {
+		const uint64_t seek_time = getFileStartTime() + static_cast<uint64_t>(_seek_time * 1e6);
+		_seek_time = -1.f;
+
+		// latest checkpoint before the seek time, or the first one
+		auto checkpoint = std::upper_bound(_checkpoints.begin(), _checkpoints.end(), seek_time);
+
+		if (checkpoint != _checkpoints.begin()) {
+			--checkpoint;
+		}
+
+		if (checkpoint != _checkpoints.end() && seek(*checkpoint)) {
+			PX4_INFO("Replay from checkpoint at %.3f s", (double)(*checkpoint - getFileStartTime()) / 1.e6);
+			_restore_checkpoint = *checkpoint;
+
+		} else {
+			PX4_ERR("failed to seek to checkpoint");
+			request_stop();
+		}
+
+		// keep the checkpoints of the full replay
+		_checkpoint_interval = 0;
+		return;
+	}
+
+	const char *checkpoint_interval = getenv(replay::ENV_CHECKPOINT_INTERVAL);
+
+	if (checkpoint_interval) {
+		_checkpoint_interval = static_cast<uint64_t>(atof(checkpoint_interval) * 1e6);
+	}
+
+	_checkpoints.clear();
 }
 
 void
@@ -209,6 +349,10 @@ ReplayEkf2::onExitMainLoop()
 	print_sensor_statistics(_vehicle_air_data_msg_id, "vehicle_air_data");
 	print_sensor_statistics(_vehicle_magnetometer_msg_id, "vehicle_magnetometer");
 	print_sensor_statistics(_vehicle_visual_odometry_msg_id, "vehicle_visual_odometry");
+
+	if (!_checkpoints.empty()) {
+		PX4_INFO("%zu checkpoints, use 'replay seek <time>' to replay from a checkpoint", _checkpoints.size());
+	}
 }
 
 } // namespace px4
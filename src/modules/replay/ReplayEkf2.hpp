@@ -35,6 +35,9 @@
 
 #include "Replay.hpp"
 
+#include <uORB/Publication.hpp>
+#include <uORB/topics/vehicle_command.h>
+
 namespace px4
 {
 
@@ -45,6 +48,13 @@ namespace px4
 class ReplayEkf2 : public Replay
 {
 public:
+	/**
+	 * Request the next replay to start from the latest ekf2 checkpoint before a given time
+	 * @param seek_time time since the start of the log in seconds
+	 * @return false if no checkpoints were taken
+	 */
+	static bool setSeekTime(float seek_time);
+
 protected:
 
 	void onEnterMainLoop() override;
@@ -54,10 +64,9 @@ protected:
 	 * handle ekf2 topic publication in ekf2 replay mode
 	 * @param sub
 	 * @param data
-	 * @param replay_file file currently replayed (file seek position should be considered arbitrary after this call)
 	 * @return true if published, false otherwise
 	 */
-	bool handleTopicUpdate(Subscription &sub, void *data, std::ifstream &replay_file) override;
+	bool handleTopicUpdate(Subscription &sub, void *data) override;
 
 	void onSubscriptionAdded(Subscription &sub, uint16_t msg_id) override;
 
@@ -66,18 +75,33 @@ protected:
 		// avoid offsetting timestamps as we use them to compare against the log
 		return 0;
 	}
+
+	bool shutdownWhenDone() override { return _checkpoints.empty(); }
+
 private:
 
-	bool publishEkf2Topics(const ekf2_timestamps_s &ekf2_timestamps, std::ifstream &replay_file);
+	bool publishEkf2Topics(const ekf2_timestamps_s &ekf2_timestamps);
 
 	/**
 	 * find the next message for a subscription that matches a given timestamp and publish it
 	 * @param timestamp in 0.1 ms
 	 * @param msg_id
-	 * @param replay_file file currently replayed (file seek position should be considered arbitrary after this call)
 	 * @return true if timestamp found and published
 	 */
-	bool findTimestampAndPublish(uint64_t timestamp, uint16_t msg_id, std::ifstream &replay_file);
+	bool findTimestampAndPublish(uint64_t timestamp, uint16_t msg_id);
+
+	/**
+	 * save a checkpoint or restore the checkpoint to seek to, before the ekf2 topics at this timestamp are published
+	 */
+	void handleCheckpoint(uint64_t timestamp);
+
+	/**
+	 * position all subscriptions at a checkpoint timestamp
+	 * @return false if the log cannot be positioned
+	 */
+	bool seek(uint64_t checkpoint);
+
+	void publishCheckpointCommand(bool restore, uint64_t timestamp);
 
 	static constexpr uint16_t msg_id_invalid = 0xffff;
 
@@ -88,6 +112,17 @@ private:
 	uint16_t _vehicle_air_data_msg_id = msg_id_invalid;
 	uint16_t _vehicle_magnetometer_msg_id = msg_id_invalid;
 	uint16_t _vehicle_visual_odometry_msg_id = msg_id_invalid;
+	uint16_t _ekf2_timestamps_msg_id = msg_id_invalid;
+
+	uORB::Publication<vehicle_command_s> _vehicle_command_pub{ORB_ID(vehicle_command)};
+
+	uint64_t _checkpoint_interval{0}; ///< from replay_checkpoint_interval env variable [us]
+	uint64_t _next_checkpoint{0};
+	uint64_t _restore_checkpoint{0}; ///< checkpoint to restore at the first ekf2 update, 0 if none
+
+	// checkpoints are kept by ekf2 across replays
+	static std::vector<uint64_t> _checkpoints; ///< timestamps of the checkpoints, ascending
+	static float _seek_time; ///< time since the start of the log to seek to [s], < 0 if no seek requested
 };
 
 } //namespace px4
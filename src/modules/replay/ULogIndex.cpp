@@ -0,0 +1,514 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+#include "ULogIndex.hpp"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <map>
+#include <string>
+
+#include <logger/messages.h>
+
+namespace px4
+{
+
+namespace
+{
+
+struct IndexFileHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t num_msg_ids;
+	uint64_t file_size;
+	int64_t file_mtime;
+	uint64_t indexed_size;
+	uint64_t data_section_start;
+	uint64_t num_subscription_messages;
+	uint64_t num_additional_messages;
+};
+
+static constexpr char INDEX_FILE_MAGIC[8] = {'U', 'L', 'o', 'g', 'I', 'd', 'x', 0};
+static constexpr uint32_t INDEX_FILE_VERSION = 1;
+
+using Formats = std::map<std::string, std::string>;
+
+int typeSize(const Formats &formats, const std::string &type_name_full, int level = 0);
+
+/** get the offset of a field from a format ("uint64_t timestamp;float[3] x;..."), -1 if not found */
+int fieldOffset(const Formats &formats, const std::string &fields, const char *field_name)
+{
+	int offset = 0;
+	size_t start = 0;
+
+	for (size_t end = fields.find(';'); end != std::string::npos; start = end + 1, end = fields.find(';', start)) {
+		const size_t space = fields.find(' ', start);
+
+		if (space == std::string::npos || space > end) {
+			return -1;
+		}
+
+		if (fields.compare(space + 1, end - space - 1, field_name) == 0) {
+			return offset;
+		}
+
+		const int size = typeSize(formats, fields.substr(start, space - start));
+
+		if (size <= 0) {
+			return -1;
+		}
+
+		offset += size;
+	}
+
+	return -1;
+}
+
+int typeSize(const Formats &formats, const std::string &type_name_full, int level)
+{
+	int array_size = 1;
+	std::string type_name = type_name_full;
+	const size_t bracket = type_name_full.find('[');
+
+	if (bracket != std::string::npos) {
+		array_size = atoi(type_name_full.c_str() + bracket + 1);
+		type_name = type_name_full.substr(0, bracket);
+	}
+
+	static const std::map<std::string, int> basic_types{
+		{"int8_t", 1}, {"uint8_t", 1}, {"char", 1}, {"bool", 1},
+		{"int16_t", 2}, {"uint16_t", 2},
+		{"int32_t", 4}, {"uint32_t", 4}, {"float", 4},
+		{"int64_t", 8}, {"uint64_t", 8}, {"double", 8},
+	};
+
+	const auto basic_type = basic_types.find(type_name);
+
+	if (basic_type != basic_types.end()) {
+		return basic_type->second * array_size;
+	}
+
+	// nested type
+	const auto format = formats.find(type_name);
+
+	if (format == formats.end() || level > 10) {
+		return -1;
+	}
+
+	int size = 0;
+	size_t start = 0;
+	const std::string &fields = format->second;
+
+	for (size_t end = fields.find(';'); end != std::string::npos; start = end + 1, end = fields.find(';', start)) {
+		const size_t space = fields.find(' ', start);
+
+		if (space == std::string::npos || space > end) {
+			return -1;
+		}
+
+		const int field_size = typeSize(formats, fields.substr(start, space - start), level + 1);
+
+		if (field_size <= 0) {
+			return -1;
+		}
+
+		size += field_size;
+	}
+
+	return size * array_size;
+}
+
+template<typename T>
+bool writeArray(FILE *file, const std::vector<T> &array)
+{
+	return array.empty() || (fwrite(array.data(), sizeof(T), array.size(), file) == array.size());
+}
+
+template<typename T>
+bool readArray(FILE *file, std::vector<T> &array, uint64_t count)
+{
+	array.resize(count);
+	return array.empty() || (fread(array.data(), sizeof(T), array.size(), file) == array.size());
+}
+
+} // namespace
+
+ULogIndex::~ULogIndex()
+{
+	close();
+}
+
+bool ULogIndex::open(const char *file_name)
+{
+	close();
+
+	int fd = ::open(file_name, O_RDONLY);
+
+	if (fd < 0) {
+		return false;
+	}
+
+	struct stat st;
+
+	if ((fstat(fd, &st) != 0) || (st.st_size <= 0)) {
+		::close(fd);
+		return false;
+	}
+
+	void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd); // the mapping stays valid
+
+	if (data == MAP_FAILED) {
+		return false;
+	}
+
+	// messages are mostly read sequentially
+	madvise(data, st.st_size, MADV_SEQUENTIAL);
+
+	_data = (const uint8_t *)data;
+	_size = st.st_size;
+	_mtime = st.st_mtime;
+
+	return true;
+}
+
+void ULogIndex::close()
+{
+	if (_data) {
+		munmap((void *)_data, _size);
+		_data = nullptr;
+	}
+
+	_size = 0;
+	_mtime = 0;
+	clear();
+}
+
+void ULogIndex::clear()
+{
+	_indexed_size = 0;
+	_data_section_start = 0;
+	_subscription_messages.clear();
+	_additional_messages.clear();
+	_data_messages.clear();
+}
+
+bool ULogIndex::build()
+{
+	clear();
+
+	if (!_data || (_size < sizeof(ulog_file_header_s)) || (memcmp(_data, "ULog", 4) != 0)) {
+		return false;
+	}
+
+	Formats formats;
+	std::vector<int> timestamp_offsets; // per msg_id, -1 if unknown
+	uint64_t end = _size;
+	uint64_t pos = sizeof(ulog_file_header_s);
+
+	while (pos + ULOG_MSG_HEADER_LEN <= end) {
+		uint8_t msg_type;
+		uint16_t msg_size;
+		messageHeader(pos, msg_type, msg_size);
+
+		const uint8_t *payload = _data + pos + ULOG_MSG_HEADER_LEN;
+		const uint64_t next_pos = pos + ULOG_MSG_HEADER_LEN + msg_size;
+
+		if (next_pos > end) {
+			break; // truncated message
+		}
+
+		switch ((ULogMessageType)msg_type) {
+		case ULogMessageType::DATA:
+			if (msg_size >= sizeof(uint16_t)) {
+				uint16_t msg_id;
+				memcpy(&msg_id, payload, sizeof(msg_id));
+
+				if (msg_id >= _data_messages.size()) {
+					_data_messages.resize(msg_id + 1);
+				}
+
+				uint64_t timestamp = 0;
+				const int timestamp_offset = (msg_id < timestamp_offsets.size()) ? timestamp_offsets[msg_id] : -1;
+
+				if ((timestamp_offset >= 0) && (sizeof(uint16_t) + timestamp_offset + sizeof(timestamp) <= msg_size)) {
+					memcpy(&timestamp, payload + sizeof(uint16_t) + timestamp_offset, sizeof(timestamp));
+				}
+
+				_data_messages[msg_id].push_back(DataMessage{pos, timestamp});
+			}
+
+			break;
+
+		case ULogMessageType::ADD_LOGGED_MSG:
+			if (msg_size > 3) {
+				if (_data_section_start == 0) {
+					_data_section_start = pos;
+				}
+
+				_subscription_messages.push_back(pos);
+
+				const uint16_t msg_id = payload[1] | (payload[2] << 8);
+				const std::string name((const char *)payload + 3, strnlen((const char *)payload + 3, msg_size - 3));
+				const auto format = formats.find(name);
+
+				if (msg_id >= timestamp_offsets.size()) {
+					timestamp_offsets.resize(msg_id + 1, -1);
+				}
+
+				timestamp_offsets[msg_id] = (format != formats.end()) ? fieldOffset(formats, format->second, "timestamp") : -1;
+			}
+
+			break;
+
+		case ULogMessageType::FORMAT: {
+				const char *format = (const char *)payload;
+				const char *colon = (const char *)memchr(format, ':', msg_size);
+
+				if (colon) {
+					formats[std::string(format, colon - format)] = std::string(colon + 1, format + msg_size - colon - 1);
+				}
+			}
+			break;
+
+		case ULogMessageType::PARAMETER:
+		case ULogMessageType::DROPOUT:
+			if (_data_section_start != 0) {
+				_additional_messages.push_back(pos);
+			}
+
+			break;
+
+		case ULogMessageType::FLAG_BITS:
+			if ((msg_size >= 40) && (payload[8] & ULOG_INCOMPAT_FLAG0_DATA_APPENDED_MASK)) {
+				uint64_t appended_offset;
+				memcpy(&appended_offset, payload + 16, sizeof(appended_offset));
+
+				// appended data (hardfault dumps) is not indexed
+				if ((appended_offset > 0) && (appended_offset < end)) {
+					end = appended_offset;
+				}
+			}
+
+			break;
+
+		default:
+			break;
+		}
+
+		pos = next_pos;
+	}
+
+	_indexed_size = pos;
+
+	return true;
+}
+
+bool ULogIndex::load(const char *index_file_name)
+{
+	clear();
+
+	FILE *file = fopen(index_file_name, "rb");
+
+	if (!file) {
+		return false;
+	}
+
+	// every message has at least a header, this bounds the counts before allocating
+	const uint64_t max_messages = _size / ULOG_MSG_HEADER_LEN;
+
+	IndexFileHeader header;
+	bool ok = (fread(&header, sizeof(header), 1, file) == 1)
+		  && (memcmp(header.magic, INDEX_FILE_MAGIC, sizeof(INDEX_FILE_MAGIC)) == 0)
+		  && (header.version == INDEX_FILE_VERSION)
+		  && (header.file_size == _size) && (header.file_mtime == _mtime)
+		  && (header.indexed_size <= _size) && (header.data_section_start < header.indexed_size)
+		  && (header.num_msg_ids <= UINT16_MAX + 1)
+		  && (header.num_subscription_messages <= max_messages) && (header.num_additional_messages <= max_messages);
+
+	if (ok) {
+		_indexed_size = header.indexed_size;
+		_data_section_start = header.data_section_start;
+		ok = readArray(file, _subscription_messages, header.num_subscription_messages)
+		     && readArray(file, _additional_messages, header.num_additional_messages);
+
+		_data_messages.resize(header.num_msg_ids);
+
+		for (uint32_t msg_id = 0; ok && msg_id < header.num_msg_ids; ++msg_id) {
+			uint64_t count;
+			ok = (fread(&count, sizeof(count), 1, file) == 1) && (count <= max_messages)
+			     && readArray(file, _data_messages[msg_id], count);
+		}
+	}
+
+	fclose(file);
+
+	// the sidecar is not trusted, all messages it refers to must be in the file
+	uint8_t msg_type = 0;
+
+	if (ok && (_data_section_start != 0)) {
+		ok = validMessage(_data_section_start, msg_type) && (msg_type == (uint8_t)ULogMessageType::ADD_LOGGED_MSG);
+	}
+
+	for (size_t i = 0; ok && i < _subscription_messages.size(); ++i) {
+		ok = validMessage(_subscription_messages[i], msg_type) && (msg_type == (uint8_t)ULogMessageType::ADD_LOGGED_MSG);
+	}
+
+	for (size_t i = 0; ok && i < _additional_messages.size(); ++i) {
+		ok = validMessage(_additional_messages[i], msg_type)
+		     && ((msg_type == (uint8_t)ULogMessageType::PARAMETER) || (msg_type == (uint8_t)ULogMessageType::DROPOUT));
+	}
+
+	for (size_t msg_id = 0; ok && msg_id < _data_messages.size(); ++msg_id) {
+		for (const DataMessage &data_message : _data_messages[msg_id]) {
+			if (!validMessage(data_message.offset, msg_type) || (msg_type != (uint8_t)ULogMessageType::DATA)) {
+				ok = false;
+				break;
+			}
+		}
+	}
+
+	if (!ok) {
+		clear();
+	}
+
+	return ok;
+}
+
+bool ULogIndex::save(const char *index_file_name) const
+{
+	FILE *file = fopen(index_file_name, "wb");
+
+	if (!file) {
+		return false;
+	}
+
+	IndexFileHeader header{};
+	memcpy(header.magic, INDEX_FILE_MAGIC, sizeof(INDEX_FILE_MAGIC));
+	header.version = INDEX_FILE_VERSION;
+	header.num_msg_ids = _data_messages.size();
+	header.file_size = _size;
+	header.file_mtime = _mtime;
+	header.indexed_size = _indexed_size;
+	header.data_section_start = _data_section_start;
+	header.num_subscription_messages = _subscription_messages.size();
+	header.num_additional_messages = _additional_messages.size();
+
+	bool ok = (fwrite(&header, sizeof(header), 1, file) == 1)
+		  && writeArray(file, _subscription_messages) && writeArray(file, _additional_messages);
+
+	for (size_t msg_id = 0; ok && msg_id < _data_messages.size(); ++msg_id) {
+		const uint64_t count = _data_messages[msg_id].size();
+		ok = (fwrite(&count, sizeof(count), 1, file) == 1) && writeArray(file, _data_messages[msg_id]);
+	}
+
+	if (fclose(file) != 0) {
+		ok = false;
+	}
+
+	if (!ok) {
+		// do not leave an incomplete index behind
+		unlink(index_file_name);
+	}
+
+	return ok;
+}
+
+bool ULogIndex::validMessage(uint64_t offset, uint8_t &msg_type) const
+{
+	if ((offset < sizeof(ulog_file_header_s)) || (offset >= _indexed_size)
+	    || (offset + ULOG_MSG_HEADER_LEN > _indexed_size)) {
+		return false;
+	}
+
+	uint16_t msg_size;
+	messageHeader(offset, msg_type, msg_size);
+
+	return offset + ULOG_MSG_HEADER_LEN + msg_size <= _indexed_size;
+}
+
+size_t ULogIndex::numDataMessages() const
+{
+	size_t num = 0;
+
+	for (const auto &data_messages : _data_messages) {
+		num += data_messages.size();
+	}
+
+	return num;
+}
+
+void ULogIndex::messageHeader(uint64_t offset, uint8_t &msg_type, uint16_t &msg_size) const
+{
+	memcpy(&msg_size, _data + offset, sizeof(msg_size));
+	msg_type = _data[offset + sizeof(msg_size)];
+}
+
+const uint8_t *ULogIndex::messagePayload(uint64_t offset) const
+{
+	return _data + offset + ULOG_MSG_HEADER_LEN;
+}
+
+void ULogIndex::Cursor::add(uint16_t msg_id, size_t position)
+{
+	const std::vector<DataMessage> &data_messages = _index.dataMessages(msg_id);
+
+	if (position < data_messages.size()) {
+		_queue.push(Entry{data_messages[position].timestamp, data_messages[position].offset, position, msg_id});
+	}
+}
+
+bool ULogIndex::Cursor::next(uint16_t &msg_id, size_t &position)
+{
+	if (_queue.empty()) {
+		return false;
+	}
+
+	const Entry entry = _queue.top();
+	_queue.pop();
+
+	msg_id = entry.msg_id;
+	position = entry.position;
+
+	add(msg_id, position + 1);
+
+	return true;
+}
+
+} // namespace px4
@@ -0,0 +1,196 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file ULogIndex.hpp
+ *
+ * Memory-mapped ULog file with an index of the data section, built in a single pass.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <functional>
+#include <queue>
+#include <vector>
+
+namespace px4
+{
+
+/**
+ * @class ULogIndex
+ * Maps an ULog file into memory and indexes it: for each msg_id the file offsets and timestamps of all
+ * data messages, and the offsets of the subscription (ADD_LOGGED_MSG) and additional (parameter and
+ * dropout) messages of the data section. Building the index requires a single pass over the file,
+ * afterwards the messages can be accessed directly. The index can be stored in a sidecar file, so that
+ * replaying the same log again does not need to scan it.
+ */
+class ULogIndex
+{
+public:
+	struct DataMessage {
+		uint64_t offset; ///< file offset of the message header
+		uint64_t timestamp; ///< timestamp field of the message (0 if the topic has none)
+	};
+
+	/**
+	 * @class Cursor
+	 * Iterates the data messages of a set of msg_ids in timestamp order (messages with equal timestamp
+	 * in file order). Data messages of different msg_ids don't need to be in chronological order in the file.
+	 */
+	class Cursor
+	{
+	public:
+		explicit Cursor(const ULogIndex &index) : _index(index) {}
+
+		/**
+		 * Add the data messages of a msg_id, starting at a position (index into dataMessages(msg_id))
+		 */
+		void add(uint16_t msg_id, size_t position = 0);
+
+		/**
+		 * Get the next data message and advance
+		 * @return false if there are no more messages
+		 */
+		bool next(uint16_t &msg_id, size_t &position);
+
+		bool empty() const { return _queue.empty(); }
+
+	private:
+		struct Entry {
+			uint64_t timestamp;
+			uint64_t offset;
+			size_t position;
+			uint16_t msg_id;
+
+			bool operator>(const Entry &other) const
+			{
+				return (timestamp > other.timestamp) || ((timestamp == other.timestamp) && (offset > other.offset));
+			}
+		};
+
+		const ULogIndex &_index;
+		std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> _queue;
+	};
+
+	ULogIndex() = default;
+	~ULogIndex();
+
+	ULogIndex(const ULogIndex &) = delete;
+	ULogIndex &operator=(const ULogIndex &) = delete;
+
+	/**
+	 * Map a file into memory
+	 * @return true on success
+	 */
+	bool open(const char *file_name);
+
+	void close();
+
+	/**
+	 * Index the mapped file. Replaces a previously built or loaded index.
+	 * @return false if the file is not a valid ULog file
+	 */
+	bool build();
+
+	/**
+	 * Load the index from a sidecar file. Fails if it does not match the mapped file (size and modification time),
+	 * or if any message it refers to is not within the indexed part of the file. The index then needs to be built.
+	 * @return true on success
+	 */
+	bool load(const char *index_file_name);
+
+	/**
+	 * Store the index into a sidecar file
+	 * @return true on success
+	 */
+	bool save(const char *index_file_name) const;
+
+	const uint8_t *data() const { return _data; }
+	uint64_t size() const { return _size; }
+
+	/** end of the indexed messages (appended data and a truncated last message are excluded) */
+	uint64_t indexedSize() const { return _indexed_size; }
+
+	/** offset of the first ADD_LOGGED_MSG message (0 if there is none) */
+	uint64_t dataSectionStart() const { return _data_section_start; }
+
+	/** offsets of all ADD_LOGGED_MSG messages */
+	const std::vector<uint64_t> &subscriptionMessages() const { return _subscription_messages; }
+
+	/** offsets of all PARAMETER and DROPOUT messages of the data section */
+	const std::vector<uint64_t> &additionalMessages() const { return _additional_messages; }
+
+	/** data messages of a msg_id in file order */
+	const std::vector<DataMessage> &dataMessages(uint16_t msg_id) const
+	{
+		return (msg_id < _data_messages.size()) ? _data_messages[msg_id] : _no_data_messages;
+	}
+
+	/** data message at a position of dataMessages(msg_id), nullptr if there is none */
+	const DataMessage *dataMessage(uint16_t msg_id, size_t position) const
+	{
+		const std::vector<DataMessage> &data_messages = dataMessages(msg_id);
+		return (position < data_messages.size()) ? &data_messages[position] : nullptr;
+	}
+
+	size_t numDataMessages() const;
+
+	/** message type and payload size of the message at offset */
+	void messageHeader(uint64_t offset, uint8_t &msg_type, uint16_t &msg_size) const;
+
+	/** payload of the message at offset (after the message header) */
+	const uint8_t *messagePayload(uint64_t offset) const;
+
+private:
+	void clear();
+
+	/** check that a message is at offset and within the indexed size, and get its type */
+	bool validMessage(uint64_t offset, uint8_t &msg_type) const;
+
+	const uint8_t *_data{nullptr};
+	uint64_t _size{0};
+	int64_t _mtime{0};
+
+	uint64_t _indexed_size{0};
+	uint64_t _data_section_start{0};
+	std::vector<uint64_t> _subscription_messages;
+	std::vector<uint64_t> _additional_messages;
+	std::vector<std::vector<DataMessage>> _data_messages;
+	const std::vector<DataMessage> _no_data_messages;
+};
+
+} // namespace px4
@@ -0,0 +1,587 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file ULogIndexTest.cpp
+ *
+ * Tests and benchmark for the ULog index used by replay.
+ * The benchmark is disabled by default, run it with --gtest_also_run_disabled_tests. It runs on a
+ * generated log, or on a real log by setting REPLAY_BENCHMARK_LOG to the file name.
+ */
+
+#include <gtest/gtest.h>
+#include "ULogIndex.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <logger/messages.h>
+
+using namespace px4;
+
+// writes ULog messages into a memory buffer
+class ULogBuilder
+{
+public:
+	ULogBuilder()
+	{
+		ulog_file_header_s header{};
+		const uint8_t magic[] = {'U', 'L', 'o', 'g', 0x01, 0x12, 0x35, 0x01};
+		memcpy(header.magic, magic, sizeof(magic));
+		append(&header, sizeof(header));
+	}
+
+	uint64_t message(ULogMessageType type, const void *payload, size_t size)
+	{
+		const uint64_t offset = _buffer.size();
+		const uint16_t msg_size = size;
+		append(&msg_size, sizeof(msg_size));
+		_buffer.push_back((uint8_t)type);
+		append(payload, size);
+		return offset;
+	}
+
+	uint64_t format(const char *format) { return message(ULogMessageType::FORMAT, format, strlen(format)); }
+
+	uint64_t addLogged(uint16_t msg_id, const char *name)
+	{
+		std::vector<uint8_t> payload{0, (uint8_t)msg_id, (uint8_t)(msg_id >> 8)};
+		payload.insert(payload.end(), name, name + strlen(name));
+		return message(ULogMessageType::ADD_LOGGED_MSG, payload.data(), payload.size());
+	}
+
+	// data message with the timestamp at timestamp_offset and total payload size (excluding msg_id)
+	uint64_t data(uint16_t msg_id, uint64_t timestamp, int timestamp_offset, size_t size)
+	{
+		std::vector<uint8_t> payload(sizeof(msg_id) + size, 0xab);
+		memcpy(payload.data(), &msg_id, sizeof(msg_id));
+		memcpy(payload.data() + sizeof(msg_id) + timestamp_offset, &timestamp, sizeof(timestamp));
+		return message(ULogMessageType::DATA, payload.data(), payload.size());
+	}
+
+	uint64_t parameter(const char *key, int32_t value)
+	{
+		std::vector<uint8_t> payload{(uint8_t)strlen(key)};
+		payload.insert(payload.end(), key, key + strlen(key));
+		payload.insert(payload.end(), (uint8_t *)&value, (uint8_t *)&value + sizeof(value));
+		return message(ULogMessageType::PARAMETER, payload.data(), payload.size());
+	}
+
+	uint64_t dropout(uint16_t duration_ms) { return message(ULogMessageType::DROPOUT, &duration_ms, sizeof(duration_ms)); }
+
+	void append(const void *data, size_t size)
+	{
+		_buffer.insert(_buffer.end(), (const uint8_t *)data, (const uint8_t *)data + size);
+	}
+
+	bool write(const std::string &file_name) const
+	{
+		std::ofstream file(file_name, std::ios::binary);
+		file.write((const char *)_buffer.data(), _buffer.size());
+		return file.good();
+	}
+
+	std::vector<uint8_t> &buffer() { return _buffer; }
+
+private:
+	std::vector<uint8_t> _buffer;
+};
+
+class ULogIndexTest : public ::testing::Test
+{
+public:
+	void SetUp() override
+	{
+		char file_name[] = "/tmp/ulog_index_test_XXXXXX";
+		const int fd = mkstemp(file_name);
+		ASSERT_GE(fd, 0);
+		close(fd);
+		_file_name = file_name;
+		_index_file_name = _file_name + ".index";
+	}
+
+	void TearDown() override
+	{
+		unlink(_file_name.c_str());
+		unlink(_index_file_name.c_str());
+	}
+
+	std::string _file_name;
+	std::string _index_file_name;
+};
+
+// topic_a: timestamp first, topic_b: timestamp after a field, topic_c: timestamp after a nested type
+static void writeDefinitions(ULogBuilder &log)
+{
+	log.format("topic_a:uint64_t timestamp;float x;");
+	log.format("topic_b:uint32_t seq;uint64_t timestamp;");
+	log.format("nested:uint8_t a;uint16_t b;");
+	log.format("topic_c:nested[2] n;uint64_t timestamp;");
+	log.parameter("int32_t PARAM_A", 1);
+}
+
+TEST_F(ULogIndexTest, BuildIndexesAllMessages)
+{
+	ULogBuilder log;
+	writeDefinitions(log);
+	const uint64_t add_a = log.addLogged(0, "topic_a");
+	const uint64_t add_b = log.addLogged(1, "topic_b");
+	const uint64_t a0 = log.data(0, 1000, 0, 12);
+	const uint64_t b0 = log.data(1, 900, 4, 12);
+	const uint64_t param = log.parameter("int32_t PARAM_B", 2);
+	const uint64_t a1 = log.data(0, 2000, 0, 12);
+	const uint64_t dropout = log.dropout(50);
+	const uint64_t add_c = log.addLogged(2, "topic_c");
+	const uint64_t c0 = log.data(2, 1500, 6, 14);
+	const uint64_t indexed_size = log.buffer().size();
+	// truncated message at the end
+	log.data(0, 3000, 0, 12);
+	log.buffer().resize(log.buffer().size() - 5);
+	ASSERT_TRUE(log.write(_file_name));
+
+	ULogIndex index;
+	ASSERT_TRUE(index.open(_file_name.c_str()));
+	ASSERT_TRUE(index.build());
+
+	EXPECT_EQ(index.dataSectionStart(), add_a);
+	EXPECT_EQ(index.indexedSize(), indexed_size);
+	EXPECT_EQ(index.subscriptionMessages(), (std::vector<uint64_t> {add_a, add_b, add_c}));
+	// the parameter of the definitions section is not part of the data section
+	EXPECT_EQ(index.additionalMessages(), (std::vector<uint64_t> {param, dropout}));
+	EXPECT_EQ(index.numDataMessages(), 4u);
+
+	ASSERT_EQ(index.dataMessages(0).size(), 2u);
+	EXPECT_EQ(index.dataMessages(0)[0].offset, a0);
+	EXPECT_EQ(index.dataMessages(0)[0].timestamp, 1000u);
+	EXPECT_EQ(index.dataMessages(0)[1].offset, a1);
+	EXPECT_EQ(index.dataMessages(0)[1].timestamp, 2000u);
+
+	ASSERT_EQ(index.dataMessages(1).size(), 1u);
+	EXPECT_EQ(index.dataMessages(1)[0].offset, b0);
+	EXPECT_EQ(index.dataMessages(1)[0].timestamp, 900u);
+
+	ASSERT_EQ(index.dataMessages(2).size(), 1u);
+	EXPECT_EQ(index.dataMessages(2)[0].offset, c0);
+	EXPECT_EQ(index.dataMessages(2)[0].timestamp, 1500u);
+
+	EXPECT_TRUE(index.dataMessages(3).empty());
+
+	uint8_t msg_type;
+	uint16_t msg_size;
+	index.messageHeader(dropout, msg_type, msg_size);
+	EXPECT_EQ(msg_type, (uint8_t)ULogMessageType::DROPOUT);
+	EXPECT_EQ(msg_size, 2);
+	uint16_t duration;
+	memcpy(&duration, index.messagePayload(dropout), sizeof(duration));
+	EXPECT_EQ(duration, 50);
+}
+
+TEST_F(ULogIndexTest, NoULogFile)
+{
+	ULogBuilder log;
+	log.buffer()[0] = 'X';
+	ASSERT_TRUE(log.write(_file_name));
+
+	ULogIndex index;
+	ASSERT_TRUE(index.open(_file_name.c_str()));
+	EXPECT_FALSE(index.build());
+	EXPECT_FALSE(index.open("/nonexistent/file.ulg"));
+}
+
+TEST_F(ULogIndexTest, AppendedDataIgnored)
+{
+	ULogBuilder log;
+
+	uint8_t flag_bits[40] {};
+	flag_bits[8] = ULOG_INCOMPAT_FLAG0_DATA_APPENDED_MASK;
+	const uint64_t flag_bits_offset = log.message(ULogMessageType::FLAG_BITS, flag_bits, sizeof(flag_bits));
+
+	writeDefinitions(log);
+	log.addLogged(0, "topic_a");
+	log.data(0, 1000, 0, 12);
+
+	const uint64_t appended_offset = log.buffer().size();
+	memcpy(log.buffer().data() + flag_bits_offset + ULOG_MSG_HEADER_LEN + 16, &appended_offset, sizeof(appended_offset));
+	log.data(0, 2000, 0, 12);
+	ASSERT_TRUE(log.write(_file_name));
+
+	ULogIndex index;
+	ASSERT_TRUE(index.open(_file_name.c_str()));
+	ASSERT_TRUE(index.build());
+	EXPECT_EQ(index.dataMessages(0).size(), 1u);
+	EXPECT_EQ(index.indexedSize(), appended_offset);
+}
+
+TEST_F(ULogIndexTest, SubscriptionWithoutData)
+{
+	ULogBuilder log;
+	writeDefinitions(log);
+	const uint64_t add_a = log.addLogged(0, "topic_a");
+	log.addLogged(1, "topic_b");
+	log.data(1, 1000, 4, 12);
+	ASSERT_TRUE(log.write(_file_name));
+
+	ULogIndex index;
+	ASSERT_TRUE(index.open(_file_name.c_str()));
+	ASSERT_TRUE(index.build());
+
+	// replay looks up the first data message of each subscription
+	EXPECT_EQ(index.subscriptionMessages().front(), add_a);
+	EXPECT_TRUE(index.dataMessages(0).empty());
+	EXPECT_EQ(index.dataMessage(0, 0), nullptr);
+	ASSERT_NE(index.dataMessage(1, 0), nullptr);
+	EXPECT_EQ(index.dataMessage(1, 0)->timestamp, 1000u);
+	EXPECT_EQ(index.dataMessage(1, 1), nullptr);
+	EXPECT_EQ(index.dataMessage(2, 0), nullptr);
+}
+
+TEST_F(ULogIndexTest, CursorMergesInTimestampOrder)
+{
+	ULogBuilder log;
+	writeDefinitions(log);
+	log.addLogged(0, "topic_a");
+	log.addLogged(1, "topic_b");
+	log.addLogged(2, "topic_c");
+
+	// the topics are logged with different delays, so they are not in chronological order in the file
+	for (uint64_t t = 1; t <= 100; ++t) {
+		log.data(0, t * 1000, 0, 12);
+
+		if (t % 3 == 0) {
+			log.data(1, (t - 2) * 1000, 4, 12);
+		}
+
+		if (t % 5 == 0) {
+			log.data(2, t * 1000, 6, 14); // same timestamp as topic_a
+		}
+	}
+
+	ASSERT_TRUE(log.write(_file_name));
+
+	ULogIndex index;
+	ASSERT_TRUE(index.open(_file_name.c_str()));
+	ASSERT_TRUE(index.build());
+
+	ULogIndex::Cursor cursor(index);
+	cursor.add(0);
+	cursor.add(1);
+	cursor.add(2, 20); // already at the end
+	cursor.add(3); // no messages
+
+	uint16_t msg_id;
+	size_t position;
+	uint64_t last_timestamp = 0;
+	uint64_t last_offset = 0;
+	size_t count = 0;
+
+	while (cursor.next(msg_id, position)) {
+		ASSERT_LT(msg_id, 2);
+		const ULogIndex::DataMessage &message = index.dataMessages(msg_id)[position];
+		EXPECT_GE(message.timestamp, last_timestamp);
+
+		if (message.timestamp == last_timestamp) {
+			EXPECT_GT(message.offset, last_offset);
+		}
+
+		last_timestamp = message.timestamp;
+		last_offset = message.offset;
+		++count;
+	}
+
+	EXPECT_TRUE(cursor.empty());
+	EXPECT_EQ(count, 100u + 33u);
+
+	// equal timestamps are returned in file order
+	ULogIndex::Cursor cursor_equal(index);
+	cursor_equal.add(2);
+	cursor_equal.add(0, 4);
+	ASSERT_TRUE(cursor_equal.next(msg_id, position));
+	EXPECT_EQ(msg_id, 0);
+	ASSERT_TRUE(cursor_equal.next(msg_id, position));
+	EXPECT_EQ(msg_id, 2);
+}
+
+TEST_F(ULogIndexTest, SidecarIndex)
+{
+	ULogBuilder log;
+	writeDefinitions(log);
+	log.addLogged(0, "topic_a");
+	log.addLogged(5, "topic_b");
+
+	for (uint64_t t = 1; t <= 50; ++t) {
+		log.data(0, t * 1000, 0, 12);
+		log.data(5, t * 1000 + 1, 4, 12);
+	}
+
+	log.dropout(10);
+	ASSERT_TRUE(log.write(_file_name));
+
+	ULogIndex index;
+	ASSERT_TRUE(index.open(_file_name.c_str()));
+	EXPECT_FALSE(index.load(_index_file_name.c_str()));
+	ASSERT_TRUE(index.build());
+	ASSERT_TRUE(index.save(_index_file_name.c_str()));
+
+	ULogIndex loaded;
+	ASSERT_TRUE(loaded.open(_file_name.c_str()));
+	ASSERT_TRUE(loaded.load(_index_file_name.c_str()));
+	EXPECT_EQ(loaded.indexedSize(), index.indexedSize());
+	EXPECT_EQ(loaded.dataSectionStart(), index.dataSectionStart());
+	EXPECT_EQ(loaded.subscriptionMessages(), index.subscriptionMessages());
+	EXPECT_EQ(loaded.additionalMessages(), index.additionalMessages());
+	EXPECT_EQ(loaded.numDataMessages(), index.numDataMessages());
+
+	for (uint16_t msg_id = 0; msg_id < 6; ++msg_id) {
+		ASSERT_EQ(loaded.dataMessages(msg_id).size(), index.dataMessages(msg_id).size());
+
+		for (size_t i = 0; i < index.dataMessages(msg_id).size(); ++i) {
+			EXPECT_EQ(loaded.dataMessages(msg_id)[i].offset, index.dataMessages(msg_id)[i].offset);
+			EXPECT_EQ(loaded.dataMessages(msg_id)[i].timestamp, index.dataMessages(msg_id)[i].timestamp);
+		}
+	}
+
+	// a modified log does not match the index anymore
+	log.data(0, 51000, 0, 12);
+	ASSERT_TRUE(log.write(_file_name));
+	ULogIndex modified;
+	ASSERT_TRUE(modified.open(_file_name.c_str()));
+	EXPECT_FALSE(modified.load(_index_file_name.c_str()));
+
+	// a corrupted index is rejected
+	ASSERT_EQ(truncate(_index_file_name.c_str(), 100), 0);
+	ASSERT_TRUE(loaded.open(_file_name.c_str()));
+	EXPECT_FALSE(loaded.load(_index_file_name.c_str()));
+}
+
+TEST_F(ULogIndexTest, SidecarOffsetsValidated)
+{
+	ULogBuilder log;
+	writeDefinitions(log);
+	const uint64_t add_a = log.addLogged(0, "topic_a");
+
+	for (uint64_t t = 1; t <= 10; ++t) {
+		log.data(0, t * 1000, 0, 12);
+	}
+
+	ASSERT_TRUE(log.write(_file_name));
+
+	ULogIndex index;
+	ASSERT_TRUE(index.open(_file_name.c_str()));
+	ASSERT_TRUE(index.build());
+
+	// the offset of the last data message is at the end of the sidecar
+	auto corrupt_last_offset = [&](uint64_t offset) {
+		ASSERT_TRUE(index.save(_index_file_name.c_str()));
+		std::fstream file(_index_file_name, std::ios::in | std::ios::out | std::ios::binary);
+		file.seekp(-(std::streamoff)sizeof(ULogIndex::DataMessage), std::ios::end);
+		file.write((const char *)&offset, sizeof(offset));
+	};
+
+	const uint64_t offsets[] {
+		log.buffer().size(), // beyond the end of the log
+		log.buffer().size() - ULOG_MSG_HEADER_LEN, // the message would extend beyond the end
+		index.dataMessages(0).back().offset + 1, // not the start of a message
+		add_a, // not a data message
+		UINT64_MAX - 1,
+	};
+
+	for (uint64_t offset : offsets) {
+		corrupt_last_offset(offset);
+		ULogIndex loaded;
+		ASSERT_TRUE(loaded.open(_file_name.c_str()));
+		EXPECT_FALSE(loaded.load(_index_file_name.c_str())) << "offset " << offset;
+		EXPECT_TRUE(loaded.dataMessages(0).empty());
+
+		// replay then builds the index
+		ASSERT_TRUE(loaded.build());
+		EXPECT_EQ(loaded.dataMessages(0).size(), 10u);
+	}
+
+	// an unmodified sidecar is accepted
+	ASSERT_TRUE(index.save(_index_file_name.c_str()));
+	ULogIndex loaded;
+	ASSERT_TRUE(loaded.open(_file_name.c_str()));
+	EXPECT_TRUE(loaded.load(_index_file_name.c_str()));
+}
+
+// per-subscription scan of the file, as replay did before: find the next data message of a msg_id
+// by reading the message headers following the previous one
+static size_t scanDataMessages(std::ifstream &file, uint64_t data_section_start, uint16_t msg_id)
+{
+	size_t count = 0;
+	file.clear();
+	file.seekg(data_section_start);
+	ulog_message_header_s header;
+
+	while (file.read((char *)&header, ULOG_MSG_HEADER_LEN)) {
+		if (header.msg_type == (uint8_t)ULogMessageType::DATA) {
+			uint16_t file_msg_id;
+			file.read((char *)&file_msg_id, sizeof(file_msg_id));
+
+			if (file_msg_id == msg_id) {
+				uint64_t timestamp;
+				file.read((char *)&timestamp, sizeof(timestamp));
+				file.seekg(header.msg_size - sizeof(file_msg_id) - sizeof(timestamp), std::ios::cur);
+				++count;
+
+			} else {
+				file.seekg(header.msg_size - sizeof(file_msg_id), std::ios::cur);
+			}
+
+		} else {
+			file.seekg(header.msg_size, std::ios::cur);
+		}
+	}
+
+	return count;
+}
+
+// not part of the unit tests, run with --gtest_also_run_disabled_tests
+TEST_F(ULogIndexTest, DISABLED_Benchmark)
+{
+	static constexpr int NUM_TOPICS = 100;
+	const char *benchmark_log = getenv("REPLAY_BENCHMARK_LOG");
+	std::string file_name = _file_name;
+
+	if (benchmark_log) {
+		file_name = benchmark_log;
+
+	} else {
+		// ~100 MB log: 100 topics with 20 to 200 bytes logged at 10 to 400 Hz
+		ULogBuilder log;
+
+		for (int i = 0; i < NUM_TOPICS; ++i) {
+			char format[64];
+			snprintf(format, sizeof(format), "topic_%i:uint64_t timestamp;uint8_t[%i] data;", i, 20 + (i * 37) % 180);
+			log.format(format);
+		}
+
+		for (int i = 0; i < NUM_TOPICS; ++i) {
+			char name[16];
+			snprintf(name, sizeof(name), "topic_%i", i);
+			log.addLogged(i, name);
+		}
+
+		for (uint64_t t = 0; log.buffer().size() < 100 * 1000 * 1000; t += 2500) {
+			for (int i = 0; i < NUM_TOPICS; ++i) {
+				const int interval = 1 << (i % 6); // 400 Hz to 12.5 Hz
+
+				if ((t / 2500) % interval == 0) {
+					log.data(i, t, 0, 8 + 20 + (i * 37) % 180);
+				}
+			}
+		}
+
+		ASSERT_TRUE(log.write(file_name));
+	}
+
+	ULogIndex index;
+	ASSERT_TRUE(index.open(file_name.c_str()));
+
+	auto start = std::chrono::steady_clock::now();
+	ASSERT_TRUE(index.build());
+	const double build_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	const double megabytes = index.indexedSize() / 1e6;
+	printf("log: %.1f MB, %zu data messages\n", megabytes, index.numDataMessages());
+	printf("index build: %.3f s (%.1f MB/s)\n", build_s, megabytes / build_s);
+
+	// replay all messages in timestamp order, copying the payloads
+	start = std::chrono::steady_clock::now();
+	ULogIndex::Cursor cursor(index);
+	size_t num_msg_ids = 0;
+
+	for (size_t msg_id = 0; msg_id < 65536 && num_msg_ids < index.numDataMessages(); ++msg_id) {
+		if (!index.dataMessages(msg_id).empty()) {
+			cursor.add(msg_id);
+			++num_msg_ids;
+		}
+	}
+
+	uint8_t buffer[UINT16_MAX];
+	uint16_t msg_id;
+	size_t position;
+	size_t count = 0;
+	uint64_t checksum = 0;
+
+	while (cursor.next(msg_id, position)) {
+		const uint64_t offset = index.dataMessages(msg_id)[position].offset;
+		uint8_t msg_type;
+		uint16_t msg_size;
+		index.messageHeader(offset, msg_type, msg_size);
+		memcpy(buffer, index.messagePayload(offset), msg_size);
+		checksum += buffer[msg_size - 1];
+		++count;
+	}
+
+	const double replay_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	EXPECT_EQ(count, index.numDataMessages());
+	printf("merged replay: %.3f s (%.1f MB/s, %.1f Mmsg/s, checksum %llu)\n", replay_s, megabytes / replay_s,
+	       count / replay_s / 1e6, (unsigned long long)checksum);
+
+	start = std::chrono::steady_clock::now();
+	ASSERT_TRUE(index.save(_index_file_name.c_str()));
+	const double save_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	ULogIndex loaded;
+	ASSERT_TRUE(loaded.open(file_name.c_str()));
+	start = std::chrono::steady_clock::now();
+	ASSERT_TRUE(loaded.load(_index_file_name.c_str()));
+	const double load_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	printf("sidecar index: save %.3f s, load %.3f s\n", save_s, load_s);
+
+	// the previous approach scanned the file for each subscription (measured on a few topics only)
+	static constexpr int NUM_SCANNED = 2;
+	std::ifstream file(file_name, std::ios::binary);
+	start = std::chrono::steady_clock::now();
+	size_t scanned = 0;
+	size_t indexed = 0;
+
+	for (uint16_t i = 0; i < NUM_SCANNED; ++i) {
+		scanned += scanDataMessages(file, index.dataSectionStart(), i);
+		indexed += index.dataMessages(i).size();
+	}
+
+	const double scan_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / NUM_SCANNED;
+	EXPECT_EQ(scanned, indexed);
+	printf("per-subscription scan: %.3f s per subscription (%.1f MB/s for %zu subscriptions)\n", scan_s,
+	       megabytes / (scan_s * num_msg_ids), num_msg_ids);
+}
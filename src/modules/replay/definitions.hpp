@@ -40,6 +40,8 @@ namespace replay
 
 static const char __attribute__((unused)) *ENV_FILENAME = "replay"; ///< name for getenv()
 static const char __attribute__((unused)) *ENV_MODE = "replay_mode";  ///< name for getenv()
+static const char __attribute__((unused)) *ENV_INDEX_CACHE = "replay_index_cache"; ///< name for getenv(), 1 to cache the index in <file>.index
+static const char __attribute__((unused)) *ENV_CHECKPOINT_INTERVAL = "replay_checkpoint_interval"; ///< name for getenv(), ekf2 checkpoint interval in seconds
 
 
 } //namespace replay
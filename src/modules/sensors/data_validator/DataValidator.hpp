@@ -163,6 +163,12 @@ public:
 	static constexpr uint32_t ERROR_FLAG_HIGH_ERRCOUNT = (0x00000001U << 3);
 	static constexpr uint32_t ERROR_FLAG_HIGH_ERRDENSITY = (0x00000001U << 4);
 
+	static const constexpr unsigned NORETURN_ERRCOUNT =
+		10000; /**< if the error count reaches this value, return sensor as invalid */
+	static const constexpr float ERROR_DENSITY_WINDOW = 100.0f; /**< window in measurement counts for errors */
+	static const constexpr unsigned VALUE_EQUAL_COUNT_DEFAULT =
+		100; /**< if the sensor value is the same (accumulated also between axes) this many times, flag it */
+
 private:
 	uint32_t _error_mask{ERROR_FLAG_NO_ERROR}; /**< sensor error state */
 
@@ -188,12 +194,6 @@ private:
 
 	DataValidator *_sibling{nullptr}; /**< sibling in the group */
 
-	static const constexpr unsigned NORETURN_ERRCOUNT =
-		10000; /**< if the error count reaches this value, return sensor as invalid */
-	static const constexpr float ERROR_DENSITY_WINDOW = 100.0f; /**< window in measurement counts for errors */
-	static const constexpr unsigned VALUE_EQUAL_COUNT_DEFAULT =
-		100; /**< if the sensor value is the same (accumulated also between axes) this many times, flag it */
-
 	/* we don't want this class to be copied */
 	DataValidator(const DataValidator &) = delete;
 	DataValidator operator=(const DataValidator &) = delete;
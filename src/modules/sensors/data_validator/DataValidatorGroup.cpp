@@ -41,106 +41,155 @@
 
 #include "DataValidatorGroup.hpp"
 
+#include <drivers/drv_hrt.h>
 #include <px4_platform_common/log.h>
 
 #include <float.h>
 
 DataValidatorGroup::DataValidatorGroup(unsigned siblings)
 {
-
-	DataValidator *next = nullptr;
-	DataValidator *prev = nullptr;
-
 	for (unsigned i = 0; i < siblings; i++) {
-		next = new DataValidator();
-
-		if (i == 0) {
-			_first = next;
-
-		} else {
-			prev->setSibling(next);
-		}
+		add_new_validator();
+	}
+}
 
-		prev = next;
+bool DataValidatorGroup::add_new_validator()
+{
+	if (_validator_count >= MAX_VALIDATORS) {
+		return false;
 	}
 
-	_last = next;
+	// the equal value threshold of the group only applies to the validators existing at the time it is set
+	_value_equal_count_threshold[_validator_count] = DataValidator::VALUE_EQUAL_COUNT_DEFAULT;
+	_validator_count++;
+	return true;
+}
 
-	if (_first) {
-		_timeout_interval_us = _first->get_timeout();
-	}
+void DataValidatorGroup::set_timeout(uint32_t timeout_interval_us)
+{
+	_timeout_interval_us = timeout_interval_us;
 }
 
-DataValidatorGroup::~DataValidatorGroup()
+void DataValidatorGroup::set_equal_value_threshold(uint32_t threshold)
 {
-	while (_first) {
-		DataValidator *next = _first->sibling();
-		delete (_first);
-		_first = next;
+	for (unsigned i = 0; i < _validator_count; i++) {
+		_value_equal_count_threshold[i] = threshold;
 	}
 }
 
-DataValidator *DataValidatorGroup::add_new_validator()
+void DataValidatorGroup::put(unsigned index, uint64_t timestamp, const float val[3], uint32_t error_count,
+			     uint8_t priority)
 {
+	if (index >= _validator_count) {
+		return;
+	}
 
-	DataValidator *validator = new DataValidator();
+	const uint64_t event_count = ++_event_count[index];
 
-	if (!validator) {
-		return nullptr;
-	}
+	if (error_count > _error_count[index]) {
+		_error_density[index] += (error_count - _error_count[index]);
 
-	_last->setSibling(validator);
-	_last = validator;
-	_last->set_timeout(_timeout_interval_us);
-	return _last;
-}
+	} else if (_error_density[index] > 0) {
+		_error_density[index]--;
+	}
 
-void DataValidatorGroup::set_timeout(uint32_t timeout_interval_us)
-{
+	_error_count[index] = error_count;
+	_priority[index] = priority;
+
+	float *mean = _mean[index];
+	float *lp = _lp[index];
+	float *M2 = _M2[index];
+	float *rms = _rms[index];
+	float *value = _value[index];
+
+	if (_time_last[index] == 0) {
+		for (unsigned i = 0; i < dimensions; i++) {
+			if (PX4_ISFINITE(val[i])) {
+				mean[i] = 0.f;
+				M2[i] = 0.f;
+				lp[i] = val[i] * 0.99f + 0.01f * val[i];
+				value[i] = val[i];
+			}
+		}
 
-	DataValidator *next = _first;
+	} else {
+		// the equal value count accumulates over the axes
+		unsigned value_equal_count = _value_equal_count[index];
 
-	while (next != nullptr) {
-		next->set_timeout(timeout_interval_us);
-		next = next->sibling();
-	}
+		for (unsigned i = 0; i < dimensions; i++) {
+			if (PX4_ISFINITE(val[i])) {
+				const float lp_val = val[i] - lp[i];
+				const float delta_val = lp_val - mean[i];
 
-	_timeout_interval_us = timeout_interval_us;
-}
+				mean[i] += delta_val / event_count;
+				M2[i] += delta_val * (lp_val - mean[i]);
+				rms[i] = sqrtf(M2[i] / (event_count - 1));
 
-void DataValidatorGroup::set_equal_value_threshold(uint32_t threshold)
-{
+				value_equal_count = (fabsf(value[i] - val[i]) < 0.000001f) ? value_equal_count + 1 : 0;
 
-	DataValidator *next = _first;
+				// XXX replace with better filter, make it auto-tune to update rate
+				lp[i] = lp[i] * 0.99f + 0.01f * val[i];
+				value[i] = val[i];
+			}
+		}
 
-	while (next != nullptr) {
-		next->set_equal_value_threshold(threshold);
-		next = next->sibling();
+		_value_equal_count[index] = value_equal_count;
 	}
+
+	_time_last[index] = timestamp;
 }
 
-void DataValidatorGroup::put(unsigned index, uint64_t timestamp, const float val[3], uint32_t error_count,
-			     uint8_t priority)
+float DataValidatorGroup::confidence(unsigned index, uint64_t timestamp)
 {
+	float ret = 1.0f;
+
+	/* check if we have any data */
+	if (_time_last[index] == 0) {
+		_error_mask[index] |= DataValidator::ERROR_FLAG_NO_DATA;
+		ret = 0.0f;
+
+	} else if (timestamp > _time_last[index] + _timeout_interval_us) {
+		/* timed out - that's it */
+		_error_mask[index] |= DataValidator::ERROR_FLAG_TIMEOUT;
+		ret = 0.0f;
+
+	} else if (_value_equal_count[index] > _value_equal_count_threshold[index]) {
+		/* we got the exact same sensor value N times in a row */
+		_error_mask[index] |= DataValidator::ERROR_FLAG_STALE_DATA;
+		ret = 0.0f;
+
+	} else if (_error_count[index] > DataValidator::NORETURN_ERRCOUNT) {
+		/* check error count limit */
+		_error_mask[index] |= DataValidator::ERROR_FLAG_HIGH_ERRCOUNT;
+		ret = 0.0f;
+
+	} else if (_error_density[index] > DataValidator::ERROR_DENSITY_WINDOW) {
+		/* cap error density counter at window size */
+		_error_mask[index] |= DataValidator::ERROR_FLAG_HIGH_ERRDENSITY;
+		_error_density[index] = DataValidator::ERROR_DENSITY_WINDOW;
+	}
 
-	DataValidator *next = _first;
-	unsigned i = 0;
+	/* no critical errors */
+	if (ret > 0.0f) {
+		/* return local error density for last N measurements */
+		ret = 1.0f - (_error_density[index] / DataValidator::ERROR_DENSITY_WINDOW);
 
-	while (next != nullptr) {
-		if (i == index) {
-			next->put(timestamp, val, error_count, priority);
-			break;
+		if (ret > 0.0f) {
+			_error_mask[index] = DataValidator::ERROR_FLAG_NO_ERROR;
 		}
-
-		next = next->sibling();
-		i++;
 	}
+
+	return ret;
 }
 
 float *DataValidatorGroup::get_best(uint64_t timestamp, int *index)
 {
+	// evaluate all validators in one pass, the selection below only works on the results
+	float confidence[MAX_VALIDATORS];
 
-	DataValidator *next = _first;
+	for (unsigned i = 0; i < _validator_count; i++) {
+		confidence[i] = DataValidatorGroup::confidence(i, timestamp);
+	}
 
 	// XXX This should eventually also include voting
 	int pre_check_best = _curr_best;
@@ -149,35 +198,26 @@ float *DataValidatorGroup::get_best(uint64_t timestamp, int *index)
 	float max_confidence = -1.0f;
 	int max_priority = -1000;
 	int max_index = -1;
-	DataValidator *best = nullptr;
-
-	int i = 0;
 
-	while (next != nullptr) {
-		float confidence = next->confidence(timestamp);
-
-		if (i == pre_check_best) {
-			pre_check_prio = next->priority();
-			pre_check_confidence = confidence;
-		}
+	if ((pre_check_best >= 0) && ((unsigned)pre_check_best < _validator_count)) {
+		pre_check_prio = _priority[pre_check_best];
+		pre_check_confidence = confidence[pre_check_best];
+	}
 
+	for (unsigned i = 0; i < _validator_count; i++) {
 		/*
 		 * Switch if:
 		 * 1) the confidence is higher and priority is equal or higher
 		 * 2) the confidence is less than 1% different and the priority is higher
 		 */
-		if ((((max_confidence < MIN_REGULAR_CONFIDENCE) && (confidence >= MIN_REGULAR_CONFIDENCE)) ||
-		     (confidence > max_confidence && (next->priority() >= max_priority)) ||
-		     (fabsf(confidence - max_confidence) < 0.01f && (next->priority() > max_priority))) &&
-		    (confidence > 0.0f)) {
+		if ((((max_confidence < MIN_REGULAR_CONFIDENCE) && (confidence[i] >= MIN_REGULAR_CONFIDENCE)) ||
+		     (confidence[i] > max_confidence && (_priority[i] >= max_priority)) ||
+		     (fabsf(confidence[i] - max_confidence) < 0.01f && (_priority[i] > max_priority))) &&
+		    (confidence[i] > 0.0f)) {
 			max_index = i;
-			max_confidence = confidence;
-			max_priority = next->priority();
-			best = next;
+			max_confidence = confidence[i];
+			max_priority = _priority[i];
 		}
-
-		next = next->sibling();
-		i++;
 	}
 
 	/* the current best sensor is not matching the previous best sensor,
@@ -192,8 +232,8 @@ float *DataValidatorGroup::get_best(uint64_t timestamp, int *index)
 			true_failsafe = false;
 
 			/* reset error flags, this is likely a hotplug sensor coming online late */
-			if (best != nullptr) {
-				best->reset_state();
+			if (max_index >= 0) {
+				_error_mask[max_index] = DataValidator::ERROR_FLAG_NO_ERROR;
 			}
 		}
 
@@ -220,7 +260,7 @@ float *DataValidatorGroup::get_best(uint64_t timestamp, int *index)
 	}
 
 	*index = max_index;
-	return (best) ? best->value() : nullptr;
+	return (max_index >= 0) ? _value[max_index] : nullptr;
 }
 
 void DataValidatorGroup::print()
@@ -228,14 +268,11 @@ void DataValidatorGroup::print()
 	PX4_INFO_RAW("validator: best: %d, prev best: %d, failsafe: %s (%u events)\n", _curr_best, _prev_best,
 		     (_toggle_count > 0) ? "YES" : "NO", _toggle_count);
 
-	DataValidator *next = _first;
-	unsigned i = 0;
-
-	while (next != nullptr) {
-		if (next->used()) {
-			uint32_t flags = next->state();
+	for (unsigned i = 0; i < _validator_count; i++) {
+		if (_time_last[i] > 0) {
+			uint32_t flags = _error_mask[i];
 
-			PX4_INFO_RAW("sensor #%u, prio: %d, state:%s%s%s%s%s%s\n", i, next->priority(),
+			PX4_INFO_RAW("sensor #%u, prio: %d, state:%s%s%s%s%s%s\n", i, _priority[i],
 				     ((flags & DataValidator::ERROR_FLAG_NO_DATA) ? " OFF" : ""),
 				     ((flags & DataValidator::ERROR_FLAG_STALE_DATA) ? " STALE" : ""),
 				     ((flags & DataValidator::ERROR_FLAG_TIMEOUT) ? " TOUT" : ""),
@@ -243,27 +280,20 @@ void DataValidatorGroup::print()
 				     ((flags & DataValidator::ERROR_FLAG_HIGH_ERRDENSITY) ? " EDNST" : ""),
 				     ((flags == DataValidator::ERROR_FLAG_NO_ERROR) ? " OK" : ""));
 
-			next->print();
+			for (unsigned axis = 0; axis < dimensions; axis++) {
+				PX4_INFO_RAW("\tval: %8.4f, lp: %8.4f mean dev: %8.4f RMS: %8.4f conf: %8.4f\n", (double)_value[i][axis],
+					     (double)_lp[i][axis], (double)_mean[i][axis], (double)_rms[i][axis],
+					     (double)confidence(i, hrt_absolute_time()));
+			}
 		}
-
-		next = next->sibling();
-		i++;
 	}
 }
 
 int DataValidatorGroup::failover_index()
 {
-	DataValidator *next = _first;
-	unsigned i = 0;
-
-	while (next != nullptr) {
-		if (next->used() && (next->state() != DataValidator::ERROR_FLAG_NO_ERROR) &&
-		    (i == (unsigned)_prev_best)) {
-			return i;
-		}
-
-		next = next->sibling();
-		i++;
+	if ((_prev_best >= 0) && ((unsigned)_prev_best < _validator_count) && (_time_last[_prev_best] > 0)
+	    && (_error_mask[_prev_best] != DataValidator::ERROR_FLAG_NO_ERROR)) {
+		return _prev_best;
 	}
 
 	return -1;
@@ -271,18 +301,8 @@ int DataValidatorGroup::failover_index()
 
 uint32_t DataValidatorGroup::failover_state()
 {
-
-	DataValidator *next = _first;
-	unsigned i = 0;
-
-	while (next != nullptr) {
-		if (next->used() && (next->state() != DataValidator::ERROR_FLAG_NO_ERROR) &&
-		    (i == (unsigned)_prev_best)) {
-			return next->state();
-		}
-
-		next = next->sibling();
-		i++;
+	if ((_prev_best >= 0) && ((unsigned)_prev_best < _validator_count) && (_time_last[_prev_best] > 0)) {
+		return _error_mask[_prev_best];
 	}
 
 	return DataValidator::ERROR_FLAG_NO_ERROR;
@@ -290,16 +310,8 @@ uint32_t DataValidatorGroup::failover_state()
 
 uint32_t DataValidatorGroup::get_sensor_state(unsigned index)
 {
-	DataValidator *next = _first;
-	unsigned i = 0;
-
-	while (next != nullptr) {
-		if (i == index) {
-			return next->state();
-		}
-
-		next = next->sibling();
-		i++;
+	if (index < _validator_count) {
+		return _error_mask[index];
 	}
 
 	// sensor index not found
@@ -308,16 +320,8 @@ uint32_t DataValidatorGroup::get_sensor_state(unsigned index)
 
 uint8_t DataValidatorGroup::get_sensor_priority(unsigned index)
 {
-	DataValidator *next = _first;
-	unsigned i = 0;
-
-	while (next != nullptr) {
-		if (i == index) {
-			return next->priority();
-		}
-
-		next = next->sibling();
-		i++;
+	if (index < _validator_count) {
+		return _priority[index];
 	}
 
 	// sensor index not found
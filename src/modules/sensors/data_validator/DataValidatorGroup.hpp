@@ -36,6 +36,10 @@
  *
  * A data validation group to identify anomalies in data streams
  *
+ * The validation state of all sensors in the group is kept in a structure of arrays, a sample
+ * update touches a single contiguous row and the confidence of all sensors is evaluated in one
+ * pass over the arrays when selecting the best sensor.
+ *
  * @author Lorenz Meier <lorenz@px4.io>
  */
 
@@ -46,17 +50,20 @@
 class DataValidatorGroup
 {
 public:
+	static constexpr unsigned MAX_VALIDATORS = 4;
+	static constexpr unsigned dimensions = DataValidator::dimensions;
+
 	/**
-	 * @param siblings initial number of DataValidator's. Must be > 0.
+	 * @param siblings initial number of validators. Must be > 0 and <= MAX_VALIDATORS.
 	 */
 	DataValidatorGroup(unsigned siblings);
-	~DataValidatorGroup();
+	~DataValidatorGroup() = default;
 
 	/**
-	 * Create a new Validator (with index equal to the number of currently existing validators)
-	 * @return the newly created DataValidator or nullptr on error
+	 * Add a new validator (with index equal to the number of currently existing validators)
+	 * @return true on success, false if the group is full
 	 */
-	DataValidator *add_new_validator();
+	bool add_new_validator();
 
 	/**
 	 * Put an item into the validator group.
@@ -132,10 +139,31 @@ public:
 	void set_equal_value_threshold(uint32_t threshold);
 
 private:
-	DataValidator *_first{nullptr}; /**< first node in the group */
-	DataValidator *_last{nullptr};  /**< last node in the group */
-
-	uint32_t _timeout_interval_us{0}; /**< currently set timeout */
+	/**
+	 * Get the confidence of a validator and update its error state
+	 * @return		the confidence between 0 and 1
+	 */
+	float confidence(unsigned index, uint64_t timestamp);
+
+	unsigned _validator_count{0}; /**< number of validators in the group */
+
+	uint32_t _timeout_interval_us{40000}; /**< currently set timeout, the same for all validators */
+
+	/* validator state, structure of arrays indexed by the validator index */
+	uint64_t _time_last[MAX_VALIDATORS] {};    /**< last timestamp */
+	uint64_t _event_count[MAX_VALIDATORS] {};  /**< total data counter */
+	uint32_t _error_count[MAX_VALIDATORS] {};  /**< error count */
+	uint32_t _error_mask[MAX_VALIDATORS] {};   /**< sensor error state */
+	int _error_density[MAX_VALIDATORS] {};     /**< ratio between successful reads and errors */
+	unsigned _value_equal_count[MAX_VALIDATORS] {}; /**< equal values in a row */
+	unsigned _value_equal_count_threshold[MAX_VALIDATORS] {}; /**< when to consider an equal count as a problem */
+	uint8_t _priority[MAX_VALIDATORS] {};      /**< sensor nominal priority */
+
+	float _mean[MAX_VALIDATORS][dimensions] {};  /**< mean of value */
+	float _lp[MAX_VALIDATORS][dimensions] {};    /**< low pass value */
+	float _M2[MAX_VALIDATORS][dimensions] {};    /**< RMS component value */
+	float _rms[MAX_VALIDATORS][dimensions] {};   /**< root mean square error */
+	float _value[MAX_VALIDATORS][dimensions] {}; /**< last value */
 
 	int _curr_best{-1}; /**< currently best index */
 	int _prev_best{-1}; /**< the previous best index */
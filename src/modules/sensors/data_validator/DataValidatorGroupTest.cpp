@@ -0,0 +1,660 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * Test code for the DataValidatorGroup
+ * Run this test only using make tests TESTFILTER=DataValidatorGroup
+ */
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <float.h>
+#include <stdlib.h>
+
+#include "DataValidatorGroup.hpp"
+
+namespace
+{
+
+/**
+ * The previous implementation of the group, a linked list of DataValidator objects.
+ * Reference for the equivalence test and the benchmark.
+ */
+class LegacyDataValidatorGroup
+{
+public:
+	LegacyDataValidatorGroup(unsigned siblings);
+	~LegacyDataValidatorGroup();
+
+	DataValidator *add_new_validator();
+	void put(unsigned index, uint64_t timestamp, const float val[3], uint32_t error_count, uint8_t priority);
+	float *get_best(uint64_t timestamp, int *index);
+	unsigned failover_count() const { return _toggle_count; }
+	int failover_index();
+	uint32_t failover_state();
+	uint32_t get_sensor_state(unsigned index);
+	uint8_t get_sensor_priority(unsigned index);
+	void print() {}
+	void set_timeout(uint32_t timeout_interval_us);
+	void set_equal_value_threshold(uint32_t threshold);
+
+private:
+	DataValidator *_first{nullptr};
+	DataValidator *_last{nullptr};
+	uint32_t _timeout_interval_us{0};
+	int _curr_best{-1};
+	int _prev_best{-1};
+	uint64_t _first_failover_time{0};
+	unsigned _toggle_count{0};
+
+	static constexpr float MIN_REGULAR_CONFIDENCE = 0.9f;
+};
+
+LegacyDataValidatorGroup::LegacyDataValidatorGroup(unsigned siblings)
+{
+
+	DataValidator *next = nullptr;
+	DataValidator *prev = nullptr;
+
+	for (unsigned i = 0; i < siblings; i++) {
+		next = new DataValidator();
+
+		if (i == 0) {
+			_first = next;
+
+		} else {
+			prev->setSibling(next);
+		}
+
+		prev = next;
+	}
+
+	_last = next;
+
+	if (_first) {
+		_timeout_interval_us = _first->get_timeout();
+	}
+}
+
+LegacyDataValidatorGroup::~LegacyDataValidatorGroup()
+{
+	while (_first) {
+		DataValidator *next = _first->sibling();
+		delete (_first);
+		_first = next;
+	}
+}
+
+DataValidator *LegacyDataValidatorGroup::add_new_validator()
+{
+
+	DataValidator *validator = new DataValidator();
+
+	if (!validator) {
+		return nullptr;
+	}
+
+	_last->setSibling(validator);
+	_last = validator;
+	_last->set_timeout(_timeout_interval_us);
+	return _last;
+}
+
+void LegacyDataValidatorGroup::set_timeout(uint32_t timeout_interval_us)
+{
+
+	DataValidator *next = _first;
+
+	while (next != nullptr) {
+		next->set_timeout(timeout_interval_us);
+		next = next->sibling();
+	}
+
+	_timeout_interval_us = timeout_interval_us;
+}
+
+void LegacyDataValidatorGroup::set_equal_value_threshold(uint32_t threshold)
+{
+
+	DataValidator *next = _first;
+
+	while (next != nullptr) {
+		next->set_equal_value_threshold(threshold);
+		next = next->sibling();
+	}
+}
+
+void LegacyDataValidatorGroup::put(unsigned index, uint64_t timestamp, const float val[3], uint32_t error_count,
+			     uint8_t priority)
+{
+
+	DataValidator *next = _first;
+	unsigned i = 0;
+
+	while (next != nullptr) {
+		if (i == index) {
+			next->put(timestamp, val, error_count, priority);
+			break;
+		}
+
+		next = next->sibling();
+		i++;
+	}
+}
+
+float *LegacyDataValidatorGroup::get_best(uint64_t timestamp, int *index)
+{
+
+	DataValidator *next = _first;
+
+	// XXX This should eventually also include voting
+	int pre_check_best = _curr_best;
+	float pre_check_confidence = 1.0f;
+	int pre_check_prio = -1;
+	float max_confidence = -1.0f;
+	int max_priority = -1000;
+	int max_index = -1;
+	DataValidator *best = nullptr;
+
+	int i = 0;
+
+	while (next != nullptr) {
+		float confidence = next->confidence(timestamp);
+
+		if (i == pre_check_best) {
+			pre_check_prio = next->priority();
+			pre_check_confidence = confidence;
+		}
+
+		/*
+		 * Switch if:
+		 * 1) the confidence is higher and priority is equal or higher
+		 * 2) the confidence is less than 1% different and the priority is higher
+		 */
+		if ((((max_confidence < MIN_REGULAR_CONFIDENCE) && (confidence >= MIN_REGULAR_CONFIDENCE)) ||
+		     (confidence > max_confidence && (next->priority() >= max_priority)) ||
+		     (fabsf(confidence - max_confidence) < 0.01f && (next->priority() > max_priority))) &&
+		    (confidence > 0.0f)) {
+			max_index = i;
+			max_confidence = confidence;
+			max_priority = next->priority();
+			best = next;
+		}
+
+		next = next->sibling();
+		i++;
+	}
+
+	/* the current best sensor is not matching the previous best sensor,
+	 * or the only sensor went bad */
+	if (max_index != _curr_best || ((max_confidence < FLT_EPSILON) && (_curr_best >= 0))) {
+		bool true_failsafe = true;
+
+		/* check whether the switch was a failsafe or preferring a higher priority sensor */
+		if (pre_check_prio != -1 && pre_check_prio < max_priority &&
+		    fabsf(pre_check_confidence - max_confidence) < 0.1f) {
+			/* this is not a failover */
+			true_failsafe = false;
+
+			/* reset error flags, this is likely a hotplug sensor coming online late */
+			if (best != nullptr) {
+				best->reset_state();
+			}
+		}
+
+		/* if we're no initialized, initialize the bookkeeping but do not count a failsafe */
+		if (_curr_best < 0) {
+			_prev_best = max_index;
+
+		} else {
+			/* we were initialized before, this is a real failsafe */
+			_prev_best = pre_check_best;
+
+			if (true_failsafe) {
+				_toggle_count++;
+
+				/* if this is the first time, log when we failed */
+				if (_first_failover_time == 0) {
+					_first_failover_time = timestamp;
+				}
+			}
+		}
+
+		/* for all cases we want to keep a record of the best index */
+		_curr_best = max_index;
+	}
+
+	*index = max_index;
+	return (best) ? best->value() : nullptr;
+}
+
+int LegacyDataValidatorGroup::failover_index()
+{
+	DataValidator *next = _first;
+	unsigned i = 0;
+
+	while (next != nullptr) {
+		if (next->used() && (next->state() != DataValidator::ERROR_FLAG_NO_ERROR) &&
+		    (i == (unsigned)_prev_best)) {
+			return i;
+		}
+
+		next = next->sibling();
+		i++;
+	}
+
+	return -1;
+}
+
+uint32_t LegacyDataValidatorGroup::failover_state()
+{
+
+	DataValidator *next = _first;
+	unsigned i = 0;
+
+	while (next != nullptr) {
+		if (next->used() && (next->state() != DataValidator::ERROR_FLAG_NO_ERROR) &&
+		    (i == (unsigned)_prev_best)) {
+			return next->state();
+		}
+
+		next = next->sibling();
+		i++;
+	}
+
+	return DataValidator::ERROR_FLAG_NO_ERROR;
+}
+
+uint32_t LegacyDataValidatorGroup::get_sensor_state(unsigned index)
+{
+	DataValidator *next = _first;
+	unsigned i = 0;
+
+	while (next != nullptr) {
+		if (i == index) {
+			return next->state();
+		}
+
+		next = next->sibling();
+		i++;
+	}
+
+	// sensor index not found
+	return UINT32_MAX;
+}
+
+uint8_t LegacyDataValidatorGroup::get_sensor_priority(unsigned index)
+{
+	DataValidator *next = _first;
+	unsigned i = 0;
+
+	while (next != nullptr) {
+		if (i == index) {
+			return next->priority();
+		}
+
+		next = next->sibling();
+		i++;
+	}
+
+	// sensor index not found
+	return 0;
+}
+
+} // namespace
+
+class DataValidatorGroupTest : public ::testing::Test
+{
+public:
+	struct Sample {
+		unsigned index;
+		uint64_t timestamp;
+		float val[3];
+		uint32_t error_count;
+		uint8_t priority;
+	};
+
+	/**
+	 * Random sensor data with stale values, NaNs, error bursts, priority changes and dropouts
+	 */
+	void generateSamples(Sample *samples, unsigned count, unsigned instances, unsigned seed);
+
+	template<typename Group>
+	void configure(Group &group, unsigned instances)
+	{
+		for (unsigned i = 1; i < instances; i++) {
+			group.add_new_validator();
+		}
+
+		group.set_timeout(20000);
+		group.set_equal_value_threshold(50);
+	}
+};
+
+void DataValidatorGroupTest::generateSamples(Sample *samples, unsigned count, unsigned instances, unsigned seed)
+{
+	srand(seed);
+
+	uint64_t timestamp = 1000000;
+	uint32_t error_count[DataValidatorGroup::MAX_VALIDATORS] {};
+	uint8_t priority[DataValidatorGroup::MAX_VALIDATORS] {};
+	float stale[DataValidatorGroup::MAX_VALIDATORS][3] {};
+
+	for (unsigned i = 0; i < instances; i++) {
+		priority[i] = 50 + 25 * (i % 3);
+	}
+
+	for (unsigned k = 0; k < count; k++) {
+		Sample &sample = samples[k];
+		const unsigned instance = rand() % instances;
+		const int event = rand() % 1000;
+
+		// dropouts of the other sensors make the selected one time out
+		timestamp += (event < 5) ? 30000 : 1000 + rand() % 500;
+
+		sample.index = instance;
+		sample.timestamp = timestamp;
+
+		for (unsigned axis = 0; axis < 3; axis++) {
+			sample.val[axis] = 9.81f * (axis == 2) + 0.1f * ((float)rand() / (float)RAND_MAX - 0.5f);
+		}
+
+		// the last instance gets stuck from time to time
+		if ((instance == instances - 1) && ((k / 500) % 2 == 1)) {
+			for (unsigned axis = 0; axis < 3; axis++) {
+				sample.val[axis] = stale[instance][axis];
+			}
+
+		} else {
+			for (unsigned axis = 0; axis < 3; axis++) {
+				stale[instance][axis] = sample.val[axis];
+			}
+		}
+
+		if (event < 20) {
+			sample.val[rand() % 3] = NAN;
+
+		} else if (event < 80) {
+			error_count[instance] += 1 + rand() % 30;
+
+		} else if (event < 85) {
+			priority[instance] = rand() % 256;
+		}
+
+		sample.error_count = error_count[instance];
+		sample.priority = priority[instance];
+	}
+}
+
+TEST_F(DataValidatorGroupTest, equivalence)
+{
+	// GIVEN: the legacy and the current implementation with the same configuration
+	static constexpr unsigned N_SAMPLES = 20000;
+	Sample *samples = new Sample[N_SAMPLES];
+
+	for (unsigned instances = 1; instances <= DataValidatorGroup::MAX_VALIDATORS; instances++) {
+		DataValidatorGroup group{1};
+		LegacyDataValidatorGroup legacy_group{1};
+		configure(group, instances);
+		configure(legacy_group, instances);
+
+		generateSamples(samples, N_SAMPLES, instances, instances);
+
+		unsigned best_changes = 0;
+		int last_best = -1;
+
+		// WHEN: the same samples are put into both groups
+		for (unsigned k = 0; k < N_SAMPLES; k++) {
+			const Sample &s = samples[k];
+			group.put(s.index, s.timestamp, s.val, s.error_count, s.priority);
+			legacy_group.put(s.index, s.timestamp, s.val, s.error_count, s.priority);
+
+			// THEN: the best sensor, its data and the error states are identical
+			int best_index = -2;
+			int legacy_best_index = -2;
+			const float *best = group.get_best(s.timestamp, &best_index);
+			const float *legacy_best = legacy_group.get_best(s.timestamp, &legacy_best_index);
+
+			ASSERT_EQ(best_index, legacy_best_index) << "instances: " << instances << " sample: " << k;
+			ASSERT_EQ(best == nullptr, legacy_best == nullptr);
+
+			if (best != nullptr) {
+				for (unsigned axis = 0; axis < 3; axis++) {
+					ASSERT_EQ(memcmp(&best[axis], &legacy_best[axis], sizeof(float)), 0);
+				}
+			}
+
+			ASSERT_EQ(group.failover_count(), legacy_group.failover_count());
+			ASSERT_EQ(group.failover_index(), legacy_group.failover_index());
+			ASSERT_EQ(group.failover_state(), legacy_group.failover_state());
+
+			for (unsigned i = 0; i <= instances; i++) {
+				ASSERT_EQ(group.get_sensor_state(i), legacy_group.get_sensor_state(i));
+				ASSERT_EQ(group.get_sensor_priority(i), legacy_group.get_sensor_priority(i));
+			}
+
+			if (best_index != last_best) {
+				best_changes++;
+				last_best = best_index;
+			}
+		}
+
+		// the data exercises the sensor switching
+		if (instances > 1) {
+			EXPECT_GT(best_changes, 10u);
+			EXPECT_GT(group.failover_count(), 0u);
+		}
+	}
+
+	delete[] samples;
+}
+
+// scenarios of the previous standalone group test, with data that does not get stale
+
+static void randomData(float data[3])
+{
+	for (int axis = 0; axis < 3; axis++) {
+		data[axis] = (float)rand() / (float)RAND_MAX;
+	}
+}
+
+TEST_F(DataValidatorGroupTest, init)
+{
+	DataValidatorGroup group{2};
+	configure(group, 2);
+
+	// no failovers and no best value yet
+	EXPECT_EQ(group.failover_count(), 0u);
+	EXPECT_EQ(group.failover_state(), DataValidator::ERROR_FLAG_NO_ERROR);
+	EXPECT_EQ(group.failover_index(), -1);
+
+	int best_index = -1;
+	EXPECT_EQ(group.get_best(1000, &best_index), nullptr);
+}
+
+TEST_F(DataValidatorGroupTest, prioritySwitch)
+{
+	DataValidatorGroup group{2};
+	configure(group, 2);
+	uint64_t timestamp = 1000;
+	float data[3] {};
+
+	// two sensors with identical values, but different priorities
+	for (int i = 0; i < 100; i++) {
+		randomData(data);
+		group.put(0, timestamp, data, 0, 100);
+		group.put(1, timestamp, data, 0, 10);
+		timestamp += 1000;
+	}
+
+	int best_index = -1;
+	const float *best = group.get_best(timestamp, &best_index);
+	ASSERT_NE(best, nullptr);
+	EXPECT_EQ(best_index, 0);
+	EXPECT_EQ(best[0], data[0]);
+
+	// a single sample with switched priorities switches the best sensor, but is not a failover
+	randomData(data);
+	group.put(0, timestamp, data, 0, 1);
+	group.put(1, timestamp, data, 0, 100);
+	best = group.get_best(timestamp, &best_index);
+	ASSERT_NE(best, nullptr);
+	EXPECT_EQ(best_index, 1);
+	EXPECT_EQ(best[0], data[0]);
+	EXPECT_EQ(group.failover_count(), 0u);
+}
+
+TEST_F(DataValidatorGroupTest, simpleFailover)
+{
+	DataValidatorGroup group{2};
+	configure(group, 2);
+	uint64_t timestamp = 1000;
+	float data[3] {};
+
+	for (int i = 0; i < 100; i++) {
+		randomData(data);
+		group.put(0, timestamp, data, 0, 100);
+		group.put(1, timestamp, data, 0, 10);
+		timestamp += 1000;
+	}
+
+	int best_index = -1;
+	ASSERT_NE(group.get_best(timestamp, &best_index), nullptr);
+	EXPECT_EQ(best_index, 0);
+
+	// errors on the best sensor
+	for (uint32_t error_count = 1; error_count <= 25; error_count++) {
+		randomData(data);
+		group.put(0, timestamp, data, error_count, 100);
+		group.put(1, timestamp, data, 0, 10);
+		timestamp += 1000;
+	}
+
+	// the sensor without errors is preferred, which is counted as failover
+	const float *best = group.get_best(timestamp, &best_index);
+	ASSERT_NE(best, nullptr);
+	EXPECT_EQ(best_index, 1);
+	EXPECT_EQ(best[0], data[0]);
+	EXPECT_EQ(group.failover_count(), 1u);
+
+	// the sensor with errors did not fail, so there is no failed sensor
+	EXPECT_EQ(group.get_sensor_state(0), DataValidator::ERROR_FLAG_NO_ERROR);
+	EXPECT_EQ(group.failover_index(), -1);
+	EXPECT_EQ(group.failover_state(), DataValidator::ERROR_FLAG_NO_ERROR);
+}
+
+TEST_F(DataValidatorGroupTest, sensorTimeout)
+{
+	DataValidatorGroup group{1};
+	configure(group, 1);
+	uint64_t timestamp = 1000;
+	float data[3] {};
+
+	for (int i = 0; i < 100; i++) {
+		randomData(data);
+		group.put(0, timestamp, data, 0, 100);
+		timestamp += 1000;
+	}
+
+	int best_index = -1;
+	ASSERT_NE(group.get_best(timestamp, &best_index), nullptr);
+	EXPECT_EQ(best_index, 0);
+
+	// no data for longer than the timeout
+	group.get_best(timestamp + 30000, &best_index);
+	EXPECT_TRUE(group.get_sensor_state(0) & DataValidator::ERROR_FLAG_TIMEOUT);
+	EXPECT_EQ(group.failover_index(), 0);
+	EXPECT_TRUE(group.failover_state() & DataValidator::ERROR_FLAG_TIMEOUT);
+}
+
+TEST_F(DataValidatorGroupTest, full)
+{
+	DataValidatorGroup group{DataValidatorGroup::MAX_VALIDATORS};
+	EXPECT_FALSE(group.add_new_validator());
+	EXPECT_EQ(group.get_sensor_state(DataValidatorGroup::MAX_VALIDATORS), UINT32_MAX);
+}
+
+// not part of the unit tests, run with --gtest_also_run_disabled_tests
+TEST_F(DataValidatorGroupTest, DISABLED_Benchmark)
+{
+	// one put per sensor and a selection per cycle, as the sensors module does it
+	static constexpr unsigned N_SAMPLES = 40000;
+	static constexpr unsigned instances = DataValidatorGroup::MAX_VALIDATORS;
+	Sample *samples = new Sample[N_SAMPLES];
+	generateSamples(samples, N_SAMPLES, instances, 1);
+
+	DataValidatorGroup group{1};
+	LegacyDataValidatorGroup legacy_group{1};
+	configure(group, instances);
+	configure(legacy_group, instances);
+
+	int index_sum = 0;
+	int legacy_index_sum = 0;
+
+	const auto legacy_start = std::chrono::steady_clock::now();
+
+	for (unsigned k = 0; k < N_SAMPLES; k++) {
+		const Sample &s = samples[k];
+		legacy_group.put(s.index, s.timestamp, s.val, s.error_count, s.priority);
+
+		if (s.index == instances - 1) {
+			int best_index = -1;
+			legacy_group.get_best(s.timestamp, &best_index);
+			legacy_index_sum += best_index;
+		}
+	}
+
+	const auto legacy_end = std::chrono::steady_clock::now();
+
+	for (unsigned k = 0; k < N_SAMPLES; k++) {
+		const Sample &s = samples[k];
+		group.put(s.index, s.timestamp, s.val, s.error_count, s.priority);
+
+		if (s.index == instances - 1) {
+			int best_index = -1;
+			group.get_best(s.timestamp, &best_index);
+			index_sum += best_index;
+		}
+	}
+
+	const auto end = std::chrono::steady_clock::now();
+
+	const double legacy_ns = std::chrono::duration<double, std::nano>(legacy_end - legacy_start).count() / N_SAMPLES;
+	const double ns = std::chrono::duration<double, std::nano>(end - legacy_end).count() / N_SAMPLES;
+	printf("%u sensors, per sample: linked list %.1f ns, structure of arrays %.1f ns\n", instances, legacy_ns, ns);
+
+	EXPECT_EQ(index_sum, legacy_index_sum);
+
+	delete[] samples;
+}
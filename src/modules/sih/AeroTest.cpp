@@ -0,0 +1,284 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file AeroTest.cpp
+ *
+ * Regression test of the aerodynamic segment: the precomputed and cached terms of AeroSeg give the
+ * same forces and moments as the model evaluated from scratch in every update, as it was before.
+ */
+
+#include <gtest/gtest.h>
+
+#include "aero.hpp"
+
+using namespace matrix;
+
+// the model before the geometry and deflection terms were precomputed, without the unused members
+class PreviousAeroSeg
+{
+public:
+	PreviousAeroSeg(float span, float mac, float alpha_0_deg, const Vector3f &p_B, float dihedral_deg = 0.0f,
+			float AR = -1.0f, float cf = 0.0f, float prop_radius = -1.0f, float cl_alpha = 2.0f * M_PI_F)
+	{
+		static const float AR_tab[N_TAB] = {0.1666f, 0.333f, 0.4f, 0.5f, 1.0f, 1.25f, 2.0f, 3.0f, 4.0f, 6.0f};
+		static const float afs_tab[N_TAB] = {49.00f, 54.00f, 56.00f, 48.00f, 40.00f, 29.00f, 27.00f, 25.00f, 24.00f, 22.00f, 22.00f, 20.00f};
+
+		_span = span;
+		_mac = mac;
+		_alpha_0 = math::radians(alpha_0_deg);
+		_p_B = p_B;
+		_ar = (AR <= 0.0f) ? _span / _mac : AR;
+		_kp = cl_alpha / (1.0f + 2.0f * (_ar + 4.0f) / (_ar * (_ar + 2.0f)));
+		_kn = 0.41f * (1.0f - expf(-17.0f / _ar));
+		const float afs_rad = math::radians(lin_interp_lkt(AR_tab, afs_tab, _ar, N_TAB));
+		_alpha_max = afs_rad;
+		_alpha_min = -afs_rad;
+		_cf = math::constrain(cf, 0.0f, mac);
+		_C_BS = Dcmf(Eulerf(math::radians(dihedral_deg), 0.0f, 0.0f));
+		_prop_radius = prop_radius;
+	}
+
+	void update_aero_rho(const Vector3f &v_B, const Vector3f &w_B, float rho, float def = 0.0f, float thrust = 0.0f)
+	{
+		_rho = rho;
+		Vector3f v_S = _C_BS.transpose() * (v_B + w_B % _p_B);
+
+		if (_prop_radius > 1e-4f) {
+			v_S(0) += sqrtf(2.0f * thrust / (_rho * M_PI_F * _prop_radius * _prop_radius));
+		}
+
+		const float vxz2 = v_S(0) * v_S(0) + v_S(2) * v_S(2);
+
+		if (vxz2 < 0.01f) {
+			_Fa = Vector3f();
+			_Ma = Vector3f();
+			return;
+		}
+
+		const float alpha = wrap_pi(atan2f(v_S(2), v_S(0)) - _alpha_0);
+		aoa_coeff(alpha, def);
+		_Fa = _C_BS * (0.5f * _rho * vxz2 * _span * _mac) * Vector3f(_CL * sinf(alpha) - _CD * cosf(alpha),
+				0.0f, -_CL * cosf(alpha) - _CD * sinf(alpha));
+		_Ma = _C_BS * (0.5f * _rho * vxz2 * _span * _mac * _mac) * Vector3f(0.0f, _CM, 0.0f) + _p_B % _Fa;
+	}
+
+	const Vector3f &get_Fa() const { return _Fa; }
+	const Vector3f &get_Ma() const { return _Ma; }
+
+private:
+	static constexpr int N_TAB = 12;
+	static constexpr float ETA_POLY[] = {0.0535f, -0.2688f, 0.5817f};
+	static constexpr float KV = M_PI_F;
+	static constexpr float CD0 = 0.04f;
+	static constexpr float CD90 = 1.98f;
+	static constexpr float ALPHA_BLEND = M_PI_F / 18.0f;
+	static constexpr float FTE = 1.0f; // the dynamic separation model is disabled
+	static constexpr float FLE = 1.0f;
+
+	void aoa_coeff(float a, float def)
+	{
+		float alpha_eff;
+		float alpha_eff_max;
+		float alpha_eff_min;
+
+		if (_cf / _mac < 0.999f) {
+			const float def_a = fminf(fabsf(def), math::radians(70.0f));
+			const float eta_f = def_a * def_a * ETA_POLY[0] + def_a * ETA_POLY[1] + ETA_POLY[2];
+			const float theta_f = acosf(2.0f * _cf / _mac - 1.0f);
+			const float tau_f = 1.0f - (theta_f - sinf(theta_f)) / M_PI_F;
+			const float deltaCL = _kp * tau_f * eta_f * def;
+			const float dCLmax = (1.0f - _cf / _mac) * deltaCL;
+			const float alf0eff = solve_alpha_eff(_kp, KV, deltaCL, _alpha_0);
+			alpha_eff = a - alf0eff;
+
+			const float CLmax = fCL(_alpha_max - _alpha_0) + dCLmax;
+			alpha_eff_max = alf0eff - solve_alpha_eff(_kp, KV * FLE * FLE,
+					CLmax / (0.25f * (1.0f + sqrtf(FTE)) * (1.0f + sqrtf(FTE))), _alpha_max - _alpha_0);
+			const float CLmin = fCL(_alpha_min - _alpha_0) + dCLmax;
+			alpha_eff_min = alf0eff - solve_alpha_eff(_kp, KV * FLE * FLE,
+					CLmin / (0.25f * (1.0f + sqrtf(FTE)) * (1.0f + sqrtf(FTE))), _alpha_min - _alpha_0);
+
+		} else {
+			alpha_eff = a + def;
+			alpha_eff_max = _alpha_max;
+			alpha_eff_min = _alpha_min;
+		}
+
+		high_aoa_coeff(alpha_eff, def);
+		const float CL_ = fCL(alpha_eff);
+		const float CD_ = CD0 + fabsf(_CL * tanf(alpha_eff));
+		const float CM_ = -fCM(alpha_eff);
+
+		float f_blend;
+
+		if (alpha_eff > 0.0f) {
+			f_blend = 0.5f * (1.0f - tanhf(4.0f * (alpha_eff - alpha_eff_max) / ALPHA_BLEND));
+
+		} else {
+			f_blend = 0.5f * (1.0f - tanhf(-4.0f * (alpha_eff - alpha_eff_min) / ALPHA_BLEND));
+		}
+
+		_CL = CL_ * f_blend + _CL * (1.0f - f_blend);
+		_CD = CD_ * f_blend + _CD * (1.0f - f_blend);
+		_CM = CM_ * f_blend + _CM * (1.0f - f_blend);
+	}
+
+	void high_aoa_coeff(float a, float def)
+	{
+		const float mac_eff = sqrtf((_mac - _cf) * (_mac - _cf) + _cf * _cf + 2.0f * (_mac - _cf) * _cf * cosf(fabsf(def)));
+		a += asinf(_cf / mac_eff * sinf(def));
+		const float cd90_eff = CD90 + 0.21f * def - 0.0426f * def * def;
+		const float CN = cd90_eff * sinf(a) * (1.0f / (0.56f + 0.44f * sinf(fabsf(a))) - _kn);
+		const float CT = 0.5f * CD0 * cosf(a);
+		_CL = CN * cosf(a) - CT * sinf(a);
+		_CD = CN * sinf(a) + CT * cosf(a);
+		_CM = -CN * (0.25f - 7.0f / 40.0f * (1.0f - 2.0f / M_PI_F * fabsf(a)));
+	}
+
+	static float lin_interp_lkt(const float x_tab[], const float y_tab[], const float x, const int length)
+	{
+		if (x < x_tab[0]) {
+			return y_tab[0];
+		}
+
+		if (x > x_tab[length - 1]) {
+			return y_tab[length - 1];
+		}
+
+		int i = length - 2;
+
+		while (x_tab[i] > x) {
+			i--;
+		}
+
+		return y_tab[i] + (y_tab[i + 1] - y_tab[i]) / (x_tab[i + 1] - x_tab[i]) * (x - x_tab[i]);
+	}
+
+	float solve_alpha_eff(const float Kp, const float Kv, const float dCL, const float a0)
+	{
+		float a = a0;
+
+		for (int i = 0; i < 3; i++) {
+			a = a - (-Kp * sinf(a) * cosf(a) * cosf(a) - Kv * fabsf(sinf(a)) * sinf(a) * cosf(a) - dCL) /
+			    (Kv * fabsf(sinf(a)) * sinf(a) * sinf(a) - Kv * fabsf(sinf(a)) * cosf(a) * cosf(a) - Kp * cosf(a) * cosf(a) * cosf(
+				     a) + 2 * Kp * cosf(a) * sinf(a) * sinf(a) - Kv * sign(sinf(a)) * cosf(a) * cosf(a) * sinf(a));
+		}
+
+		return a;
+	}
+
+	float fCL(float a)
+	{
+		return 0.25f * (1.0f + sqrtf(FTE)) * (1.0f + sqrtf(FTE)) * (_kp * sinf(a) * cosf(a) * cosf(a)
+				+ FLE * FLE * KV * fabsf(sinf(a)) * sinf(a) * cosf(a));
+	}
+
+	float fCM(float a)
+	{
+		return -0.25f * (1.0f + sqrtf(FTE)) * (1.0f + sqrtf(FTE)) * 0.0625f
+		       * (-1.0f + 6.0f * sqrtf(FTE) - 5.0f * FTE) * _kp * sinf(a) * cosf(a) + 0.17f * FLE * FLE * KV * fabsf(sinf(a)) * sinf(a);
+	}
+
+	float _CL{0.f}, _CD{0.f}, _CM{0.f};
+	Vector3f _p_B;
+	Dcmf _C_BS;
+	float _ar, _span, _mac, _alpha_0, _kp, _kn, _cf, _alpha_min, _alpha_max, _prop_radius;
+	float _rho{1.225f};
+	Vector3f _Fa;
+	Vector3f _Ma;
+};
+
+constexpr float PreviousAeroSeg::ETA_POLY[];
+
+// the segment geometries of the sih fixed-wing, including a full flap segment
+struct Segment {
+	float span, mac, alpha_0_deg;
+	Vector3f p_B;
+	float dihedral_deg, AR, cf, prop_radius;
+};
+
+static const Segment SEGMENTS[] = {
+	{0.43f, 0.21f, -4.0f, Vector3f(0.0f, -0.215f, 0.0f), 3.0f, 0.86f / 0.21f, 0.07f, -1.0f}, // wing
+	{0.3f, 0.1f, 0.0f, Vector3f(-0.4f, 0.0f, 0.0f), 0.0f, -1.0f, 0.05f, 0.1f}, // tailplane in the slipstream
+	{0.25f, 0.18f, 0.0f, Vector3f(-0.45f, 0.0f, -0.1f), -90.0f, -1.0f, 0.12f, 0.1f}, // fin in the slipstream
+	{0.2f, 0.8f, 0.0f, Vector3f(0.0f, 0.0f, 0.0f), -90.0f, -1.0f, 0.0f, -1.0f}, // fuselage
+	{0.1f, 0.05f, 0.0f, Vector3f(-0.1f, 0.2f, 0.0f), 0.0f, 4.0f, 0.05f, -1.0f}, // full flap
+};
+
+// relative to the magnitude of the previous result, absolute for forces close to 0
+static float difference(const Vector3f &current, const Vector3f &previous)
+{
+	return (current - previous).norm() / fmaxf(previous.norm(), 1e-3f);
+}
+
+TEST(AeroTest, MatchesPreviousModel)
+{
+	const float rho = AeroSeg::air_density(500.f);
+	const Vector3f w_B(0.3f, -0.5f, 0.2f);
+	// the deflection changes and changes back at the same state
+	const float deflections[] = {0.f, -0.1f, 0.35f, -0.1f, -0.6f, 0.f};
+	const float thrusts[] = {0.f, 2.f, 10.f};
+
+	float max_difference = 0.f;
+
+	for (const Segment &seg : SEGMENTS) {
+		// one instance over the whole sweep, the cached deflection terms change and are reused
+		AeroSeg current(seg.span, seg.mac, seg.alpha_0_deg, seg.p_B, seg.dihedral_deg, seg.AR, seg.cf,
+				seg.prop_radius);
+		PreviousAeroSeg previous(seg.span, seg.mac, seg.alpha_0_deg, seg.p_B, seg.dihedral_deg, seg.AR, seg.cf,
+					 seg.prop_radius);
+		const Dcmf C_BS(Eulerf(math::radians(seg.dihedral_deg), 0.0f, 0.0f));
+
+		for (int alpha_deg = -180; alpha_deg < 180; alpha_deg += 3) {
+			// velocity at the angle of attack in the segment frame, with some side slip
+			const float alpha = math::radians((float)alpha_deg);
+			const Vector3f v_B = C_BS * Vector3f(15.f * cosf(alpha), 2.f, 15.f * sinf(alpha));
+
+			for (float thrust : thrusts) {
+				for (float def : deflections) {
+					current.update_aero_rho(v_B, w_B, rho, def, thrust);
+					previous.update_aero_rho(v_B, w_B, rho, def, thrust);
+
+					const float force = difference(current.get_Fa(), previous.get_Fa());
+					const float moment = difference(current.get_Ma(), previous.get_Ma());
+					EXPECT_LT(force, 1e-4f) << "alpha " << alpha_deg << ", def " << def << ", thrust " << thrust;
+					EXPECT_LT(moment, 1e-4f) << "alpha " << alpha_deg << ", def " << def << ", thrust " << thrust;
+					max_difference = fmaxf(max_difference, fmaxf(force, moment));
+				}
+			}
+		}
+	}
+
+	printf("max relative difference to the previous model: %.1e\n", (double)max_difference);
+}
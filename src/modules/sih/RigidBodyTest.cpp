@@ -0,0 +1,228 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file RigidBodyTest.cpp
+ *
+ * Tests for the rigid body integration of sih: Euler reproduces the historical integration, and the
+ * energy of conservative motions drifts less with the higher order integrators. The benchmark prints
+ * the integration rate and the energy drift of each integrator (disabled by default).
+ */
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <stdio.h>
+
+#include "aero.hpp"
+#include "rigid_body.hpp"
+
+using namespace matrix;
+using sih::Integrator;
+
+static constexpr float G = 9.80665f;
+static constexpr float DT = 0.004f;
+
+static sih::RigidBody asymmetric_body()
+{
+	sih::RigidBody body;
+	body.set_mass(1.5f);
+	body.set_inertia(diag(Vector3f(0.02f, 0.03f, 0.05f)));
+	return body;
+}
+
+// tumbling around the unstable intermediate axis, and thrown upward
+static sih::State tumbling_state()
+{
+	return sih::State{Vector3f(0.f, 0.f, -10.f), Vector3f(3.f, 0.f, -8.f), Quatf(), Vector3f(0.1f, 8.f, 0.1f)};
+}
+
+// gravity only, the total energy is conserved
+static void gravity(const sih::RigidBody &body, const sih::State &, Vector3f &F_I, Vector3f &M_B)
+{
+	F_I = Vector3f(0.f, 0.f, body.mass() * G);
+	M_B.setZero();
+}
+
+static float total_energy(const sih::RigidBody &body, const sih::State &x)
+{
+	return body.kinetic_energy(x) - body.mass() * G * x.p_I(2);
+}
+
+// relative energy drift after the given duration
+static float energy_drift(Integrator method, int substeps, float duration)
+{
+	const sih::RigidBody body = asymmetric_body();
+	sih::State x = tumbling_state();
+	const float energy_0 = total_energy(body, x);
+	auto wrench = [&body](const sih::State & x_i, Vector3f & F_I, Vector3f & M_B) { gravity(body, x_i, F_I, M_B); };
+
+	for (int i = 0; i < (int)(duration / DT + 0.5f); i++) {
+		Vector3f F_I;
+		Vector3f M_B;
+		wrench(x, F_I, M_B);
+		body.integrate(x, body.derivative(x, F_I, M_B), DT, method, substeps, wrench);
+	}
+
+	return fabsf(total_energy(body, x) - energy_0) / energy_0;
+}
+
+TEST(RigidBodyTest, EulerMatchesHistoricalIntegration)
+{
+	const sih::RigidBody body = asymmetric_body();
+	const Matrix3f I = body.inertia();
+	const Matrix3f Im1 = 100.0f * inv(static_cast<Matrix3f>(100.0f * I));
+	sih::State x = tumbling_state();
+	x.q = Quatf(Eulerf(0.1f, -0.2f, 0.3f));
+
+	const Vector3f F_I(0.5f, -1.f, -12.f);
+	const Vector3f M_B(0.01f, -0.02f, 0.03f);
+
+	// integration of sih before the rigid body was factored out
+	const Vector3f p_I = x.p_I + x.v_I * DT;
+	const Vector3f v_I = x.v_I + F_I / body.mass() * DT;
+	Quatf q = x.q * Quatf::expq(0.5f * DT * x.w_B);
+	q.normalize();
+	const Vector3f w_B = x.w_B + Im1 * (M_B - x.w_B.cross(I * x.w_B)) * DT;
+
+	body.integrate(x, body.derivative(x, F_I, M_B), DT, Integrator::Euler, 1,
+	[](const sih::State &, Vector3f &, Vector3f &) { FAIL() << "Euler with a single sub-step evaluates no stage"; });
+
+	for (int i = 0; i < 3; i++) {
+		EXPECT_FLOAT_EQ(x.p_I(i), p_I(i));
+		EXPECT_FLOAT_EQ(x.v_I(i), v_I(i));
+		EXPECT_FLOAT_EQ(x.w_B(i), w_B(i));
+	}
+
+	for (int i = 0; i < 4; i++) {
+		EXPECT_FLOAT_EQ(x.q(i), q(i));
+	}
+}
+
+TEST(RigidBodyTest, ConstantRateIsExact)
+{
+	// around a principal axis the rate stays constant, and each integrator follows the exact rotation
+	sih::RigidBody body = asymmetric_body();
+	const Vector3f w_B(0.f, 0.f, 2.f);
+
+	for (Integrator method : {Integrator::Euler, Integrator::RK2, Integrator::RK4}) {
+		sih::State x{Vector3f(), Vector3f(), Quatf(), w_B};
+		auto wrench = [](const sih::State &, Vector3f & F_I, Vector3f & M_B) { F_I.setZero(); M_B.setZero(); };
+
+		for (int i = 0; i < 250; i++) {
+			body.integrate(x, body.derivative(x, Vector3f(), Vector3f()), DT, method, 2, wrench);
+		}
+
+		const Quatf q_expected(AxisAnglef(Vector3f(0.f, 0.f, 1.f), 2.f * 250 * DT));
+		EXPECT_NEAR(Quatf(x.q * q_expected.inversed()).canonical()(0), 1.f, 1e-6f);
+		EXPECT_NEAR(x.q.norm(), 1.f, 1e-6f);
+	}
+}
+
+TEST(RigidBodyTest, EnergyDrift)
+{
+	const float euler = energy_drift(Integrator::Euler, 1, 2.f);
+	const float euler_substeps = energy_drift(Integrator::Euler, 4, 2.f);
+	const float rk2 = energy_drift(Integrator::RK2, 1, 2.f);
+	const float rk4 = energy_drift(Integrator::RK4, 1, 2.f);
+
+	// Euler gains energy from the tumbling and the ballistic motion, the sub-steps reduce the error linearly
+	EXPECT_GT(euler, 1e-3f);
+	EXPECT_LT(euler_substeps, euler / 2.f);
+	EXPECT_LT(rk2, euler / 100.f);
+	EXPECT_LT(rk4, 1e-5f);
+}
+
+// not part of the unit tests, run with --gtest_also_run_disabled_tests
+TEST(RigidBodyTest, DISABLED_Benchmark)
+{
+	// fixed-wing like body: gravity, drag and the aerodynamic segments of sih
+	sih::RigidBody body = asymmetric_body();
+	AeroSeg segments[] = {
+		AeroSeg(0.43f, 0.21f, -4.0f, Vector3f(0.0f, -0.215f, 0.0f), 3.0f, 0.86f / 0.21f, 0.07f),
+		AeroSeg(0.43f, 0.21f, -4.0f, Vector3f(0.0f, 0.215f, 0.0f), -3.0f, 0.86f / 0.21f, 0.07f),
+		AeroSeg(0.3f, 0.1f, 0.0f, Vector3f(-0.4f, 0.0f, 0.0f), 0.0f, -1.0f, 0.05f, 0.1f),
+		AeroSeg(0.25f, 0.18f, 0.0f, Vector3f(-0.45f, 0.0f, -0.1f), -90.0f, -1.0f, 0.12f, 0.1f),
+		AeroSeg(0.2f, 0.8f, 0.0f, Vector3f(0.0f, 0.0f, 0.0f), -90.0f),
+	};
+
+	auto wrench = [&](const sih::State & x, Vector3f & F_I, Vector3f & M_B) {
+		const Dcmf C_IB(x.q);
+		const Vector3f v_B = C_IB.transpose() * x.v_I;
+		const float rho = AeroSeg::air_density(-x.p_I(2));
+		Vector3f Fa_B(2.f, 0.f, 0.f); // thrust
+		M_B = -0.025f * x.w_B;
+
+		for (AeroSeg &segment : segments) {
+			segment.update_aero_rho(v_B, x.w_B, rho, 0.05f, 2.f);
+			Fa_B += segment.get_Fa();
+			M_B += segment.get_Ma();
+		}
+
+		F_I = C_IB * Fa_B + Vector3f(0.f, 0.f, body.mass() * G) - 0.1f * x.v_I;
+	};
+
+	struct Case {
+		const char *name;
+		Integrator method;
+		int substeps;
+	};
+
+	const Case cases[] = {
+		{"Euler", Integrator::Euler, 1},
+		{"Euler x4", Integrator::Euler, 4},
+		{"RK2", Integrator::RK2, 1},
+		{"RK4", Integrator::RK4, 1},
+		{"RK4 x4", Integrator::RK4, 4},
+	};
+
+	static constexpr int STEPS = 20000;
+
+	printf("integrator  aero steps/s  energy drift (2 s)\n");
+
+	for (const Case &c : cases) {
+		sih::State x{Vector3f(0.f, 0.f, -100.f), Vector3f(15.f, 0.f, 0.f), Quatf(), Vector3f()};
+
+		const auto start = std::chrono::steady_clock::now();
+
+		for (int i = 0; i < STEPS; i++) {
+			Vector3f F_I;
+			Vector3f M_B;
+			wrench(x, F_I, M_B);
+			body.integrate(x, body.derivative(x, F_I, M_B), DT, c.method, c.substeps, wrench);
+		}
+
+		const double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		printf("%-10s  %12.0f  %18.2e\n", c.name, STEPS / elapsed_s, (double)energy_drift(c.method, c.substeps, 2.f));
+	}
+}
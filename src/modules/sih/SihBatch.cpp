@@ -0,0 +1,482 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+#include "SihBatch.hpp"
+
+#include <lib/geo/geo.h>
+#include <math.h>
+#include <string.h>
+
+namespace
+{
+
+// sensor noise standard deviations
+static constexpr float ACC_NOISE = 0.5f;	// [m/s^2]
+static constexpr float GYRO_NOISE = 0.05f;	// [rad/s]
+static constexpr float MAG_NOISE = 0.02f;	// [G]
+static constexpr float POS_NOISE = 0.2f;	// [m]
+
+// NED magnetic field [G]
+static constexpr float MU_X = 0.2f;
+static constexpr float MU_Y = 0.f;
+static constexpr float MU_Z = 0.4f;
+
+// estimator gains
+static constexpr float EST_ATT_P = 0.5f;	// attitude correction [rad/s]
+static constexpr float EST_POS_P = 4.f;		// position correction [1/s]
+static constexpr float EST_VEL_P = 4.f;		// velocity correction [1/s^2]
+
+// controller gains and limits
+static constexpr float POS_P = 1.f;
+static constexpr float VEL_MAX = 3.f;
+static constexpr float VEL_P = 2.f;
+static constexpr float VEL_I = 1.f;
+static constexpr float VEL_INT_MAX = 3.f;	// [m/s^2]
+static constexpr float ATT_P = 6.f;
+static constexpr float RATE_P = 15.f;
+static constexpr float RATE_MAX = 6.f * M_PI_F;
+
+// xorshift32, cheap enough to draw noise for every vehicle in every step
+static inline float uniform(uint32_t &state)
+{
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return (float)(state >> 8) * (1.f / 16777216.f);
+}
+
+// approximately Gaussian (Irwin-Hall with 4 samples) with standard deviation 1
+static inline float gauss(uint32_t &state)
+{
+	return (uniform(state) + uniform(state) + uniform(state) + uniform(state) - 2.f) * 1.7320508f;
+}
+
+static inline float constrain(float value, float min, float max)
+{
+	return (value < min) ? min : ((value > max) ? max : value);
+}
+
+// body to inertial rotation matrix of a quaternion
+struct Dcm {
+	Dcm(float qw, float qx, float qy, float qz)
+	{
+		r00 = 1.f - 2.f * (qy * qy + qz * qz);
+		r01 = 2.f * (qx * qy - qw * qz);
+		r02 = 2.f * (qx * qz + qw * qy);
+		r10 = 2.f * (qx * qy + qw * qz);
+		r11 = 1.f - 2.f * (qx * qx + qz * qz);
+		r12 = 2.f * (qy * qz - qw * qx);
+		r20 = 2.f * (qx * qz - qw * qy);
+		r21 = 2.f * (qy * qz + qw * qx);
+		r22 = 1.f - 2.f * (qx * qx + qy * qy);
+	}
+
+	float r00, r01, r02, r10, r11, r12, r20, r21, r22;
+};
+
+// integrate q' = 0.5 q * (0, w) over dt and normalize
+static inline void integrate_quaternion(float &qw, float &qx, float &qy, float &qz, float wx, float wy, float wz,
+					float dt)
+{
+	const float h = 0.5f * dt;
+	const float dqw = -qx * wx - qy * wy - qz * wz;
+	const float dqx = qw * wx + qy * wz - qz * wy;
+	const float dqy = qw * wy - qx * wz + qz * wx;
+	const float dqz = qw * wz + qx * wy - qy * wx;
+
+	qw += h * dqw;
+	qx += h * dqx;
+	qy += h * dqy;
+	qz += h * dqz;
+
+	const float norm_inv = 1.f / sqrtf(qw * qw + qx * qx + qy * qy + qz * qz);
+	qw *= norm_inv;
+	qx *= norm_inv;
+	qy *= norm_inv;
+	qz *= norm_inv;
+}
+
+} // namespace
+
+SihBatch::~SihBatch()
+{
+	delete[] _data;
+	delete[] _rng;
+}
+
+bool SihBatch::init(const Config &config)
+{
+	delete[] _data;
+	delete[] _rng;
+	_data = nullptr;
+	_rng = nullptr;
+	_num_vehicles = 0;
+	_steps = 0;
+
+	if ((config.num_vehicles <= 0) || !(config.dt > 0.f)) {
+		return false;
+	}
+
+	_config = config;
+
+	// every field starts at a cache line
+	_stride = ((size_t)config.num_vehicles + 15) & ~(size_t)15;
+	_data = new float[_stride * NUM_FIELDS];
+	_rng = new uint32_t[_stride];
+
+	if ((_data == nullptr) || (_rng == nullptr)) {
+		return false;
+	}
+
+	_num_vehicles = config.num_vehicles;
+	memset(_data, 0, _stride * NUM_FIELDS * sizeof(float));
+
+	for (int i = 0; i < _num_vehicles; i++) {
+		// xorshift must not start at 0
+		uint32_t rng = (config.seed + 1) * 2654435761u + (uint32_t)i * 40503u;
+		rng = (rng == 0) ? 1 : rng;
+
+		const Vehicle &nominal = config.nominal;
+		const float spread = config.spread;
+
+		field(MASS)[i] = nominal.mass * (1.f + spread * (2.f * uniform(rng) - 1.f));
+		field(IXX)[i] = nominal.ixx * (1.f + spread * (2.f * uniform(rng) - 1.f));
+		field(IYY)[i] = nominal.iyy * (1.f + spread * (2.f * uniform(rng) - 1.f));
+		field(IZZ)[i] = nominal.izz * (1.f + spread * (2.f * uniform(rng) - 1.f));
+		field(T_MAX)[i] = nominal.t_max * (1.f + spread * (2.f * uniform(rng) - 1.f));
+
+		// uniformly distributed on a disc
+		const float radius = config.setpoint_radius * sqrtf(uniform(rng));
+		const float angle = 2.f * M_PI_F * uniform(rng);
+		field(SPX)[i] = radius * cosf(angle);
+		field(SPY)[i] = radius * sinf(angle);
+		field(SPZ)[i] = -config.altitude;
+
+		field(QW)[i] = 1.f;
+		field(EST_QW)[i] = 1.f;
+
+		_rng[i] = rng;
+	}
+
+	return true;
+}
+
+void SihBatch::step()
+{
+	sense();
+	estimate();
+	control();
+	dynamics();
+
+	_steps++;
+}
+
+void SihBatch::sense()
+{
+	const int n = _num_vehicles;
+
+	const float *__restrict px = field(PX), *__restrict py = field(PY), *__restrict pz = field(PZ);
+	const float *__restrict ax = field(AX), *__restrict ay = field(AY), *__restrict az = field(AZ);
+	const float *__restrict qw = field(QW), *__restrict qx = field(QX), *__restrict qy = field(QY), *__restrict qz = field(QZ);
+	const float *__restrict wx = field(WX), *__restrict wy = field(WY), *__restrict wz = field(WZ);
+	float *__restrict acc_x = field(ACC_X), *__restrict acc_y = field(ACC_Y), *__restrict acc_z = field(ACC_Z);
+	float *__restrict gyro_x = field(GYRO_X), *__restrict gyro_y = field(GYRO_Y), *__restrict gyro_z = field(GYRO_Z);
+	float *__restrict mag_x = field(MAG_X), *__restrict mag_y = field(MAG_Y), *__restrict mag_z = field(MAG_Z);
+	float *__restrict pos_x = field(POS_X), *__restrict pos_y = field(POS_Y), *__restrict pos_z = field(POS_Z);
+	uint32_t *__restrict rng = _rng;
+
+	for (int i = 0; i < n; i++) {
+		const Dcm R(qw[i], qx[i], qy[i], qz[i]);
+
+		// specific force in body frame
+		const float fx = ax[i];
+		const float fy = ay[i];
+		const float fz = az[i] - CONSTANTS_ONE_G;
+		acc_x[i] = R.r00 * fx + R.r10 * fy + R.r20 * fz + ACC_NOISE * gauss(rng[i]);
+		acc_y[i] = R.r01 * fx + R.r11 * fy + R.r21 * fz + ACC_NOISE * gauss(rng[i]);
+		acc_z[i] = R.r02 * fx + R.r12 * fy + R.r22 * fz + ACC_NOISE * gauss(rng[i]);
+
+		gyro_x[i] = wx[i] + GYRO_NOISE * gauss(rng[i]);
+		gyro_y[i] = wy[i] + GYRO_NOISE * gauss(rng[i]);
+		gyro_z[i] = wz[i] + GYRO_NOISE * gauss(rng[i]);
+
+		mag_x[i] = R.r00 * MU_X + R.r10 * MU_Y + R.r20 * MU_Z + MAG_NOISE * gauss(rng[i]);
+		mag_y[i] = R.r01 * MU_X + R.r11 * MU_Y + R.r21 * MU_Z + MAG_NOISE * gauss(rng[i]);
+		mag_z[i] = R.r02 * MU_X + R.r12 * MU_Y + R.r22 * MU_Z + MAG_NOISE * gauss(rng[i]);
+
+		pos_x[i] = px[i] + POS_NOISE * gauss(rng[i]);
+		pos_y[i] = py[i] + POS_NOISE * gauss(rng[i]);
+		pos_z[i] = pz[i] + POS_NOISE * gauss(rng[i]);
+	}
+}
+
+void SihBatch::estimate()
+{
+	const int n = _num_vehicles;
+	const float dt = _config.dt;
+
+	const float *__restrict acc_x = field(ACC_X), *__restrict acc_y = field(ACC_Y), *__restrict acc_z = field(ACC_Z);
+	const float *__restrict gyro_x = field(GYRO_X), *__restrict gyro_y = field(GYRO_Y), *__restrict gyro_z = field(GYRO_Z);
+	const float *__restrict mag_x = field(MAG_X), *__restrict mag_y = field(MAG_Y), *__restrict mag_z = field(MAG_Z);
+	const float *__restrict pos_x = field(POS_X), *__restrict pos_y = field(POS_Y), *__restrict pos_z = field(POS_Z);
+	float *__restrict qw = field(EST_QW), *__restrict qx = field(EST_QX), *__restrict qy = field(EST_QY);
+	float *__restrict qz = field(EST_QZ);
+	float *__restrict px = field(EST_PX), *__restrict py = field(EST_PY), *__restrict pz = field(EST_PZ);
+	float *__restrict vx = field(EST_VX), *__restrict vy = field(EST_VY), *__restrict vz = field(EST_VZ);
+
+	static constexpr float mu_norm_inv = 1.f / 0.4472136f; // 1 / |mu|
+
+	for (int i = 0; i < n; i++) {
+		const Dcm R(qw[i], qx[i], qy[i], qz[i]);
+
+		// attitude: complementary filter, the measured specific force and magnetic field directions
+		// are compared with the ones expected from the estimated attitude
+		const float acc_norm = sqrtf(acc_x[i] * acc_x[i] + acc_y[i] * acc_y[i] + acc_z[i] * acc_z[i]);
+		const float acc_norm_inv = (acc_norm > 1.f) ? 1.f / acc_norm : 0.f;
+		const float a_x = acc_x[i] * acc_norm_inv;
+		const float a_y = acc_y[i] * acc_norm_inv;
+		const float a_z = acc_z[i] * acc_norm_inv;
+		const float a_hat_x = -R.r20;
+		const float a_hat_y = -R.r21;
+		const float a_hat_z = -R.r22;
+
+		const float mag_norm = sqrtf(mag_x[i] * mag_x[i] + mag_y[i] * mag_y[i] + mag_z[i] * mag_z[i]);
+		const float mag_norm_inv = (mag_norm > 0.01f) ? 1.f / mag_norm : 0.f;
+		const float m_x = mag_x[i] * mag_norm_inv;
+		const float m_y = mag_y[i] * mag_norm_inv;
+		const float m_z = mag_z[i] * mag_norm_inv;
+		const float m_hat_x = (R.r00 * MU_X + R.r10 * MU_Y + R.r20 * MU_Z) * mu_norm_inv;
+		const float m_hat_y = (R.r01 * MU_X + R.r11 * MU_Y + R.r21 * MU_Z) * mu_norm_inv;
+		const float m_hat_z = (R.r02 * MU_X + R.r12 * MU_Y + R.r22 * MU_Z) * mu_norm_inv;
+
+		const float e_x = (a_y * a_hat_z - a_z * a_hat_y) + (m_y * m_hat_z - m_z * m_hat_y);
+		const float e_y = (a_z * a_hat_x - a_x * a_hat_z) + (m_z * m_hat_x - m_x * m_hat_z);
+		const float e_z = (a_x * a_hat_y - a_y * a_hat_x) + (m_x * m_hat_y - m_y * m_hat_x);
+
+		integrate_quaternion(qw[i], qx[i], qy[i], qz[i],
+				     gyro_x[i] + EST_ATT_P * e_x, gyro_y[i] + EST_ATT_P * e_y, gyro_z[i] + EST_ATT_P * e_z, dt);
+
+		// position and velocity: predict with the measured specific force, correct with the position
+		const float a_i_x = R.r00 * acc_x[i] + R.r01 * acc_y[i] + R.r02 * acc_z[i];
+		const float a_i_y = R.r10 * acc_x[i] + R.r11 * acc_y[i] + R.r12 * acc_z[i];
+		const float a_i_z = R.r20 * acc_x[i] + R.r21 * acc_y[i] + R.r22 * acc_z[i] + CONSTANTS_ONE_G;
+
+		const float innov_x = pos_x[i] - px[i];
+		const float innov_y = pos_y[i] - py[i];
+		const float innov_z = pos_z[i] - pz[i];
+
+		px[i] += (vx[i] + EST_POS_P * innov_x) * dt;
+		py[i] += (vy[i] + EST_POS_P * innov_y) * dt;
+		pz[i] += (vz[i] + EST_POS_P * innov_z) * dt;
+		vx[i] += (a_i_x + EST_VEL_P * innov_x) * dt;
+		vy[i] += (a_i_y + EST_VEL_P * innov_y) * dt;
+		vz[i] += (a_i_z + EST_VEL_P * innov_z) * dt;
+	}
+}
+
+void SihBatch::control()
+{
+	const int n = _num_vehicles;
+	const float dt = _config.dt;
+	const Vehicle &nominal = _config.nominal;
+
+	const float *__restrict spx = field(SPX), *__restrict spy = field(SPY), *__restrict spz = field(SPZ);
+	const float *__restrict px = field(EST_PX), *__restrict py = field(EST_PY), *__restrict pz = field(EST_PZ);
+	const float *__restrict vx = field(EST_VX), *__restrict vy = field(EST_VY), *__restrict vz = field(EST_VZ);
+	const float *__restrict qw = field(EST_QW), *__restrict qx = field(EST_QX), *__restrict qy = field(EST_QY);
+	const float *__restrict qz = field(EST_QZ);
+	const float *__restrict gyro_x = field(GYRO_X), *__restrict gyro_y = field(GYRO_Y), *__restrict gyro_z = field(GYRO_Z);
+	float *__restrict int_x = field(VEL_INT_X), *__restrict int_y = field(VEL_INT_Y), *__restrict int_z = field(VEL_INT_Z);
+	float *__restrict u_sp0 = field(U_SP0), *__restrict u_sp1 = field(U_SP1), *__restrict u_sp2 = field(U_SP2);
+	float *__restrict u_sp3 = field(U_SP3);
+
+	// mixer: normalized roll, pitch, yaw torque and collective thrust
+	const float roll_scale = 1.f / (nominal.l_roll * nominal.t_max);
+	const float pitch_scale = 1.f / (nominal.l_pitch * nominal.t_max);
+	const float yaw_scale = 1.f / nominal.q_max;
+	const float thrust_scale = 1.f / nominal.t_max;
+
+	for (int i = 0; i < n; i++) {
+		// position -> velocity -> acceleration
+		const float v_sp_x = constrain(POS_P * (spx[i] - px[i]), -VEL_MAX, VEL_MAX);
+		const float v_sp_y = constrain(POS_P * (spy[i] - py[i]), -VEL_MAX, VEL_MAX);
+		const float v_sp_z = constrain(POS_P * (spz[i] - pz[i]), -VEL_MAX, VEL_MAX);
+
+		const float v_err_x = v_sp_x - vx[i];
+		const float v_err_y = v_sp_y - vy[i];
+		const float v_err_z = v_sp_z - vz[i];
+
+		// the integrator compensates for the difference between the nominal and the simulated vehicle
+		int_x[i] = constrain(int_x[i] + VEL_I * v_err_x * dt, -VEL_INT_MAX, VEL_INT_MAX);
+		int_y[i] = constrain(int_y[i] + VEL_I * v_err_y * dt, -VEL_INT_MAX, VEL_INT_MAX);
+		int_z[i] = constrain(int_z[i] + VEL_I * v_err_z * dt, -VEL_INT_MAX, VEL_INT_MAX);
+
+		// thrust vector, limited to keep some thrust upwards
+		const float f_x = nominal.mass * (VEL_P * v_err_x + int_x[i]);
+		const float f_y = nominal.mass * (VEL_P * v_err_y + int_y[i]);
+		const float f_z = fminf(nominal.mass * (VEL_P * v_err_z + int_z[i] - CONSTANTS_ONE_G),
+					-0.3f * nominal.mass * CONSTANTS_ONE_G);
+
+		const float f_norm_inv = 1.f / sqrtf(f_x * f_x + f_y * f_y + f_z * f_z);
+		const float z_sp_x = -f_x * f_norm_inv;
+		const float z_sp_y = -f_y * f_norm_inv;
+		const float z_sp_z = -f_z * f_norm_inv;
+
+		// collective thrust along the current body z axis
+		const Dcm R(qw[i], qx[i], qy[i], qz[i]);
+		const float thrust = constrain(-(f_x * R.r02 + f_y * R.r12 + f_z * R.r22), 0.f, 4.f * nominal.t_max);
+
+		// tilt error: rotation of the body z axis to the setpoint, in body frame
+		const float e_i_x = R.r12 * z_sp_z - R.r22 * z_sp_y;
+		const float e_i_y = R.r22 * z_sp_x - R.r02 * z_sp_z;
+		const float e_i_z = R.r02 * z_sp_y - R.r12 * z_sp_x;
+		const float e_b_x = R.r00 * e_i_x + R.r10 * e_i_y + R.r20 * e_i_z;
+		const float e_b_y = R.r01 * e_i_x + R.r11 * e_i_y + R.r21 * e_i_z;
+
+		// rates, yaw is only damped
+		const float m_x = nominal.ixx * RATE_P * (ATT_P * e_b_x - gyro_x[i]);
+		const float m_y = nominal.iyy * RATE_P * (ATT_P * e_b_y - gyro_y[i]);
+		const float m_z = nominal.izz * RATE_P * (0.f - gyro_z[i]);
+
+		const float a = m_x * roll_scale;
+		const float b = m_y * pitch_scale;
+		const float c = m_z * yaw_scale;
+		const float d = thrust * thrust_scale;
+
+		u_sp0[i] = constrain(0.25f * (d - a + b + c), 0.f, 1.f);
+		u_sp1[i] = constrain(0.25f * (d + a - b + c), 0.f, 1.f);
+		u_sp2[i] = constrain(0.25f * (d + a + b - c), 0.f, 1.f);
+		u_sp3[i] = constrain(0.25f * (d - a - b - c), 0.f, 1.f);
+	}
+}
+
+void SihBatch::dynamics()
+{
+	const int n = _num_vehicles;
+	const float dt = _config.dt;
+	const Vehicle &nominal = _config.nominal;
+	const float motor_alpha = dt / nominal.t_tau;
+
+	float *__restrict px = field(PX), *__restrict py = field(PY), *__restrict pz = field(PZ);
+	float *__restrict vx = field(VX), *__restrict vy = field(VY), *__restrict vz = field(VZ);
+	float *__restrict ax = field(AX), *__restrict ay = field(AY), *__restrict az = field(AZ);
+	float *__restrict qw = field(QW), *__restrict qx = field(QX), *__restrict qy = field(QY), *__restrict qz = field(QZ);
+	float *__restrict wx = field(WX), *__restrict wy = field(WY), *__restrict wz = field(WZ);
+	float *__restrict u0 = field(U0), *__restrict u1 = field(U1), *__restrict u2 = field(U2), *__restrict u3 = field(U3);
+	const float *__restrict u_sp0 = field(U_SP0), *__restrict u_sp1 = field(U_SP1), *__restrict u_sp2 = field(U_SP2);
+	const float *__restrict u_sp3 = field(U_SP3);
+	const float *__restrict mass = field(MASS), *__restrict t_max = field(T_MAX);
+	const float *__restrict ixx = field(IXX), *__restrict iyy = field(IYY), *__restrict izz = field(IZZ);
+
+	for (int i = 0; i < n; i++) {
+		// first order motor dynamics
+		u0[i] += motor_alpha * (u_sp0[i] - u0[i]);
+		u1[i] += motor_alpha * (u_sp1[i] - u1[i]);
+		u2[i] += motor_alpha * (u_sp2[i] - u2[i]);
+		u3[i] += motor_alpha * (u_sp3[i] - u3[i]);
+
+		// forces and moments, same model as Sih::generate_force_and_torques()
+		const float thrust = t_max[i] * (u0[i] + u1[i] + u2[i] + u3[i]);
+		const float m_x = nominal.l_roll * t_max[i] * (-u0[i] + u1[i] + u2[i] - u3[i]) - nominal.kdw * wx[i];
+		const float m_y = nominal.l_pitch * t_max[i] * (u0[i] - u1[i] + u2[i] - u3[i]) - nominal.kdw * wy[i];
+		const float m_z = nominal.q_max * (u0[i] + u1[i] - u2[i] - u3[i]) - nominal.kdw * wz[i];
+
+		const Dcm R(qw[i], qx[i], qy[i], qz[i]);
+		const float mass_inv = 1.f / mass[i];
+		float a_x = (-R.r02 * thrust - nominal.kdv * vx[i]) * mass_inv;
+		float a_y = (-R.r12 * thrust - nominal.kdv * vy[i]) * mass_inv;
+		float a_z = (-R.r22 * thrust - nominal.kdv * vz[i]) * mass_inv + CONSTANTS_ONE_G;
+
+		// Euler's rotation equations with a diagonal inertia
+		const float w_dot_x = (m_x - (izz[i] - iyy[i]) * wy[i] * wz[i]) / ixx[i];
+		const float w_dot_y = (m_y - (ixx[i] - izz[i]) * wz[i] * wx[i]) / iyy[i];
+		const float w_dot_z = (m_z - (iyy[i] - ixx[i]) * wx[i] * wy[i]) / izz[i];
+
+		// integration: Euler forward
+		px[i] += vx[i] * dt;
+		py[i] += vy[i] * dt;
+		pz[i] += vz[i] * dt;
+		vx[i] += a_x * dt;
+		vy[i] += a_y * dt;
+		vz[i] += a_z * dt;
+		integrate_quaternion(qw[i], qx[i], qy[i], qz[i], wx[i], wy[i], wz[i], dt);
+		wx[i] = constrain(wx[i] + w_dot_x * dt, -RATE_MAX, RATE_MAX);
+		wy[i] = constrain(wy[i] + w_dot_y * dt, -RATE_MAX, RATE_MAX);
+		wz[i] = constrain(wz[i] + w_dot_z * dt, -RATE_MAX, RATE_MAX);
+
+		// fake ground, the vehicle rests on it
+		const bool grounded = (pz[i] >= 0.f) && (vz[i] > 0.f);
+		pz[i] = grounded ? 0.f : pz[i];
+		vx[i] = grounded ? 0.f : vx[i];
+		vy[i] = grounded ? 0.f : vy[i];
+		vz[i] = grounded ? 0.f : vz[i];
+		wx[i] = grounded ? 0.f : wx[i];
+		wy[i] = grounded ? 0.f : wy[i];
+		wz[i] = grounded ? 0.f : wz[i];
+		a_x = grounded ? 0.f : a_x;
+		a_y = grounded ? 0.f : a_y;
+		a_z = grounded ? 0.f : a_z;
+
+		ax[i] = a_x;
+		ay[i] = a_y;
+		az[i] = a_z;
+	}
+}
+
+SihBatch::Statistics SihBatch::statistics() const
+{
+	Statistics statistics{};
+
+	float error_sum = 0.f;
+	int count = 0;
+
+	for (int i = 0; i < _num_vehicles; i++) {
+		const float e_x = position(i, 0) - setpoint(i, 0);
+		const float e_y = position(i, 1) - setpoint(i, 1);
+		const float e_z = position(i, 2) - setpoint(i, 2);
+		const float error = sqrtf(e_x * e_x + e_y * e_y + e_z * e_z);
+
+		if (!isfinite(error) || (error > 10.f)) {
+			statistics.diverged++;
+
+		} else {
+			error_sum += error;
+			statistics.position_error_max = fmaxf(statistics.position_error_max, error);
+			count++;
+		}
+	}
+
+	statistics.position_error_mean = (count > 0) ? error_sum / count : NAN;
+
+	return statistics;
+}
@@ -0,0 +1,153 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file SihBatch.hpp
+ *
+ * Headless batch simulation of many independent multicopters in one process.
+ *
+ * The vehicles are stored as a structure of arrays, and every stage of a step (sensors, estimator,
+ * controller, dynamics) is a single loop over all vehicles without branching on the vehicle, so that
+ * the compiler can vectorize it. The dynamics are the multicopter model of sih. Instead of the flight
+ * stack, each vehicle runs a reduced estimator (complementary attitude filter and position observer)
+ * and a cascaded position, attitude and rate controller using the nominal vehicle parameters, while
+ * the simulated vehicles are spread around the nominal one. This is enough for hover and setpoint
+ * tracking parameter sweeps.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+class SihBatch
+{
+public:
+	struct Vehicle {
+		float mass{1.f};			///< [kg]
+		float ixx{0.025f};			///< [kg m^2]
+		float iyy{0.025f};			///< [kg m^2]
+		float izz{0.030f};			///< [kg m^2]
+		float t_max{5.f};			///< max thrust per rotor [N]
+		float q_max{0.1f};			///< max torque per rotor [Nm]
+		float l_roll{0.2f};			///< roll arm [m]
+		float l_pitch{0.2f};			///< pitch arm [m]
+		float kdv{1.f};				///< linear damping [N/(m/s)]
+		float kdw{0.025f};			///< angular damping [Nm/(rad/s)]
+		float t_tau{0.05f};			///< motor time constant [s]
+	};
+
+	struct Config {
+		int num_vehicles{100};
+		float dt{0.004f};			///< step [s]
+		Vehicle nominal{};			///< vehicle the controllers are tuned for
+		float spread{0.1f};			///< relative spread of the simulated mass, inertia and thrust
+		float setpoint_radius{5.f};		///< horizontal setpoints are spread within this radius [m]
+		float altitude{5.f};			///< setpoint altitude [m]
+		uint32_t seed{1};
+	};
+
+	struct Statistics {
+		float position_error_mean;		///< [m], over the vehicles which did not diverge
+		float position_error_max;		///< [m], over the vehicles which did not diverge
+		int diverged;				///< vehicles with a non-finite state or off by more than 10 m
+	};
+
+	SihBatch() = default;
+	~SihBatch();
+
+	SihBatch(const SihBatch &) = delete;
+	SihBatch &operator=(const SihBatch &) = delete;
+
+	/**
+	 * Allocate and initialize the vehicles: landed at the origin, with the setpoints spread around it.
+	 * @return false if the vehicles could not be allocated
+	 */
+	bool init(const Config &config);
+
+	/** advance all vehicles by one step */
+	void step();
+
+	void run(uint32_t steps)
+	{
+		for (uint32_t i = 0; i < steps; i++) {
+			step();
+		}
+	}
+
+	Statistics statistics() const;
+
+	int num_vehicles() const { return _num_vehicles; }
+	uint64_t steps() const { return _steps; }
+
+	float position(int vehicle, int axis) const { return field(PX + axis)[vehicle]; }
+	float setpoint(int vehicle, int axis) const { return field(SPX + axis)[vehicle]; }
+
+private:
+	// fields of the structure of arrays, each one holds a value per vehicle
+	enum Field : int {
+		// simulated state
+		PX, PY, PZ, VX, VY, VZ, AX, AY, AZ, QW, QX, QY, QZ, WX, WY, WZ, U0, U1, U2, U3,
+
+		// simulated vehicle
+		MASS, IXX, IYY, IZZ, T_MAX,
+
+		// sensors
+		ACC_X, ACC_Y, ACC_Z, GYRO_X, GYRO_Y, GYRO_Z, MAG_X, MAG_Y, MAG_Z, POS_X, POS_Y, POS_Z,
+
+		// estimator
+		EST_QW, EST_QX, EST_QY, EST_QZ, EST_PX, EST_PY, EST_PZ, EST_VX, EST_VY, EST_VZ,
+
+		// controller
+		SPX, SPY, SPZ, VEL_INT_X, VEL_INT_Y, VEL_INT_Z, U_SP0, U_SP1, U_SP2, U_SP3,
+
+		NUM_FIELDS
+	};
+
+	float *field(int f) { return _data + f * _stride; }
+	const float *field(int f) const { return _data + f * _stride; }
+
+	void sense();
+	void estimate();
+	void control();
+	void dynamics();
+
+	Config _config{};
+
+	int _num_vehicles{0};
+	size_t _stride{0};			///< number of vehicles rounded up to full cache lines
+	float *_data{nullptr};
+	uint32_t *_rng{nullptr};		///< noise generator state per vehicle
+
+	uint64_t _steps{0};
+};
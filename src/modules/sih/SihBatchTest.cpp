@@ -0,0 +1,103 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file SihBatchTest.cpp
+ *
+ * Tests for the headless batch simulation: the vehicles take off and reach their setpoints,
+ * and runs are reproducible for a given seed.
+ */
+
+#include <gtest/gtest.h>
+#include "SihBatch.hpp"
+
+TEST(SihBatchTest, InvalidConfig)
+{
+	SihBatch batch;
+	SihBatch::Config config{};
+
+	config.num_vehicles = 0;
+	EXPECT_FALSE(batch.init(config));
+
+	config.num_vehicles = 10;
+	config.dt = 0.f;
+	EXPECT_FALSE(batch.init(config));
+}
+
+TEST(SihBatchTest, ReachSetpoints)
+{
+	SihBatch batch;
+	SihBatch::Config config{};
+	config.num_vehicles = 50;
+	ASSERT_TRUE(batch.init(config));
+
+	// all vehicles start landed
+	for (int i = 0; i < batch.num_vehicles(); i++) {
+		EXPECT_FLOAT_EQ(batch.position(i, 2), 0.f);
+	}
+
+	// 15 seconds at the default 250 Hz
+	batch.run(3750);
+	EXPECT_EQ(batch.steps(), 3750u);
+
+	const SihBatch::Statistics statistics = batch.statistics();
+	EXPECT_EQ(statistics.diverged, 0);
+	EXPECT_LT(statistics.position_error_mean, 0.2f);
+	EXPECT_LT(statistics.position_error_max, 0.5f);
+}
+
+TEST(SihBatchTest, Reproducible)
+{
+	SihBatch::Config config{};
+	config.num_vehicles = 20;
+
+	SihBatch batch_a;
+	SihBatch batch_b;
+	ASSERT_TRUE(batch_a.init(config));
+	ASSERT_TRUE(batch_b.init(config));
+	batch_a.run(500);
+	batch_b.run(500);
+
+	config.seed = 2;
+	SihBatch batch_c;
+	ASSERT_TRUE(batch_c.init(config));
+	batch_c.run(500);
+
+	for (int i = 0; i < config.num_vehicles; i++) {
+		for (int axis = 0; axis < 3; axis++) {
+			EXPECT_EQ(batch_a.position(i, axis), batch_b.position(i, axis));
+		}
+
+		EXPECT_NE(batch_a.setpoint(i, 0), batch_c.setpoint(i, 0));
+	}
+}
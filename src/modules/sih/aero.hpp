@@ -110,13 +110,15 @@ private:
 	float _ate, _ale, _afte, _afle;	// semi empirical coefficients for flat plates function of AR
 	float _tau_te, _tau_le, _fte, _fle; 	// leading and trailing edge functions
 	float _rho = 1.225f; 	// air density at current altitude [kg/m^3]
+	float _area;		// area of the segment [m^2]
+	float _sin_alpha_0, _cos_alpha_0;	// to rotate the velocity angle by the zero lift angle of attack
 	float _kD;		// for parabolic drag model
 	const float K0 = 0.87f;	// Oswald efficiency factor
 	// variables for flap model
 	float _eta_f;		// flap effectiveness
 	float _def_a;		// absolute value of the deflection angle
 	float _cf;		// flap chord (control surface chord length)
-	float _theta_f, _tau_f;	// check 3.2.3 in [2]
+	float _theta_f, _tau_f;	// check 3.2.3 in [2], only function of the flap chord
 	float _deltaCL, _dCLmax;	// increase in lift coefficient
 	float _CLmax, _CLmin;	// max and min lift value
 	float _alpha_eff_min; 	// min effective angle of attack
@@ -124,14 +126,21 @@ private:
 	float _alpha_min; 	// min angle of attack (stall angle)
 	float _alpha_max;	// min angle of attack (stall angle)
 	float _alf0eff;		// effective zero lift angle of attack
+	float _CL_stall_max;	// lift at the positive stall angle without flap deflection
+	float _CL_stall_min;	// lift at the negative stall angle without flap deflection
+	float _fte_gain;	// 0.25 * (1 + sqrt(_fte))^2
+	float _fcm_gain;	// pitching moment gain of the trailing edge separation
+	// terms function of the deflection only, recomputed when the deflection changes
+	float _def_cached;	// deflection the terms below were computed for
+	float _def_a_offset;	// angle of attack offset of the deflected flap at high angle of attack
+	float _cd90_eff;	// 90 deg angle of attack drag coefficient of the deflected flap
 	// float _alfmeff;		// effective maximum lift angle of attack
 	float _alpha_eff;	// effectie angle of attack
 	// float _alpha_eff_dot;	// effectie angle of attack derivative
 	float _alpha_eff_old;	// angle of attack [rad]
 
-	float _pressure; 	// pressure in Pa at current altitude
-	float _temperature;	// temperature in K at current altitude
 	float _prop_radius;	// propeller radius [m], used to create the slipstream
+	float _slipstream_k;	// 2 / (pi * _prop_radius^2), slipstream velocity squared per thrust and density
 	// float _v_slipstream;	// slipstream velocity [m/s], computed from momentum theory
 
 	matrix::Vector3f _Fa;	// aerodynamic force
@@ -199,7 +208,24 @@ public:
 		_cf = math::constrain(cf, 0.0f, mac);
 		_C_BS = matrix::Dcmf(matrix::Eulerf(math::radians(dihedral_deg), 0.0f, 0.0f));
 		_prop_radius = prop_radius;
+		_slipstream_k = (_prop_radius > 1e-4f) ? 2.0f / (M_PI_F * _prop_radius * _prop_radius) : 0.0f;
 		_kD = 1.0f / (M_PI_F * K0 * _ar);
+		_area = _span * _mac;
+		_sin_alpha_0 = sinf(_alpha_0);
+		_cos_alpha_0 = cosf(_alpha_0);
+
+		// the dynamic separation model is disabled, see aoa_coeff()
+		_fte = 1.0f;
+		_fle = 1.0f;
+		_fte_gain = 0.25f * (1.0f + sqrtf(_fte)) * (1.0f + sqrtf(_fte));
+		_fcm_gain = _fte_gain * 0.0625f * (-1.0f + 6.0f * sqrtf(_fte) - 5.0f * _fte);
+
+		// everything which only depends on the geometry is computed once here
+		_theta_f = acosf(2.0f * _cf / _mac - 1.0f);
+		_tau_f = 1.0f - (_theta_f - sinf(_theta_f)) / M_PI_F;
+		_CL_stall_max = fCL(_alpha_max - _alpha_0);
+		_CL_stall_min = fCL(_alpha_min - _alpha_0);
+		_def_cached = NAN;
 	}
 
 
@@ -219,11 +245,16 @@ public:
 	void update_aero(const matrix::Vector3f &v_B, const matrix::Vector3f &w_B, float alt = 0.0f, float def = 0.0f,
 			 float thrust = 0.0f)
 	{
-		// ISA model taken from Mustafa Cavcar, Anadolu University, Turkey
-		_pressure = P0 * powf(1.0f - 0.0065f * alt / T0_K, 5.2561f);
-		_temperature = T0_K + TEMP_GRADIENT * alt;
-		_rho = _pressure / R / _temperature;
+		update_aero_rho(v_B, w_B, air_density(alt), def, thrust);
+	}
 
+	/** same as update_aero(), with the air density [kg/m^3] computed by the caller with air_density(),
+	 * so that it is computed once for all the segments of a vehicle
+	 */
+	void update_aero_rho(const matrix::Vector3f &v_B, const matrix::Vector3f &w_B, float rho, float def = 0.0f,
+			     float thrust = 0.0f)
+	{
+		_rho = rho;
 		_v_S = _C_BS.transpose() * (v_B + w_B % _p_B); 	// velocity in segment frame
 
 		if (_prop_radius > 1e-4f) {
@@ -231,7 +262,7 @@ public:
 			// Computed from momentum theory.
 			// For info, the diameter of the slipstream is sqrt(2)*_prop_radius,
 			// this should be the width of the segment in the slipstream.
-			_v_S(0) += sqrtf(2.0f * thrust / (_rho * M_PI_F * _prop_radius * _prop_radius));
+			_v_S(0) += sqrtf(_slipstream_k * thrust / _rho);
 		}
 
 		float vxz2 = _v_S(0) * _v_S(0) + _v_S(2) * _v_S(2);
@@ -245,12 +276,29 @@ public:
 
 		_alpha = matrix::wrap_pi(atan2f(_v_S(2), _v_S(0)) - _alpha_0);
 		// _alpha = atan2f(_v_S(2), _v_S(0));
-		aoa_coeff(_alpha, sqrtf(vxz2), def);
-		_Fa = _C_BS * (0.5f * _rho * vxz2 * _span * _mac) * matrix::Vector3f(_CL * sinf(_alpha) - _CD * cosf(_alpha),
-				0.0f,
-				-_CL * cosf(_alpha) - _CD * sinf(_alpha));
-		_Ma = _C_BS * (0.5f * _rho * vxz2 * _span * _mac * _mac) * matrix::Vector3f(0.0f, _CM,
-				0.0f) + _p_B % _Fa; 	// computed at vehicle _CM
+		const float vxz = sqrtf(vxz2);
+		aoa_coeff(_alpha, vxz, def);
+
+		// sine and cosine of the angle of attack from the velocity, rotated by the zero lift angle of attack
+		const float s_v = _v_S(2) / vxz;
+		const float c_v = _v_S(0) / vxz;
+		const float s_a = s_v * _cos_alpha_0 - c_v * _sin_alpha_0;
+		const float c_a = c_v * _cos_alpha_0 + s_v * _sin_alpha_0;
+
+		const float q_S = 0.5f * _rho * vxz2 * _area; 	// dynamic pressure times area
+		_Fa = _C_BS * q_S * matrix::Vector3f(_CL * s_a - _CD * c_a, 0.0f, -_CL * c_a - _CD * s_a);
+		_Ma = _C_BS * (q_S * _mac) * matrix::Vector3f(0.0f, _CM, 0.0f) + _p_B % _Fa; 	// computed at vehicle _CM
+	}
+
+	/** air density from the ISA model [kg/m^3]
+	 * alt: altitude above mean sea level [m]
+	 */
+	static float air_density(float alt)
+	{
+		// ISA model taken from Mustafa Cavcar, Anadolu University, Turkey
+		const float pressure = P0 * powf(1.0f - 0.0065f * alt / T0_K, 5.2561f);
+		const float temperature = T0_K + TEMP_GRADIENT * alt;
+		return pressure / R / temperature;
 	}
 
 	// return the air density at current altitude, must be called after update_aero()
@@ -282,15 +330,13 @@ private:
 		_tau_te = (vxz > 0.01f) ? 4.5f * _mac / vxz : 0.0f;
 		_tau_le = (vxz > 0.01f) ? 0.5f * _mac / vxz : 0.0f;
 
+		// the deflection terms only change with the actuator setpoints, not with the state
+		if (def != _def_cached) {
+			update_deflection(def);
+		}
+
 		// model for the control surface deflection
 		if (_cf / _mac < 0.999f) {
-			_def_a = fminf(fabsf(def), math::radians(70.0f));
-			_eta_f = _def_a * _def_a * ETA_POLY[0] + _def_a * ETA_POLY[1] + ETA_POLY[2];	// second order fit
-			_theta_f = acosf(2.0f * _cf / _mac - 1.0f);
-			_tau_f = 1.0f - (_theta_f - sinf(_theta_f)) / M_PI_F;
-			_deltaCL = _kp * _tau_f * _eta_f * def;
-			_dCLmax = (1.0f - _cf / _mac) * _deltaCL;
-			_alf0eff = solve_alpha_eff(_kp, KV, _deltaCL, _alpha_0);
 			_alpha_eff = a - _alf0eff;
 
 			// this doesn't seem to work, so let's comment it
@@ -300,15 +346,6 @@ private:
 			// _fle = 0.5f * (1.0f - tanhf(_ale * ((_alpha_eff) - _tau_le * (_alpha_eff_dot)
 			// 	- math::radians(_afle))));	// normalized leading edge separation
 
-			_fte = 1.0f;
-			_fle = 1.0f;
-			_CLmax = fCL(_alpha_max - _alpha_0) + _dCLmax;
-			_alpha_eff_max = _alf0eff - solve_alpha_eff(_kp, KV * _fle * _fle,
-					 _CLmax / (0.25f * (1.0f + sqrtf(_fte)) * (1.0f + sqrtf(_fte))), _alpha_max - _alpha_0);
-			_CLmin = fCL(_alpha_min - _alpha_0) + _dCLmax;
-			_alpha_eff_min = _alf0eff - solve_alpha_eff(_kp, KV * _fle * _fle,
-					 _CLmin / (0.25f * (1.0f + sqrtf(_fte)) * (1.0f + sqrtf(_fte))), _alpha_min - _alpha_0);
-
 		} else { 	// this segment is a full flap
 			_alpha_eff = a + def;
 
@@ -318,19 +355,16 @@ private:
 			// 	- math::radians(_afte))));	// normalized trailing edge separation
 			// _fle = 0.5f * (1.0f - tanhf(_ale * ((_alpha_eff) - _tau_le * (_alpha_eff_dot)
 			// 	- math::radians(_afle))));	// normalized leading edge separation
-
-			_fte = 1.0f;
-			_fle = 1.0f;
-			_alpha_eff_max = _alpha_max;
-			_alpha_eff_min = _alpha_min;
 		}
 
 		// compute the aerodynamic coefficients
-		high_aoa_coeff(_alpha_eff, def);
-		_CL_ = fCL(_alpha_eff);
+		high_aoa_coeff(_alpha_eff);
+		const float s = sinf(_alpha_eff);
+		const float c = cosf(_alpha_eff);
+		_CL_ = fCL(s, c);
 		_CD_ = CD0 + fabsf(_CL * tanf(_alpha_eff));
 		// _CD_ = CD0 + _kD*_CL_*_CL_; 	// alternative method
-		_CM_ = -fCM(_alpha_eff);
+		_CM_ = -fCM(s, c);
 
 		// blending function
 		if (_alpha_eff > 0.0f) {
@@ -345,19 +379,45 @@ private:
 		_CM = _CM_ * _f_blend + _CM * (1.0f - _f_blend);
 	}
 
-	// high angle of attack coefficient based on flat plate
-	void high_aoa_coeff(float a, float def = 0.0f)
+	// terms of the coefficients which only depend on the deflection
+	void update_deflection(float def)
 	{
+		_def_cached = def;
+
 		float mac_eff = sqrtf((_mac - _cf) * (_mac - _cf) + _cf * _cf + 2.0f * (_mac - _cf) * _cf * cosf(fabsf(def)));
-		a += asinf(_cf / mac_eff * sinf(def));
-		float cd90_eff = CD90 + 0.21f * def - 0.0426f * def *
-				 def; // this might not be accurate for lower flap chord to chord ratio
-		// normal coeff
-		float CN = cd90_eff * sinf(a) * (1.0f / (0.56f + 0.44f * sinf(fabsf(a))) - _kn);
+		_def_a_offset = asinf(_cf / mac_eff * sinf(def));
+		_cd90_eff = CD90 + 0.21f * def - 0.0426f * def *
+			    def; // this might not be accurate for lower flap chord to chord ratio
+
+		if (_cf / _mac < 0.999f) {
+			_def_a = fminf(fabsf(def), math::radians(70.0f));
+			_eta_f = _def_a * _def_a * ETA_POLY[0] + _def_a * ETA_POLY[1] + ETA_POLY[2];	// second order fit
+			_deltaCL = _kp * _tau_f * _eta_f * def;
+			_dCLmax = (1.0f - _cf / _mac) * _deltaCL;
+			_alf0eff = solve_alpha_eff(_kp, KV, _deltaCL, _alpha_0);
+			_CLmax = _CL_stall_max + _dCLmax;
+			_alpha_eff_max = _alf0eff - solve_alpha_eff(_kp, KV * _fle * _fle, _CLmax / _fte_gain, _alpha_max - _alpha_0);
+			_CLmin = _CL_stall_min + _dCLmax;
+			_alpha_eff_min = _alf0eff - solve_alpha_eff(_kp, KV * _fle * _fle, _CLmin / _fte_gain, _alpha_min - _alpha_0);
+
+		} else {
+			_alpha_eff_max = _alpha_max;
+			_alpha_eff_min = _alpha_min;
+		}
+	}
+
+	// high angle of attack coefficient based on flat plate, update_deflection() needs to be called before
+	void high_aoa_coeff(float a)
+	{
+		a += _def_a_offset;
+		const float s = sinf(a);
+		const float c = cosf(a);
+		// normal coeff, sin(|a|) = sign(a) * sin(a)
+		float CN = _cd90_eff * s * (1.0f / (0.56f + 0.44f * ((a >= 0.0f) ? s : -s)) - _kn);
 		// tengential coeff
-		float CT = 0.5f * CD0 * cosf(a);
-		_CL = CN * cosf(a) - CT * sinf(a);
-		_CD = CN * sinf(a) + CT * cosf(a);
+		float CT = 0.5f * CD0 * c;
+		_CL = CN * c - CT * s;
+		_CD = CN * s + CT * c;
 		_CM = -CN * (0.25f - 7.0f / 40.0f * (1.0f - 2.0f / M_PI_F * fabsf(a)));
 	}
 
@@ -402,25 +462,28 @@ private:
 		float a = a0; 	// init the search
 
 		for (int i = 0; i < 3; i++) {
-			a = a - (-Kp * sinf(a) * cosf(a) * cosf(a) - Kv * fabsf(sinf(a)) * sinf(a) * cosf(a) - dCL) /
-			    (Kv * fabsf(sinf(a)) * sinf(a) * sinf(a) - Kv * fabsf(sinf(a)) * cosf(a) * cosf(a) - Kp * cosf(a) * cosf(a) * cosf(
-				     a) + 2 * Kp * cosf(a) * sinf(a) * sinf(a) - Kv * matrix::sign(sinf(a)) * cosf(a) * cosf(a) * sinf(a));
+			const float s = sinf(a);
+			const float c = cosf(a);
+			a = a - (-Kp * s * c * c - Kv * fabsf(s) * s * c - dCL) /
+			    (Kv * fabsf(s) * s * s - Kv * fabsf(s) * c * c - Kp * c * c * c + 2 * Kp * c * s * s
+			     - Kv * matrix::sign(s) * c * c * s);
 		}
 
 		return a;
 	}
 
-	float fCL(float a)
+	float fCL(float a) const { return fCL(sinf(a), cosf(a)); }
+
+	// low angle of attack lift from the sine and cosine of the effective angle of attack
+	float fCL(float s, float c) const
 	{
-		return 0.25f * (1.0f + sqrtf(_fte)) * (1.0f + sqrtf(_fte)) * (_kp * sinf(a) * cosf(a) * cosf(a)
-				+ _fle * _fle * KV * fabsf(sinf(a)) * sinf(a) * cosf(a));
+		return _fte_gain * (_kp * s * c * c + _fle * _fle * KV * fabsf(s) * s * c);
 	}
 
-	float fCM(float a)
+	// low angle of attack pitching moment from the sine and cosine of the effective angle of attack
+	float fCM(float s, float c) const
 	{
-		return -0.25f * (1.0f + sqrtf(_fte)) * (1.0f + sqrtf(_fte)) * 0.0625f * (-1.0f + 6.0f * sqrtf(
-					_fte) - 5.0f * _fte) * _kp * sinf(a) * cosf(a)
-		       + 0.17f * _fle * _fle * KV * fabsf(sinf(a)) * sinf(a);
+		return -_fcm_gain * _kp * s * c + 0.17f * _fle * _fle * KV * fabsf(s) * s;
 	}
 
 	// AeroSeg operator=(const AeroSeg&) const {
@@ -0,0 +1,210 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file rigid_body.hpp
+ * Equations of motion of a rigid body and their integration.
+ *
+ * The translational states are integrated as vectors, the attitude on the unit quaternion group with the
+ * Runge-Kutta-Munthe-Kaas method from [3] (see sih.hpp): the stages are combined as rotation vectors in the
+ * body frame, and the quaternion is only updated with the exponential map, so it stays on the unit sphere.
+ *
+ * Forward Euler with a single sub-step is the historical integration of sih and gives the same results.
+ */
+
+#pragma once
+
+#include <matrix/matrix/math.hpp>
+#include <stdint.h>
+
+namespace sih
+{
+
+struct State {
+	matrix::Vector3f p_I;	// inertial position [m]
+	matrix::Vector3f v_I;	// inertial velocity [m/s]
+	matrix::Quatf q;	// attitude, body to inertial
+	matrix::Vector3f w_B;	// body rates in body frame [rad/s]
+};
+
+struct Derivative {
+	matrix::Vector3f p_I_dot;	// inertial position differential
+	matrix::Vector3f v_I_dot;	// inertial velocity differential
+	matrix::Vector3f w_B;		// body rates, the attitude differential is q * [0, w_B / 2]
+	matrix::Vector3f w_B_dot;	// body rates differential
+};
+
+enum class Integrator : int32_t {
+	Euler = 0,	// forward Euler, first order
+	RK2 = 1,	// explicit midpoint, second order
+	RK4 = 2,	// classic Runge-Kutta, fourth order
+};
+
+class RigidBody
+{
+public:
+	void set_mass(float mass) { _mass = mass; }
+
+	void set_inertia(const matrix::Matrix3f &I)
+	{
+		_I = I;
+		// guards against too small determinants
+		_Im1 = 100.0f * matrix::inv(static_cast<matrix::SquareMatrix<float, 3>>(100.0f * I));
+	}
+
+	float mass() const { return _mass; }
+	const matrix::Matrix3f &inertia() const { return _I; }
+
+	/** equations of motion for a force in inertial frame and a moment in body frame, both taken at the CM */
+	Derivative derivative(const State &x, const matrix::Vector3f &F_I, const matrix::Vector3f &M_B) const
+	{
+		Derivative x_dot;
+		x_dot.p_I_dot = x.v_I;					// position differential
+		x_dot.v_I_dot = F_I / _mass;				// conservation of linear momentum
+		x_dot.w_B = x.w_B;					// attitude differential
+		x_dot.w_B_dot = _Im1 * (M_B - x.w_B.cross(_I * x.w_B));	// conservation of angular momentum
+		return x_dot;
+	}
+
+	/** kinetic energy, translational and rotational [J] */
+	float kinetic_energy(const State &x) const
+	{
+		return 0.5f * _mass * x.v_I.norm_squared() + 0.5f * x.w_B.dot(_I * x.w_B);
+	}
+
+	/**
+	 * Integrate the state over dt.
+	 * @param x state, updated in place
+	 * @param x_dot derivative at x, as computed by the caller for the beginning of the step
+	 * @param dt step [s]
+	 * @param method integration method
+	 * @param substeps number of sub-steps dt is divided into
+	 * @param wrench callable (const State &, Vector3f &F_I, Vector3f &M_B) returning the force in inertial frame
+	 *               and the moment in body frame at an intermediate state, it is not called for Euler with a
+	 *               single sub-step
+	 */
+	template<typename Wrench>
+	void integrate(State &x, const Derivative &x_dot, float dt, Integrator method, int substeps, Wrench &&wrench) const
+	{
+		if (substeps < 1) {
+			substeps = 1;
+		}
+
+		const float h = dt / substeps;
+
+		for (int i = 0; i < substeps; i++) {
+			// the derivative of the first sub-step is given, the following ones are evaluated here
+			const Derivative k1 = (i == 0) ? x_dot : evaluate(x, wrench);
+
+			switch (method) {
+			case Integrator::RK2:
+				rk2_step(x, k1, h, wrench);
+				break;
+
+			case Integrator::RK4:
+				rk4_step(x, k1, h, wrench);
+				break;
+
+			case Integrator::Euler:
+			default:
+				x = stage(x, k1, h, h * k1.w_B);
+				break;
+			}
+		}
+	}
+
+private:
+	template<typename Wrench>
+	Derivative evaluate(const State &x, Wrench &wrench) const
+	{
+		matrix::Vector3f F_I;
+		matrix::Vector3f M_B;
+		wrench(x, F_I, M_B);
+		return derivative(x, F_I, M_B);
+	}
+
+	// state reached from x0 with the linear increment a * k and the attitude increment theta (body frame rotation vector)
+	static State stage(const State &x0, const Derivative &k, float a, const matrix::Vector3f &theta)
+	{
+		State x;
+		x.p_I = x0.p_I + k.p_I_dot * a;
+		x.v_I = x0.v_I + k.v_I_dot * a;
+		x.q = x0.q * matrix::Quatf::expq(0.5f * theta);
+		x.q.normalize();
+		x.w_B = x0.w_B + k.w_B_dot * a;
+		return x;
+	}
+
+	// inverse of the right Jacobian of the exponential map, truncated after the terms needed for fourth order
+	static matrix::Vector3f dexpinv(const matrix::Vector3f &theta, const matrix::Vector3f &w)
+	{
+		const matrix::Vector3f theta_w = theta.cross(w);
+		return w + 0.5f * theta_w + (1.0f / 12.0f) * theta.cross(theta_w);
+	}
+
+	template<typename Wrench>
+	void rk2_step(State &x, const Derivative &k1, float h, Wrench &wrench) const
+	{
+		const matrix::Vector3f theta2 = 0.5f * h * k1.w_B;
+		const Derivative k2 = evaluate(stage(x, k1, 0.5f * h, theta2), wrench);
+		x = stage(x, k2, h, h * dexpinv(theta2, k2.w_B));
+	}
+
+	template<typename Wrench>
+	void rk4_step(State &x, const Derivative &k1, float h, Wrench &wrench) const
+	{
+		const matrix::Vector3f theta2 = 0.5f * h * k1.w_B;
+		const Derivative k2 = evaluate(stage(x, k1, 0.5f * h, theta2), wrench);
+		const matrix::Vector3f u2 = dexpinv(theta2, k2.w_B);
+
+		const matrix::Vector3f theta3 = 0.5f * h * u2;
+		const Derivative k3 = evaluate(stage(x, k2, 0.5f * h, theta3), wrench);
+		const matrix::Vector3f u3 = dexpinv(theta3, k3.w_B);
+
+		const matrix::Vector3f theta4 = h * u3;
+		const Derivative k4 = evaluate(stage(x, k3, h, theta4), wrench);
+		const matrix::Vector3f u4 = dexpinv(theta4, k4.w_B);
+
+		Derivative k;
+		k.p_I_dot = (k1.p_I_dot + 2.0f * (k2.p_I_dot + k3.p_I_dot) + k4.p_I_dot) / 6.0f;
+		k.v_I_dot = (k1.v_I_dot + 2.0f * (k2.v_I_dot + k3.v_I_dot) + k4.v_I_dot) / 6.0f;
+		k.w_B_dot = (k1.w_B_dot + 2.0f * (k2.w_B_dot + k3.w_B_dot) + k4.w_B_dot) / 6.0f;
+		x = stage(x, k, h, h / 6.0f * (k1.w_B + 2.0f * (u2 + u3) + u4));
+	}
+
+	float _mass{1.0f};
+	matrix::Matrix3f _I{matrix::eye<float, 3>()};
+	matrix::Matrix3f _Im1{matrix::eye<float, 3>()};
+};
+
+} // namespace sih
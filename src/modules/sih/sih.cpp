@@ -43,6 +43,10 @@
 #include "aero.hpp"
 #include "sih.hpp"
 
+#if defined(CONFIG_SIH_BATCH)
+#include "SihBatch.hpp"
+#endif // CONFIG_SIH_BATCH
+
 #include <px4_platform_common/getopt.h>
 #include <px4_platform_common/log.h>
 
@@ -217,7 +221,7 @@ void Sih::sensor_step()
 
 	read_motors();
 
-	generate_force_and_torques();
+	generate_force_and_torques(sih::State{_p_I, _v_I, _q, _w_B}, _Fa_I, _Ma_B, _v_B);
 
 	equations_of_motion();
 
@@ -299,13 +303,17 @@ void Sih::parameters_updated()
 
 	_W_I = Vector3f(0.0f, 0.0f, _MASS * CONSTANTS_ONE_G);
 
-	_I = diag(Vector3f(_sih_ixx.get(), _sih_iyy.get(), _sih_izz.get()));
-	_I(0, 1) = _I(1, 0) = _sih_ixy.get();
-	_I(0, 2) = _I(2, 0) = _sih_ixz.get();
-	_I(1, 2) = _I(2, 1) = _sih_iyz.get();
+	Matrix3f I = diag(Vector3f(_sih_ixx.get(), _sih_iyy.get(), _sih_izz.get()));
+	I(0, 1) = I(1, 0) = _sih_ixy.get();
+	I(0, 2) = I(2, 0) = _sih_ixz.get();
+	I(1, 2) = I(2, 1) = _sih_iyz.get();
+
+	_rigid_body.set_mass(_MASS);
+	_rigid_body.set_inertia(I);
 
-	// guards against too small determinants
-	_Im1 = 100.0f * inv(static_cast<typeof _I>(100.0f * _I));
+	_integrator = static_cast<sih::Integrator>(math::constrain(_sih_integrator.get(), (int32_t)sih::Integrator::Euler,
+			(int32_t)sih::Integrator::RK4));
+	_substeps = math::constrain(_sih_substeps.get(), (int32_t)1, (int32_t)10);
 
 	_mu_I = Vector3f(_sih_mu_x.get(), _sih_mu_y.get(), _sih_mu_z.get());
 
@@ -400,72 +408,74 @@ void Sih::read_motors()
 	}
 }
 
-// generate the motors thrust and torque in the body frame
-void Sih::generate_force_and_torques()
+// generate the motors thrust and torque in the body frame, and the aerodynamic forces at the state x
+void Sih::generate_force_and_torques(const sih::State &x, Vector3f &Fa_I, Vector3f &Ma_B, Vector3f &v_B)
 {
 	if (_vehicle == VehicleType::MC) {
 		_T_B = Vector3f(0.0f, 0.0f, -_T_MAX * (+_u[0] + _u[1] + _u[2] + _u[3]));
 		_Mt_B = Vector3f(_L_ROLL * _T_MAX * (-_u[0] + _u[1] + _u[2] - _u[3]),
 				 _L_PITCH * _T_MAX * (+_u[0] - _u[1] + _u[2] - _u[3]),
 				 _Q_MAX * (+_u[0] + _u[1] - _u[2] - _u[3]));
-		_Fa_I = -_KDV * _v_I;   // first order drag to slow down the aircraft
-		_Ma_B = -_KDW * _w_B;   // first order angular damper
+		Fa_I = -_KDV * x.v_I;   // first order drag to slow down the aircraft
+		Ma_B = -_KDW * x.w_B;   // first order angular damper
 
 	} else if (_vehicle == VehicleType::FW) {
 		_T_B = Vector3f(_T_MAX * _u[3], 0.0f, 0.0f); 	// forward thruster
 		// _Mt_B = Vector3f(_Q_MAX*_u[3], 0.0f,0.0f); 	// thruster torque
 		_Mt_B = Vector3f();
-		generate_fw_aerodynamics();
+		generate_fw_aerodynamics(x, Fa_I, Ma_B, v_B);
 
 	} else if (_vehicle == VehicleType::TS) {
 		_T_B = Vector3f(0.0f, 0.0f, -_T_MAX * (_u[0] + _u[1]));
 		_Mt_B = Vector3f(_L_ROLL * _T_MAX * (_u[1] - _u[0]), 0.0f, _Q_MAX * (_u[1] - _u[0]));
-		generate_ts_aerodynamics();
+		generate_ts_aerodynamics(x, Fa_I, Ma_B, v_B);
 
 		// _Fa_I = -_KDV * _v_I;   // first order drag to slow down the aircraft
 		// _Ma_B = -_KDW * _w_B;   // first order angular damper
 	}
 }
 
-void Sih::generate_fw_aerodynamics()
+void Sih::generate_fw_aerodynamics(const sih::State &x, Vector3f &Fa_I, Vector3f &Ma_B, Vector3f &v_B)
 {
-	_v_B = _C_IB.transpose() * _v_I; 	// velocity in body frame [m/s]
-	float altitude = _H0 - _p_I(2);
-	_wing_l.update_aero(_v_B, _w_B, altitude, _u[0]*FLAP_MAX);
-	_wing_r.update_aero(_v_B, _w_B, altitude, -_u[0]*FLAP_MAX);
-	_tailplane.update_aero(_v_B, _w_B, altitude, _u[1]*FLAP_MAX, _T_MAX * _u[3]);
-	_fin.update_aero(_v_B, _w_B, altitude, _u[2]*FLAP_MAX, _T_MAX * _u[3]);
-	_fuselage.update_aero(_v_B, _w_B, altitude);
-	_Fa_I = _C_IB * (_wing_l.get_Fa() + _wing_r.get_Fa() + _tailplane.get_Fa() + _fin.get_Fa() + _fuselage.get_Fa())
-		- _KDV * _v_I; 	// sum of aerodynamic forces
-	_Ma_B = _wing_l.get_Ma() + _wing_r.get_Ma() + _tailplane.get_Ma() + _fin.get_Ma() + _fuselage.get_Ma() - _KDW *
-		_w_B; 	// aerodynamic moments
+	const Dcmf C_IB(x.q);
+	v_B = C_IB.transpose() * x.v_I; 	// velocity in body frame [m/s]
+	const float rho = AeroSeg::air_density(_H0 - x.p_I(2)); 	// same for all the segments
+	_wing_l.update_aero_rho(v_B, x.w_B, rho, _u[0]*FLAP_MAX);
+	_wing_r.update_aero_rho(v_B, x.w_B, rho, -_u[0]*FLAP_MAX);
+	_tailplane.update_aero_rho(v_B, x.w_B, rho, _u[1]*FLAP_MAX, _T_MAX * _u[3]);
+	_fin.update_aero_rho(v_B, x.w_B, rho, _u[2]*FLAP_MAX, _T_MAX * _u[3]);
+	_fuselage.update_aero_rho(v_B, x.w_B, rho);
+	Fa_I = C_IB * (_wing_l.get_Fa() + _wing_r.get_Fa() + _tailplane.get_Fa() + _fin.get_Fa() + _fuselage.get_Fa())
+		- _KDV * x.v_I; 	// sum of aerodynamic forces
+	Ma_B = _wing_l.get_Ma() + _wing_r.get_Ma() + _tailplane.get_Ma() + _fin.get_Ma() + _fuselage.get_Ma() - _KDW *
+		x.w_B; 	// aerodynamic moments
 }
 
-void Sih::generate_ts_aerodynamics()
+void Sih::generate_ts_aerodynamics(const sih::State &x, Vector3f &Fa_I, Vector3f &Ma_B, Vector3f &v_B)
 {
-	_v_B = _C_IB.transpose() * _v_I; // velocity in body frame [m/s]
+	const Dcmf C_IB(x.q);
+	v_B = C_IB.transpose() * x.v_I; // velocity in body frame [m/s]
 	Vector3f Fa_ts = Vector3f();
 	Vector3f Ma_ts = Vector3f();
 	Vector3f v_ts = _C_BS.transpose() *
-			_v_B; // the aerodynamic is resolved in a frame like a standard aircraft (nose-right-belly)
-	Vector3f w_ts = _C_BS.transpose() * _w_B;
-	float altitude = _H0 - _p_I(2);
+			v_B; // the aerodynamic is resolved in a frame like a standard aircraft (nose-right-belly)
+	Vector3f w_ts = _C_BS.transpose() * x.w_B;
+	const float rho = AeroSeg::air_density(_H0 - x.p_I(2)); 	// same for all the segments
 
 	for (int i = 0; i < NB_TS_SEG; i++) {
 		if (i <= NB_TS_SEG / 2) {
-			_ts[i].update_aero(v_ts, w_ts, altitude, _u[5]*TS_DEF_MAX, _T_MAX * _u[1]);
+			_ts[i].update_aero_rho(v_ts, w_ts, rho, _u[5]*TS_DEF_MAX, _T_MAX * _u[1]);
 
 		} else {
-			_ts[i].update_aero(v_ts, w_ts, altitude, -_u[4]*TS_DEF_MAX, _T_MAX * _u[0]);
+			_ts[i].update_aero_rho(v_ts, w_ts, rho, -_u[4]*TS_DEF_MAX, _T_MAX * _u[0]);
 		}
 
 		Fa_ts += _ts[i].get_Fa();
 		Ma_ts += _ts[i].get_Ma();
 	}
 
-	_Fa_I = _C_IB * _C_BS * Fa_ts - _KDV * _v_I; 	// sum of aerodynamic forces
-	_Ma_B = _C_BS * Ma_ts - _KDW * _w_B; 	// aerodynamic moments
+	Fa_I = C_IB * _C_BS * Fa_ts - _KDV * x.v_I; 	// sum of aerodynamic forces
+	Ma_B = _C_BS * Ma_ts - _KDW * x.w_B; 	// aerodynamic moments
 }
 
 // apply the equations of motion of a rigid body and integrate one step
@@ -473,12 +483,12 @@ void Sih::equations_of_motion()
 {
 	_C_IB = matrix::Dcm<float>(_q); // body to inertial transformation
 
-	// Equations of motion of a rigid body
-	_p_I_dot = _v_I;                        // position differential
-	_v_I_dot = (_W_I + _Fa_I + _C_IB * _T_B) / _MASS;   // conservation of linear momentum
-	// _q_dot = _q.derivative1(_w_B);              // attitude differential
-	_dq = Quatf::expq(0.5f * _dt * _w_B);
-	_w_B_dot = _Im1 * (_Mt_B + _Ma_B - _w_B.cross(_I * _w_B)); // conservation of angular momentum
+	// Equations of motion of a rigid body, at the beginning of the step
+	const sih::State x{_p_I, _v_I, _q, _w_B};
+	const sih::Derivative x_dot = _rigid_body.derivative(x, _W_I + _Fa_I + _C_IB * _T_B, _Mt_B + _Ma_B);
+	_p_I_dot = x_dot.p_I_dot;
+	_v_I_dot = x_dot.v_I_dot;
+	_w_B_dot = x_dot.w_B_dot;
 
 	// fake ground, avoid free fall
 	if (_p_I(2) > 0.0f && (_v_I_dot(2) > 0.0f || _v_I(2) > 0.0f)) {
@@ -517,32 +527,27 @@ void Sih::equations_of_motion()
 		}
 
 	} else {
-		// integration: Euler forward
-		_p_I = _p_I + _p_I_dot * _dt;
-		_v_I = _v_I + _v_I_dot * _dt;
-		_q = _q * _dq;
-		_q.normalize();
-		// integration Runge-Kutta 4
-		// rk4_update(_p_I, _v_I, _q, _w_B);
-		_w_B = constrain(_w_B + _w_B_dot * _dt, -6.0f * M_PI_F, 6.0f * M_PI_F);
+		// the forces are evaluated again at the intermediate states of the higher order integrators,
+		// the actuators are held over the step. The members keep the values at the start of the step.
+		sih::State x_next = x;
+		_rigid_body.integrate(x_next, x_dot, _dt, _integrator, _substeps,
+		[this](const sih::State & x_i, Vector3f & F_I, Vector3f & M_B) {
+			Vector3f Fa_I;
+			Vector3f Ma_B;
+			Vector3f v_B;
+			generate_force_and_torques(x_i, Fa_I, Ma_B, v_B);
+			F_I = _W_I + Fa_I + Dcmf(x_i.q) * _T_B;
+			M_B = _Mt_B + Ma_B;
+		});
+
+		_p_I = x_next.p_I;
+		_v_I = x_next.v_I;
+		_q = x_next.q;
+		_w_B = constrain(x_next.w_B, -6.0f * M_PI_F, 6.0f * M_PI_F);
 		_grounded = false;
 	}
 }
 
-// Sih::States Sih::eom_f(States x) 	// equations of motion f: x'=f(x)
-// {
-// 	States x_dot{}; 	// dx/dt
-
-// 	Dcmf C_IB = matrix::Dcm<float>(x.q); // body to inertial transformation
-// 	// Equations of motion of a rigid body
-// 	x_dot.p_I = x.v_I;                        // position differential
-// 	x_dot.v_I = (_W_I + _Fa_I + C_IB * _T_B) / _MASS;   // conservation of linear momentum
-// 	x_dot.q = x.q.derivative1(x.w_B);              // attitude differential
-// 	x_dot.w_B = _Im1 * (_Mt_B + _Ma_B - x.w_B.cross(_I * x.w_B)); // conservation of angular momentum
-
-// 	return x_dot;
-// }
-
 // reconstruct the noisy sensor signals
 void Sih::reconstruct_sensors_signals()
 {
@@ -786,6 +791,99 @@ int Sih::custom_command(int argc, char *argv[])
 	return print_usage("unknown command");
 }
 
+#if defined(CONFIG_SIH_BATCH)
+static uint64_t wall_time_us()
+{
+#if defined(ENABLE_LOCKSTEP_SCHEDULER)
+	// hrt_absolute_time() is the simulated time
+	return micros();
+#else
+	return hrt_absolute_time();
+#endif
+}
+
+int Sih::run_batch(int argc, char *argv[])
+{
+	SihBatch::Config config{};
+	float duration = 10.f;
+	int rate = 250;
+
+	int myoptind = 1;
+	int ch;
+	const char *myoptarg = nullptr;
+
+	while ((ch = px4_getopt(argc, argv, "n:t:r:s:", &myoptind, &myoptarg)) != EOF) {
+		switch (ch) {
+		case 'n':
+			config.num_vehicles = strtol(myoptarg, nullptr, 10);
+			break;
+
+		case 't':
+			duration = strtof(myoptarg, nullptr);
+			break;
+
+		case 'r':
+			rate = strtol(myoptarg, nullptr, 10);
+			break;
+
+		case 's':
+			config.spread = strtof(myoptarg, nullptr) * 0.01f;
+			break;
+
+		default:
+			return print_usage("unrecognized flag");
+		}
+	}
+
+	if (config.num_vehicles <= 0 || !(duration > 0.f) || rate <= 0) {
+		return print_usage("invalid argument");
+	}
+
+	config.dt = 1.f / rate;
+
+	// the controllers are tuned for the vehicle configured by the SIH parameters
+	SihBatch::Vehicle &nominal = config.nominal;
+	param_get(param_find("SIH_MASS"), &nominal.mass);
+	param_get(param_find("SIH_IXX"), &nominal.ixx);
+	param_get(param_find("SIH_IYY"), &nominal.iyy);
+	param_get(param_find("SIH_IZZ"), &nominal.izz);
+	param_get(param_find("SIH_T_MAX"), &nominal.t_max);
+	param_get(param_find("SIH_Q_MAX"), &nominal.q_max);
+	param_get(param_find("SIH_L_ROLL"), &nominal.l_roll);
+	param_get(param_find("SIH_L_PITCH"), &nominal.l_pitch);
+	param_get(param_find("SIH_KDV"), &nominal.kdv);
+	param_get(param_find("SIH_KDW"), &nominal.kdw);
+	param_get(param_find("SIH_T_TAU"), &nominal.t_tau);
+
+	SihBatch *batch = new SihBatch();
+
+	if (batch == nullptr || !batch->init(config)) {
+		PX4_ERR("alloc failed");
+		delete batch;
+		return PX4_ERROR;
+	}
+
+	const uint32_t steps = (uint32_t)(duration * rate);
+
+	PX4_INFO("%d vehicles, %.1f s at %d Hz", config.num_vehicles, (double)duration, rate);
+
+	const uint64_t start = wall_time_us();
+	batch->run(steps);
+	const float elapsed_s = math::max(wall_time_us() - start, (uint64_t)1) * 1e-6f;
+
+	const SihBatch::Statistics statistics = batch->statistics();
+
+	PX4_INFO("wall time: %.3f s, %.0f vehicle-steps/s, %.1fx realtime per vehicle", (double)elapsed_s,
+		 (double)config.num_vehicles * steps / (double)elapsed_s, (double)(duration / elapsed_s * config.num_vehicles));
+	PX4_INFO("position error: mean %.3f m, max %.3f m, diverged: %d", (double)statistics.position_error_mean,
+		 (double)statistics.position_error_max, statistics.diverged);
+
+	delete batch;
+
+	return PX4_OK;
+}
+#endif // CONFIG_SIH_BATCH
+
 int Sih::print_usage(const char *reason)
 {
 	if (reason) {
@@ -807,14 +905,29 @@ in order to incorporate the state estimator in the loop.
 ### Implementation
 The simulator implements the equations of motion using matrix algebra.
 Quaternion representation is used for the attitude.
-Forward Euler is used for integration.
+Forward Euler is used for integration by default, SIH_INTEGRATOR selects a higher order
+Runge-Kutta(-Munthe-Kaas) integration and SIH_SUBSTEPS divides each step into sub-steps.
 Most of the variables are declared global in the .hpp file to avoid stack overflow.
 
+### Batch mode
+The batch command (POSIX only) runs many independent multicopters headless in the
+calling context, e.g. for parameter sweeps: the simulated vehicles are spread around
+the one configured by the SIH parameters, and each one is flown by a reduced
+estimator and controller to a randomized setpoint. It reports the achieved
+vehicle-steps per second and the final position errors.
+The command blocks until the simulation is done. It does not need the module to
+be running and does not hold the module lock meanwhile.
+
 
 )DESCR_STR");
 
     PRINT_MODULE_USAGE_NAME("sih", "simulation");
     PRINT_MODULE_USAGE_COMMAND("start");
+    PRINT_MODULE_USAGE_COMMAND_DESCR("batch", "Run a headless batch simulation of many multicopters");
+    PRINT_MODULE_USAGE_PARAM_INT('n', 100, 1, 1000000, "Number of vehicles", true);
+    PRINT_MODULE_USAGE_PARAM_FLOAT('t', 10.f, 0.1f, 100000.f, "Simulated duration in seconds", true);
+    PRINT_MODULE_USAGE_PARAM_INT('r', 250, 50, 10000, "Simulation rate in Hz", true);
+    PRINT_MODULE_USAGE_PARAM_FLOAT('s', 10.f, 0.f, 50.f, "Spread of mass, inertia and thrust in percent", true);
     PRINT_MODULE_USAGE_DEFAULT_COMMANDS();
 
     return 0;
@@ -822,5 +935,14 @@ Most of the variables are declared global in the .hpp file to avoid stack overfl
 
 extern "C" __EXPORT int sih_main(int argc, char *argv[])
 {
+#if defined(CONFIG_SIH_BATCH)
+
+	// the batch runs in the calling context, outside of the module lock of ModuleBase::main()
+	if (argc > 1 && strcmp(argv[1], "batch") == 0) {
+		return Sih::run_batch(argc - 1, argv + 1);
+	}
+
+#endif // CONFIG_SIH_BATCH
+
 	return Sih::main(argc, argv);
 }
@@ -59,6 +59,8 @@
 #include <px4_platform_common/module_params.h>
 #include <px4_platform_common/posix.h>
 
+#include "rigid_body.hpp"
+
 #include <matrix/matrix/math.hpp>   // matrix, vectors, dcm, quaterions
 #include <conversion/rotation.h>    // math::radians,
 #include <lib/geo/geo.h>        // to get the physical constants
@@ -104,6 +106,11 @@ public:
 	/** @see ModuleBase */
 	static int custom_command(int argc, char *argv[]);
 
+#if defined(CONFIG_SIH_BATCH)
+	/** batch mode: simulate many vehicles without the flight stack, blocks until done */
+	static int run_batch(int argc, char *argv[]);
+#endif // CONFIG_SIH_BATCH
+
 	/** @see ModuleBase::print_status() */
 	int print_status() override;
 
@@ -173,15 +180,19 @@ private:
 	void gps_fix();
 	void gps_no_fix();
 	void read_motors();
-	void generate_force_and_torques();
+	// the aerodynamic wrench and body velocity at state x, the thrust only depends on the actuators
+	void generate_force_and_torques(const sih::State &x, matrix::Vector3f &Fa_I, matrix::Vector3f &Ma_B,
+					matrix::Vector3f &v_B);
 	void equations_of_motion();
 	void reconstruct_sensors_signals();
 	void send_gps();
 	void send_airspeed();
 	void send_dist_snsr();
 	void publish_sih();
-	void generate_fw_aerodynamics();
-	void generate_ts_aerodynamics();
+	void generate_fw_aerodynamics(const sih::State &x, matrix::Vector3f &Fa_I, matrix::Vector3f &Ma_B,
+				      matrix::Vector3f &v_B);
+	void generate_ts_aerodynamics(const sih::State &x, matrix::Vector3f &Fa_I, matrix::Vector3f &Ma_B,
+				      matrix::Vector3f &v_B);
 	void sensor_step();
 
 #if defined(ENABLE_LOCKSTEP_SCHEDULER)
@@ -221,7 +232,6 @@ private:
 	matrix::Quatf       _q;             // quaternion attitude
 	matrix::Dcmf        _C_IB;          // body to inertial transformation
 	matrix::Vector3f    _w_B;           // body rates in body frame [rad/s]
-	matrix::Quatf       _dq;            // quaternion differential
 	matrix::Vector3f    _w_B_dot;       // body rates differential
 	float       _u[NB_MOTORS];          // thruster signals
 
@@ -287,8 +297,9 @@ private:
 	float _MASS, _T_MAX, _Q_MAX, _L_ROLL, _L_PITCH, _KDV, _KDW, _H0, _T_TAU;
 	double _LAT0, _LON0, _COS_LAT0;
 	matrix::Vector3f _W_I;  // weight of the vehicle in inertial frame [N]
-	matrix::Matrix3f _I;    // vehicle inertia matrix
-	matrix::Matrix3f _Im1;  // inverse of the inertia matrix
+	sih::RigidBody _rigid_body;     // mass and inertia
+	sih::Integrator _integrator{sih::Integrator::Euler};
+	int _substeps{1};       // integration sub-steps per simulation step
 	matrix::Vector3f _mu_I; // NED magnetic field in inertial frame [G]
 
 	int _gps_used;
@@ -328,6 +339,8 @@ private:
 		(ParamFloat<px4::params::SIH_DISTSNSR_OVR>) _sih_distance_snsr_override,
 		(ParamFloat<px4::params::SIH_T_TAU>) _sih_thrust_tau,
 		(ParamInt<px4::params::SIH_VEHICLE_TYPE>) _sih_vtype,
+		(ParamInt<px4::params::SIH_INTEGRATOR>) _sih_integrator,
+		(ParamInt<px4::params::SIH_SUBSTEPS>) _sih_substeps,
 		(ParamBool<px4::params::SYS_CTRL_ALLOC>) _sys_ctrl_alloc
 	)
 };
@@ -446,3 +446,27 @@ PARAM_DEFINE_FLOAT(SIH_T_TAU, 0.05f);
  * @group Simulation In Hardware
  */
 PARAM_DEFINE_INT32(SIH_VEHICLE_TYPE, 0);
+
+/**
+ * Integration method
+ *
+ * Runge-Kutta integrations evaluate the forces and moments again at the intermediate states,
+ * RK4 costs four times as much as Euler per sub-step.
+ *
+ * @value 0 Euler
+ * @value 1 RK2
+ * @value 2 RK4
+ * @group Simulation In Hardware
+ */
+PARAM_DEFINE_INT32(SIH_INTEGRATOR, 0);
+
+/**
+ * Integration sub-steps
+ *
+ * Number of integration steps per simulation step, the actuators are held over the simulation step.
+ *
+ * @min 1
+ * @max 10
+ * @group Simulation In Hardware
+ */
+PARAM_DEFINE_INT32(SIH_SUBSTEPS, 1);
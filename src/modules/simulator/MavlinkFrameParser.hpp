@@ -0,0 +1,202 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file MavlinkFrameParser.hpp
+ *
+ * Frame level MAVLink parser for the simulator link.
+ *
+ * The socket is read directly into the receive buffer of the parser, and complete frames are then
+ * validated and copied into a message at once, instead of running the byte-wise state machine of
+ * mavlink_parse_char(). A partial frame at the end of the buffered data (TCP) is kept until the rest
+ * of it is received. Frames with a bad checksum or unknown incompatibility flags are dropped and the
+ * parser resynchronizes on the next start byte, like mavlink_parse_char(). Signatures are not verified.
+ */
+
+#pragma once
+
+#include <mavlink.h>
+#include <mavlink_types.h>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+class MavlinkFrameParser
+{
+public:
+	static constexpr size_t BUFFER_SIZE = 16384;
+
+	MavlinkFrameParser() = default;
+	~MavlinkFrameParser() = default;
+
+	MavlinkFrameParser(const MavlinkFrameParser &) = delete;
+	MavlinkFrameParser &operator=(const MavlinkFrameParser &) = delete;
+
+	/** free space behind the buffered data, to receive into */
+	uint8_t *receive_buffer()
+	{
+		compact();
+		return _buffer + _end;
+	}
+
+	/** size of receive_buffer() */
+	size_t receive_space()
+	{
+		compact();
+		return BUFFER_SIZE - _end;
+	}
+
+	/** mark len bytes written to receive_buffer() as received */
+	void received(size_t len) { _end += len; }
+
+	/**
+	 * Parse the next complete frame.
+	 * @return false if no complete frame is buffered
+	 */
+	bool parse(mavlink_message_t &msg)
+	{
+		while (_begin < _end) {
+			const uint8_t *frame = _buffer + _begin;
+			const size_t available = _end - _begin;
+
+			if ((frame[0] != MAVLINK_STX) && (frame[0] != MAVLINK_STX_MAVLINK1)) {
+				skip(1);
+				continue;
+			}
+
+			const bool mavlink1 = (frame[0] == MAVLINK_STX_MAVLINK1);
+			const size_t header_len = 1 + (mavlink1 ? MAVLINK_CORE_HEADER_MAVLINK1_LEN : MAVLINK_CORE_HEADER_LEN);
+
+			if (available < header_len) {
+				break;
+			}
+
+			const uint8_t payload_len = frame[1];
+			const uint8_t incompat_flags = mavlink1 ? 0 : frame[2];
+
+			if ((incompat_flags & ~MAVLINK_IFLAG_MASK) != 0) {
+				skip(1);
+				continue;
+			}
+
+			const bool is_signed = (incompat_flags & MAVLINK_IFLAG_SIGNED) != 0;
+			const size_t frame_len = header_len + payload_len + MAVLINK_NUM_CHECKSUM_BYTES
+						 + (is_signed ? MAVLINK_SIGNATURE_BLOCK_LEN : 0);
+
+			if (available < frame_len) {
+				break;
+			}
+
+			const uint32_t msgid = mavlink1 ? frame[5] : (frame[7] | (frame[8] << 8) | ((uint32_t)frame[9] << 16));
+			const mavlink_msg_entry_t *entry = mavlink_get_msg_entry(msgid);
+
+			// checksum over the header without the start byte and the payload, and the CRC extra of the message
+			uint16_t checksum = crc_calculate(frame + 1, header_len - 1 + payload_len);
+			crc_accumulate(entry ? entry->crc_extra : 0, &checksum);
+
+			const uint8_t *ck = frame + header_len + payload_len;
+
+			if ((ck[0] != (checksum & 0xFF)) || (ck[1] != (checksum >> 8))) {
+				_crc_errors++;
+				skip(1);
+				continue;
+			}
+
+			msg.magic = frame[0];
+			msg.len = payload_len;
+			msg.incompat_flags = incompat_flags;
+			msg.compat_flags = mavlink1 ? 0 : frame[3];
+			msg.seq = mavlink1 ? frame[2] : frame[4];
+			msg.sysid = mavlink1 ? frame[3] : frame[5];
+			msg.compid = mavlink1 ? frame[4] : frame[6];
+			msg.msgid = msgid;
+			msg.checksum = checksum;
+			msg.ck[0] = ck[0];
+			msg.ck[1] = ck[1];
+
+			uint8_t *payload = (uint8_t *)_MAV_PAYLOAD_NON_CONST(&msg);
+			memcpy(payload, frame + header_len, payload_len);
+
+			// trailing zeros of the payload are truncated by the sender
+			if (entry && (payload_len < entry->max_msg_len)) {
+				memset(payload + payload_len, 0, entry->max_msg_len - payload_len);
+			}
+
+			if (is_signed) {
+				memcpy(msg.signature, ck + MAVLINK_NUM_CHECKSUM_BYTES, MAVLINK_SIGNATURE_BLOCK_LEN);
+			}
+
+			_begin += frame_len;
+			_frames++;
+			return true;
+		}
+
+		return false;
+	}
+
+	/** drop the buffered data, e.g. after the link was reconnected */
+	void reset() { _begin = _end = 0; }
+
+	uint32_t frames() const { return _frames; }
+	uint32_t crc_errors() const { return _crc_errors; }
+	uint32_t dropped_bytes() const { return _dropped_bytes; }
+
+private:
+	void skip(size_t len)
+	{
+		_begin += len;
+		_dropped_bytes += len;
+	}
+
+	// move a partial frame to the start of the buffer
+	void compact()
+	{
+		if (_begin == _end) {
+			_begin = _end = 0;
+
+		} else if (_begin > 0) {
+			memmove(_buffer, _buffer + _begin, _end - _begin);
+			_end -= _begin;
+			_begin = 0;
+		}
+	}
+
+	uint8_t _buffer[BUFFER_SIZE];
+	size_t _begin{0};	///< first byte not parsed yet
+	size_t _end{0};		///< end of the received data
+
+	uint32_t _frames{0};
+	uint32_t _crc_errors{0};
+	uint32_t _dropped_bytes{0};
+};
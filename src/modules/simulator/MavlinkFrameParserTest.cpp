@@ -0,0 +1,228 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file MavlinkFrameParserTest.cpp
+ *
+ * Tests for the frame level parser of the simulator link: the messages are the same as the ones of
+ * mavlink_parse_char() for streams split at any byte, and the parser resynchronizes after corrupted data.
+ * The benchmark (disabled by default) prints the HIL_SENSOR rate both parsers can sustain.
+ */
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <vector>
+
+#include "MavlinkFrameParser.hpp"
+
+static mavlink_message_t hil_sensor_message(uint32_t i)
+{
+	mavlink_hil_sensor_t hil_sensor{};
+	hil_sensor.time_usec = 1000 * (uint64_t)i;
+	hil_sensor.xacc = 0.01f * i;
+	hil_sensor.yacc = -0.02f * i;
+	hil_sensor.zacc = -9.81f;
+	hil_sensor.xgyro = 0.001f * i;
+	hil_sensor.abs_pressure = 1013.25f;
+	hil_sensor.temperature = 20.f;
+	hil_sensor.fields_updated = (i % 4 == 0) ? 0x1fff : 0x3f; // trailing zeros are truncated in some frames
+	hil_sensor.id = i % 2;
+
+	mavlink_message_t msg;
+	mavlink_msg_hil_sensor_encode(1, 51, &msg, &hil_sensor);
+	return msg;
+}
+
+static void append(std::vector<uint8_t> &stream, const mavlink_message_t &msg)
+{
+	uint8_t buf[MAVLINK_MAX_PACKET_LEN];
+	const uint16_t len = mavlink_msg_to_send_buffer(buf, &msg);
+	stream.insert(stream.end(), buf, buf + len);
+}
+
+// feed the stream in chunks of the given size and collect the parsed messages
+static std::vector<mavlink_message_t> parse(MavlinkFrameParser &parser, const std::vector<uint8_t> &stream,
+		size_t chunk)
+{
+	std::vector<mavlink_message_t> messages;
+	size_t pos = 0;
+
+	while (pos < stream.size()) {
+		const size_t len = std::min(std::min(chunk, stream.size() - pos), parser.receive_space());
+		memcpy(parser.receive_buffer(), stream.data() + pos, len);
+		parser.received(len);
+		pos += len;
+
+		mavlink_message_t msg;
+
+		while (parser.parse(msg)) {
+			messages.push_back(msg);
+		}
+	}
+
+	return messages;
+}
+
+static void expect_same_message(const mavlink_message_t &a, const mavlink_message_t &b)
+{
+	EXPECT_EQ(a.msgid, b.msgid);
+	EXPECT_EQ(a.len, b.len);
+	EXPECT_EQ(a.seq, b.seq);
+	EXPECT_EQ(a.sysid, b.sysid);
+	EXPECT_EQ(a.compid, b.compid);
+	EXPECT_EQ(a.checksum, b.checksum);
+
+	mavlink_hil_sensor_t hil_sensor_a;
+	mavlink_hil_sensor_t hil_sensor_b;
+	mavlink_msg_hil_sensor_decode(&a, &hil_sensor_a);
+	mavlink_msg_hil_sensor_decode(&b, &hil_sensor_b);
+	EXPECT_EQ(memcmp(&hil_sensor_a, &hil_sensor_b, sizeof(hil_sensor_a)), 0);
+}
+
+TEST(MavlinkFrameParserTest, SameAsByteParser)
+{
+	std::vector<uint8_t> stream;
+
+	for (uint32_t i = 0; i < 100; i++) {
+		append(stream, hil_sensor_message(i));
+	}
+
+	std::vector<mavlink_message_t> expected;
+	mavlink_status_t status{};
+	mavlink_message_t msg;
+
+	for (uint8_t c : stream) {
+		if (mavlink_parse_char(MAVLINK_COMM_1, c, &msg, &status)) {
+			expected.push_back(msg);
+		}
+	}
+
+	ASSERT_EQ(expected.size(), 100u);
+
+	// datagrams of whole frames, and a TCP stream split at any byte
+	for (size_t chunk : {stream.size(), (size_t)1, (size_t)7, (size_t)100}) {
+		MavlinkFrameParser parser;
+		const std::vector<mavlink_message_t> messages = parse(parser, stream, chunk);
+
+		ASSERT_EQ(messages.size(), expected.size()) << "chunk " << chunk;
+
+		for (size_t i = 0; i < messages.size(); i++) {
+			expect_same_message(messages[i], expected[i]);
+		}
+
+		EXPECT_EQ(parser.frames(), 100u);
+		EXPECT_EQ(parser.crc_errors(), 0u);
+		EXPECT_EQ(parser.dropped_bytes(), 0u);
+	}
+}
+
+TEST(MavlinkFrameParserTest, Resynchronize)
+{
+	std::vector<uint8_t> stream{0x00, 0x12, MAVLINK_STX, 0x34}; // garbage, including a start byte
+	append(stream, hil_sensor_message(1));
+
+	// corrupted frame
+	const size_t corrupted = stream.size();
+	append(stream, hil_sensor_message(2));
+	stream[corrupted + 20] ^= 0xFF;
+
+	append(stream, hil_sensor_message(3));
+
+	MavlinkFrameParser parser;
+	const std::vector<mavlink_message_t> messages = parse(parser, stream, 13);
+
+	ASSERT_EQ(messages.size(), 2u);
+	expect_same_message(messages[0], hil_sensor_message(1));
+	expect_same_message(messages[1], hil_sensor_message(3));
+	EXPECT_GE(parser.crc_errors(), 1u);
+	EXPECT_GT(parser.dropped_bytes(), 0u);
+}
+
+// not part of the unit tests, run with --gtest_also_run_disabled_tests
+TEST(MavlinkFrameParserTest, DISABLED_Benchmark)
+{
+	static constexpr uint32_t MESSAGES = 100000;
+	std::vector<uint8_t> stream;
+
+	for (uint32_t i = 0; i < MESSAGES; i++) {
+		append(stream, hil_sensor_message(i));
+	}
+
+	// what the simulator module does with every message: parse and decode
+	double checksum = 0.;
+	mavlink_hil_sensor_t hil_sensor;
+
+	auto start = std::chrono::steady_clock::now();
+	mavlink_status_t status{};
+	mavlink_message_t msg;
+	uint32_t received = 0;
+
+	for (uint8_t c : stream) {
+		if (mavlink_parse_char(MAVLINK_COMM_2, c, &msg, &status)) {
+			mavlink_msg_hil_sensor_decode(&msg, &hil_sensor);
+			checksum += hil_sensor.xacc;
+			received++;
+		}
+	}
+
+	const double byte_parser_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	EXPECT_EQ(received, MESSAGES);
+
+	start = std::chrono::steady_clock::now();
+	MavlinkFrameParser parser;
+	size_t pos = 0;
+	received = 0;
+
+	while (pos < stream.size()) {
+		// as received from the socket, in reads of the whole free space
+		const size_t len = std::min(stream.size() - pos, parser.receive_space());
+		memcpy(parser.receive_buffer(), stream.data() + pos, len);
+		parser.received(len);
+		pos += len;
+
+		while (parser.parse(msg)) {
+			mavlink_msg_hil_sensor_decode(&msg, &hil_sensor);
+			checksum -= hil_sensor.xacc;
+			received++;
+		}
+	}
+
+	const double frame_parser_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	EXPECT_EQ(received, MESSAGES);
+	EXPECT_NEAR(checksum, 0., 1e-3);
+
+	printf("HIL_SENSOR/s: mavlink_parse_char %.0f, MavlinkFrameParser %.0f\n",
+	       MESSAGES / byte_parser_s, MESSAGES / frame_parser_s);
+}
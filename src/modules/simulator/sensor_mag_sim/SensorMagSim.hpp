@@ -35,6 +35,7 @@
 
 #include <lib/drivers/magnetometer/PX4Magnetometer.hpp>
 #include <lib/perf/perf_counter.h>
+#include <lib/world_magnetic_model/geo_mag_declination.h>
 #include <px4_platform_common/defines.h>
 #include <px4_platform_common/module.h>
 #include <px4_platform_common/module_params.h>
@@ -83,6 +84,7 @@ private:
 	bool _mag_earth_available{false};
 
 	matrix::Vector3f _mag_earth_pred{};
+	MagFieldCache _mag_field_cache{};
 
 	perf_counter_t _loop_perf{perf_alloc(PC_ELAPSED, MODULE_NAME": cycle")};
 
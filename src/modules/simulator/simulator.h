@@ -83,6 +83,8 @@
 #include <mavlink.h>
 #include <mavlink_types.h>
 
+#include "MavlinkFrameParser.hpp"
+
 using namespace time_literals;
 
 //! Enumeration to use on the bitmask in HIL_SENSOR
@@ -165,6 +167,8 @@ private:
 
 	// simulated sensor instances
 	static constexpr uint8_t ACCEL_COUNT_MAX = 3;
+	static constexpr float ACCEL_FIFO_SCALE = CONSTANTS_ONE_G / 2048.f;
+	static constexpr float ACCEL_FIFO_RANGE = 16.f * CONSTANTS_ONE_G;
 	PX4Accelerometer _px4_accel[ACCEL_COUNT_MAX] {
 		{1310988, ROTATION_NONE}, // 1310988: DRV_IMU_DEVTYPE_SIM, BUS: 1, ADDR: 1, TYPE: SIMULATION
 		{1310996, ROTATION_NONE}, // 1310996: DRV_IMU_DEVTYPE_SIM, BUS: 2, ADDR: 1, TYPE: SIMULATION
@@ -172,6 +176,8 @@ private:
 	};
 
 	static constexpr uint8_t GYRO_COUNT_MAX = 3;
+	static constexpr float GYRO_FIFO_SCALE = math::radians(2000.f / 32768.f);
+	static constexpr float GYRO_FIFO_RANGE = math::radians(2000.f);
 	PX4Gyroscope _px4_gyro[GYRO_COUNT_MAX] {
 		{1310988, ROTATION_NONE}, // 1310988: DRV_IMU_DEVTYPE_SIM, BUS: 1, ADDR: 1, TYPE: SIMULATION
 		{1310996, ROTATION_NONE}, // 1310996: DRV_IMU_DEVTYPE_SIM, BUS: 2, ADDR: 1, TYPE: SIMULATION
@@ -188,6 +194,8 @@ private:
 	perf_counter_t _perf_sim_delay{perf_alloc(PC_ELAPSED, MODULE_NAME": network delay")};
 	perf_counter_t _perf_sim_interval{perf_alloc(PC_INTERVAL, MODULE_NAME": network interval")};
 
+	MavlinkFrameParser _mavlink_parser{};
+
 	// uORB publisher handlers
 	uORB::Publication<differential_pressure_s>	_differential_pressure_pub{ORB_ID(differential_pressure)};
 	uORB::PublicationMulti<sensor_optical_flow_s>	_sensor_optical_flow_pub{ORB_ID(sensor_optical_flow)};
@@ -231,6 +239,7 @@ private:
 
 	void parameters_update(bool force);
 	void poll_for_MAVLink_messages();
+	void publish_imu_fifo();
 	void request_hil_state_quaternion();
 	void send();
 	void send_controls();
@@ -278,11 +287,13 @@ private:
 	bool _accel_blocked[ACCEL_COUNT_MAX] {};
 	bool _accel_stuck[ACCEL_COUNT_MAX] {};
 	sensor_accel_fifo_s _last_accel_fifo{};
+	bool _accel_fifo_pending{false};	///< _last_accel_fifo holds samples which are not published yet
 	matrix::Vector3f _last_accel[GYRO_COUNT_MAX] {};
 
 	bool _gyro_blocked[GYRO_COUNT_MAX] {};
 	bool _gyro_stuck[GYRO_COUNT_MAX] {};
 	sensor_gyro_fifo_s _last_gyro_fifo{};
+	bool _gyro_fifo_pending{false};		///< _last_gyro_fifo holds samples which are not published yet
 	matrix::Vector3f _last_gyro[GYRO_COUNT_MAX] {};
 
 	bool _baro_blocked{false};
@@ -72,7 +72,6 @@ static int openUart(const char *uart_name, int baud);
 #endif
 
 static int _fd;
-static unsigned char _buf[2048];
 static sockaddr_in _srcaddr;
 static unsigned _addrlen = sizeof(_srcaddr);
 
@@ -109,6 +108,51 @@ Simulator::Simulator()
 		snprintf(param_name, sizeof(param_name), "%s_%s%d", "PWM_MAIN", "FUNC", i + 1);
 		param_get(param_find(param_name), &_output_functions[i]);
 	}
+
+	// accel 0 and gyro 0 are simulated FIFOs
+	_px4_accel[0].set_scale(ACCEL_FIFO_SCALE);
+	_px4_accel[0].set_range(ACCEL_FIFO_RANGE);
+	_px4_gyro[0].set_scale(GYRO_FIFO_SCALE);
+	_px4_gyro[0].set_range(GYRO_FIFO_RANGE);
+}
+
+// Append a sample to a simulated FIFO. Equally spaced samples of consecutive HIL_SENSOR messages are
+// published together, the FIFO is published first if the sample does not fit.
+template<typename FIFO, typename Sensor>
+static void fifo_push(FIFO &fifo, bool &pending, Sensor &sensor, const hrt_abstime &time, float x, float y, float z)
+{
+	static constexpr uint8_t FIFO_SIZE = sizeof(FIFO::x) / sizeof(FIFO::x[0]);
+	const float dt = time - fifo.timestamp_sample;
+
+	if (pending && ((fifo.samples >= FIFO_SIZE) || (dt != fifo.dt))) {
+		sensor.updateFIFO(fifo);
+		pending = false;
+	}
+
+	if (!pending) {
+		fifo.samples = 0;
+		fifo.dt = dt;
+	}
+
+	fifo.x[fifo.samples] = x;
+	fifo.y[fifo.samples] = y;
+	fifo.z[fifo.samples] = z;
+	fifo.samples++;
+	fifo.timestamp_sample = time;
+	pending = true;
+}
+
+void Simulator::publish_imu_fifo()
+{
+	if (_accel_fifo_pending) {
+		_px4_accel[0].updateFIFO(_last_accel_fifo);
+		_accel_fifo_pending = false;
+	}
+
+	if (_gyro_fifo_pending) {
+		_px4_gyro[0].updateFIFO(_last_gyro_fifo);
+		_gyro_fifo_pending = false;
+	}
 }
 
 void Simulator::actuator_controls_from_outputs(mavlink_hil_actuator_controls_t *msg)
@@ -275,26 +319,15 @@ void Simulator::update_sensors(const hrt_abstime &time, const mavlink_hil_sensor
 		for (int i = 0; i < ACCEL_COUNT_MAX; i++) {
 			if (i == 0) {
 				// accel 0 is simulated FIFO
-				static constexpr float ACCEL_FIFO_SCALE = CONSTANTS_ONE_G / 2048.f;
-				static constexpr float ACCEL_FIFO_RANGE = 16.f * CONSTANTS_ONE_G;
-
-				_px4_accel[i].set_scale(ACCEL_FIFO_SCALE);
-				_px4_accel[i].set_range(ACCEL_FIFO_RANGE);
-
 				if (_accel_stuck[i]) {
+					publish_imu_fifo();
 					_px4_accel[i].updateFIFO(_last_accel_fifo);
 
 				} else if (!_accel_blocked[i]) {
 					_px4_accel[i].set_temperature(_sensors_temperature);
 
-					_last_accel_fifo.samples = 1;
-					_last_accel_fifo.dt = time - _last_accel_fifo.timestamp_sample;
-					_last_accel_fifo.timestamp_sample = time;
-					_last_accel_fifo.x[0] = sensors.xacc / ACCEL_FIFO_SCALE;
-					_last_accel_fifo.y[0] = sensors.yacc / ACCEL_FIFO_SCALE;
-					_last_accel_fifo.z[0] = sensors.zacc / ACCEL_FIFO_SCALE;
-
-					_px4_accel[i].updateFIFO(_last_accel_fifo);
+					fifo_push(_last_accel_fifo, _accel_fifo_pending, _px4_accel[i], time,
+						  sensors.xacc / ACCEL_FIFO_SCALE, sensors.yacc / ACCEL_FIFO_SCALE, sensors.zacc / ACCEL_FIFO_SCALE);
 				}
 
 			} else {
@@ -315,26 +348,15 @@ void Simulator::update_sensors(const hrt_abstime &time, const mavlink_hil_sensor
 		for (int i = 0; i < GYRO_COUNT_MAX; i++) {
 			if (i == 0) {
 				// gyro 0 is simulated FIFO
-				static constexpr float GYRO_FIFO_SCALE = math::radians(2000.f / 32768.f);
-				static constexpr float GYRO_FIFO_RANGE = math::radians(2000.f);
-
-				_px4_gyro[i].set_scale(GYRO_FIFO_SCALE);
-				_px4_gyro[i].set_range(GYRO_FIFO_RANGE);
-
 				if (_gyro_stuck[i]) {
+					publish_imu_fifo();
 					_px4_gyro[i].updateFIFO(_last_gyro_fifo);
 
 				} else if (!_gyro_blocked[i]) {
 					_px4_gyro[i].set_temperature(_sensors_temperature);
 
-					_last_gyro_fifo.samples = 1;
-					_last_gyro_fifo.dt = time - _last_gyro_fifo.timestamp_sample;
-					_last_gyro_fifo.timestamp_sample = time;
-					_last_gyro_fifo.x[0] = sensors.xgyro / GYRO_FIFO_SCALE;
-					_last_gyro_fifo.y[0] = sensors.ygyro / GYRO_FIFO_SCALE;
-					_last_gyro_fifo.z[0] = sensors.zgyro / GYRO_FIFO_SCALE;
-
-					_px4_gyro[i].updateFIFO(_last_gyro_fifo);
+					fifo_push(_last_gyro_fifo, _gyro_fifo_pending, _px4_gyro[i], time,
+						  sensors.xgyro / GYRO_FIFO_SCALE, sensors.ygyro / GYRO_FIFO_SCALE, sensors.zgyro / GYRO_FIFO_SCALE);
 				}
 
 			} else {
@@ -567,8 +589,14 @@ void Simulator::handle_message_hil_sensor(const mavlink_message_t *msg)
 		_has_initialized.store(true);
 	}
 
+	// the simulator waits for the outputs computed from this sample, the samples can't be batched
+	publish_imu_fifo();
+
 #endif
 
+	// parallel lockstep: process the work triggered by the sensor data before completing the cycle
+	px4_lockstep_run_steps();
+
 	px4_lockstep_progress(_lockstep_component);
 }
 
@@ -1168,7 +1196,7 @@ void Simulator::run()
 
 		while (true) {
 			// Once we receive something, we're most probably good and can carry on.
-			int len = ::recvfrom(_fd, _buf, sizeof(_buf), 0,
+			int len = ::recvfrom(_fd, _mavlink_parser.receive_buffer(), _mavlink_parser.receive_space(), 0,
 					     (struct sockaddr *)&_srcaddr, (socklen_t *)&_addrlen);
 
 			if (len > 0) {
@@ -1257,8 +1285,6 @@ void Simulator::run()
 	pthread_create(&sender_thread, &sender_thread_attr, Simulator::sending_trampoline, nullptr);
 	pthread_attr_destroy(&sender_thread_attr);
 
-	mavlink_status_t mavlink_status = {};
-
 	// Request HIL_STATE_QUATERNION for ground truth.
 	request_hil_state_quaternion();
 
@@ -1280,17 +1306,27 @@ void Simulator::run()
 
 		if (fds[0].revents & POLLIN) {
 
-			int len = ::recvfrom(_fd, _buf, sizeof(_buf), 0, (struct sockaddr *)&_srcaddr, (socklen_t *)&_addrlen);
-
-			if (len > 0) {
-				mavlink_message_t msg;
+			// read everything received since the last wakeup straight into the parser, a partial frame (TCP) stays
+			// buffered until the next read
+			while (_mavlink_parser.receive_space() >= MAVLINK_MAX_PACKET_LEN) {
+				int len = ::recvfrom(_fd, _mavlink_parser.receive_buffer(), _mavlink_parser.receive_space(), MSG_DONTWAIT,
+						     (struct sockaddr *)&_srcaddr, (socklen_t *)&_addrlen);
 
-				for (int i = 0; i < len; i++) {
-					if (mavlink_parse_char(MAVLINK_COMM_0, _buf[i], &msg, &mavlink_status)) {
-						handle_message(&msg);
-					}
+				if (len <= 0) {
+					break;
 				}
+
+				_mavlink_parser.received(len);
 			}
+
+			mavlink_message_t msg;
+
+			while (_mavlink_parser.parse(msg)) {
+				handle_message(&msg);
+			}
+
+			// the IMU samples of all the HIL_SENSOR messages received at once are published together
+			publish_imu_fifo();
 		}
 
 #ifdef ENABLE_UART_RC_INPUT
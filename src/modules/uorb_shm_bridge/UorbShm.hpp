@@ -0,0 +1,189 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file UorbShm.hpp
+ *
+ * Layout of the POSIX shared memory segment used to export uORB topics to other processes.
+ * Shared by the uorb_shm_bridge module (writer) and the reader library, it must not depend on PX4.
+ *
+ * The segment starts with a header and a table of topic descriptors, followed by a ring of queue_size
+ * slots for each exported topic instance. A ring has a single writer (the bridge serializes the
+ * publications of a topic) and any number of readers, which only need read access to the segment.
+ *
+ * Like DeviceNode, a ring counts the publications in its generation, the publication with generation g
+ * is stored in slot g % queue_size. Each slot is protected by a sequence number: it is odd while the slot
+ * is written and 2 * (g + 1) once publication g is complete, so that a reader can detect if a slot was
+ * overwritten while copying it.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace uorb_shm
+{
+
+static constexpr uint32_t MAGIC = 0x4d534f55; // "UOSM"
+static constexpr uint32_t VERSION = 1;
+
+static constexpr unsigned MAX_TOPICS = 64;
+static constexpr unsigned MAX_NAME_LENGTH = 48;
+static constexpr size_t ALIGNMENT = 64; // cache line
+
+// only lock-free atomics are address-free and can be used across processes
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "lock-free 32 bit atomics required");
+
+struct Header {
+	std::atomic<uint32_t> magic;		///< written last, once the segment is initialized
+	uint32_t version;
+	uint32_t size;				///< size of the segment in bytes
+	uint32_t num_topics;
+	std::atomic<uint32_t> heartbeat;	///< CLOCK_MONOTONIC of the writer [ms], updated periodically
+	uint32_t reserved[3];
+};
+
+struct TopicDescriptor {
+	char name[MAX_NAME_LENGTH];
+	uint32_t offset;	///< offset of the ring from the start of the segment
+	uint32_t slot_size;	///< size of a slot including the sequence number
+	uint16_t size;		///< message size (orb_metadata::o_size)
+	uint8_t instance;
+	uint8_t queue_size;	///< number of slots, power of 2
+	uint32_t reserved;
+};
+
+struct alignas(ALIGNMENT) Ring {
+	std::atomic<uint32_t> generation;	///< number of publications
+	std::atomic<uint32_t> advertised;
+	// followed by queue_size slots
+};
+
+struct Slot {
+	std::atomic<uint32_t> sequence;
+	uint32_t reserved;
+	// followed by the message
+};
+
+static constexpr size_t align(size_t size) { return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1); }
+
+static constexpr size_t slot_size(size_t message_size) { return align(sizeof(Slot) + message_size); }
+
+static constexpr size_t ring_size(size_t message_size, unsigned queue_size)
+{
+	return sizeof(Ring) + queue_size * slot_size(message_size);
+}
+
+static constexpr size_t rings_offset() { return align(sizeof(Header) + MAX_TOPICS * sizeof(TopicDescriptor)); }
+
+static inline const TopicDescriptor *descriptors(const void *segment)
+{
+	return reinterpret_cast<const TopicDescriptor *>(static_cast<const uint8_t *>(segment) + sizeof(Header));
+}
+
+static inline Slot *get_slot(Ring *ring, const TopicDescriptor &topic, uint32_t generation)
+{
+	return reinterpret_cast<Slot *>(reinterpret_cast<uint8_t *>(ring) + sizeof(Ring)
+					+ (generation & (topic.queue_size - 1)) * topic.slot_size);
+}
+
+static inline const Slot *get_slot(const Ring *ring, const TopicDescriptor &topic, uint32_t generation)
+{
+	return get_slot(const_cast<Ring *>(ring), topic, generation);
+}
+
+static inline const void *slot_data(const Slot *slot) { return slot + 1; }
+
+/**
+ * Publish a message to a ring. The publications of a ring must be serialized by the caller.
+ */
+static inline void write(Ring *ring, const TopicDescriptor &topic, const void *data)
+{
+	const uint32_t generation = ring->generation.load(std::memory_order_relaxed);
+	Slot *slot = get_slot(ring, topic, generation);
+
+	slot->sequence.store(2 * generation + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	memcpy(reinterpret_cast<uint8_t *>(slot) + sizeof(Slot), data, topic.size);
+
+	slot->sequence.store(2 * generation + 2, std::memory_order_release);
+	ring->generation.store(generation + 1, std::memory_order_release);
+}
+
+/**
+ * Get the message of a publication without copying it. Check with is_valid() once done with the data,
+ * as it might have been overwritten in the meantime.
+ * @return the message, nullptr if the publication is not available (anymore)
+ */
+static inline const void *peek(const Ring *ring, const TopicDescriptor &topic, uint32_t generation)
+{
+	const Slot *slot = get_slot(ring, topic, generation);
+
+	if (slot->sequence.load(std::memory_order_acquire) != 2 * generation + 2) {
+		return nullptr;
+	}
+
+	return slot_data(slot);
+}
+
+/**
+ * @return true if the publication has not been overwritten since peek()
+ */
+static inline bool is_valid(const Ring *ring, const TopicDescriptor &topic, uint32_t generation)
+{
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return get_slot(ring, topic, generation)->sequence.load(std::memory_order_relaxed) == 2 * generation + 2;
+}
+
+/**
+ * Copy the message of a publication.
+ * @return false if the publication is not available (anymore)
+ */
+static inline bool read(const Ring *ring, const TopicDescriptor &topic, uint32_t generation, void *dst)
+{
+	const void *data = peek(ring, topic, generation);
+
+	if (data == nullptr) {
+		return false;
+	}
+
+	memcpy(dst, data, topic.size);
+
+	return is_valid(ring, topic, generation);
+}
+
+} // namespace uorb_shm
@@ -0,0 +1,351 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+#include "UorbShmBridge.hpp"
+
+#include <px4_platform_common/getopt.h>
+#include <px4_platform_common/log.h>
+#include <uORB/uORBManager.hpp>
+
+#include <string.h>
+
+using namespace time_literals;
+
+// exported if no topics are given on the command line
+static constexpr const char *default_topics[] {
+	"sensor_combined",
+	"vehicle_odometry",
+	"vehicle_attitude",
+	"vehicle_local_position",
+	"vehicle_angular_velocity",
+};
+
+static UorbShmChannel channel;
+
+void UorbShmChannel::detach()
+{
+	_bridge.store(nullptr);
+
+	while (_in_flight.load() > 0) {
+		px4_usleep(100);
+	}
+}
+
+int16_t UorbShmChannel::send_message(const char *messageName, int32_t length, uint8_t *data, uint8_t instance)
+{
+	_in_flight.fetch_add(1);
+
+	UorbShmBridge *bridge = _bridge.load();
+
+	if (bridge) {
+		bridge->publish(messageName, length, data, instance);
+	}
+
+	_in_flight.fetch_sub(1);
+
+	// topics which are not exported are not an error of the publisher
+	return 0;
+}
+
+UorbShmBridge::UorbShmBridge() :
+	ScheduledWorkItem(MODULE_NAME, px4::wq_configurations::lp_default)
+{
+}
+
+UorbShmBridge::~UorbShmBridge()
+{
+	ScheduleClear();
+	channel.detach();
+
+	for (unsigned i = 0; i < _num_topics; i++) {
+		pthread_mutex_destroy(&_topics[i].mutex);
+	}
+}
+
+bool UorbShmBridge::add_topic(const orb_metadata *meta, uint8_t instance)
+{
+	if ((_num_topics >= uorb_shm::MAX_TOPICS) || (instance >= ORB_MULTI_MAX_INSTANCES)
+	    || (strlen(meta->o_name) >= uorb_shm::MAX_NAME_LENGTH)) {
+		return false;
+	}
+
+	for (unsigned i = 0; i < _num_topics; i++) {
+		if ((_topics[i].meta == meta) && (_topics[i].instance == instance)) {
+			return true;
+		}
+	}
+
+	Topic &topic = _topics[_num_topics++];
+	topic.meta = meta;
+	topic.instance = instance;
+	topic.advertised = false;
+	pthread_mutex_init(&topic.mutex, nullptr);
+
+	return true;
+}
+
+bool UorbShmBridge::init(const char *segment_name, uint8_t queue_size)
+{
+	if (uORB::Manager::get_instance()->get_uorb_communicator() != nullptr) {
+		PX4_ERR("another communicator is already registered");
+		return false;
+	}
+
+	uorb_shm::TopicConfig topics[uorb_shm::MAX_TOPICS];
+
+	for (unsigned i = 0; i < _num_topics; i++) {
+		topics[i].name = _topics[i].meta->o_name;
+		topics[i].size = _topics[i].meta->o_size;
+		topics[i].instance = _topics[i].instance;
+		topics[i].queue_size = queue_size;
+	}
+
+	const int ret = _writer.create(segment_name, topics, _num_topics);
+
+	if (ret < 0) {
+		PX4_ERR("creating %s failed (%i)", segment_name, ret);
+		return false;
+	}
+
+	strncpy(_segment_name, segment_name, sizeof(_segment_name) - 1);
+
+	channel.attach(this);
+	uORB::Manager::get_instance()->set_uorb_communicator(&channel);
+
+	ScheduleOnInterval(100_ms);
+
+	return true;
+}
+
+void UorbShmBridge::publish(const char *messageName, int32_t length, const uint8_t *data, uint8_t instance)
+{
+	// called from the publishers' context: the topic names point to the topic metadata, no need to compare strings
+	for (unsigned i = 0; i < _num_topics; i++) {
+		Topic &topic = _topics[i];
+
+		if ((topic.meta->o_name == messageName) && (topic.instance == instance)) {
+			if (length != topic.meta->o_size) {
+				return;
+			}
+
+			pthread_mutex_lock(&topic.mutex);
+
+			_writer.publish(i, data);
+
+			if (!topic.advertised) {
+				_writer.set_advertised(i, true);
+				topic.advertised = true;
+			}
+
+			pthread_mutex_unlock(&topic.mutex);
+			break;
+		}
+	}
+}
+
+void UorbShmBridge::Run()
+{
+	if (should_exit()) {
+		ScheduleClear();
+		exit_and_cleanup();
+		return;
+	}
+
+	_writer.heartbeat();
+}
+
+void UorbShmBridge::request_stop()
+{
+	// stop forwarding before the segment is unmapped, publishers which already got the channel are waited for
+	if (uORB::Manager::get_instance()->get_uorb_communicator() == &channel) {
+		uORB::Manager::get_instance()->set_uorb_communicator(nullptr);
+	}
+
+	channel.detach();
+
+	ModuleBase::request_stop();
+}
+
+int UorbShmBridge::print_status()
+{
+	PX4_INFO("segment: %s (%zu bytes)", _segment_name, _writer.size());
+
+	for (unsigned i = 0; i < _num_topics; i++) {
+		PX4_INFO_RAW("  %-32s %u: %s, %" PRIu32 " publications\n", _topics[i].meta->o_name, _topics[i].instance,
+			     _topics[i].advertised ? "advertised" : "not advertised", _writer.generation(i));
+	}
+
+	return 0;
+}
+
+static const orb_metadata *find_topic(const char *name)
+{
+	const orb_metadata *const *topics = orb_get_topics();
+
+	for (size_t i = 0; i < orb_topics_count(); i++) {
+		if (strcmp(topics[i]->o_name, name) == 0) {
+			return topics[i];
+		}
+	}
+
+	return nullptr;
+}
+
+int UorbShmBridge::task_spawn(int argc, char *argv[])
+{
+	const char *segment_name = DEFAULT_SEGMENT_NAME;
+	int queue_size = DEFAULT_QUEUE_SIZE;
+
+	int myoptind = 1;
+	int ch;
+	const char *myoptarg = nullptr;
+
+	while ((ch = px4_getopt(argc, argv, "n:q:", &myoptind, &myoptarg)) != EOF) {
+		switch (ch) {
+		case 'n':
+			segment_name = myoptarg;
+			break;
+
+		case 'q':
+			queue_size = atoi(myoptarg);
+			break;
+
+		default:
+			print_usage("unrecognized flag");
+			return PX4_ERROR;
+		}
+	}
+
+	if ((segment_name[0] != '/') || (strlen(segment_name) >= sizeof(_segment_name))) {
+		print_usage("invalid segment name");
+		return PX4_ERROR;
+	}
+
+	if ((queue_size < 1) || (queue_size > 128)) {
+		print_usage("invalid queue size");
+		return PX4_ERROR;
+	}
+
+	UorbShmBridge *obj = new UorbShmBridge();
+
+	if (!obj) {
+		PX4_ERR("alloc failed");
+		return PX4_ERROR;
+	}
+
+	bool topics_valid = true;
+
+	// topic[:instance] arguments
+	for (int i = myoptind; i < argc; i++) {
+		char name[uorb_shm::MAX_NAME_LENGTH] {};
+		int instance = 0;
+		const char *separator = strchr(argv[i], ':');
+		const size_t length = separator ? (size_t)(separator - argv[i]) : strlen(argv[i]);
+
+		if (separator) {
+			instance = atoi(separator + 1);
+		}
+
+		if (length < sizeof(name)) {
+			memcpy(name, argv[i], length);
+		}
+
+		const orb_metadata *meta = find_topic(name);
+
+		if (!meta || (instance < 0) || !obj->add_topic(meta, instance)) {
+			PX4_ERR("invalid topic %s", argv[i]);
+			topics_valid = false;
+		}
+	}
+
+	if (myoptind >= argc) {
+		for (const char *name : default_topics) {
+			const orb_metadata *meta = find_topic(name);
+
+			if (meta) {
+				obj->add_topic(meta, 0);
+			}
+		}
+	}
+
+	if (!topics_valid || !obj->init(segment_name, queue_size)) {
+		delete obj;
+		return PX4_ERROR;
+	}
+
+	_object.store(obj);
+	_task_id = task_id_is_work_queue;
+
+	return PX4_OK;
+}
+
+int UorbShmBridge::print_usage(const char *reason)
+{
+	if (reason) {
+		PX4_ERR("%s\n", reason);
+	}
+
+	PRINT_MODULE_DESCRIPTION(
+		R"DESCR_STR(
+### Description
+Exports uORB topics to a POSIX shared memory segment, so that other processes on the same host can
+subscribe to them with low latency (e.g. a companion process reading `sensor_combined` or `vehicle_odometry`).
+
+Every exported topic instance has a lock-free single producer ring in the segment, which is written from the
+publisher's context. Readers map the segment read-only (see `UorbShmReader.hpp`) and track the
+generation counter of a ring like a uORB subscription, including the detection of lost publications.
+
+The module registers as uORB communicator channel. Only one channel can be registered at a time.
+
+### Examples
+Export the default topics to `/dev/shm/px4_uorb`:
+$ uorb_shm_bridge start
+Export the second gyro and the odometry with a queue of 16 publications:
+$ uorb_shm_bridge start -q 16 sensor_gyro:1 vehicle_odometry
+)DESCR_STR");
+
+	PRINT_MODULE_USAGE_NAME("uorb_shm_bridge", "communication");
+	PRINT_MODULE_USAGE_COMMAND("start");
+	PRINT_MODULE_USAGE_PARAM_STRING('n', DEFAULT_SEGMENT_NAME, "</name>", "Shared memory segment name", true);
+	PRINT_MODULE_USAGE_PARAM_INT('q', DEFAULT_QUEUE_SIZE, 1, 128, "Queue size (rounded up to a power of 2)", true);
+	PRINT_MODULE_USAGE_ARG("<topic>[:<instance>]", "Exported topics, default: sensor_combined, vehicle_odometry, ...",
+			       true);
+	PRINT_MODULE_USAGE_DEFAULT_COMMANDS();
+
+	return 0;
+}
+
+extern "C" __EXPORT int uorb_shm_bridge_main(int argc, char *argv[])
+{
+	return UorbShmBridge::main(argc, argv);
+}
@@ -0,0 +1,135 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file UorbShmBridge.hpp
+ *
+ * uORB communicator channel exporting topics to POSIX shared memory, so that other processes
+ * on the same host can subscribe to them without a network transport (see UorbShmReader.hpp).
+ */
+
+#pragma once
+
+#include "UorbShmWriter.hpp"
+
+#include <pthread.h>
+
+#include <px4_platform_common/atomic.h>
+#include <px4_platform_common/defines.h>
+#include <px4_platform_common/module.h>
+#include <px4_platform_common/px4_work_queue/ScheduledWorkItem.hpp>
+#include <uORB/uORBCommunicator.hpp>
+#include <uORB/topics/uORBTopics.hpp>
+
+class UorbShmBridge;
+
+/**
+ * Communicator channel registered with uORB. Publishers use the registered channel without a lock,
+ * therefore the channel is never freed: it forwards to the bridge while one is attached, and detaching
+ * waits for the calls in flight.
+ */
+class UorbShmChannel : public uORBCommunicator::IChannel
+{
+public:
+	void attach(UorbShmBridge *bridge) { _bridge.store(bridge); }
+
+	/** stop forwarding to the bridge, returns once no publisher uses it anymore */
+	void detach();
+
+	int16_t topic_advertised(const char *messageName) override { return 0; }
+	int16_t add_subscription(const char *messageName, int32_t msgRateInHz) override { return 0; }
+	int16_t remove_subscription(const char *messageName) override { return 0; }
+	int16_t register_handler(uORBCommunicator::IChannelRxHandler *handler) override { return 0; }
+
+	int16_t send_message(const char *messageName, int32_t length, uint8_t *data) override
+	{
+		return send_message(messageName, length, data, 0);
+	}
+
+	int16_t send_message(const char *messageName, int32_t length, uint8_t *data, uint8_t instance) override;
+
+private:
+	px4::atomic<UorbShmBridge *> _bridge{nullptr};
+	px4::atomic<int> _in_flight{0};
+};
+
+class UorbShmBridge : public ModuleBase<UorbShmBridge>, public px4::ScheduledWorkItem
+{
+public:
+	UorbShmBridge();
+	~UorbShmBridge() override;
+
+	/** @see ModuleBase */
+	static int task_spawn(int argc, char *argv[]);
+
+	/** @see ModuleBase */
+	static int custom_command(int argc, char *argv[])
+	{
+		return print_usage("unknown command");
+	}
+
+	/** @see ModuleBase */
+	static int print_usage(const char *reason = nullptr);
+
+	/** @see ModuleBase::print_status() */
+	int print_status() override;
+
+	/** @see ModuleBase::request_stop() */
+	void request_stop() override;
+
+	bool add_topic(const orb_metadata *meta, uint8_t instance);
+
+	bool init(const char *segment_name, uint8_t queue_size);
+
+	/** export a publication, called from the publishers' context */
+	void publish(const char *messageName, int32_t length, const uint8_t *data, uint8_t instance);
+
+private:
+	static constexpr const char *DEFAULT_SEGMENT_NAME = "/px4_uorb";
+	static constexpr uint8_t DEFAULT_QUEUE_SIZE = 4;
+
+	void Run() override;
+
+	struct Topic {
+		const orb_metadata *meta;
+		uint8_t instance;
+		bool advertised;
+		pthread_mutex_t mutex; ///< serializes the publishers of the topic instance
+	};
+
+	Topic _topics[uorb_shm::MAX_TOPICS] {};
+	unsigned _num_topics{0};
+
+	uorb_shm::SegmentWriter _writer;
+	char _segment_name[64] {};
+};
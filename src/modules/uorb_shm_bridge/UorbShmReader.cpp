@@ -0,0 +1,229 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+#include "UorbShmReader.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace uorb_shm
+{
+
+bool Segment::open(const char *name)
+{
+	close();
+
+	const int fd = shm_open(name, O_RDONLY, 0);
+
+	if (fd < 0) {
+		return false;
+	}
+
+	struct stat st {};
+
+	if ((fstat(fd, &st) != 0) || (st.st_size < (off_t)rings_offset())) {
+		::close(fd);
+		return false;
+	}
+
+	void *segment = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+
+	if (segment == MAP_FAILED) {
+		return false;
+	}
+
+	const Header *header = static_cast<const Header *>(segment);
+
+	bool valid = (header->magic.load(std::memory_order_acquire) == MAGIC) && (header->version == VERSION)
+		     && (header->size <= (size_t)st.st_size) && (header->num_topics <= MAX_TOPICS);
+
+	for (unsigned i = 0; valid && (i < header->num_topics); i++) {
+		const TopicDescriptor &topic = descriptors(segment)[i];
+
+		valid = (topic.queue_size > 0) && ((topic.queue_size & (topic.queue_size - 1)) == 0)
+			&& (topic.slot_size >= sizeof(Slot) + topic.size)
+			&& (topic.offset + sizeof(Ring) + topic.queue_size * topic.slot_size <= header->size);
+	}
+
+	if (!valid) {
+		munmap(segment, st.st_size);
+		return false;
+	}
+
+	_header = header;
+	_size = st.st_size;
+
+	return true;
+}
+
+void Segment::close()
+{
+	if (_header != nullptr) {
+		munmap(const_cast<Header *>(_header), _size);
+		_header = nullptr;
+		_size = 0;
+	}
+}
+
+const TopicDescriptor *Segment::topic(unsigned index) const
+{
+	return (index < num_topics()) ? &descriptors(_header)[index] : nullptr;
+}
+
+const TopicDescriptor *Segment::find(const char *name, uint8_t instance) const
+{
+	for (unsigned i = 0; i < num_topics(); i++) {
+		const TopicDescriptor *topic = &descriptors(_header)[i];
+
+		if ((topic->instance == instance) && (strncmp(topic->name, name, MAX_NAME_LENGTH) == 0)) {
+			return topic;
+		}
+	}
+
+	return nullptr;
+}
+
+const Ring *Segment::ring(const TopicDescriptor *topic) const
+{
+	if (!is_open() || (topic == nullptr)) {
+		return nullptr;
+	}
+
+	return reinterpret_cast<const Ring *>(reinterpret_cast<const uint8_t *>(_header) + topic->offset);
+}
+
+uint32_t Segment::heartbeat_age() const
+{
+	if (!is_open()) {
+		return UINT32_MAX;
+	}
+
+	struct timespec ts {};
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	const uint32_t now_ms = ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+
+	return now_ms - _header->heartbeat.load(std::memory_order_relaxed);
+}
+
+Subscription::Subscription(const Segment &segment, const char *name, uint8_t instance) :
+	_topic(segment.find(name, instance)),
+	_ring(segment.ring(_topic))
+{
+	if (_ring != nullptr) {
+		// like DeviceNode, start with the latest publication
+		const uint32_t generation = _ring->generation.load(std::memory_order_acquire);
+		_last_generation = (generation > 0) ? generation - 1 : 0;
+	}
+}
+
+uint32_t Subscription::skip_overwritten()
+{
+	const uint32_t generation = _ring->generation.load(std::memory_order_acquire);
+
+	if (generation - _last_generation > _topic->queue_size) {
+		_lost += generation - _last_generation - _topic->queue_size;
+		_last_generation = generation - _topic->queue_size;
+	}
+
+	return generation;
+}
+
+bool Subscription::update(void *dst, size_t size)
+{
+	if (!valid() || (size != _topic->size)) {
+		return false;
+	}
+
+	while (skip_overwritten() != _last_generation) {
+		if (read(_ring, *_topic, _last_generation++, dst)) {
+			return true;
+		}
+
+		// overwritten while copying
+		_lost++;
+	}
+
+	return false;
+}
+
+bool Subscription::copy(void *dst, size_t size)
+{
+	if (!valid() || (size != _topic->size)) {
+		return false;
+	}
+
+	for (;;) {
+		const uint32_t generation = _ring->generation.load(std::memory_order_acquire);
+
+		if (generation == 0) {
+			return false;
+		}
+
+		if (read(_ring, *_topic, generation - 1, dst)) {
+			return true;
+		}
+	}
+}
+
+const void *Subscription::peek()
+{
+	if (!valid()) {
+		return nullptr;
+	}
+
+	while (skip_overwritten() != _last_generation) {
+		const void *data = uorb_shm::peek(_ring, *_topic, _last_generation);
+
+		if (data != nullptr) {
+			_peek_generation = _last_generation++;
+			return data;
+		}
+
+		_lost++;
+		_last_generation++;
+	}
+
+	return nullptr;
+}
+
+bool Subscription::is_valid() const
+{
+	return valid() && uorb_shm::is_valid(_ring, *_topic, _peek_generation);
+}
+
+} // namespace uorb_shm
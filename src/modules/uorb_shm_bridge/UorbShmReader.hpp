@@ -0,0 +1,158 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file UorbShmReader.hpp
+ *
+ * Reader library for the uORB topics exported by uorb_shm_bridge, to be used by other processes.
+ * It only depends on POSIX and the segment layout, the message definitions (uORB/topics/...) have to match
+ * the ones of the PX4 build.
+ *
+ * Example:
+ *
+ *	uorb_shm::Segment segment;
+ *	segment.open("/px4_uorb");
+ *	uorb_shm::Subscription sub{segment, "sensor_combined"};
+ *	sensor_combined_s sensor_combined;
+ *
+ *	if (sub.update(&sensor_combined, sizeof(sensor_combined))) { ... }
+ */
+
+#pragma once
+
+#include "UorbShm.hpp"
+
+namespace uorb_shm
+{
+
+class Segment
+{
+public:
+	Segment() = default;
+	~Segment() { close(); }
+
+	Segment(const Segment &) = delete;
+	Segment &operator=(const Segment &) = delete;
+
+	/**
+	 * Map an existing segment read-only.
+	 * @param name shared memory object name, e.g. "/px4_uorb"
+	 * @return false if the segment does not exist (yet) or is not compatible
+	 */
+	bool open(const char *name);
+	void close();
+
+	bool is_open() const { return _header != nullptr; }
+
+	unsigned num_topics() const { return is_open() ? _header->num_topics : 0; }
+	const TopicDescriptor *topic(unsigned index) const;
+
+	/**
+	 * @return the exported topic instance, nullptr if not exported
+	 */
+	const TopicDescriptor *find(const char *name, uint8_t instance = 0) const;
+
+	const Ring *ring(const TopicDescriptor *topic) const;
+
+	/**
+	 * @return time since the last heartbeat of the writer [ms], to detect if PX4 is still running
+	 */
+	uint32_t heartbeat_age() const;
+
+private:
+	const Header *_header{nullptr};
+	size_t _size{0};
+};
+
+class Subscription
+{
+public:
+	/**
+	 * @param segment opened segment, must outlive the subscription
+	 */
+	Subscription(const Segment &segment, const char *name, uint8_t instance = 0);
+
+	/**
+	 * @return true if the topic is exported by the segment
+	 */
+	bool valid() const { return _ring != nullptr; }
+
+	bool advertised() const { return valid() && _ring->advertised.load(std::memory_order_relaxed); }
+
+	bool updated() const { return valid() && (_ring->generation.load(std::memory_order_acquire) != _last_generation); }
+
+	/**
+	 * Copy the next publication. Consecutive calls return all queued publications in order.
+	 * @param size size of dst, has to match the message size
+	 * @return true if a new publication was copied
+	 */
+	bool update(void *dst, size_t size);
+
+	/**
+	 * Copy the latest publication, regardless of whether it was read already.
+	 * @return true on success
+	 */
+	bool copy(void *dst, size_t size);
+
+	/**
+	 * Zero-copy access to the next publication. Once done with the data, call is_valid() to check that it
+	 * was not overwritten in the meantime.
+	 * @return the message, nullptr if there is no new publication
+	 */
+	const void *peek();
+	bool is_valid() const;
+
+	/** size of the message */
+	size_t size() const { return valid() ? _topic->size : 0; }
+
+	/** number of publications lost because they were overwritten before being read */
+	uint32_t lost() const { return _lost; }
+
+	uint32_t get_last_generation() const { return _last_generation; }
+
+private:
+	/**
+	 * Skip the publications which are not in the ring anymore.
+	 * @return generation of the latest publication
+	 */
+	uint32_t skip_overwritten();
+
+	const TopicDescriptor *_topic{nullptr};
+	const Ring *_ring{nullptr};
+
+	uint32_t _last_generation{0};	///< generation of the next publication to read
+	uint32_t _peek_generation{0};
+	uint32_t _lost{0};
+};
+
+} // namespace uorb_shm
@@ -0,0 +1,341 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "UorbShmReader.hpp"
+#include "UorbShmWriter.hpp"
+
+#include <chrono>
+#include <stdio.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+using namespace uorb_shm;
+
+struct TestMessage {
+	uint64_t timestamp;
+	uint32_t counter[30];
+};
+
+static uint64_t monotonic_ns()
+{
+	struct timespec ts {};
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void fill(TestMessage &msg, uint32_t counter)
+{
+	msg.timestamp = monotonic_ns();
+
+	for (auto &c : msg.counter) {
+		c = counter;
+	}
+}
+
+// a torn message would contain counters of different publications
+static bool consistent(const TestMessage &msg)
+{
+	for (auto &c : msg.counter) {
+		if (c != msg.counter[0]) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+class UorbShmTest : public ::testing::Test
+{
+public:
+	void SetUp() override
+	{
+		snprintf(_name, sizeof(_name), "/uorb_shm_test_%d", (int)getpid());
+
+		const TopicConfig topics[] {
+			{"test_topic", sizeof(TestMessage), 0, 4},
+			{"test_topic", sizeof(TestMessage), 1, 1},
+			{"other_topic", 8, 0, 3},
+		};
+
+		ASSERT_EQ(_writer.create(_name, topics, 3), 0);
+	}
+
+	char _name[64] {};
+	SegmentWriter _writer;
+};
+
+TEST_F(UorbShmTest, segment)
+{
+	Segment segment;
+	ASSERT_TRUE(segment.open(_name));
+	ASSERT_EQ(segment.num_topics(), 3u);
+
+	EXPECT_EQ(segment.find("test_topic", 0), segment.topic(0));
+	EXPECT_EQ(segment.find("test_topic", 1), segment.topic(1));
+	EXPECT_EQ(segment.find("other_topic"), segment.topic(2));
+	EXPECT_EQ(segment.find("test_topic", 2), nullptr);
+	EXPECT_EQ(segment.find("missing"), nullptr);
+
+	// queue sizes are rounded up to a power of 2
+	EXPECT_EQ(segment.topic(0)->queue_size, 4);
+	EXPECT_EQ(segment.topic(2)->queue_size, 4);
+
+	EXPECT_LT(segment.heartbeat_age(), 1000u);
+
+	Segment missing;
+	EXPECT_FALSE(missing.open("/uorb_shm_test_missing"));
+}
+
+TEST_F(UorbShmTest, publishSubscribe)
+{
+	Segment segment;
+	ASSERT_TRUE(segment.open(_name));
+
+	Subscription sub{segment, "test_topic"};
+	Subscription sub1{segment, "test_topic", 1};
+	Subscription missing{segment, "missing"};
+	ASSERT_TRUE(sub.valid());
+	EXPECT_FALSE(missing.valid());
+
+	TestMessage msg{};
+	EXPECT_FALSE(sub.advertised());
+	EXPECT_FALSE(sub.updated());
+	EXPECT_FALSE(sub.update(&msg, sizeof(msg)));
+	EXPECT_FALSE(sub.copy(&msg, sizeof(msg)));
+
+	_writer.set_advertised(0, true);
+	EXPECT_TRUE(sub.advertised());
+
+	// all queued publications in order
+	for (uint32_t i = 0; i < 3; i++) {
+		fill(msg, i);
+		_writer.publish(0, &msg);
+	}
+
+	EXPECT_TRUE(sub.updated());
+	EXPECT_FALSE(sub1.updated());
+
+	for (uint32_t i = 0; i < 3; i++) {
+		ASSERT_TRUE(sub.update(&msg, sizeof(msg)));
+		EXPECT_EQ(msg.counter[0], i);
+	}
+
+	EXPECT_FALSE(sub.update(&msg, sizeof(msg)));
+	EXPECT_EQ(sub.lost(), 0u);
+
+	// a wrong size is rejected
+	fill(msg, 3);
+	_writer.publish(0, &msg);
+	EXPECT_FALSE(sub.update(&msg, sizeof(msg) - 1));
+
+	// overflow: the oldest publications are lost
+	for (uint32_t i = 4; i < 10; i++) {
+		fill(msg, i);
+		_writer.publish(0, &msg);
+	}
+
+	for (uint32_t i = 6; i < 10; i++) {
+		ASSERT_TRUE(sub.update(&msg, sizeof(msg)));
+		EXPECT_EQ(msg.counter[0], i);
+	}
+
+	EXPECT_EQ(sub.lost(), 3u);
+
+	// latest
+	ASSERT_TRUE(sub.copy(&msg, sizeof(msg)));
+	EXPECT_EQ(msg.counter[0], 9u);
+
+	// a new subscription starts with the latest publication
+	Subscription late{segment, "test_topic"};
+	ASSERT_TRUE(late.update(&msg, sizeof(msg)));
+	EXPECT_EQ(msg.counter[0], 9u);
+	EXPECT_FALSE(late.updated());
+
+	// zero-copy
+	fill(msg, 10);
+	_writer.publish(0, &msg);
+	const TestMessage *data = static_cast<const TestMessage *>(sub.peek());
+	ASSERT_NE(data, nullptr);
+	EXPECT_EQ(data->counter[0], 10u);
+	EXPECT_TRUE(sub.is_valid());
+	EXPECT_EQ(sub.peek(), nullptr);
+
+	// the slot is overwritten after queue_size publications
+	for (uint32_t i = 11; i < 15; i++) {
+		fill(msg, i);
+		_writer.publish(0, &msg);
+	}
+
+	EXPECT_FALSE(sub.is_valid());
+}
+
+TEST_F(UorbShmTest, crossProcess)
+{
+	static constexpr uint32_t N = 100000;
+
+	const pid_t pid = fork();
+	ASSERT_GE(pid, 0);
+
+	if (pid == 0) {
+		// reader process: all messages consistent and in order
+		Segment segment;
+
+		while (!segment.open(_name)) {}
+
+		Subscription sub{segment, "test_topic"};
+		TestMessage msg{};
+		uint32_t last = 0;
+		bool ok = true;
+
+		while (ok && (last < N - 1)) {
+			if (sub.update(&msg, sizeof(msg))) {
+				ok = consistent(msg) && (msg.counter[0] >= last);
+				last = msg.counter[0];
+			}
+		}
+
+		_exit(ok ? 0 : 1);
+	}
+
+	TestMessage msg{};
+
+	for (uint32_t i = 0; i < N; i++) {
+		fill(msg, i);
+		_writer.publish(0, &msg);
+	}
+
+	int status = 0;
+	ASSERT_EQ(waitpid(pid, &status, 0), pid);
+	EXPECT_TRUE(WIFEXITED(status) && (WEXITSTATUS(status) == 0));
+}
+
+// not part of the unit tests, run with --gtest_also_run_disabled_tests
+TEST_F(UorbShmTest, DISABLED_Benchmark)
+{
+	static constexpr uint32_t N_THROUGHPUT = 1000000;
+	static constexpr uint32_t N_LATENCY = 10000;
+
+	struct Result {
+		uint32_t received;
+		uint32_t lost;
+		double latency_mean_us;
+		double latency_max_us;
+	};
+
+	int fds[2];
+	ASSERT_EQ(pipe(fds), 0);
+
+	const pid_t pid = fork();
+	ASSERT_GE(pid, 0);
+
+	if (pid == 0) {
+		Segment segment;
+
+		while (!segment.open(_name)) {}
+
+		Subscription sub{segment, "test_topic"};
+		TestMessage msg{};
+		Result result{};
+		double latency_sum = 0.;
+
+		// attached, the writer can start
+		const char ready = 1;
+
+		if (write(fds[1], &ready, sizeof(ready)) != sizeof(ready)) {
+			_exit(1);
+		}
+
+		// throughput: read as much as possible, then latency with a message every 100 us
+		while (true) {
+			if (sub.update(&msg, sizeof(msg))) {
+				if (msg.counter[0] >= N_THROUGHPUT) {
+					const double latency = (monotonic_ns() - msg.timestamp) * 1e-3;
+					latency_sum += latency;
+					result.latency_max_us = (latency > result.latency_max_us) ? latency : result.latency_max_us;
+
+				} else {
+					result.received++;
+				}
+
+				if (msg.counter[0] == N_THROUGHPUT + N_LATENCY - 1) {
+					break;
+				}
+			}
+		}
+
+		result.lost = sub.lost();
+		result.latency_mean_us = latency_sum / (sub.get_last_generation() - N_THROUGHPUT);
+		_exit((write(fds[1], &result, sizeof(result)) == sizeof(result)) ? 0 : 1);
+	}
+
+	// wait for the reader to attach
+	char ready = 0;
+	ASSERT_EQ(read(fds[0], &ready, sizeof(ready)), (ssize_t)sizeof(ready));
+
+	TestMessage msg{};
+	const auto start = std::chrono::steady_clock::now();
+
+	for (uint32_t i = 0; i < N_THROUGHPUT; i++) {
+		fill(msg, i);
+		_writer.publish(0, &msg);
+	}
+
+	const double publish_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+				  N_THROUGHPUT;
+
+	for (uint32_t i = N_THROUGHPUT; i < N_THROUGHPUT + N_LATENCY; i++) {
+		const uint64_t next = monotonic_ns() + 100000;
+
+		while (monotonic_ns() < next) {}
+
+		fill(msg, i);
+		_writer.publish(0, &msg);
+	}
+
+	Result result{};
+	ASSERT_EQ(read(fds[0], &result, sizeof(result)), (ssize_t)sizeof(result));
+
+	int status = 0;
+	ASSERT_EQ(waitpid(pid, &status, 0), pid);
+	EXPECT_TRUE(WIFEXITED(status) && (WEXITSTATUS(status) == 0));
+
+	printf("%zu byte messages, publish: %.1f ns (%.1f MB/s), reader received %u of %u, lost %u\n",
+	       sizeof(TestMessage), publish_ns, sizeof(TestMessage) / publish_ns * 1e3, result.received, N_THROUGHPUT, result.lost);
+	printf("latency at 10 kHz: mean %.2f us, max %.2f us\n", result.latency_mean_us, result.latency_max_us);
+
+	close(fds[0]);
+	close(fds[1]);
+}
@@ -0,0 +1,154 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+#include "UorbShmWriter.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <new>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace uorb_shm
+{
+
+static uint8_t round_queue_size(uint8_t queue_size)
+{
+	uint8_t rounded = 1;
+
+	while (rounded < queue_size) {
+		rounded <<= 1;
+	}
+
+	return rounded;
+}
+
+int SegmentWriter::create(const char *name, const TopicConfig *topics, unsigned num_topics)
+{
+	destroy();
+
+	if ((num_topics > MAX_TOPICS) || (strlen(name) >= sizeof(_name))) {
+		return -EINVAL;
+	}
+
+	size_t size = rings_offset();
+
+	for (unsigned i = 0; i < num_topics; i++) {
+		if ((strlen(topics[i].name) >= MAX_NAME_LENGTH) || (topics[i].queue_size == 0) || (topics[i].queue_size > 128)) {
+			return -EINVAL;
+		}
+
+		size += ring_size(topics[i].size, round_queue_size(topics[i].queue_size));
+	}
+
+	// a reader which still has an old segment mapped keeps it, new readers get the new one
+	shm_unlink(name);
+
+	const int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+
+	if (fd < 0) {
+		return -errno;
+	}
+
+	if (ftruncate(fd, size) != 0) {
+		const int ret = -errno;
+		::close(fd);
+		shm_unlink(name);
+		return ret;
+	}
+
+	void *segment = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+
+	if (segment == MAP_FAILED) {
+		shm_unlink(name);
+		return -ENOMEM;
+	}
+
+	// the new object is zero filled
+	_segment = static_cast<uint8_t *>(segment);
+	_size = size;
+	strncpy(_name, name, sizeof(_name) - 1);
+
+	TopicDescriptor *descriptor = reinterpret_cast<TopicDescriptor *>(_segment + sizeof(Header));
+	size_t offset = rings_offset();
+
+	for (unsigned i = 0; i < num_topics; i++) {
+		const uint8_t queue_size = round_queue_size(topics[i].queue_size);
+
+		strncpy(descriptor[i].name, topics[i].name, MAX_NAME_LENGTH - 1);
+		descriptor[i].offset = offset;
+		descriptor[i].slot_size = slot_size(topics[i].size);
+		descriptor[i].size = topics[i].size;
+		descriptor[i].instance = topics[i].instance;
+		descriptor[i].queue_size = queue_size;
+
+		_rings[i] = new (_segment + offset) Ring{};
+		offset += ring_size(topics[i].size, queue_size);
+	}
+
+	Header *header = new (_segment) Header{};
+	header->version = VERSION;
+	header->size = offset;
+	header->num_topics = num_topics;
+	heartbeat();
+
+	// readers only accept the segment once it is complete
+	header->magic.store(MAGIC, std::memory_order_release);
+
+	return 0;
+}
+
+void SegmentWriter::destroy()
+{
+	if (_segment != nullptr) {
+		munmap(_segment, _size);
+		shm_unlink(_name);
+		_segment = nullptr;
+		_size = 0;
+	}
+}
+
+void SegmentWriter::heartbeat()
+{
+	struct timespec ts {};
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	reinterpret_cast<Header *>(_segment)->heartbeat.store(ts.tv_sec * 1000 + ts.tv_nsec / 1000000,
+			std::memory_order_relaxed);
+}
+
+} // namespace uorb_shm
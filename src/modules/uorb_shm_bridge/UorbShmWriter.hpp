@@ -0,0 +1,106 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2022 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file UorbShmWriter.hpp
+ *
+ * Creates the shared memory segment and publishes to its rings (writer side of UorbShm.hpp).
+ */
+
+#pragma once
+
+#include "UorbShm.hpp"
+
+namespace uorb_shm
+{
+
+struct TopicConfig {
+	const char *name;
+	uint16_t size;
+	uint8_t instance;
+	uint8_t queue_size; ///< rounded up to a power of 2
+};
+
+class SegmentWriter
+{
+public:
+	SegmentWriter() = default;
+	~SegmentWriter() { destroy(); }
+
+	SegmentWriter(const SegmentWriter &) = delete;
+	SegmentWriter &operator=(const SegmentWriter &) = delete;
+
+	/**
+	 * Create the segment (replacing an existing one with the same name) for a set of topics.
+	 * The topics are published with the index they have in the array.
+	 * @return 0 on success, < 0 on error
+	 */
+	int create(const char *name, const TopicConfig *topics, unsigned num_topics);
+
+	/**
+	 * Unmap and remove the segment. Readers which still have it mapped keep their mapping.
+	 */
+	void destroy();
+
+	bool is_created() const { return _segment != nullptr; }
+	size_t size() const { return _size; }
+
+	/**
+	 * Publish a message to a topic. The publications of a topic must be serialized by the caller,
+	 * different topics can be published concurrently.
+	 */
+	void publish(unsigned index, const void *data) { write(_rings[index], descriptor(index), data); }
+
+	void set_advertised(unsigned index, bool advertised)
+	{
+		_rings[index]->advertised.store(advertised ? 1 : 0, std::memory_order_relaxed);
+	}
+
+	uint32_t generation(unsigned index) const { return _rings[index]->generation.load(std::memory_order_relaxed); }
+
+	/**
+	 * Update the heartbeat, which allows readers to detect that the writer is not running anymore.
+	 */
+	void heartbeat();
+
+private:
+	const TopicDescriptor &descriptor(unsigned index) const { return descriptors(_segment)[index]; }
+
+	uint8_t *_segment{nullptr};
+	size_t _size{0};
+	char _name[64] {};
+
+	Ring *_rings[MAX_TOPICS] {};
+};
+
+} // namespace uorb_shm
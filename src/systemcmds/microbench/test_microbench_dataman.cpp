@@ -0,0 +1,233 @@
+/****************************************************************************
+ *
+ *  Copyright (C) 2022 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file test_microbench_dataman.cpp
+ * Microbenchmark dataman read and write throughput, and the upload time of a large mission
+ * with single writes, a transaction and range writes.
+ *
+ * Measures the running dataman backend, compare backends by restarting dataman
+ * with -f (file), -m (memory-mapped file) or -r (RAM) in between.
+ */
+
+#include <unit_test.h>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <drivers/drv_hrt.h>
+#include <perf/perf_counter.h>
+#include <px4_platform_common/px4_config.h>
+
+#include <dataman/dataman.h>
+
+namespace MicroBenchDataman
+{
+
+#define PERF(name, op, count) do { \
+		px4_usleep(1000); \
+		perf_counter_t p = perf_alloc(PC_ELAPSED, name); \
+		for (int i = 0; i < count; i++) { \
+			perf_begin(p); \
+			op; \
+			perf_end(p); \
+		} \
+		perf_print_counter(p); \
+		perf_free(p); \
+	} while (0)
+
+class MicroBenchDataman : public UnitTest
+{
+public:
+	virtual bool run_tests();
+
+private:
+	static constexpr unsigned NUM_ITEMS = (DM_KEY_WAYPOINTS_OFFBOARD_0_MAX < 500) ? DM_KEY_WAYPOINTS_OFFBOARD_0_MAX : 500;
+	static constexpr unsigned RANGE_SIZE = 10;
+
+	bool time_dataman_write();
+	bool time_dataman_read();
+	bool time_dataman_upload_transaction();
+	bool time_dataman_upload_range();
+	bool time_dataman_read_range();
+
+	// use the mission storage not used by the current mission
+	dm_item_t unused_mission_key();
+
+	void print_throughput(const char *name, hrt_abstime elapsed);
+
+	mission_item_s _mission_item{};
+	mission_item_s _mission_items[RANGE_SIZE] {};
+};
+
+bool MicroBenchDataman::run_tests()
+{
+	ut_run_test(time_dataman_write);
+	ut_run_test(time_dataman_read);
+	ut_run_test(time_dataman_upload_transaction);
+	ut_run_test(time_dataman_upload_range);
+	ut_run_test(time_dataman_read_range);
+
+	return (_tests_failed == 0);
+}
+
+ut_declare_test_c(test_microbench_dataman, MicroBenchDataman)
+
+dm_item_t MicroBenchDataman::unused_mission_key()
+{
+	mission_s mission{};
+
+	if ((dm_read(DM_KEY_MISSION_STATE, 0, &mission, sizeof(mission_s)) == sizeof(mission_s))
+	    && (mission.dataman_id == DM_KEY_WAYPOINTS_OFFBOARD_1)) {
+		return DM_KEY_WAYPOINTS_OFFBOARD_0;
+	}
+
+	return DM_KEY_WAYPOINTS_OFFBOARD_1;
+}
+
+void MicroBenchDataman::print_throughput(const char *name, hrt_abstime elapsed)
+{
+	const double items_per_second = (elapsed > 0) ? (NUM_ITEMS * 1e6 / elapsed) : 0.0;
+	PX4_INFO_RAW("%s: %u items in %" PRIu64 " us, %.0f items/s\n", name, NUM_ITEMS, elapsed, items_per_second);
+}
+
+bool MicroBenchDataman::time_dataman_write()
+{
+	const dm_item_t key = unused_mission_key();
+	unsigned index = 0;
+	ssize_t ret = 0;
+
+	PERF("dm_write mission_item", ret = dm_write(key, index++ % NUM_ITEMS, &_mission_item, sizeof(mission_item_s)), 100);
+	ut_compare("dm_write", ret, sizeof(mission_item_s));
+
+	const hrt_abstime start = hrt_absolute_time();
+
+	for (index = 0; index < NUM_ITEMS; index++) {
+		_mission_item.lat = index;
+
+		ut_compare("dm_write", dm_write(key, index, &_mission_item, sizeof(mission_item_s)), sizeof(mission_item_s));
+	}
+
+	print_throughput("dm_write", hrt_elapsed_time(&start));
+
+	return true;
+}
+
+bool MicroBenchDataman::time_dataman_read()
+{
+	const dm_item_t key = unused_mission_key();
+	unsigned index = 0;
+	ssize_t ret = 0;
+
+	PERF("dm_read mission_item", ret = dm_read(key, index++ % NUM_ITEMS, &_mission_item, sizeof(mission_item_s)), 100);
+	ut_compare("dm_read", ret, sizeof(mission_item_s));
+
+	const hrt_abstime start = hrt_absolute_time();
+
+	for (index = 0; index < NUM_ITEMS; index++) {
+		ut_compare("dm_read", dm_read(key, index, &_mission_item, sizeof(mission_item_s)), sizeof(mission_item_s));
+		ut_compare("dm_read index", (unsigned)_mission_item.lat, index);
+	}
+
+	print_throughput("dm_read", hrt_elapsed_time(&start));
+
+	return true;
+}
+
+bool MicroBenchDataman::time_dataman_upload_transaction()
+{
+	const dm_item_t key = unused_mission_key();
+
+	// the same sequence as a mission upload over mavlink: one write per item, flushed on commit
+	const hrt_abstime start = hrt_absolute_time();
+
+	ut_compare("dm_transaction_begin", dm_transaction_begin(key), 0);
+
+	for (unsigned index = 0; index < NUM_ITEMS; index++) {
+		_mission_item.lat = index;
+
+		ut_compare("dm_write", dm_write(key, index, &_mission_item, sizeof(mission_item_s)), sizeof(mission_item_s));
+	}
+
+	ut_compare("dm_transaction_commit", dm_transaction_commit(key), 0);
+
+	print_throughput("dm_write transaction", hrt_elapsed_time(&start));
+
+	return true;
+}
+
+bool MicroBenchDataman::time_dataman_upload_range()
+{
+	const dm_item_t key = unused_mission_key();
+
+	const hrt_abstime start = hrt_absolute_time();
+
+	for (unsigned index = 0; index < NUM_ITEMS; index += RANGE_SIZE) {
+		const unsigned num_items = (NUM_ITEMS - index < RANGE_SIZE) ? NUM_ITEMS - index : RANGE_SIZE;
+
+		for (unsigned i = 0; i < num_items; i++) {
+			_mission_items[i].lat = index + i;
+		}
+
+		ut_compare("dm_write_range", dm_write_range(key, index, num_items, _mission_items, sizeof(mission_item_s)),
+			   num_items);
+	}
+
+	print_throughput("dm_write_range", hrt_elapsed_time(&start));
+
+	return true;
+}
+
+bool MicroBenchDataman::time_dataman_read_range()
+{
+	const dm_item_t key = unused_mission_key();
+
+	const hrt_abstime start = hrt_absolute_time();
+
+	for (unsigned index = 0; index < NUM_ITEMS; index += RANGE_SIZE) {
+		const unsigned num_items = (NUM_ITEMS - index < RANGE_SIZE) ? NUM_ITEMS - index : RANGE_SIZE;
+
+		ut_compare("dm_read_range", dm_read_range(key, index, num_items, _mission_items, sizeof(mission_item_s)),
+			   num_items);
+
+		for (unsigned i = 0; i < num_items; i++) {
+			ut_compare("dm_read_range index", (unsigned)_mission_items[i].lat, index + i);
+		}
+	}
+
+	print_throughput("dm_read_range", hrt_elapsed_time(&start));
+
+	return true;
+}
+
+} // namespace MicroBenchDataman
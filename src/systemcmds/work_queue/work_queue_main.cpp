@@ -35,6 +35,9 @@
 #include <px4_platform_common/module.h>
 #include <px4_platform_common/getopt.h>
 #include <px4_platform_common/px4_work_queue/WorkQueueManager.hpp>
+#include <px4_platform_common/px4_work_queue/WorkQueueTrace.hpp>
+
+#include <stdlib.h>
 
 static void	usage();
 
@@ -45,11 +48,27 @@ extern "C" {
 int
 work_queue_main(int argc, char *argv[])
 {
-	if (argc != 2) {
+	if (argc < 2) {
 		usage();
 		return 1;
 	}
 
+	if (!strcmp(argv[1], "trace") && argc >= 3) {
+		if (!strcmp(argv[2], "start")) {
+			const unsigned num_events = (argc >= 4) ? strtoul(argv[3], nullptr, 10) : 16384;
+			return px4::WorkQueueTraceStart(num_events);
+
+		} else if (!strcmp(argv[2], "stop")) {
+			return px4::WorkQueueTraceStop();
+
+		} else if (!strcmp(argv[2], "dump")) {
+			return px4::WorkQueueTraceDump((argc >= 4) ? argv[3] : "wq_trace.json");
+
+		} else if (!strcmp(argv[2], "status")) {
+			return px4::WorkQueueTraceStatus();
+		}
+	}
+
 	if (!strcmp(argv[1], "start")) {
 		px4::WorkQueueManagerStart();
 		return 0;
@@ -78,9 +97,20 @@ usage()
 
 Command-line tool to show work queue status.
 
+On POSIX the execution of work items and uORB publications can be traced into a ring buffer
+and dumped as Chrome trace JSON, which can be opened in chrome://tracing or https://ui.perfetto.dev.
+
+### Examples
+Trace for a few seconds and write the timeline:
+$ work_queue trace start
+$ work_queue trace stop
+$ work_queue trace dump /tmp/wq_trace.json
+
 )DESCR_STR");
 
 	PRINT_MODULE_USAGE_NAME("work_queue", "system");
 	PRINT_MODULE_USAGE_COMMAND("start");
+	PRINT_MODULE_USAGE_COMMAND_DESCR("trace", "Trace work queue execution (POSIX only)");
+	PRINT_MODULE_USAGE_ARG("start [<events>]|stop|status|dump [<file>]", "Start/stop tracing or write Chrome trace JSON", false);
 	PRINT_MODULE_USAGE_DEFAULT_COMMANDS();
 }